@@ -19,13 +19,13 @@
 #include "BitBoard.h"
 #include <cstring>
 
+#include "Utils/MemoryUtils.h"
+
 
 u64 BitBoard::s_directionBits[Square::VALUES_COUNT][Direction::VALUES_COUNT];
 u64 BitBoard::s_adjacentFiles[File::VALUES_COUNT];
 u64 BitBoard::s_betweenBits[Square::VALUES_COUNT][Square::VALUES_COUNT];
 u64 BitBoard::s_alignedBits[Square::VALUES_COUNT][Square::VALUES_COUNT];
-u64 BitBoard::s_threeFilesForward[Color::VALUES_COUNT][Square::VALUES_COUNT];
-u64 BitBoard::s_adjacentFilesForward[Color::VALUES_COUNT][Square::VALUES_COUNT];
 u64 BitBoard::s_pawnAttacks[Color::VALUES_COUNT][Square::VALUES_COUNT];
 u64 BitBoard::s_pieceAttacks[PieceType::VALUES_COUNT][Square::VALUES_COUNT];
 u64 BitBoard::s_castlingInternalSquares[Color::VALUES_COUNT][Castle::VALUES_COUNT];
@@ -34,17 +34,23 @@ BitBoard::MagicBitBoards BitBoard::s_rookMagic[Square::VALUES_COUNT];
 
 
 void BitBoard::init() noexcept {
-	static BitBoard s_rookTable[0x19000];
-	static BitBoard s_bishopTable[0x1480];
+	// The slider attack tables are accessed randomly, so they share a single huge page if possible
+	constexpr size_t ROOK_TABLE_SIZE = 0x19000;
+	constexpr size_t BISHOP_TABLE_SIZE = 0x1480;
+	static_assert((ROOK_TABLE_SIZE + BISHOP_TABLE_SIZE) * sizeof(BitBoard) <= mem_utils::HUGE_PAGE_SIZE);
+
+	static mem_utils::LargeMemory s_sliderTables = mem_utils::allocateLarge(mem_utils::HUGE_PAGE_SIZE);
+	assert(s_sliderTables.data != nullptr);
+
+	BitBoard* rookTable = reinterpret_cast<BitBoard*>(s_sliderTables.data);
+	BitBoard* bishopTable = rookTable + ROOK_TABLE_SIZE;
 
-	memset(s_rookTable, 0, sizeof(s_rookTable));
-	memset(s_bishopTable, 0, sizeof(s_bishopTable));
+	memset(s_sliderTables.data, 0, (ROOK_TABLE_SIZE + BISHOP_TABLE_SIZE) * sizeof(BitBoard));
 
 	memset(s_directionBits, 0, sizeof(s_directionBits));
 	memset(s_adjacentFiles, 0, sizeof(s_adjacentFiles));
 	memset(s_betweenBits, 0, sizeof(s_betweenBits));
 	memset(s_alignedBits, 0, sizeof(s_alignedBits));
-	memset(s_threeFilesForward, 0, sizeof(s_threeFilesForward));
 	memset(s_pawnAttacks, 0, sizeof(s_pawnAttacks));
 	memset(s_pieceAttacks, 0, sizeof(s_pieceAttacks));
 	memset(s_castlingInternalSquares, 0, sizeof(s_castlingInternalSquares));
@@ -52,8 +58,8 @@ void BitBoard::init() noexcept {
 	Square::init();
 	Castle::init();
 
-	initMagicBitBoards(PieceType::ROOK, s_rookTable, s_rookMagic);
-	initMagicBitBoards(PieceType::BISHOP, s_bishopTable, s_bishopMagic);
+	initMagicBitBoards(PieceType::ROOK, rookTable, s_rookMagic);
+	initMagicBitBoards(PieceType::BISHOP, bishopTable, s_bishopMagic);
 
 	for (Square i : Square::iter()) {
 		for (i32 j = i + 8; j < 64; j += 8) s_directionBits[i][Direction::UP] |= (1ull << j);
@@ -65,16 +71,6 @@ void BitBoard::init() noexcept {
 		for (i32 j = i - 7; j >= 0 && (j & 7) > 0; j -= 7) s_directionBits[i][Direction::DOWNRIGHT] |= (1ull << j);
 		for (i32 j = i - 9; j >= 0 && (j & 7) < 7; j -= 9) s_directionBits[i][Direction::DOWNLEFT] |= (1ull << j);
 		for (i32 j = i + 7; j < 64 && (j & 7) < 7; j += 7) s_directionBits[i][Direction::UPLEFT] |= (1ull << j);
-
-		s_threeFilesForward[Color::WHITE][i] |= s_directionBits[i][Direction::UP];
-		s_threeFilesForward[Color::BLACK][i] |= s_directionBits[i][Direction::DOWN];
-		if (i.getFile() != File::A) {
-			s_threeFilesForward[Color::WHITE][i] |= s_directionBits[i.shift(Direction::LEFT)][Direction::UP];
-			s_threeFilesForward[Color::BLACK][i] |= s_directionBits[i.shift(Direction::LEFT)][Direction::DOWN];
-		} if (i.getFile() != File::H) {
-			s_threeFilesForward[Color::WHITE][i] |= s_directionBits[i.shift(Direction::RIGHT)][Direction::UP];
-			s_threeFilesForward[Color::BLACK][i] |= s_directionBits[i.shift(Direction::RIGHT)][Direction::DOWN];
-		}
 	}
 
 	for (File file : File::iter()) {
@@ -86,9 +82,6 @@ void BitBoard::init() noexcept {
 		s_pawnAttacks[Color::WHITE][i] = sqBB.pawnAttackedSquares<Color::WHITE>();
 		s_pawnAttacks[Color::BLACK][i] = sqBB.pawnAttackedSquares<Color::BLACK>();
 
-		s_adjacentFilesForward[Color::WHITE][i] = s_adjacentFiles[i.getFile()] & s_threeFilesForward[Color::WHITE][i];
-		s_adjacentFilesForward[Color::BLACK][i] = s_adjacentFiles[i.getFile()] & s_threeFilesForward[Color::BLACK][i];
-
 		for (Direction dir : Direction::iter()) {
 			s_pieceAttacks[PieceType::KING][i] |= sqBB.shift(dir);
 		}
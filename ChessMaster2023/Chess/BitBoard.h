@@ -74,14 +74,6 @@ public:
 	// Contains the bits between on the line that is formed by the squares (if there is)
 	static u64 s_alignedBits[Square::VALUES_COUNT][Square::VALUES_COUNT];
 
-	// [side][square]
-	// Contains the bits ahead of the square on the same file and the two adjacent files
-	static u64 s_threeFilesForward[Color::VALUES_COUNT][Square::VALUES_COUNT];
-
-	// [side][square]
-	// Contains the bits of the adjacent files ahead of the square
-	static u64 s_adjacentFilesForward[Color::VALUES_COUNT][Square::VALUES_COUNT];
-
 	// [pawn color][square]
 	// Contains a bitboard of pawn attacks from the given square
 	static u64 s_pawnAttacks[Color::VALUES_COUNT][Square::VALUES_COUNT];
@@ -332,20 +324,6 @@ public:
 		return s_adjacentFiles[file];
 	}
 
-	template<Color::Value Side>
-	CM_PURE static BitBoard threeFilesForward(const Square sq) noexcept {
-		high_assert(sq < 64);
-
-		return s_threeFilesForward[Side][sq];
-	}
-
-	template<Color::Value Side>
-	CM_PURE static BitBoard adjacentFilesForward(const Square sq) noexcept {
-		high_assert(sq < 64);
-
-		return s_adjacentFilesForward[Side][sq];
-	}
-
 	CM_PURE static BitBoard castlingInternalSquares(const Color color, const Castle castle) noexcept {
 		return s_castlingInternalSquares[color][castle];
 	}
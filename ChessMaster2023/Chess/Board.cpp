@@ -73,6 +73,31 @@ void Board::operator=(Board&& other) noexcept {
 	memset(&other, 0, sizeof(Board));
 }
 
+Board Board::clone() const {
+	Board result;
+	result.m_states = m_states;
+	result.m_material[0] = m_material[0];
+	result.m_material[1] = m_material[1];
+	result.m_score[0] = m_score[0];
+	result.m_score[1] = m_score[1];
+	result.m_moveCount = m_moveCount;
+	result.m_side = m_side;
+
+	for (auto square : Square::iter()) {
+		result.m_board[square] = m_board[square];
+	}
+
+	for (auto piece : Piece::iter()) {
+		result.m_pieces[piece] = m_pieces[piece];
+	}
+
+	for (auto color : Color::iter()) {
+		result.m_piecesByColor[color] = m_piecesByColor[color];
+	}
+
+	return result;
+}
+
 Board Board::makeInitialPosition() noexcept {
 	bool _;
 	return fromFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -", _);
@@ -284,6 +309,161 @@ Move Board::makeMoveFromString(std::string_view str) const noexcept {
 	return Move::makeNullMove();
 }
 
+Move Board::makeMoveFromSAN(std::string_view san) const noexcept {
+	// Check/mate marks and annotations
+	while (!san.empty() && std::string_view("+#!?").find(san.back()) != std::string_view::npos) {
+		san.remove_suffix(1);
+	}
+
+	MoveList moves;
+	generateMoves(moves);
+
+	// Castling
+	if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+		const bool isKingCastle = san.size() == 3;
+		for (Move m : moves) {
+			if (m.getMoveType() == MoveType::CASTLE && (m.getTo().getFile() > m.getFrom().getFile()) == isKingCastle && isLegal(m)) {
+				return m;
+			}
+		}
+
+		return Move::makeNullMove();
+	}
+
+	// Piece
+	PieceType pt = PieceType::PAWN;
+	if (!san.empty() && std::string_view("NBRQK").find(san.front()) != std::string_view::npos) {
+		pt = Piece::fromFENChar(san.front()).getType();
+		san.remove_prefix(1);
+	}
+
+	// Promotion, both e8=Q and e8Q
+	PieceType promoted = PieceType::NONE;
+	if (pt == PieceType::PAWN && !san.empty() && std::string_view("NBRQ").find(san.back()) != std::string_view::npos) {
+		promoted = Piece::fromFENChar(san.back()).getType();
+		san.remove_suffix(1);
+
+		if (!san.empty() && san.back() == '=') {
+			san.remove_suffix(1);
+		}
+	}
+
+	// Destination and disambiguation
+	if (san.size() < 2) {
+		return Move::makeNullMove();
+	}
+
+	const char toFile = san[san.size() - 2];
+	const char toRank = san[san.size() - 1];
+	if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8') {
+		return Move::makeNullMove();
+	}
+
+	const Square to = Square::fromChars(toFile, toRank);
+	san.remove_suffix(2);
+
+	char fromFile = 0;
+	char fromRank = 0;
+	for (const char ch : san) {
+		if (ch >= 'a' && ch <= 'h') {
+			fromFile = ch;
+		} else if (ch >= '1' && ch <= '8') {
+			fromRank = ch;
+		} else if (ch != 'x' && ch != ':' && ch != '-') {
+			return Move::makeNullMove();
+		}
+	}
+
+	Move result = Move::makeNullMove();
+	for (Move m : moves) {
+		const Square from = m.getFrom();
+		if (m.getTo() != to
+			|| m_board[from].getType() != pt
+			|| m.getMoveType() == MoveType::CASTLE
+			|| (fromFile && from.getFile() != File::fromFENChar(fromFile))
+			|| (fromRank && from.getRank() != Rank::fromFENChar(fromRank))
+			|| (m.getMoveType() == MoveType::PROMOTION) != (promoted != PieceType::NONE)
+			|| (promoted != PieceType::NONE && m.getPromotedPiece() != promoted)
+			|| !isLegal(m)) {
+			continue;
+		}
+
+		if (!result.isNullMove()) {
+			return Move::makeNullMove(); // Ambiguous move
+		}
+
+		result = m;
+	}
+
+	return result;
+}
+
+std::string Board::toSAN(const Move m) const noexcept {
+	const Square from = m.getFrom();
+	const Square to = m.getTo();
+	std::string result;
+
+	if (m.getMoveType() == MoveType::CASTLE) {
+		result = to.getFile() > from.getFile() ? "O-O" : "O-O-O";
+	} else {
+		const PieceType pt = m_board[from].getType();
+		const bool isCapture = m_board[to] != Piece::NONE || m.getMoveType() == MoveType::ENPASSANT;
+
+		if (pt == PieceType::PAWN) {
+			if (isCapture) {
+				result += from.toString()[0];
+			}
+		} else {
+			result += char(toupper(pt.toChar()));
+
+			// Disambiguation by the file, the rank, or both
+			bool isAmbiguous = false;
+			bool isFileShared = false;
+			bool isRankShared = false;
+
+			MoveList moves;
+			generateMoves(moves);
+			for (Move other : moves) {
+				if (other.getTo() != to || other.getFrom() == from || m_board[other.getFrom()].getType() != pt || !isLegal(other)) {
+					continue;
+				}
+
+				isAmbiguous = true;
+				isFileShared |= other.getFrom().getFile() == from.getFile();
+				isRankShared |= other.getFrom().getRank() == from.getRank();
+			}
+
+			if (isAmbiguous) {
+				const std::string fromStr = from.toString();
+				if (!isFileShared) {
+					result += fromStr[0];
+				} else if (!isRankShared) {
+					result += fromStr[1];
+				} else {
+					result += fromStr;
+				}
+			}
+		}
+
+		if (isCapture) {
+			result += 'x';
+		}
+
+		result += to.toString();
+
+		if (m.getMoveType() == MoveType::PROMOTION) {
+			result += '=';
+			result += char(toupper(m.getPromotedPiece().toChar()));
+		}
+	}
+
+	if (givesCheck(m)) {
+		result += '+';
+	}
+
+	return result;
+}
+
 bool Board::isLegal(const Move m) const noexcept {
 	const Square from = m.getFrom();
 	const Square to = m.getTo();
@@ -346,7 +526,7 @@ void Board::makeMove(const Move m) noexcept {
 	st.ep = Square::NO_POS;
 	++m_moveCount;
 	m_side = Color(Side).getOpposite();
-	st.hash ^= zobrist::MOVE_KEY;
+	st.hash ^= zobrist::SIDE[Color::WHITE] ^ zobrist::SIDE[Color::BLACK];
 
 	// Changes by move type
 
@@ -389,11 +569,13 @@ void Board::makeMove(const Move m) noexcept {
 	} break;
 	case MoveType::ENPASSANT: {
 		constexpr Piece OurPawn = Piece(Side, PieceType::PAWN);
+		constexpr Piece TheirPawn = Piece(Color(Side).getOpposite(), PieceType::PAWN);
 
 		doEnpassant<Side, true>(from, to);
 
 		st.fiftyRule = 0;
-		st.hash ^= zobrist::PIECE[OurPawn][from] ^ zobrist::PIECE[OurPawn][to];
+		st.hash ^= zobrist::PIECE[OurPawn][from] ^ zobrist::PIECE[OurPawn][to]
+			^ zobrist::PIECE[TheirPawn][Square(to.getFile(), from.getRank())];
 	} break;
 	case MoveType::CASTLE: {
 		constexpr Piece OurKing = Piece(Side, PieceType::KING);
@@ -724,6 +906,9 @@ Value Board::SEE(const Move m) const noexcept {
 	default: return 0;
 	}
 
+	// The captured piece can neither attack nor pin anymore
+	occ.clear(to);
+
 	// The actual SEE algorithm starts here
 	Value valuesArr[36] = { result };
 	i32 i = 0;
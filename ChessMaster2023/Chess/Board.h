@@ -79,6 +79,9 @@ public:
 
 	void operator=(Board&& other) noexcept;
 
+	// The boards are only copied explicitly, with the whole history
+	Board clone() const;
+
 
 	///  FEN  ///
 
@@ -94,6 +97,14 @@ public:
 	// Returns null move if the move is illegal
 	Move makeMoveFromString(std::string_view str) const noexcept;
 
+	// Parses a move in the Standard Algebraic Notation, like Nbd7, exf8=Q+ or O-O
+	// Returns null move if the move is illegal or ambiguous
+	Move makeMoveFromSAN(std::string_view san) const noexcept;
+
+	// Writes a legal move in the Standard Algebraic Notation
+	// Checks are marked with +, but mates are not told apart from them
+	std::string toSAN(const Move m) const noexcept;
+
 
 	///  OPERATORS  ///
 
@@ -472,7 +483,6 @@ public:
 
 	CM_PURE Hash computeHash() const noexcept {
 		return hash()
-			^ zobrist::SIDE[m_side]
 			^ (state().ep != Square::NO_POS ? zobrist::EP[state().ep.getFile()] : 0ull)
 			^ zobrist::CASTLING[state().castleRight];
 	}
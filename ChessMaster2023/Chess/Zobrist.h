@@ -29,6 +29,5 @@ namespace zobrist {
 	extern const Hash EP[File::VALUES_COUNT];
 	extern const Hash CASTLING[64];
 
-	inline constexpr Hash MOVE_KEY = 0x54ca3eb5b5f3cb5bull;
 	inline constexpr Hash NULL_MOVE_KEY = 0x08d9bc25bebf91b1ull;
 }
\ No newline at end of file
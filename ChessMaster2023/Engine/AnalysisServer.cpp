@@ -0,0 +1,506 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "AnalysisServer.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+
+#include "Utils/StringUtils.h"
+#include "Chess/Board.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+namespace engine {
+	///  JSON  ///
+
+	using JsonObject = std::unordered_map<std::string, std::string>;
+
+	// Parses a flat JSON object with string, number and literal values, the values are kept as strings
+	// Returns false on a syntax error or a nested value
+	bool parseJsonObject(std::string_view str, JsonObject& result) {
+		size_t i = 0;
+		const auto skipSpaces = [&]() {
+			while (i < str.size() && isspace(str[i])) {
+				++i;
+			}
+		};
+
+		const auto parseString = [&](std::string& out) {
+			out.clear();
+			if (i >= str.size() || str[i] != '"') {
+				return false;
+			}
+
+			for (++i; i < str.size() && str[i] != '"'; ++i) {
+				if (str[i] == '\\' && ++i < str.size()) {
+					switch (str[i]) {
+					case 'n': out += '\n'; break;
+					case 't': out += '\t'; break;
+					case 'r': out += '\r'; break;
+					default: out += str[i]; break;
+					}
+				} else {
+					out += str[i];
+				}
+			}
+
+			return i++ < str.size();
+		};
+
+		result.clear();
+		skipSpaces();
+		if (i >= str.size() || str[i++] != '{') {
+			return false;
+		}
+
+		std::string key;
+		std::string value;
+		for (skipSpaces(); i < str.size() && str[i] != '}'; skipSpaces()) {
+			if (!parseString(key)) {
+				return false;
+			}
+
+			skipSpaces();
+			if (i >= str.size() || str[i++] != ':') {
+				return false;
+			}
+
+			skipSpaces();
+			if (i < str.size() && str[i] == '"') {
+				if (!parseString(value)) {
+					return false;
+				}
+			} else {
+				const size_t start = i;
+				while (i < str.size() && (isalnum(str[i]) || str[i] == '-' || str[i] == '+' || str[i] == '.')) {
+					++i;
+				}
+
+				if (start == i) {
+					return false; // Nested objects and arrays are not supported
+				}
+
+				value = str.substr(start, i - start);
+			}
+
+			result[key] = value;
+
+			skipSpaces();
+			if (i < str.size() && str[i] == ',') {
+				++i;
+			}
+		}
+
+		return i < str.size();
+	}
+
+	std::string escapeJson(std::string_view str) {
+		std::string result;
+		for (const char ch : str) {
+			if (ch == '"' || ch == '\\') {
+				result += '\\';
+			}
+
+			result += ch;
+		}
+
+		return result;
+	}
+
+	// Returns false if the field is present but is not a number
+	template<typename T>
+	bool getJsonNumber(const JsonObject& object, const std::string& key, T& value) {
+		const auto it = object.find(key);
+		if (it == object.end()) {
+			return true;
+		}
+
+		const std::string& str = it->second;
+		return std::from_chars(str.data(), str.data() + str.size(), value).ec == std::errc();
+	}
+
+
+	///  SERVER  ///
+
+	time_t steadyMilliseconds() {
+		using namespace std::chrono;
+		return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	struct ServerSettings final {
+		u32 threads = std::max(1u, std::thread::hardware_concurrency());
+		size_t hashMegabytes = TranspositionTable::DEFAULT_TABLE_SIZE / (1024 * 1024);
+		size_t cacheSize = 4096;
+	};
+
+	struct ServerRequest final {
+		u64 order; // The number of the request in the order of arrival
+		std::string id;
+		std::string fen;
+		u32 depth = 0;
+		NodesCount nodes = 0;
+		time_t moveTime = 0;
+		u32 multiPV = 1;
+		i32 priority = 0;
+		time_t deadline = 0; // Absolute, in steadyMilliseconds(), 0 for no deadline
+
+		// The key of the result in the cache: the position without the move counters and the limits
+		std::string cacheKey() const {
+			const std::vector<std::string_view> tokens = str_utils::split(fen, " ");
+			std::string key;
+			for (size_t i = 0; i < std::min<size_t>(4, tokens.size()); i++) {
+				key.append(tokens[i]).append(" ");
+			}
+
+			return key + std::to_string(depth) + ' ' + std::to_string(nodes) + ' ' + std::to_string(moveTime) + ' ' + std::to_string(multiPV);
+		}
+	};
+
+	// The requests with a higher priority come first, then the ones that came earlier
+	struct ServerRequestOrder final {
+		bool operator()(const ServerRequest& a, const ServerRequest& b) const noexcept {
+			return a.priority != b.priority ? a.priority < b.priority : a.order > b.order;
+		}
+	};
+
+	class AnalysisServer final {
+	private:
+		const ServerSettings& m_settings;
+
+		// The queue of the requests
+		std::mutex m_queueMutex;
+		std::condition_variable m_requestAdded;
+		std::priority_queue<ServerRequest, std::vector<ServerRequest>, ServerRequestOrder> m_queue;
+		bool m_isClosed = false;
+
+		// The LRU cache of the results, the most recently used are in the front
+		// Only the result line is stored, without "cached" and the id
+		std::mutex m_cacheMutex;
+		std::list<std::pair<std::string, std::string>> m_cache;
+		std::unordered_map<std::string, decltype(m_cache)::iterator> m_cacheIndex;
+
+		std::mutex m_outMutex;
+
+	public:
+		explicit AnalysisServer(const ServerSettings& settings) : m_settings(settings) { }
+
+		void run() {
+			std::vector<std::thread> workers;
+			for (u32 i = 0; i < m_settings.threads; i++) {
+				workers.emplace_back([this, i]() {
+					bindSearchThread(i);
+					work();
+				});
+			}
+
+			std::string line;
+			JsonObject object;
+			for (u64 order = 0; std::getline(std::cin, line); order++) {
+				if (line.find_first_not_of(" \t\r") == std::string::npos) {
+					continue;
+				}
+
+				if (!parseJsonObject(line, object)) {
+					writeError("", "incorrect JSON");
+					continue;
+				}
+
+				if (object["cmd"] == "quit") {
+					break;
+				}
+
+				ServerRequest request { .order = order };
+				if (std::string error; !parseRequest(object, request, error)) {
+					writeError(request.id, error);
+					continue;
+				}
+
+				if (const std::string cached = findCached(request.cacheKey()); !cached.empty()) {
+					writeLine("{\"id\": \"" + escapeJson(request.id) + "\", " + cached + ", \"cached\": true}");
+					continue;
+				}
+
+				std::lock_guard lock(m_queueMutex);
+				m_queue.push(std::move(request));
+				m_requestAdded.notify_one();
+			}
+
+			{
+				std::lock_guard lock(m_queueMutex);
+				m_isClosed = true;
+				m_requestAdded.notify_all();
+			}
+
+			for (std::thread& worker : workers) {
+				worker.join();
+			}
+		}
+
+	private:
+		static bool parseRequest(const JsonObject& object, ServerRequest& request, std::string& error) {
+			if (const auto it = object.find("id"); it != object.end()) {
+				request.id = it->second;
+			}
+
+			const auto fen = object.find("fen");
+			if (fen == object.end()) {
+				error = "no fen";
+				return false;
+			}
+
+			request.fen = fen->second;
+
+			time_t deadline = 0;
+			if (!getJsonNumber(object, "depth", request.depth)
+				|| !getJsonNumber(object, "nodes", request.nodes)
+				|| !getJsonNumber(object, "movetime", request.moveTime)
+				|| !getJsonNumber(object, "multipv", request.multiPV)
+				|| !getJsonNumber(object, "priority", request.priority)
+				|| !getJsonNumber(object, "deadline", deadline)) {
+				error = "incorrect number";
+				return false;
+			}
+
+			if (!request.depth && !request.nodes && !request.moveTime) {
+				error = "no depth, nodes or movetime";
+				return false;
+			}
+
+			bool success;
+			Board board = Board::fromFEN(request.fen, success);
+			if (!success) {
+				error = "incorrect fen";
+				return false;
+			}
+
+			request.depth = std::min<u32>(request.depth, MAX_DEPTH);
+			request.multiPV = std::max(1u, request.multiPV);
+			request.deadline = deadline > 0 ? steadyMilliseconds() + deadline : 0;
+			return true;
+		}
+
+		void writeLine(const std::string& line) {
+			std::lock_guard lock(m_outMutex);
+			std::cout << line << std::endl;
+		}
+
+		void writeError(const std::string& id, std::string_view error) {
+			writeLine("{\"id\": \"" + escapeJson(id) + "\", \"type\": \"error\", \"error\": \"" + escapeJson(error) + "\"}");
+		}
+
+		std::string findCached(const std::string& key) {
+			std::lock_guard lock(m_cacheMutex);
+			const auto it = m_cacheIndex.find(key);
+			if (it == m_cacheIndex.end()) {
+				return "";
+			}
+
+			m_cache.splice(m_cache.begin(), m_cache, it->second);
+			return it->second->second;
+		}
+
+		void addCached(const std::string& key, std::string result) {
+			std::lock_guard lock(m_cacheMutex);
+			if (m_cacheIndex.contains(key) || !m_settings.cacheSize) {
+				return;
+			}
+
+			m_cache.emplace_front(key, std::move(result));
+			m_cacheIndex[key] = m_cache.begin();
+
+			if (m_cache.size() > m_settings.cacheSize) {
+				m_cacheIndex.erase(m_cache.back().first);
+				m_cache.pop_back();
+			}
+		}
+
+		// The worker thread: takes the requests until the server is closed
+		void work() {
+			g_reporting.checkInput = false;
+			g_reporting.isAnalysis = true;
+			initSearch();
+
+			while (true) {
+				ServerRequest request;
+				{
+					std::unique_lock lock(m_queueMutex);
+					m_requestAdded.wait(lock, [this]() { return m_isClosed || !m_queue.empty(); });
+					if (m_queue.empty()) {
+						break;
+					}
+
+					request = m_queue.top();
+					m_queue.pop();
+				}
+
+				// Repeated requests could have been queued before the first one was answered
+				if (const std::string cached = findCached(request.cacheKey()); !cached.empty()) {
+					writeLine("{\"id\": \"" + escapeJson(request.id) + "\", " + cached + ", \"cached\": true}");
+					continue;
+				}
+
+				time_t timeLeft = 0;
+				if (request.deadline) {
+					timeLeft = request.deadline - steadyMilliseconds();
+					if (timeLeft <= 0) {
+						writeError(request.id, "deadline expired");
+						continue;
+					}
+				}
+
+				analyze(request, timeLeft);
+			}
+
+			g_reporting = SearchReporting();
+		}
+
+		// Searches every line of the multi-PV and writes the result
+		void analyze(const ServerRequest& request, const time_t timeLeft) {
+			const time_t start = steadyMilliseconds();
+			const std::string id = escapeJson(request.id);
+
+			bool success;
+			Board board = Board::fromFEN(request.fen, success);
+
+			// Multi-PV cannot have more lines than there are legal moves
+			u32 legalMovesCount = 0;
+			MoveList moves;
+			board.generateMoves(moves);
+			for (Move m : moves) {
+				legalMovesCount += board.isLegal(m);
+			}
+
+			std::string lines;
+			std::string pv;
+			Depth depth = 0;
+			Move best = Move::makeNullMove();
+			NodesCount nodes = 0;
+
+			g_excludedRootMoves.clear();
+			for (u32 line = 1; line <= std::min(request.multiPV, legalMovesCount); line++) {
+				g_reporting.onIteration = [&](const IterationInfo& info) {
+					pv = info.pv.toString();
+					pv.erase(pv.find_last_not_of(' ') + 1);
+					depth = info.depth;
+
+					writeLine("{\"id\": \"" + id + "\", \"type\": \"info\", \"multipv\": " + std::to_string(line)
+						+ ", \"depth\": " + std::to_string(info.depth)
+						+ ", \"score\": \"" + scoreToString(info.value)
+						+ "\", \"nodes\": " + std::to_string(nodes + info.nodes)
+						+ ", \"time\": " + std::to_string(steadyMilliseconds() - start)
+						+ ", \"pv\": \"" + pv + "\"}");
+				};
+
+				// Every line is given an equal share of the time
+				const time_t lineTimeLeft = request.deadline ? std::max<time_t>(1, request.deadline - steadyMilliseconds()) : 0;
+				const time_t moveTime = request.moveTime && lineTimeLeft
+					? std::min(request.moveTime, lineTimeLeft)
+					: std::max(request.moveTime, lineTimeLeft);
+
+				g_limits.makeInfinite();
+				if (moveTime) {
+					const time_t lineTime = std::max<time_t>(1, moveTime / (std::min(request.multiPV, legalMovesCount) - line + 1));
+					g_limits.setTimeLimitsInMs(0, 0, lineTime);
+					g_limits.reset(lineTime);
+				}
+
+				if (request.depth) {
+					g_limits.setDepthLimit(Depth(request.depth));
+				}
+
+				if (request.nodes) {
+					g_limits.setNodesLimit(request.nodes);
+				}
+
+				pv.clear();
+				depth = 0;
+				const SearchResult result = rootSearch(board);
+				nodes += getNodesCount();
+
+				if (result.best.isNullMove()) {
+					break;
+				}
+
+				if (line == 1) {
+					best = result.best;
+				}
+
+				lines.append(lines.empty() ? "" : ", ")
+					.append("{\"multipv\": ").append(std::to_string(line))
+					.append(", \"depth\": ").append(std::to_string(depth))
+					.append(", \"score\": \"").append(scoreToString(result.value))
+					.append("\", \"pv\": \"").append(pv).append("\"}");
+
+				g_excludedRootMoves.push_back(result.best);
+			}
+
+			g_excludedRootMoves.clear();
+			g_reporting.onIteration = nullptr;
+
+			std::string result = "\"type\": \"result\", \"bestmove\": \"" + (best.isNullMove() ? std::string("0000") : best.toString())
+				+ "\", \"lines\": [" + lines + "], \"nodes\": " + std::to_string(nodes)
+				+ ", \"time\": " + std::to_string(steadyMilliseconds() - start);
+
+			writeLine("{\"id\": \"" + id + "\", " + result + ", \"cached\": false}");
+
+			// The results cut by the deadline are not what the same request would get again
+			if (!timeLeft || (request.moveTime && request.moveTime <= timeLeft)) {
+				addCached(request.cacheKey(), std::move(result));
+			}
+		}
+	};
+
+	bool runAnalysisServer(const std::vector<std::string>& args) {
+		ServerSettings settings;
+		for (size_t i = 0; i < args.size(); i++) {
+			if (i + 1 >= args.size()) {
+				std::cerr << "No value for " << args[i] << std::endl;
+				return false;
+			}
+
+			const std::string& arg = args[i];
+			const std::string& value = args[++i];
+
+			if (arg == "--threads") {
+				settings.threads = std::max(1u, str_utils::fromString<u32>(value));
+			} else if (arg == "--hash") {
+				settings.hashMegabytes = std::max<size_t>(1, str_utils::fromString<u32>(value));
+			} else if (arg == "--cache") {
+				settings.cacheSize = str_utils::fromString<u32>(value);
+			} else {
+				std::cerr << "Unknown argument: " << arg << std::endl
+					<< "Usage: serve [--threads N] [--hash MB] [--cache N]" << std::endl;
+				return false;
+			}
+		}
+
+		TranspositionTable::init(settings.hashMegabytes * 1024 * 1024);
+
+		AnalysisServer server(settings);
+		server.run();
+		return true;
+	}
+}
@@ -0,0 +1,48 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+
+/*
+*	AnalysisServer(.h/.cpp) contains the resident analysis service:
+*		ChessMaster2023 serve [--threads N] [--hash MB] [--cache N]
+*
+*	The requests are read from stdin as newline-delimited JSON objects:
+*		{"id": "a1", "fen": "<FEN>", "depth": 12, "nodes": 100000, "movetime": 500, "multipv": 3, "priority": 1, "deadline": 2000}
+*	Only the FEN and at least one of depth/nodes/movetime are required.
+*	The deadline is in milliseconds since the request was received: a request that was not started by then
+*	is rejected, and a started one is given no more time than is left.
+*
+*	The requests are scheduled onto a fixed pool of workers by priority (higher first), then by arrival.
+*	The transposition table is kept between the requests, and the results of repeated requests
+*	are answered from an LRU cache.
+*
+*	The answers are written to stdout as JSON lines:
+*		{"id": "a1", "type": "info", "multipv": 1, "depth": 5, "score": "cp 15", "nodes": 1234, "time": 3, "pv": "e2e4 e7e5"}
+*		{"id": "a1", "type": "result", "bestmove": "e2e4", "lines": [...], "nodes": 5678, "time": 12, "cached": false}
+*		{"id": "a1", "type": "error", "error": "<message>"}
+*	{"cmd": "quit"} or the end of the input stops the server once all the accepted requests are answered.
+*/
+
+namespace engine {
+	// Runs the server with the command line arguments following "serve"
+	// Returns false on incorrect arguments
+	bool runAnalysisServer(const std::vector<std::string>& args);
+}
@@ -0,0 +1,449 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Annotation.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "Utils/StringUtils.h"
+#include "Chess/Board.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+namespace engine {
+	struct AnnotationSettings final {
+		std::string inFileName;
+		std::string outFileName;
+		Depth depth = 0;
+		NodesCount nodes = 0;
+		time_t moveTime = 0;
+		u32 jobs = std::max(1u, std::thread::hardware_concurrency());
+		size_t hashMegabytes = TranspositionTable::DEFAULT_TABLE_SIZE / (1024 * 1024);
+		Value blunder = 200;
+	};
+
+	// A game as it was read from PGN, the variations and the comments are dropped
+	struct PgnGame final {
+		std::vector<std::string> tags;
+		std::string fen;
+		std::vector<std::string> moves;
+		std::string result = "*";
+	};
+
+	// The evaluation of a position of the game from the point of view of the side to move
+	struct PositionAnalysis final {
+		Value value = 0;
+		Move best = Move::makeNullMove();
+		Depth depth = 0;
+	};
+
+
+	///  PGN  ///
+
+	std::vector<PgnGame> readPgnGames(std::istream& in) {
+		const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+		std::vector<PgnGame> games;
+		PgnGame game;
+		bool hasGame = false;
+
+		const auto finishGame = [&]() {
+			if (hasGame) {
+				games.push_back(std::move(game));
+			}
+
+			game = PgnGame();
+			hasGame = false;
+		};
+
+		for (size_t i = 0; i < text.size(); ) {
+			const char ch = text[i];
+
+			if (isspace(ch)) {
+				++i;
+			} else if (ch == '[') { // Tag
+				if (!game.moves.empty()) { // A game without the result
+					finishGame();
+				}
+
+				const size_t end = std::min(text.find('\n', i), text.size());
+				std::string tag = text.substr(i, end - i);
+				tag.erase(tag.find_last_not_of(" \t\r") + 1);
+
+				if (tag.starts_with("[FEN ")) {
+					const size_t from = tag.find('"');
+					const size_t to = tag.rfind('"');
+					if (from != std::string::npos && to > from) {
+						game.fen = tag.substr(from + 1, to - from - 1);
+					}
+				}
+
+				game.tags.push_back(std::move(tag));
+				hasGame = true;
+				i = end;
+			} else if (ch == '{') { // Comment
+				i = std::min(text.find('}', i), text.size()) + 1;
+			} else if (ch == ';' || ch == '%') { // Comment till the end of the line
+				i = std::min(text.find('\n', i), text.size());
+			} else if (ch == '(') { // Variation
+				for (u32 level = 0; i < text.size(); ++i) {
+					if (text[i] == '(') {
+						++level;
+					} else if (text[i] == ')' && --level == 0) {
+						++i;
+						break;
+					} else if (text[i] == '{') {
+						i = std::min(text.find('}', i), text.size());
+					}
+				}
+			} else {
+				const size_t end = std::min(text.find_first_of(" \t\r\n{}();", i), text.size());
+				std::string_view token = std::string_view(text).substr(i, std::max<size_t>(1, end - i));
+				i += token.size();
+
+				if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+					game.result = token;
+					hasGame = true;
+					finishGame();
+					continue;
+				}
+
+				if (token[0] == '$') { // Numeric annotation glyph
+					continue;
+				}
+
+				// Move number, like 12. or 12...
+				while (!token.empty() && (str_utils::isDigit(token[0]) || token[0] == '.')) {
+					token.remove_prefix(1);
+				}
+
+				if (!token.empty()) {
+					game.moves.emplace_back(token);
+					hasGame = true;
+				}
+			}
+		}
+
+		finishGame();
+		return games;
+	}
+
+	// Evaluation in pawns from White's point of view, like +0.35 or #-3
+	std::string evaluationToString(const Value value, const Color side) {
+		const Value whiteValue = side == Color::WHITE ? value : Value(-value);
+		if (isMateValue(whiteValue)) {
+			const i32 moves = whiteValue < 0 ? -i32(gettingMatedIn(whiteValue)) : i32(givingMateIn(whiteValue));
+			return "#" + std::to_string(moves);
+		}
+
+		std::ostringstream out;
+		out.setf(std::ios::fixed);
+		out.precision(2);
+		out << (whiteValue >= 0 ? "+" : "") << whiteValue / 100.0;
+		return out.str();
+	}
+
+
+	///  ANNOTATION  ///
+
+	class Annotator final {
+	private:
+		const AnnotationSettings& m_settings;
+
+	public:
+		explicit Annotator(const AnnotationSettings& settings) : m_settings(settings) { }
+
+		std::string annotate(const PgnGame& game, u32& positionsCount) {
+			bool success;
+			Board board = Board::fromFEN(game.fen.empty() ? "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" : game.fen, success);
+
+			std::string text;
+			for (const std::string& tag : game.tags) {
+				text.append(tag).append("\n");
+			}
+
+			text.append("\n");
+			if (!success) {
+				return text + "{Incorrect FEN} " + game.result + "\n\n";
+			}
+
+			// Playing the game forward
+			std::vector<Move> moves;
+			std::vector<std::string> sans;
+			std::vector<Color> sides;
+			std::vector<u32> moveNumbers;
+			std::string error;
+
+			for (const std::string& token : game.moves) {
+				Move m = board.makeMoveFromSAN(token);
+				if (m.isNullMove() && isCoordinateMove(token)) {
+					m = board.makeMoveFromString(token);
+				}
+
+				if (m.isNullMove()) {
+					error = "{Illegal move " + token + ", the rest of the game is skipped} ";
+					break;
+				}
+
+				const std::string fen = board.toFEN();
+				moveNumbers.push_back(str_utils::fromString<u32>(fen.substr(fen.rfind(' ') + 1)));
+				sides.push_back(board.side());
+				sans.push_back(board.toSAN(m));
+
+				board.makeMove(m);
+				moves.push_back(m);
+
+				if (board.isInCheck() && !hasLegalMoves(board)) {
+					sans.back().back() = '#';
+				}
+			}
+
+			// Walking backwards, so that every position is searched after its successor
+			std::vector<PositionAnalysis> analysis(moves.size() + 1);
+			for (size_t i = moves.size() + 1; i-- > 0; ) {
+				if (i < moves.size()) {
+					board.unmakeMove(moves[i]);
+				}
+
+				analysis[i] = analyzePosition(board);
+				++positionsCount;
+			}
+
+			// Writing the moves with the evaluations
+			std::string line;
+			const auto addToken = [&](const std::string& token) {
+				if (!line.empty() && line.size() + token.size() + 1 > 80) {
+					text.append(line).append("\n");
+					line.clear();
+				}
+
+				line.append(line.empty() ? "" : " ").append(token);
+			};
+
+			for (size_t i = 0; i < moves.size(); i++) {
+				const Color side = sides[i];
+				addToken(std::to_string(moveNumbers[i]) + (side == Color::WHITE ? "." : "..."));
+
+				// The loss of the move from the point of view of its side
+				const Value before = std::clamp<Value>(analysis[i].value, -SURE_WIN / 10, SURE_WIN / 10);
+				const Value after = std::clamp<Value>(Value(-analysis[i + 1].value), -SURE_WIN / 10, SURE_WIN / 10);
+				const Value drop = before - after;
+
+				const bool isBest = analysis[i].best.getData() == moves[i].getData();
+				const bool isBlunder = !isBest && drop >= m_settings.blunder;
+				const bool isMistake = !isBest && !isBlunder && drop >= m_settings.blunder / 2;
+
+				addToken(sans[i] + (isBlunder ? "??" : isMistake ? "?" : ""));
+
+				std::string comment = "{" + evaluationToString(analysis[i + 1].value, side.getOpposite())
+					+ "/" + std::to_string(analysis[i + 1].depth);
+				if ((isBlunder || isMistake) && !analysis[i].best.isNullMove()) {
+					comment += std::string(isBlunder ? " blunder" : " mistake") + ", best " + board.toSAN(analysis[i].best)
+						+ " " + evaluationToString(analysis[i].value, side);
+				}
+
+				addToken(comment + "}");
+				board.makeMove(moves[i]);
+			}
+
+			if (!error.empty()) {
+				addToken(error.substr(0, error.size() - 1));
+			}
+
+			addToken(game.result);
+			text.append(line).append("\n\n");
+			return text;
+		}
+
+	private:
+		// Some PGN writers use the coordinate notation, like e2e4 or e7e8q
+		static bool isCoordinateMove(std::string_view token) noexcept {
+			return (token.size() == 4 || token.size() == 5)
+				&& token[0] >= 'a' && token[0] <= 'h' && token[1] >= '1' && token[1] <= '8'
+				&& token[2] >= 'a' && token[2] <= 'h' && token[3] >= '1' && token[3] <= '8';
+		}
+
+		static bool hasLegalMoves(const Board& board) {
+			MoveList moves;
+			board.generateMoves(moves);
+			return std::any_of(moves.begin(), moves.end(), [&board](const Move m) { return board.isLegal(m); });
+		}
+
+		PositionAnalysis analyzePosition(Board& board) {
+			PositionAnalysis result;
+			if (!hasLegalMoves(board)) {
+				result.value = board.isInCheck() ? -MATE : 0;
+				return result;
+			}
+
+			g_reporting.onIteration = [&result](const IterationInfo& info) {
+				result.depth = info.depth;
+			};
+
+			g_limits.makeInfinite();
+			if (m_settings.moveTime) {
+				g_limits.setTimeLimitsInMs(0, 0, m_settings.moveTime);
+				g_limits.reset(m_settings.moveTime);
+			}
+
+			if (m_settings.depth) {
+				g_limits.setDepthLimit(m_settings.depth);
+			}
+
+			if (m_settings.nodes) {
+				g_limits.setNodesLimit(m_settings.nodes);
+			}
+
+			const SearchResult searchResult = rootSearch(board);
+			result.value = searchResult.value;
+			result.best = searchResult.best;
+			return result;
+		}
+	};
+
+	bool parseAnnotationArgs(const std::vector<std::string>& args, AnnotationSettings& settings) {
+		for (size_t i = 0; i < args.size(); i++) {
+			if (i + 1 >= args.size()) {
+				std::cerr << "No value for " << args[i] << std::endl;
+				return false;
+			}
+
+			const std::string& arg = args[i];
+			const std::string& value = args[++i];
+
+			if (arg == "--in") {
+				settings.inFileName = value;
+			} else if (arg == "--out") {
+				settings.outFileName = value;
+			} else if (arg == "--depth") {
+				settings.depth = Depth(std::min<u32>(str_utils::fromString<u32>(value), MAX_DEPTH));
+			} else if (arg == "--nodes") {
+				settings.nodes = str_utils::fromString<NodesCount>(value);
+			} else if (arg == "--movetime") {
+				settings.moveTime = time_t(str_utils::fromString<u32>(value));
+			} else if (arg == "--jobs") {
+				settings.jobs = std::max(1u, str_utils::fromString<u32>(value));
+			} else if (arg == "--hash") {
+				settings.hashMegabytes = std::max<size_t>(1, str_utils::fromString<u32>(value));
+			} else if (arg == "--blunder") {
+				settings.blunder = Value(std::max(1u, str_utils::fromString<u32>(value)));
+			} else {
+				std::cerr << "Unknown argument: " << arg << std::endl;
+				return false;
+			}
+		}
+
+		if (settings.inFileName.empty() || (!settings.depth && !settings.nodes && !settings.moveTime)) {
+			std::cerr << "Usage: annotate --in <pgn> [--out <pgn>] --depth N|--nodes N|--movetime MS [--jobs J] [--hash MB] [--blunder CP]" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool runAnnotation(const std::vector<std::string>& args) {
+		AnnotationSettings settings;
+		if (!parseAnnotationArgs(args, settings)) {
+			return false;
+		}
+
+		std::ifstream in(settings.inFileName);
+		if (!in.is_open()) {
+			std::cerr << "Cannot open the input file: " << settings.inFileName << std::endl;
+			return false;
+		}
+
+		std::ofstream outFile;
+		if (!settings.outFileName.empty()) {
+			outFile.open(settings.outFileName);
+			if (!outFile.is_open()) {
+				std::cerr << "Cannot open the output file: " << settings.outFileName << std::endl;
+				return false;
+			}
+		}
+
+		std::ostream& out = settings.outFileName.empty() ? std::cout : outFile;
+		const std::vector<PgnGame> games = readPgnGames(in);
+
+		TranspositionTable::init(settings.hashMegabytes * 1024 * 1024);
+
+		// The games are annotated in parallel and written in order
+		std::vector<std::string> annotated(games.size());
+		std::vector<bool> isReady(games.size());
+		std::atomic<u32> nextGame = 0;
+		std::atomic<u32> positionsCount = 0;
+		std::mutex mutex;
+		std::condition_variable gameAnnotated;
+
+		const auto work = [&]() {
+			g_reporting.checkInput = false;
+			g_reporting.isAnalysis = true;
+			initSearch();
+
+			Annotator annotator(settings);
+			for (u32 i; (i = nextGame++) < games.size(); ) {
+				u32 positions = 0;
+				std::string text = annotator.annotate(games[i], positions);
+				positionsCount += positions;
+
+				std::lock_guard lock(mutex);
+				annotated[i] = std::move(text);
+				isReady[i] = true;
+				gameAnnotated.notify_one();
+			}
+
+			g_reporting = SearchReporting();
+		};
+
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> workers;
+		for (u32 i = 0; i < std::min<u32>(settings.jobs, std::max<u32>(1, u32(games.size()))); i++) {
+			workers.emplace_back([&work, i]() {
+				bindSearchThread(i);
+				work();
+			});
+		}
+
+		for (size_t i = 0; i < games.size(); i++) {
+			std::unique_lock lock(mutex);
+			gameAnnotated.wait(lock, [&]() { return isReady[i]; });
+
+			const std::string text = std::move(annotated[i]);
+			lock.unlock();
+
+			out << text << std::flush;
+		}
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+		const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		std::cerr << "Annotated " << games.size() << " games, " << positionsCount << " positions with " << settings.jobs
+			<< " jobs in " << ms / 1000.0 << " seconds" << std::endl;
+
+		return true;
+	}
+}
@@ -0,0 +1,39 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+
+/*
+*	Annotation(.h/.cpp) contains the annotation of whole games:
+*		ChessMaster2023 annotate --in games.pgn [--out annotated.pgn] --depth N|--nodes N|--movetime MS [--jobs J] [--hash MB] [--blunder CP]
+*
+*	Every game is walked backwards from the final position, so each position is searched
+*	while the transposition table is still warm from the search of its successor.
+*	Every move gets a comment with the evaluation (from White's point of view) and the depth.
+*	The moves that drop the evaluation by at least the blunder threshold (200 cp by default) are marked with ??,
+*	by a half of it - with ?, and the best move is given for them.
+*	The games are annotated in parallel by J threads and written in the order of the input.
+*/
+
+namespace engine {
+	// Runs the annotation with the command line arguments following "annotate"
+	// Returns false on incorrect arguments or if the files cannot be opened
+	bool runAnnotation(const std::vector<std::string>& args);
+}
@@ -0,0 +1,292 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "BatchAnalysis.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "Utils/StringUtils.h"
+#include "Chess/Board.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+namespace engine {
+	struct BatchAnalysisSettings final {
+		std::string inFileName;
+		std::string outFileName;
+		Depth depth = 0;
+		NodesCount nodes = 0;
+		u32 jobs = std::max(1u, std::thread::hardware_concurrency());
+		size_t hashMegabytes = TranspositionTable::DEFAULT_TABLE_SIZE / (1024 * 1024);
+	};
+
+	// The state shared by the workers and the writer
+	class BatchAnalysis final {
+	private:
+		const BatchAnalysisSettings& m_settings;
+
+		// Input, the positions are numbered in the order of reading
+		std::ifstream m_in;
+		std::mutex m_inMutex;
+		u64 m_linesRead = 0;
+
+		// Output, the records wait until all the previous ones are written
+		std::ostream& m_out;
+		std::mutex m_outMutex;
+		std::condition_variable m_recordAdded;
+		std::map<u64, std::string> m_pendingRecords;
+		u32 m_workingCount = 0;
+
+		std::atomic<NodesCount> m_totalNodes = 0;
+
+	public:
+		BatchAnalysis(const BatchAnalysisSettings& settings, std::ostream& out)
+			: m_settings(settings), m_in(settings.inFileName), m_out(out) { }
+
+		CM_PURE bool isInputOpen() const noexcept {
+			return m_in.is_open();
+		}
+
+		// Returns the number of positions analyzed
+		u64 run() {
+			m_workingCount = m_settings.jobs;
+
+			std::vector<std::thread> workers;
+			for (u32 i = 0; i < m_settings.jobs; i++) {
+				workers.emplace_back([this, i]() {
+					bindSearchThread(i);
+					work();
+				});
+			}
+
+			write();
+			for (std::thread& worker : workers) {
+				worker.join();
+			}
+
+			return m_linesRead;
+		}
+
+		CM_PURE NodesCount totalNodes() const noexcept {
+			return m_totalNodes;
+		}
+
+	private:
+		// Reads the next position line, returns false at the end of the input
+		bool readLine(std::string& line, u64& index) {
+			std::lock_guard lock(m_inMutex);
+			while (std::getline(m_in, line)) {
+				if (line.empty() || line[0] == '#' || line.find_first_not_of(" \t\r") == std::string::npos) {
+					continue;
+				}
+
+				index = m_linesRead++;
+				return true;
+			}
+
+			return false;
+		}
+
+		// Takes the position from a FEN or an EPD line, completing the move counters if there are none
+		static bool parsePosition(std::string_view line, std::string& fen) {
+			const std::vector<std::string_view> tokens = str_utils::split(line, " \t\r");
+			if (tokens.size() < 4) {
+				return false;
+			}
+
+			fen.clear();
+			for (size_t i = 0; i < 4; i++) {
+				fen.append(fen.empty() ? "" : " ").append(tokens[i]);
+			}
+
+			const auto isNumber = [](std::string_view str) {
+				return std::all_of(str.begin(), str.end(), str_utils::isDigit);
+			};
+
+			if (tokens.size() >= 6 && isNumber(tokens[4]) && isNumber(tokens[5])) {
+				fen.append(" ").append(tokens[4]).append(" ").append(tokens[5]);
+			} else {
+				fen.append(" 0 1");
+			}
+
+			return true;
+		}
+
+		// The worker thread: searches the positions until the input ends
+		void work() {
+			std::string pv;
+
+			g_reporting.checkInput = false;
+			g_reporting.isAnalysis = true;
+			g_reporting.onIteration = [&pv](const IterationInfo& info) {
+				pv = info.pv.toString();
+				pv.erase(pv.find_last_not_of(' ') + 1);
+			};
+
+			initSearch();
+
+			std::string line;
+			std::string fen;
+			u64 index;
+			while (readLine(line, index)) {
+				std::string record;
+				bool success = parsePosition(line, fen);
+				Board board = success ? Board::fromFEN(fen, success) : Board();
+
+				if (!success) {
+					record = std::string(str_utils::split(line, "\r")[0]) + ",0000,,,0";
+				} else {
+					g_limits.makeInfinite();
+					if (m_settings.depth) {
+						g_limits.setDepthLimit(m_settings.depth);
+					}
+
+					if (m_settings.nodes) {
+						g_limits.setNodesLimit(m_settings.nodes);
+					}
+
+					pv.clear();
+					const SearchResult result = rootSearch(board);
+					const NodesCount nodes = getNodesCount();
+					m_totalNodes += nodes;
+
+					record = fen + ','
+						+ (result.best.isNullMove() ? "0000" : result.best.toString()) + ','
+						+ (result.best.isNullMove() ? "" : scoreToString(result.value)) + ','
+						+ pv + ','
+						+ std::to_string(nodes);
+				}
+
+				std::lock_guard lock(m_outMutex);
+				m_pendingRecords.emplace(index, std::move(record));
+				m_recordAdded.notify_one();
+			}
+
+			std::lock_guard lock(m_outMutex);
+			--m_workingCount;
+			m_recordAdded.notify_one();
+		}
+
+		// The writer: streams the records in the order of the input
+		void write() {
+			m_out << "fen,bestmove,score,pv,nodes\n";
+
+			std::unique_lock lock(m_outMutex);
+			for (u64 next = 0; ; ) {
+				m_recordAdded.wait(lock, [&]() {
+					return m_pendingRecords.contains(next) || (!m_workingCount && m_pendingRecords.empty());
+				});
+
+				if (m_pendingRecords.empty()) {
+					break;
+				}
+
+				// Writing everything that is ready without holding the workers
+				std::vector<std::string> records;
+				for (auto it = m_pendingRecords.begin(); it != m_pendingRecords.end() && it->first == next; next++) {
+					records.push_back(std::move(it->second));
+					it = m_pendingRecords.erase(it);
+				}
+
+				lock.unlock();
+				for (const std::string& record : records) {
+					m_out << record << '\n';
+				}
+
+				m_out.flush();
+				lock.lock();
+			}
+		}
+	};
+
+	bool parseBatchAnalysisArgs(const std::vector<std::string>& args, BatchAnalysisSettings& settings) {
+		for (size_t i = 0; i < args.size(); i++) {
+			if (i + 1 >= args.size()) {
+				std::cerr << "No value for " << args[i] << std::endl;
+				return false;
+			}
+
+			const std::string& arg = args[i];
+			const std::string& value = args[++i];
+
+			if (arg == "--in") {
+				settings.inFileName = value;
+			} else if (arg == "--out") {
+				settings.outFileName = value;
+			} else if (arg == "--depth") {
+				settings.depth = Depth(std::min<u32>(str_utils::fromString<u32>(value), MAX_DEPTH));
+			} else if (arg == "--nodes") {
+				settings.nodes = str_utils::fromString<NodesCount>(value);
+			} else if (arg == "--jobs") {
+				settings.jobs = std::max(1u, str_utils::fromString<u32>(value));
+			} else if (arg == "--hash") {
+				settings.hashMegabytes = std::max<size_t>(1, str_utils::fromString<u32>(value));
+			} else {
+				std::cerr << "Unknown argument: " << arg << std::endl;
+				return false;
+			}
+		}
+
+		if (settings.inFileName.empty() || (!settings.depth && !settings.nodes)) {
+			std::cerr << "Usage: analyze --in <file> [--out <file>] --depth N|--nodes N [--jobs J] [--hash MB]" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool runBatchAnalysis(const std::vector<std::string>& args) {
+		BatchAnalysisSettings settings;
+		if (!parseBatchAnalysisArgs(args, settings)) {
+			return false;
+		}
+
+		std::ofstream outFile;
+		if (!settings.outFileName.empty()) {
+			outFile.open(settings.outFileName);
+			if (!outFile.is_open()) {
+				std::cerr << "Cannot open the output file: " << settings.outFileName << std::endl;
+				return false;
+			}
+		}
+
+		BatchAnalysis analysis(settings, settings.outFileName.empty() ? std::cout : outFile);
+		if (!analysis.isInputOpen()) {
+			std::cerr << "Cannot open the input file: " << settings.inFileName << std::endl;
+			return false;
+		}
+
+		TranspositionTable::init(settings.hashMegabytes * 1024 * 1024);
+
+		const auto start = std::chrono::steady_clock::now();
+		const u64 positionsCount = analysis.run();
+		const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+		std::cerr << "Analyzed " << positionsCount << " positions with " << settings.jobs << " jobs in " << ms / 1000.0 << " seconds, "
+			<< analysis.totalNodes() << " nodes, " << (ms ? analysis.totalNodes() / ms : 0) << " kN/s" << std::endl;
+
+		return true;
+	}
+}
@@ -0,0 +1,37 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+
+/*
+*	BatchAnalysis(.h/.cpp) contains the non-interactive analysis of a file of positions:
+*		ChessMaster2023 analyze --in positions.epd [--out results.csv] --depth N|--nodes N [--jobs J] [--hash MB]
+*
+*	Every line of the input is a FEN or an EPD (the operations are ignored).
+*	The positions are searched by J worker threads, each with its own search state, sharing one transposition table.
+*	The results are written in the order of the input by a separate writer thread as CSV records:
+*		fen,bestmove,score,pv,nodes
+*/
+
+namespace engine {
+	// Runs the analysis with the command line arguments following "analyze"
+	// Returns false on incorrect arguments or if the files cannot be opened
+	bool runBatchAnalysis(const std::vector<std::string>& args);
+}
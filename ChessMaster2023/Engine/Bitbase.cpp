@@ -0,0 +1,162 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Bitbase.h"
+#include <vector>
+
+namespace engine {
+	namespace bitbase {
+		constexpr u32 KPK_PAWN_SQUARES_COUNT = 24; // Files A-D, ranks 2-7
+		constexpr u32 KPK_POSITIONS_COUNT = 2 * 64 * 64 * KPK_PAWN_SQUARES_COUNT;
+
+		u64 s_kpkWins[KPK_POSITIONS_COUNT / 64];
+
+		enum class KPKResult : u8 {
+			INVALID,
+			UNKNOWN,
+			DRAW,
+			WIN
+		};
+
+		// The pawn must be on the files A-D
+		inline u32 kpkIndex(const bool isStrongSideToMove, const Square strongKing, const Square strongPawn, const Square weakKing) noexcept {
+			const u32 pawnIndex = strongPawn.getFile() + 4 * (strongPawn.getRank() - Rank::R2);
+			return u32(!isStrongSideToMove) | (u32(weakKing) << 1) | (u32(strongKing) << 7) | (pawnIndex << 13);
+		}
+
+		KPKResult classify(const bool isStrongSideToMove, const Square strongKing, const Square strongPawn, const Square weakKing) {
+			const BitBoard strongKingAttacks = BitBoard::pseudoAttacks<PieceType::KING>(strongKing);
+			const BitBoard weakKingAttacks = BitBoard::pseudoAttacks<PieceType::KING>(weakKing);
+			const BitBoard pawnAttacks = BitBoard::pawnAttacks(Color::WHITE, strongPawn);
+
+			if (strongKingAttacks.test(weakKing) || strongKing == weakKing
+				|| strongKing == strongPawn || weakKing == strongPawn
+				|| (isStrongSideToMove && pawnAttacks.test(weakKing))) {
+				return KPKResult::INVALID;
+			}
+
+			if (isStrongSideToMove) {
+				// The pawn is promoted, and the queen cannot be captured
+				const Square promotion = strongPawn.shift(Direction::UP);
+				if (strongPawn.getRank() == Rank::R7 && promotion != strongKing && promotion != weakKing
+					&& (!weakKingAttacks.test(promotion) || strongKingAttacks.test(promotion))) {
+					return KPKResult::WIN;
+				}
+			} else {
+				// Stalemate or the pawn is captured
+				const BitBoard escapes = weakKingAttacks.b_and(strongKingAttacks.b_or(pawnAttacks).b_not());
+				if (escapes == BitBoard::EMPTY || escapes.test(strongPawn)) {
+					return KPKResult::DRAW;
+				}
+			}
+
+			return KPKResult::UNKNOWN;
+		}
+
+		// Resolves the position from its successors, leaves it unknown if they are not enough
+		KPKResult resolve(const std::vector<KPKResult>& results, const bool isStrongSideToMove, const Square strongKing, const Square strongPawn, const Square weakKing) {
+			// The side to move takes the good result from any move and the bad result only from all the moves
+			const KPKResult good = isStrongSideToMove ? KPKResult::WIN : KPKResult::DRAW;
+			const KPKResult bad = isStrongSideToMove ? KPKResult::DRAW : KPKResult::WIN;
+
+			bool isAnyUnknown = false;
+			const auto consider = [&](const KPKResult result) {
+				isAnyUnknown |= result == KPKResult::UNKNOWN;
+				return result == good;
+			};
+
+			if (isStrongSideToMove) {
+				BitBoard kingMoves = BitBoard::pseudoAttacks<PieceType::KING>(strongKing);
+				BB_FOR_EACH(to, kingMoves) {
+					if (to != strongPawn && consider(results[kpkIndex(false, to, strongPawn, weakKing)])) {
+						return good;
+					}
+				}
+
+				// The pawn on the 7th rank is promoted only if it wins at once
+				const Square push = strongPawn.shift(Direction::UP);
+				if (strongPawn.getRank() < Rank::R7 && push != strongKing && push != weakKing) {
+					if (consider(results[kpkIndex(false, strongKing, push, weakKing)])) {
+						return good;
+					}
+
+					const Square doublePush = push.shift(Direction::UP);
+					if (strongPawn.getRank() == Rank::R2 && doublePush != strongKing && doublePush != weakKing
+						&& consider(results[kpkIndex(false, strongKing, doublePush, weakKing)])) {
+						return good;
+					}
+				}
+			} else {
+				BitBoard kingMoves = BitBoard::pseudoAttacks<PieceType::KING>(weakKing);
+				BB_FOR_EACH(to, kingMoves) {
+					if (consider(results[kpkIndex(true, strongKing, strongPawn, to)])) {
+						return good;
+					}
+				}
+			}
+
+			return isAnyUnknown ? KPKResult::UNKNOWN : bad;
+		}
+
+		void init() {
+			std::vector<KPKResult> results(KPK_POSITIONS_COUNT);
+
+			// The index is decoded back into the position
+			const auto forEachPosition = [](const auto& function) {
+				for (u32 index = 0; index < KPK_POSITIONS_COUNT; index++) {
+					const u32 pawnIndex = index >> 13;
+					const Square strongPawn(File::Value(pawnIndex % 4), Rank::Value(Rank::R2 + pawnIndex / 4));
+
+					function(index, !(index & 1), Square((index >> 7) & 63), strongPawn, Square((index >> 1) & 63));
+				}
+			};
+
+			forEachPosition([&results](const u32 index, const bool isStrongSideToMove, const Square strongKing, const Square strongPawn, const Square weakKing) {
+				results[index] = classify(isStrongSideToMove, strongKing, strongPawn, weakKing);
+			});
+
+			for (bool isChanged = true; isChanged; ) {
+				isChanged = false;
+
+				forEachPosition([&results, &isChanged](const u32 index, const bool isStrongSideToMove, const Square strongKing, const Square strongPawn, const Square weakKing) {
+					if (results[index] == KPKResult::UNKNOWN) {
+						results[index] = resolve(results, isStrongSideToMove, strongKing, strongPawn, weakKing);
+						isChanged |= results[index] != KPKResult::UNKNOWN;
+					}
+				});
+			}
+
+			for (u32 index = 0; index < KPK_POSITIONS_COUNT; index++) {
+				if (results[index] == KPKResult::WIN) {
+					s_kpkWins[index / 64] |= 1ull << (index % 64);
+				}
+			}
+		}
+
+		bool probeKPK(const bool isStrongSideToMove, Square strongKing, Square strongPawn, Square weakKing) noexcept {
+			if (strongPawn.getFile() > File::D) {
+				strongKing = strongKing.mirrorByFile();
+				strongPawn = strongPawn.mirrorByFile();
+				weakKing = weakKing.mirrorByFile();
+			}
+
+			const u32 index = kpkIndex(isStrongSideToMove, strongKing, strongPawn, weakKing);
+			return s_kpkWins[index / 64] & (1ull << (index % 64));
+		}
+	}
+}
@@ -0,0 +1,44 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "Chess/Board.h"
+
+/*
+*	Bitbase(.h/.cpp) contains the KPK bitbase: a bit for every king and pawn versus king position,
+*	set if the side with the pawn wins.
+*
+*	The bitbase is generated at the startup by the retrograde analysis. The positions are given
+*	from the side with the pawn as if it was White, and the pawn is mirrored to the files A-D,
+*	so there are 2 (side to move) * 64 * 64 (kings) * 24 (pawn) positions, 24 KB in total.
+*
+*	The positions are first classified by the immediate results (a safe promotion, a captured pawn, a stalemate),
+*	and then the unknown ones are resolved from their successors until nothing changes:
+*	the side with the pawn wins if any move wins, and the other side draws if any move draws.
+*	The positions that are still unknown at the end are draws.
+*/
+
+namespace engine {
+	namespace bitbase {
+		// Generates the KPK bitbase, expected to be called after BitBoard::init
+		void init();
+
+		// Returns true if the side with the pawn wins, the squares are given from its point of view
+		bool probeKPK(const bool isStrongSideToMove, Square strongKing, Square strongPawn, Square weakKing) noexcept;
+	}
+}
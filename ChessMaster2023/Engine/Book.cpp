@@ -0,0 +1,504 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Book.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <random>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#include "Tuning.h"
+
+namespace engine {
+	constexpr size_t BOOK_ENTRY_SIZE = 16; // 8b key, 2b move, 2b weight, 4b learning data
+	constexpr u32 MAX_WEIGHT = UINT16_MAX;
+
+	struct BookEntry final {
+		Hash key;
+		u16 move;
+		u16 weight;
+	};
+
+	const u8* g_bookEntries = nullptr; // Either mapped from the file or allocated
+	size_t g_bookEntriesCount = 0;
+	bool g_isBestMoveMode = false;
+	std::mt19937_64 g_bookRandom { std::random_device()() };
+
+	// The random numbers of the Polyglot key: 12 * 64 for the pieces (the black pawn, the white pawn ... the white king,
+	// every piece by the squares from a1 to h8), then 4 for castling (white short and long, black short and long),
+	// 8 for the en passant files and 1 for white to move
+	constexpr size_t POLYGLOT_CASTLING = 768;
+	constexpr size_t POLYGLOT_EN_PASSANT = 772;
+	constexpr size_t POLYGLOT_TURN = 780;
+
+	constexpr Hash POLYGLOT_RANDOM[781] = {
+		0x9d39247e33776d41u, 0x2af7398005aaa5c7u, 0x44db015024623547u, 0x9c15f73e62a76ae2u,
+		0x75834465489c0c89u, 0x3290ac3a203001bfu, 0x0fbbad1f61042279u, 0xe83a908ff2fb60cau,
+		0x0d7e765d58755c10u, 0x1a083822ceafe02du, 0x9605d5f0e25ec3b0u, 0xd021ff5cd13a2ed5u,
+		0x40bdf15d4a672e32u, 0x011355146fd56395u, 0x5db4832046f3d9e5u, 0x239f8b2d7ff719ccu,
+		0x05d1a1ae85b49aa1u, 0x679f848f6e8fc971u, 0x7449bbff801fed0bu, 0x7d11cdb1c3b7adf0u,
+		0x82c7709e781eb7ccu, 0xf3218f1c9510786cu, 0x331478f3af51bbe6u, 0x4bb38de5e7219443u,
+		0xaa649c6ebcfd50fcu, 0x8dbd98a352afd40bu, 0x87d2074b81d79217u, 0x19f3c751d3e92ae1u,
+		0xb4ab30f062b19abfu, 0x7b0500ac42047ac4u, 0xc9452ca81a09d85du, 0x24aa6c514da27500u,
+		0x4c9f34427501b447u, 0x14a68fd73c910841u, 0xa71b9b83461cbd93u, 0x03488b95b0f1850fu,
+		0x637b2b34ff93c040u, 0x09d1bc9a3dd90a94u, 0x3575668334a1dd3bu, 0x735e2b97a4c45a23u,
+		0x18727070f1bd400bu, 0x1fcbacd259bf02e7u, 0xd310a7c2ce9b6555u, 0xbf983fe0fe5d8244u,
+		0x9f74d14f7454a824u, 0x51ebdc4ab9ba3035u, 0x5c82c505db9ab0fau, 0xfcf7fe8a3430b241u,
+		0x3253a729b9ba3ddeu, 0x8c74c368081b3075u, 0xb9bc6c87167c33e7u, 0x7ef48f2b83024e20u,
+		0x11d505d4c351bd7fu, 0x6568fca92c76a243u, 0x4de0b0f40f32a7b8u, 0x96d693460cc37e5du,
+		0x42e240cb63689f2fu, 0x6d2bdcdae2919661u, 0x42880b0236e4d951u, 0x5f0f4a5898171bb6u,
+		0x39f890f579f92f88u, 0x93c5b5f47356388bu, 0x63dc359d8d231b78u, 0xec16ca8aea98ad76u,
+		0x5355f900c2a82dc7u, 0x07fb9f855a997142u, 0x5093417aa8a7ed5eu, 0x7bcbc38da25a7f3cu,
+		0x19fc8a768cf4b6d4u, 0x637a7780decfc0d9u, 0x8249a47aee0e41f7u, 0x79ad695501e7d1e8u,
+		0x14acbaf4777d5776u, 0xf145b6beccdea195u, 0xdabf2ac8201752fcu, 0x24c3c94df9c8d3f6u,
+		0xbb6e2924f03912eau, 0x0ce26c0b95c980d9u, 0xa49cd132bfbf7cc4u, 0xe99d662af4243939u,
+		0x27e6ad7891165c3fu, 0x8535f040b9744ff1u, 0x54b3f4fa5f40d873u, 0x72b12c32127fed2bu,
+		0xee954d3c7b411f47u, 0x9a85ac909a24eaa1u, 0x70ac4cd9f04f21f5u, 0xf9b89d3e99a075c2u,
+		0x87b3e2b2b5c907b1u, 0xa366e5b8c54f48b8u, 0xae4a9346cc3f7cf2u, 0x1920c04d47267bbdu,
+		0x87bf02c6b49e2ae9u, 0x092237ac237f3859u, 0xff07f64ef8ed14d0u, 0x8de8dca9f03cc54eu,
+		0x9c1633264db49c89u, 0xb3f22c3d0b0b38edu, 0x390e5fb44d01144bu, 0x5bfea5b4712768e9u,
+		0x1e1032911fa78984u, 0x9a74acb964e78cb3u, 0x4f80f7a035dafb04u, 0x6304d09a0b3738c4u,
+		0x2171e64683023a08u, 0x5b9b63eb9ceff80cu, 0x506aacf489889342u, 0x1881afc9a3a701d6u,
+		0x6503080440750644u, 0xdfd395339cdbf4a7u, 0xef927dbcf00c20f2u, 0x7b32f7d1e03680ecu,
+		0xb9fd7620e7316243u, 0x05a7e8a57db91b77u, 0xb5889c6e15630a75u, 0x4a750a09ce9573f7u,
+		0xcf464cec899a2f8au, 0xf538639ce705b824u, 0x3c79a0ff5580ef7fu, 0xede6c87f8477609du,
+		0x799e81f05bc93f31u, 0x86536b8cf3428a8cu, 0x97d7374c60087b73u, 0xa246637cff328532u,
+		0x043fcae60cc0eba0u, 0x920e449535dd359eu, 0x70eb093b15b290ccu, 0x73a1921916591cbdu,
+		0x56436c9fe1a1aa8du, 0xefac4b70633b8f81u, 0xbb215798d45df7afu, 0x45f20042f24f1768u,
+		0x930f80f4e8eb7462u, 0xff6712ffcfd75ea1u, 0xae623fd67468aa70u, 0xdd2c5bc84bc8d8fcu,
+		0x7eed120d54cf2dd9u, 0x22fe545401165f1cu, 0xc91800e98fb99929u, 0x808bd68e6ac10365u,
+		0xdec468145b7605f6u, 0x1bede3a3aef53302u, 0x43539603d6c55602u, 0xaa969b5c691ccb7au,
+		0xa87832d392efee56u, 0x65942c7b3c7e11aeu, 0xded2d633cad004f6u, 0x21f08570f420e565u,
+		0xb415938d7da94e3cu, 0x91b859e59ecb6350u, 0x10cff333e0ed804au, 0x28aed140be0bb7ddu,
+		0xc5cc1d89724fa456u, 0x5648f680f11a2741u, 0x2d255069f0b7dab3u, 0x9bc5a38ef729abd4u,
+		0xef2f054308f6a2bcu, 0xaf2042f5cc5c2858u, 0x480412bab7f5be2au, 0xaef3af4a563dfe43u,
+		0x19afe59ae451497fu, 0x52593803dff1e840u, 0xf4f076e65f2ce6f0u, 0x11379625747d5af3u,
+		0xbce5d2248682c115u, 0x9da4243de836994fu, 0x066f70b33fe09017u, 0x4dc4de189b671a1cu,
+		0x51039ab7712457c3u, 0xc07a3f80c31fb4b4u, 0xb46ee9c5e64a6e7cu, 0xb3819a42abe61c87u,
+		0x21a007933a522a20u, 0x2df16f761598aa4fu, 0x763c4a1371b368fdu, 0xf793c46702e086a0u,
+		0xd7288e012aeb8d31u, 0xde336a2a4bc1c44bu, 0x0bf692b38d079f23u, 0x2c604a7a177326b3u,
+		0x4850e73e03eb6064u, 0xcfc447f1e53c8e1bu, 0xb05ca3f564268d99u, 0x9ae182c8bc9474e8u,
+		0xa4fc4bd4fc5558cau, 0xe755178d58fc4e76u, 0x69b97db1a4c03dfeu, 0xf9b5b7c4acc67c96u,
+		0xfc6a82d64b8655fbu, 0x9c684cb6c4d24417u, 0x8ec97d2917456ed0u, 0x6703df9d2924e97eu,
+		0xc547f57e42a7444eu, 0x78e37644e7cad29eu, 0xfe9a44e9362f05fau, 0x08bd35cc38336615u,
+		0x9315e5eb3a129aceu, 0x94061b871e04df75u, 0xdf1d9f9d784ba010u, 0x3bba57b68871b59du,
+		0xd2b7adeeded1f73fu, 0xf7a255d83bc373f8u, 0xd7f4f2448c0ceb81u, 0xd95be88cd210ffa7u,
+		0x336f52f8ff4728e7u, 0xa74049dac312ac71u, 0xa2f61bb6e437fdb5u, 0x4f2a5cb07f6a35b3u,
+		0x87d380bda5bf7859u, 0x16b9f7e06c453a21u, 0x7ba2484c8a0fd54eu, 0xf3a678cad9a2e38cu,
+		0x39b0bf7dde437ba2u, 0xfcaf55c1bf8a4424u, 0x18fcf680573fa594u, 0x4c0563b89f495ac3u,
+		0x40e087931a00930du, 0x8cffa9412eb642c1u, 0x68ca39053261169fu, 0x7a1ee967d27579e2u,
+		0x9d1d60e5076f5b6fu, 0x3810e399b6f65ba2u, 0x32095b6d4ab5f9b1u, 0x35cab62109dd038au,
+		0xa90b24499fcfafb1u, 0x77a225a07cc2c6bdu, 0x513e5e634c70e331u, 0x4361c0ca3f692f12u,
+		0xd941aca44b20a45bu, 0x528f7c8602c5807bu, 0x52ab92beb9613989u, 0x9d1dfa2efc557f73u,
+		0x722ff175f572c348u, 0x1d1260a51107fe97u, 0x7a249a57ec0c9ba2u, 0x04208fe9e8f7f2d6u,
+		0x5a110c6058b920a0u, 0x0cd9a497658a5698u, 0x56fd23c8f9715a4cu, 0x284c847b9d887aaeu,
+		0x04feabfbbdb619cbu, 0x742e1e651c60ba83u, 0x9a9632e65904ad3cu, 0x881b82a13b51b9e2u,
+		0x506e6744cd974924u, 0xb0183db56ffc6a79u, 0x0ed9b915c66ed37eu, 0x5e11e86d5873d484u,
+		0xf678647e3519ac6eu, 0x1b85d488d0f20cc5u, 0xdab9fe6525d89021u, 0x0d151d86adb73615u,
+		0xa865a54edcc0f019u, 0x93c42566aef98ffbu, 0x99e7afeabe000731u, 0x48cbff086ddf285au,
+		0x7f9b6af1ebf78bafu, 0x58627e1a149bba21u, 0x2cd16e2abd791e33u, 0xd363eff5f0977996u,
+		0x0ce2a38c344a6eedu, 0x1a804aadb9cfa741u, 0x907f30421d78c5deu, 0x501f65edb3034d07u,
+		0x37624ae5a48fa6e9u, 0x957baf61700cff4eu, 0x3a6c27934e31188au, 0xd49503536abca345u,
+		0x088e049589c432e0u, 0xf943aee7febf21b8u, 0x6c3b8e3e336139d3u, 0x364f6ffa464ee52eu,
+		0xd60f6dcedc314222u, 0x56963b0dca418fc0u, 0x16f50edf91e513afu, 0xef1955914b609f93u,
+		0x565601c0364e3228u, 0xecb53939887e8175u, 0xbac7a9a18531294bu, 0xb344c470397bba52u,
+		0x65d34954daf3cebdu, 0xb4b81b3fa97511e2u, 0xb422061193d6f6a7u, 0x071582401c38434du,
+		0x7a13f18bbedc4ff5u, 0xbc4097b116c524d2u, 0x59b97885e2f2ea28u, 0x99170a5dc3115544u,
+		0x6f423357e7c6a9f9u, 0x325928ee6e6f8794u, 0xd0e4366228b03343u, 0x565c31f7de89ea27u,
+		0x30f5611484119414u, 0xd873db391292ed4fu, 0x7bd94e1d8e17debcu, 0xc7d9f16864a76e94u,
+		0x947ae053ee56e63cu, 0xc8c93882f9475f5fu, 0x3a9bf55ba91f81cau, 0xd9a11fbb3d9808e4u,
+		0x0fd22063edc29fcau, 0xb3f256d8aca0b0b9u, 0xb03031a8b4516e84u, 0x35dd37d5871448afu,
+		0xe9f6082b05542e4eu, 0xebfafa33d7254b59u, 0x9255abb50d532280u, 0xb9ab4ce57f2d34f3u,
+		0x693501d628297551u, 0xc62c58f97dd949bfu, 0xcd454f8f19c5126au, 0xbbe83f4ecc2bdecbu,
+		0xdc842b7e2819e230u, 0xba89142e007503b8u, 0xa3bc941d0a5061cbu, 0xe9f6760e32cd8021u,
+		0x09c7e552bc76492fu, 0x852f54934da55cc9u, 0x8107fccf064fcf56u, 0x098954d51fff6580u,
+		0x23b70edb1955c4bfu, 0xc330de426430f69du, 0x4715ed43e8a45c0au, 0xa8d7e4dab780a08du,
+		0x0572b974f03ce0bbu, 0xb57d2e985e1419c7u, 0xe8d9ecbe2cf3d73fu, 0x2fe4b17170e59750u,
+		0x11317ba87905e790u, 0x7fbf21ec8a1f45ecu, 0x1725cabfcb045b00u, 0x964e915cd5e2b207u,
+		0x3e2b8bcbf016d66du, 0xbe7444e39328a0acu, 0xf85b2b4fbcde44b7u, 0x49353fea39ba63b1u,
+		0x1dd01aafcd53486au, 0x1fca8a92fd719f85u, 0xfc7c95d827357afau, 0x18a6a990c8b35ebdu,
+		0xcccb7005c6b9c28du, 0x3bdbb92c43b17f26u, 0xaa70b5b4f89695a2u, 0xe94c39a54a98307fu,
+		0xb7a0b174cff6f36eu, 0xd4dba84729af48adu, 0x2e18bc1ad9704a68u, 0x2de0966daf2f8b1cu,
+		0xb9c11d5b1e43a07eu, 0x64972d68dee33360u, 0x94628d38d0c20584u, 0xdbc0d2b6ab90a559u,
+		0xd2733c4335c6a72fu, 0x7e75d99d94a70f4du, 0x6ced1983376fa72bu, 0x97fcaacbf030bc24u,
+		0x7b77497b32503b12u, 0x8547eddfb81ccb94u, 0x79999cdff70902cbu, 0xcffe1939438e9b24u,
+		0x829626e3892d95d7u, 0x92fae24291f2b3f1u, 0x63e22c147b9c3403u, 0xc678b6d860284a1cu,
+		0x5873888850659ae7u, 0x0981dcd296a8736du, 0x9f65789a6509a440u, 0x9ff38fed72e9052fu,
+		0xe479ee5b9930578cu, 0xe7f28ecd2d49eecdu, 0x56c074a581ea17feu, 0x5544f7d774b14aefu,
+		0x7b3f0195fc6f290fu, 0x12153635b2c0cf57u, 0x7f5126dbba5e0ca7u, 0x7a76956c3eafb413u,
+		0x3d5774a11d31ab39u, 0x8a1b083821f40cb4u, 0x7b4a38e32537df62u, 0x950113646d1d6e03u,
+		0x4da8979a0041e8a9u, 0x3bc36e078f7515d7u, 0x5d0a12f27ad310d1u, 0x7f9d1a2e1ebe1327u,
+		0xda3a361b1c5157b1u, 0xdcdd7d20903d0c25u, 0x36833336d068f707u, 0xce68341f79893389u,
+		0xab9090168dd05f34u, 0x43954b3252dc25e5u, 0xb438c2b67f98e5e9u, 0x10dcd78e3851a492u,
+		0xdbc27ab5447822bfu, 0x9b3cdb65f82ca382u, 0xb67b7896167b4c84u, 0xbfced1b0048eac50u,
+		0xa9119b60369ffebdu, 0x1fff7ac80904bf45u, 0xac12fb171817eee7u, 0xaf08da9177dda93du,
+		0x1b0cab936e65c744u, 0xb559eb1d04e5e932u, 0xc37b45b3f8d6f2bau, 0xc3a9dc228caac9e9u,
+		0xf3b8b6675a6507ffu, 0x9fc477de4ed681dau, 0x67378d8eccef96cbu, 0x6dd856d94d259236u,
+		0xa319ce15b0b4db31u, 0x073973751f12dd5eu, 0x8a8e849eb32781a5u, 0xe1925c71285279f5u,
+		0x74c04bf1790c0efeu, 0x4dda48153c94938au, 0x9d266d6a1cc0542cu, 0x7440fb816508c4feu,
+		0x13328503df48229fu, 0xd6bf7baee43cac40u, 0x4838d65f6ef6748fu, 0x1e152328f3318deau,
+		0x8f8419a348f296bfu, 0x72c8834a5957b511u, 0xd7a023a73260b45cu, 0x94ebc8abcfb56daeu,
+		0x9fc10d0f989993e0u, 0xde68a2355b93cae6u, 0xa44cfe79ae538bbeu, 0x9d1d84fcce371425u,
+		0x51d2b1ab2ddfb636u, 0x2fd7e4b9e72cd38cu, 0x65ca5b96b7552210u, 0xdd69a0d8ab3b546du,
+		0x604d51b25fbf70e2u, 0x73aa8a564fb7ac9eu, 0x1a8c1e992b941148u, 0xaac40a2703d9bea0u,
+		0x764dbeae7fa4f3a6u, 0x1e99b96e70a9be8bu, 0x2c5e9deb57ef4743u, 0x3a938fee32d29981u,
+		0x26e6db8ffdf5adfeu, 0x469356c504ec9f9du, 0xc8763c5b08d1908cu, 0x3f6c6af859d80055u,
+		0x7f7cc39420a3a545u, 0x9bfb227ebdf4c5ceu, 0x89039d79d6fc5c5cu, 0x8fe88b57305e2ab6u,
+		0xa09e8c8c35ab96deu, 0xfa7e393983325753u, 0xd6b6d0ecc617c699u, 0xdfea21ea9e7557e3u,
+		0xb67c1fa481680af8u, 0xca1e3785a9e724e5u, 0x1cfc8bed0d681639u, 0xd18d8549d140caeau,
+		0x4ed0fe7e9dc91335u, 0xe4dbf0634473f5d2u, 0x1761f93a44d5aefeu, 0x53898e4c3910da55u,
+		0x734de8181f6ec39au, 0x2680b122baa28d97u, 0x298af231c85bafabu, 0x7983eed3740847d5u,
+		0x66c1a2a1a60cd889u, 0x9e17e49642a3e4c1u, 0xedb454e7badc0805u, 0x50b704cab602c329u,
+		0x4cc317fb9cddd023u, 0x66b4835d9eafea22u, 0x219b97e26ffc81bdu, 0x261e4e4c0a333a9du,
+		0x1fe2cca76517db90u, 0xd7504dfa8816edbbu, 0xb9571fa04dc089c8u, 0x1ddc0325259b27deu,
+		0xcf3f4688801eb9aau, 0xf4f5d05c10cab243u, 0x38b6525c21a42b0eu, 0x36f60e2ba4fa6800u,
+		0xeb3593803173e0ceu, 0x9c4cd6257c5a3603u, 0xaf0c317d32adaa8au, 0x258e5a80c7204c4bu,
+		0x8b889d624d44885du, 0xf4d14597e660f855u, 0xd4347f66ec8941c3u, 0xe699ed85b0dfb40du,
+		0x2472f6207c2d0484u, 0xc2a1e7b5b459aeb5u, 0xab4f6451cc1d45ecu, 0x63767572ae3d6174u,
+		0xa59e0bd101731a28u, 0x116d0016cb948f09u, 0x2cf9c8ca052f6e9fu, 0x0b090a7560a968e3u,
+		0xabeeddb2dde06ff1u, 0x58efc10b06a2068du, 0xc6e57a78fbd986e0u, 0x2eab8ca63ce802d7u,
+		0x14a195640116f336u, 0x7c0828dd624ec390u, 0xd74bbe77e6116ac7u, 0x804456af10f5fb53u,
+		0xebe9ea2adf4321c7u, 0x03219a39ee587a30u, 0x49787fef17af9924u, 0xa1e9300cd8520548u,
+		0x5b45e522e4b1b4efu, 0xb49c3b3995091a36u, 0xd4490ad526f14431u, 0x12a8f216af9418c2u,
+		0x001f837cc7350524u, 0x1877b51e57a764d5u, 0xa2853b80f17f58eeu, 0x993e1de72d36d310u,
+		0xb3598080ce64a656u, 0x252f59cf0d9f04bbu, 0xd23c8e176d113600u, 0x1bda0492e7e4586eu,
+		0x21e0bd5026c619bfu, 0x3b097adaf088f94eu, 0x8d14dedb30be846eu, 0xf95cffa23af5f6f4u,
+		0x3871700761b3f743u, 0xca672b91e9e4fa16u, 0x64c8e531bff53b55u, 0x241260ed4ad1e87du,
+		0x106c09b972d2e822u, 0x7fba195410e5ca30u, 0x7884d9bc6cb569d8u, 0x0647dfedcd894a29u,
+		0x63573ff03e224774u, 0x4fc8e9560f91b123u, 0x1db956e450275779u, 0xb8d91274b9e9d4fbu,
+		0xa2ebee47e2fbfce1u, 0xd9f1f30ccd97fb09u, 0xefed53d75fd64e6bu, 0x2e6d02c36017f67fu,
+		0xa9aa4d20db084e9bu, 0xb64be8d8b25396c1u, 0x70cb6af7c2d5bcf0u, 0x98f076a4f7a2322eu,
+		0xbf84470805e69b5fu, 0x94c3251f06f90cf3u, 0x3e003e616a6591e9u, 0xb925a6cd0421aff3u,
+		0x61bdd1307c66e300u, 0xbf8d5108e27e0d48u, 0x240ab57a8b888b20u, 0xfc87614baf287e07u,
+		0xef02cdd06ffdb432u, 0xa1082c0466df6c0au, 0x8215e577001332c8u, 0xd39bb9c3a48db6cfu,
+		0x2738259634305c14u, 0x61cf4f94c97df93du, 0x1b6baca2ae4e125bu, 0x758f450c88572e0bu,
+		0x959f587d507a8359u, 0xb063e962e045f54du, 0x60e8ed72c0dff5d1u, 0x7b64978555326f9fu,
+		0xfd080d236da814bau, 0x8c90fd9b083f4558u, 0x106f72fe81e2c590u, 0x7976033a39f7d952u,
+		0xa4ec0132764ca04bu, 0x733ea705fae4fa77u, 0xb4d8f77bc3e56167u, 0x9e21f4f903b33fd9u,
+		0x9d765e419fb69f6du, 0xd30c088ba61ea5efu, 0x5d94337fbfaf7f5bu, 0x1a4e4822eb4d7a59u,
+		0x6ffe73e81b637fb3u, 0xddf957bc36d8b9cau, 0x64d0e29eea8838b3u, 0x08dd9bdfd96b9f63u,
+		0x087e79e5a57d1d13u, 0xe328e230e3e2b3fbu, 0x1c2559e30f0946beu, 0x720bf5f26f4d2eaau,
+		0xb0774d261cc609dbu, 0x443f64ec5a371195u, 0x4112cf68649a260eu, 0xd813f2fab7f5c5cau,
+		0x660d3257380841eeu, 0x59ac2c7873f910a3u, 0xe846963877671a17u, 0x93b633abfa3469f8u,
+		0xc0c0f5a60ef4cdcfu, 0xcaf21ecd4377b28cu, 0x57277707199b8175u, 0x506c11b9d90e8b1du,
+		0xd83cc2687a19255fu, 0x4a29c6465a314cd1u, 0xed2df21216235097u, 0xb5635c95ff7296e2u,
+		0x22af003ab672e811u, 0x52e762596bf68235u, 0x9aeba33ac6ecc6b0u, 0x944f6de09134dfb6u,
+		0x6c47bec883a7de39u, 0x6ad047c430a12104u, 0xa5b1cfdba0ab4067u, 0x7c45d833aff07862u,
+		0x5092ef950a16da0bu, 0x9338e69c052b8e7bu, 0x455a4b4cfe30e3f5u, 0x6b02e63195ad0cf8u,
+		0x6b17b224bad6bf27u, 0xd1e0ccd25bb9c169u, 0xde0c89a556b9ae70u, 0x50065e535a213cf6u,
+		0x9c1169fa2777b874u, 0x78edefd694af1eedu, 0x6dc93d9526a50e68u, 0xee97f453f06791edu,
+		0x32ab0edb696703d3u, 0x3a6853c7e70757a7u, 0x31865ced6120f37du, 0x67fef95d92607890u,
+		0x1f2b1d1f15f6dc9cu, 0xb69e38a8965c6b65u, 0xaa9119ff184cccf4u, 0xf43c732873f24c13u,
+		0xfb4a3d794a9a80d2u, 0x3550c2321fd6109cu, 0x371f77e76bb8417eu, 0x6bfa9aae5ec05779u,
+		0xcd04f3ff001a4778u, 0xe3273522064480cau, 0x9f91508bffcfc14au, 0x049a7f41061a9e60u,
+		0xfcb6be43a9f2fe9bu, 0x08de8a1c7797da9bu, 0x8f9887e6078735a1u, 0xb5b4071dbfc73a66u,
+		0x230e343dfba08d33u, 0x43ed7f5a0fae657du, 0x3a88a0fbbcb05c63u, 0x21874b8b4d2dbc4fu,
+		0x1bdea12e35f6a8c9u, 0x53c065c6c8e63528u, 0xe34a1d250e7a8d6bu, 0xd6b04d3b7651dd7eu,
+		0x5e90277e7cb39e2du, 0x2c046f22062dc67du, 0xb10bb459132d0a26u, 0x3fa9ddfb67e2f199u,
+		0x0e09b88e1914f7afu, 0x10e8b35af3eeab37u, 0x9eedeca8e272b933u, 0xd4c718bc4ae8ae5fu,
+		0x81536d601170fc20u, 0x91b534f885818a06u, 0xec8177f83f900978u, 0x190e714fada5156eu,
+		0xb592bf39b0364963u, 0x89c350c893ae7dc1u, 0xac042e70f8b383f2u, 0xb49b52e587a1ee60u,
+		0xfb152fe3ff26da89u, 0x3e666e6f69ae2c15u, 0x3b544ebe544c19f9u, 0xe805a1e290cf2456u,
+		0x24b33c9d7ed25117u, 0xe74733427b72f0c1u, 0x0a804d18b7097475u, 0x57e3306d881edb4fu,
+		0x4ae7d6a36eb5dbcbu, 0x2d8d5432157064c8u, 0xd1e649de1e7f268bu, 0x8a328a1cedfe552cu,
+		0x07a3aec79624c7dau, 0x84547ddc3e203c94u, 0x990a98fd5071d263u, 0x1a4ff12616eefc89u,
+		0xf6f7fd1431714200u, 0x30c05b1ba332f41cu, 0x8d2636b81555a786u, 0x46c9feb55d120902u,
+		0xccec0a73b49c9921u, 0x4e9d2827355fc492u, 0x19ebb029435dcb0fu, 0x4659d2b743848a2cu,
+		0x963ef2c96b33be31u, 0x74f85198b05a2e7du, 0x5a0f544dd2b1fb18u, 0x03727073c2e134b1u,
+		0xc7f6aa2de59aea61u, 0x352787baa0d7c22fu, 0x9853eab63b5e0b35u, 0xabbdcdd7ed5c0860u,
+		0xcf05daf5ac8d77b0u, 0x49cad48cebf4a71eu, 0x7a4c10ec2158c4a6u, 0xd9e92aa246bf719eu,
+		0x13ae978d09fe5556u, 0x730499af921549ffu, 0x4e4b705b92903ba4u, 0xff577222c14f0a3au,
+		0x55b6344cf97aafaeu, 0xb862225b055b6960u, 0xcac09afbddd2cdb4u, 0xdaf8e9829fe96b5fu,
+		0xb5fdfc5d3132c498u, 0x310cb380db6f7503u, 0xe87fbb46217a360eu, 0x2102ae466ebb1148u,
+		0xf8549e1a3aa5e00du, 0x07a69afdcc42261au, 0xc4c118bfe78feaaeu, 0xf9f4892ed96bd438u,
+		0x1af3dbe25d8f45dau, 0xf5b4b0b0d2deeeb4u, 0x962aceefa82e1c84u, 0x046e3ecaaf453ce9u,
+		0xf05d129681949a4cu, 0x964781ce734b3c84u, 0x9c2ed44081ce5fbdu, 0x522e23f3925e319eu,
+		0x177e00f9fc32f791u, 0x2bc60a63a6f3b3f2u, 0x222bbfae61725606u, 0x486289ddcc3d6780u,
+		0x7dc7785b8efdfc80u, 0x8af38731c02ba980u, 0x1fab64ea29a2ddf7u, 0xe4d9429322cd065au,
+		0x9da058c67844f20cu, 0x24c0e332b70019b0u, 0x233003b5a6cfe6adu, 0xd586bd01c5c217f6u,
+		0x5e5637885f29bc2bu, 0x7eba726d8c94094bu, 0x0a56a5f0bfe39272u, 0xd79476a84ee20d06u,
+		0x9e4c1269baa4bf37u, 0x17efee45b0dee640u, 0x1d95b0a5fcf90bc6u, 0x93cbe0b699c2585du,
+		0x65fa4f227a2b6d79u, 0xd5f9e858292504d5u, 0xc2b5a03f71471a6fu, 0x59300222b4561e00u,
+		0xce2f8642ca0712dcu, 0x7ca9723fbb2e8988u, 0x2785338347f2ba08u, 0xc61bb3a141e50e8cu,
+		0x150f361dab9dec26u, 0x9f6a419d382595f4u, 0x64a53dc924fe7ac9u, 0x142de49fff7a7c3du,
+		0x0c335248857fa9e7u, 0x0a9c32d5eae45305u, 0xe6c42178c4bbb92eu, 0x71f1ce2490d20b07u,
+		0xf1bcc3d275afe51au, 0xe728e8c83c334074u, 0x96fbf83a12884624u, 0x81a1549fd6573da5u,
+		0x5fa7867caf35e149u, 0x56986e2ef3ed091bu, 0x917f1dd5f8886c61u, 0xd20d8c88c8ffe65fu,
+		0x31d71dce64b2c310u, 0xf165b587df898190u, 0xa57e6339dd2cf3a1u, 0x1ef6e6dbb1961ec9u,
+		0x70cc73d90bc26e24u, 0xe21a6b35df0c3ad7u, 0x003a93d8b2806962u, 0x1c99ded33cb890a1u,
+		0xcf3145de0add4289u, 0xd0e4427a5514fb72u, 0x77c621cc9fb3a483u, 0x67a34dac4356550bu,
+		0xf8d626aaaf278509u
+	};
+
+	template<typename T>
+	inline T readBigEndian(const u8* bytes) noexcept {
+		T value = 0;
+		for (size_t i = 0; i < sizeof(T); i++) {
+			value = T((value << 8) | bytes[i]);
+		}
+
+		return value;
+	}
+
+	template<typename T>
+	inline void writeBigEndian(u8* bytes, const T value) noexcept {
+		for (size_t i = 0; i < sizeof(T); i++) {
+			bytes[i] = u8(value >> (8 * (sizeof(T) - 1 - i)));
+		}
+	}
+
+	inline BookEntry readEntry(const size_t index) noexcept {
+		const u8* bytes = g_bookEntries + index * BOOK_ENTRY_SIZE;
+		return BookEntry { .key = readBigEndian<Hash>(bytes), .move = readBigEndian<u16>(bytes + 8), .weight = readBigEndian<u16>(bytes + 10) };
+	}
+
+	// The move in the Polyglot encoding, castling is the king capturing its rook
+	u16 encodeMove(const Move m) noexcept {
+		const Square from = m.getFrom();
+		Square to = m.getTo();
+		u16 promotion = 0;
+
+		if (m.getMoveType() == MoveType::CASTLE) {
+			to = Square(to.getFile() > from.getFile() ? File::H : File::A, from.getRank());
+		} else if (m.getMoveType() == MoveType::PROMOTION) {
+			promotion = u16(m.getPromotedPiece() - PieceType::KNIGHT + 1);
+		}
+
+		return u16(u32(to) | (u32(from) << 6) | (u32(promotion) << 12));
+	}
+
+	void releaseBook() {
+		if (!g_bookEntries) {
+			return;
+		}
+
+#ifndef _WIN32
+		munmap(const_cast<u8*>(g_bookEntries), g_bookEntriesCount * BOOK_ENTRY_SIZE);
+#else
+		free(const_cast<u8*>(g_bookEntries));
+#endif // _WIN32
+
+		g_bookEntries = nullptr;
+		g_bookEntriesCount = 0;
+	}
+
+	bool Book::open(const std::string& fileName) {
+		close();
+
+		size_t size;
+		void* memory;
+#ifndef _WIN32
+		const int file = ::open(fileName.c_str(), O_RDONLY);
+		struct stat info;
+		if (file < 0 || fstat(file, &info) != 0 || info.st_size == 0 || size_t(info.st_size) % BOOK_ENTRY_SIZE != 0) {
+			if (file >= 0) {
+				::close(file);
+			}
+
+			return false;
+		}
+
+		size = size_t(info.st_size);
+		memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+		::close(file); // The mapping stays
+		if (memory == MAP_FAILED) {
+			return false;
+		}
+#else
+		std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+		if (!file || file.tellg() == 0 || size_t(file.tellg()) % BOOK_ENTRY_SIZE != 0) {
+			return false;
+		}
+
+		size = size_t(file.tellg());
+		memory = malloc(size);
+		file.seekg(0);
+		if (!memory || !file.read(static_cast<char*>(memory), std::streamsize(size))) {
+			free(memory);
+			return false;
+		}
+#endif // _WIN32
+
+		g_bookEntries = static_cast<const u8*>(memory);
+		g_bookEntriesCount = size / BOOK_ENTRY_SIZE;
+		return true;
+	}
+
+	void Book::close() {
+		releaseBook();
+	}
+
+	bool Book::isOpen() noexcept {
+		return g_bookEntries;
+	}
+
+	void Book::setBestMoveMode(const bool isBestMove) noexcept {
+		g_isBestMoveMode = isBestMove;
+	}
+
+	Hash Book::computeKey(const Board& board) noexcept {
+		Hash key = 0;
+		for (Square sq : Square::iter()) {
+			if (board[sq] != Piece::NONE) {
+				key ^= POLYGLOT_RANDOM[64 * (board[sq] - Piece::PAWN_BLACK) + sq];
+			}
+		}
+
+		const u8 rights = board.castleRight();
+		const Castle castles[] = { Castle::KING_CASTLE, Castle::QUEEN_CASTLE };
+		for (size_t i = 0; i < 4; i++) {
+			if (Castle::hasCastleRight(rights, castles[i % 2], i < 2 ? Color::WHITE : Color::BLACK)) {
+				key ^= POLYGLOT_RANDOM[POLYGLOT_CASTLING + i];
+			}
+		}
+
+		// The en passant file counts only if a pawn stands ready to capture, whether the capture is legal or not
+		const Square ep = board.ep();
+		if (ep != Square::NO_POS && BitBoard::pawnAttacks(board.side().getOpposite(), ep)
+				.b_and(board.byPiece(Piece(board.side(), PieceType::PAWN))) != BitBoard::EMPTY) {
+			key ^= POLYGLOT_RANDOM[POLYGLOT_EN_PASSANT + ep.getFile()];
+		}
+
+		if (board.side() == Color::WHITE) {
+			key ^= POLYGLOT_RANDOM[POLYGLOT_TURN];
+		}
+
+		return key;
+	}
+
+	Move Book::probe(const Board& board) {
+		if (!g_bookEntries) {
+			return Move::makeNullMove();
+		}
+
+		// Looking for the first entry of the position
+		const Hash key = computeKey(board);
+		size_t low = 0;
+		size_t high = g_bookEntriesCount;
+		while (low < high) {
+			const size_t middle = (low + high) / 2;
+			if (readEntry(middle).key < key) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+
+		MoveList moves;
+		board.generateMoves(moves);
+
+		// The book moves are matched with the legal ones, so a colliding key cannot give an illegal move
+		std::vector<std::pair<Move, u32>> bookMoves;
+		u64 totalWeight = 0;
+		for (size_t i = low; i < g_bookEntriesCount; i++) {
+			const BookEntry entry = readEntry(i);
+			if (entry.key != key) {
+				break;
+			}
+
+			const auto it = std::find_if(moves.begin(), moves.end(), [&board, &entry](const Move m) {
+				return encodeMove(m) == (entry.move & 0x7fff) && board.isLegal(m);
+			});
+
+			if (it != moves.end() && entry.weight) {
+				bookMoves.emplace_back(*it, entry.weight);
+				totalWeight += entry.weight;
+			}
+		}
+
+		if (bookMoves.empty()) {
+			return Move::makeNullMove();
+		}
+
+		if (g_isBestMoveMode) {
+			return std::max_element(bookMoves.begin(), bookMoves.end(), [](const auto& a, const auto& b) { return a.second < b.second; })->first;
+		}
+
+		u64 chosen = std::uniform_int_distribution<u64>(0, totalWeight - 1)(g_bookRandom);
+		for (const auto& [m, weight] : bookMoves) {
+			if (chosen < weight) {
+				return m;
+			}
+
+			chosen -= weight;
+		}
+
+		return bookMoves.back().first;
+	}
+
+	i64 Book::build(const std::string& pgnFileName, const std::string& bookFileName, const u32 maxPlies, const u32 minGames) {
+		struct MoveStats final {
+			u32 games = 0;
+			u32 weight = 0;
+		};
+
+		// Ordered by the key, as the book must be
+		std::map<std::pair<Hash, u16>, MoveStats> stats;
+		Tuning::forEachMove(pgnFileName, [&stats, maxPlies](const Board& board, const Move m, const u32 moveNumber, const float result) {
+			if (moveNumber >= maxPlies) {
+				return;
+			}
+
+			const float sideResult = board.side() == Color::WHITE ? result : 1.f - result;
+			MoveStats& moveStats = stats[{ computeKey(board), encodeMove(m) }];
+			moveStats.games++;
+			moveStats.weight += u32(sideResult * 2 + 0.5f);
+		});
+
+		// The entries of every position are written together, scaled down if their weights do not fit
+		std::vector<u8> book;
+		std::vector<std::pair<u16, u32>> positionMoves;
+		for (auto it = stats.begin(); it != stats.end(); ) {
+			const Hash key = it->first.first;
+
+			positionMoves.clear();
+			u32 maxWeight = 0;
+			for (; it != stats.end() && it->first.first == key; it++) {
+				if (it->second.games >= minGames && it->second.weight) {
+					positionMoves.emplace_back(it->first.second, it->second.weight);
+					maxWeight = std::max(maxWeight, it->second.weight);
+				}
+			}
+
+			const u32 divisor = maxWeight / (MAX_WEIGHT + 1) + 1;
+			for (const auto& [move, weight] : positionMoves) {
+				u8 bytes[BOOK_ENTRY_SIZE] = { };
+				writeBigEndian(bytes, key);
+				writeBigEndian(bytes + 8, move);
+				writeBigEndian(bytes + 10, u16(std::max(1u, weight / divisor)));
+
+				book.insert(book.end(), std::begin(bytes), std::end(bytes));
+			}
+		}
+
+		std::ofstream out(bookFileName, std::ios::binary);
+		if (!out.write(reinterpret_cast<const char*>(book.data()), std::streamsize(book.size()))) {
+			return -1;
+		}
+
+		return i64(book.size() / BOOK_ENTRY_SIZE);
+	}
+}
@@ -0,0 +1,71 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <string>
+
+#include "Chess/Board.h"
+
+/*
+*	Book(.h/.cpp) contains the opening book.
+*
+*	The book is a file in the Polyglot .bin layout: 16-byte big-endian entries (the key of the position,
+*	the move, its weight and the learning data) sorted by the key. The move is kept as Polyglot keeps it:
+*	the target square in the bits 0-5, the origin in 6-11, the promoted piece (1 is a knight ... 4 is a queen)
+*	in 12-14, and castling as the king capturing its rook.
+*	The positions are keyed by the standard Polyglot key (the Polyglot random numbers, not the Zobrist hash
+*	of the engine), so the third-party Polyglot books are read, and the books built by the engine
+*	from the games in the long algebraic form (see Tuning::extractPositions) are read by the other programs.
+*
+*	The file is memory-mapped (POSIX only, elsewhere it is read into memory) and binary-searched by the key.
+*	The root search plays a book move at once, either the one with the greatest weight,
+*	or a random one with the probability proportional to its weight.
+*/
+
+namespace engine {
+	class Book final {
+	public:
+		// The moves played in fewer games than this are not put into a book by default
+		constexpr inline static u32 DEFAULT_MIN_GAMES = 2;
+
+		// The number of plies from the start of the game put into a book by default
+		constexpr inline static u32 DEFAULT_MAX_PLIES = 20;
+
+		// Maps the book, closing the previous one
+		// Returns false if the file cannot be opened or is not a book
+		static bool open(const std::string& fileName);
+		static void close();
+
+		static bool isOpen() noexcept;
+
+		// Plays the move with the greatest weight instead of a random one
+		static void setBestMoveMode(const bool isBestMove) noexcept;
+
+		// The Polyglot key of the position. The en passant file is a part of the key only
+		// if a pawn of the side to move can capture on it
+		static Hash computeKey(const Board& board) noexcept;
+
+		// Returns the null move if the position is not in the book
+		static Move probe(const Board& board);
+
+		// Builds a book of the first plies of the games, weighting the moves by their results (2 for a win, 1 for a draw)
+		// Returns the number of the entries written, or -1 if the book cannot be written
+		static i64 build(const std::string& pgnFileName, const std::string& bookFileName,
+			const u32 maxPlies = DEFAULT_MAX_PLIES, const u32 minGames = DEFAULT_MIN_GAMES);
+	};
+}
@@ -0,0 +1,499 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Cluster.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#include "Utils/StringUtils.h"
+#include "Library.h"
+#include "TranspositionTable.h"
+
+namespace engine {
+	constexpr size_t ENTRIES_PER_LINE = 256;
+	constexpr auto EXCHANGE_INTERVAL = std::chrono::milliseconds(20);
+	constexpr auto STOP_TIMEOUT = std::chrono::milliseconds(2000); // The workers that do not answer in time are ignored
+
+	enum class ReadResult : u8 {
+		LINE = 0,
+		NOTHING,
+		CLOSED
+	};
+
+#ifndef _WIN32
+	// A line-based connection, may be written from several threads
+	class Connection final {
+	private:
+		std::atomic<int> m_socket;
+		std::string m_buffer; // Received, but not returned yet
+		std::mutex m_writeMutex;
+
+	public:
+		explicit Connection(const int socket) : m_socket(socket) { }
+
+		~Connection() {
+			close();
+		}
+
+		CM_PURE bool isOpen() const noexcept {
+			return m_socket >= 0;
+		}
+
+		void close() {
+			std::lock_guard lock(m_writeMutex);
+			if (m_socket >= 0) {
+				::close(m_socket);
+				m_socket = -1;
+			}
+		}
+
+		bool writeLine(std::string_view line) {
+			std::lock_guard lock(m_writeMutex);
+			if (m_socket < 0) {
+				return false;
+			}
+
+			std::string data(line);
+			data.push_back('\n');
+			for (size_t sent = 0; sent < data.size(); ) {
+				const ssize_t count = send(m_socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+				if (count <= 0) {
+					return false;
+				}
+
+				sent += size_t(count);
+			}
+
+			return true;
+		}
+
+		// Waits for a line for at most the given time
+		ReadResult readLine(std::string& line, const int timeoutMs) {
+			for (bool isWaiting = true; ; isWaiting = false) {
+				if (const size_t end = m_buffer.find('\n'); end != std::string::npos) {
+					line = m_buffer.substr(0, end);
+					m_buffer.erase(0, end + 1);
+					return ReadResult::LINE;
+				}
+
+				if (m_socket < 0) {
+					return ReadResult::CLOSED;
+				}
+
+				pollfd request { .fd = m_socket, .events = POLLIN, .revents = 0 };
+				if (!isWaiting || poll(&request, 1, timeoutMs) <= 0) {
+					return ReadResult::NOTHING;
+				}
+
+				char chunk[4096];
+				const ssize_t count = recv(m_socket, chunk, sizeof(chunk), 0);
+				if (count <= 0) {
+					close();
+					return ReadResult::CLOSED;
+				}
+
+				m_buffer.append(chunk, size_t(count));
+			}
+		}
+	};
+
+	// Opens a listening or a connected socket, returns -1 on failure
+	int openSocket(std::string_view address, const bool isListening) {
+		if (address.starts_with("unix:")) {
+			const std::string path(address.substr(5));
+
+			sockaddr_un socketAddress { };
+			socketAddress.sun_family = AF_UNIX;
+			if (path.empty() || path.size() >= sizeof(socketAddress.sun_path)) {
+				return -1;
+			}
+
+			memcpy(socketAddress.sun_path, path.c_str(), path.size() + 1);
+
+			const int s = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (s < 0) {
+				return -1;
+			}
+
+			if (isListening) {
+				unlink(path.c_str()); // Left by a previous worker
+			}
+
+			const sockaddr* socketAddressPtr = reinterpret_cast<const sockaddr*>(&socketAddress);
+			if (isListening
+				? bind(s, socketAddressPtr, sizeof(socketAddress)) != 0 || listen(s, 4) != 0
+				: connect(s, socketAddressPtr, sizeof(socketAddress)) != 0) {
+				::close(s);
+				return -1;
+			}
+
+			return s;
+		}
+
+		const size_t colon = address.rfind(':');
+		const std::string host = colon == std::string_view::npos ? (isListening ? "" : "localhost") : std::string(address.substr(0, colon));
+		const std::string port(colon == std::string_view::npos ? address : address.substr(colon + 1));
+
+		addrinfo hints { };
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = isListening ? AI_PASSIVE : 0;
+
+		addrinfo* addresses = nullptr;
+		if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+			return -1;
+		}
+
+		int s = -1;
+		for (const addrinfo* it = addresses; it && s < 0; it = it->ai_next) {
+			s = socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+			if (s < 0) {
+				continue;
+			}
+
+			const int one = 1;
+			setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+			if (isListening) {
+				setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+			}
+
+			if (isListening
+				? bind(s, it->ai_addr, it->ai_addrlen) != 0 || listen(s, 4) != 0
+				: connect(s, it->ai_addr, it->ai_addrlen) != 0) {
+				::close(s);
+				s = -1;
+			}
+		}
+
+		freeaddrinfo(addresses);
+		return s;
+	}
+
+
+	///  ENTRIES  ///
+
+	// Sends the entries as the "tt" lines
+	void sendEntries(Connection& connection, const std::vector<TableEntry>& entries) {
+		for (size_t from = 0; from < entries.size(); from += ENTRIES_PER_LINE) {
+			std::string line = "tt";
+			char buffer[17];
+			for (size_t i = from; i < std::min(entries.size(), from + ENTRIES_PER_LINE); i++) {
+				for (const u64 word : { entries[i].hash, entries[i].getData() }) {
+					*std::to_chars(buffer, buffer + 16, word, 16).ptr = '\0';
+					line.append(" ").append(buffer);
+				}
+			}
+
+			if (!connection.writeLine(line)) {
+				return;
+			}
+		}
+	}
+
+	void importEntries(const std::vector<std::string_view>& args) {
+		for (size_t i = 1; i + 1 < args.size(); i += 2) {
+			u64 hash, data;
+			if (std::from_chars(args[i].data(), args[i].data() + args[i].size(), hash, 16).ec != std::errc()
+				|| std::from_chars(args[i + 1].data(), args[i + 1].data() + args[i + 1].size(), data, 16).ec != std::errc()) {
+				return;
+			}
+
+			TableEntry entry { .hash = hash };
+			memcpy(&entry.move, &data, sizeof(data));
+			if (entry.type != 0 && entry.depth != 0) {
+				TranspositionTable::importEntry(entry);
+			}
+		}
+	}
+
+
+	///  WORKER  ///
+
+	// Serves the coordinator until it disconnects, returns false if it asked to shut down
+	bool serveCoordinator(Connection& coordinator) {
+		SearchHandle handle;
+		std::string searchId;
+
+		std::jthread sender([&coordinator](std::stop_token stopToken) {
+			std::vector<TableEntry> entries;
+			while (!stopToken.stop_requested() && coordinator.isOpen()) {
+				std::this_thread::sleep_for(EXCHANGE_INTERVAL);
+
+				entries.clear();
+				TranspositionTable::takeExportedEntries(entries);
+				sendEntries(coordinator, entries);
+			}
+		});
+
+		std::string line;
+		while (true) {
+			const ReadResult result = coordinator.readLine(line, 1000);
+			if (result == ReadResult::CLOSED) {
+				break;
+			} else if (result == ReadResult::NOTHING) {
+				continue;
+			}
+
+			const std::vector<std::string_view> args = str_utils::split(line, " ");
+			if (args.empty()) {
+				continue;
+			}
+
+			if (args[0] == "tt") {
+				importEntries(args);
+			} else if (args[0] == "position") {
+				if (!handle.setPosition(std::string_view(line).substr(std::min(line.size(), sizeof("position")))))  {
+					coordinator.writeLine("error incorrect position");
+				}
+			} else if (args[0] == "go" && args.size() >= 2) {
+				searchId = args[1];
+				handle.go(SearchLimits(), [&coordinator, searchId](const SearchInfo& info) {
+					coordinator.writeLine("info " + searchId + " " + std::to_string(info.depth) + " " + std::to_string(info.value)
+						+ " " + std::to_string(info.nodes) + " " + (info.pv.empty() ? "0000" : info.pv[0]));
+				}, [&coordinator, searchId](const std::string& bestMove, const Value value) {
+					coordinator.writeLine("bestmove " + searchId + " " + bestMove + " " + std::to_string(value));
+				});
+			} else if (args[0] == "stop") {
+				handle.stop();
+			} else if (args[0] == "shutdown") {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool runClusterWorker(const std::vector<std::string>& args) {
+		if (args.size() != 1) {
+			std::cerr << "Usage: ChessMaster2023 cluster-worker unix:<path>|[<host>:]<port>" << std::endl;
+			return false;
+		}
+
+		const int listener = openSocket(args[0], true);
+		if (listener < 0) {
+			std::cerr << "Cannot listen on " << args[0] << std::endl;
+			return false;
+		}
+
+		std::cerr << "Cluster worker is listening on " << args[0] << std::endl;
+		TranspositionTable::setExportDepth(CLUSTER_SHARED_ENTRY_DEPTH);
+
+		// One coordinator at a time, the table stays warm between them
+		bool isRunning = true;
+		while (isRunning) {
+			const int s = accept(listener, nullptr, nullptr);
+			if (s < 0) {
+				continue;
+			}
+
+			Connection coordinator(s);
+			isRunning = serveCoordinator(coordinator);
+		}
+
+		::close(listener);
+		if (args[0].starts_with("unix:")) {
+			unlink(args[0].c_str() + 5);
+		}
+
+		return true;
+	}
+
+
+	///  COORDINATOR  ///
+
+	struct ClusterWorker final {
+		std::string address;
+		std::unique_ptr<Connection> connection;
+
+		// The results of the current search
+		Depth depth = 0;
+		Value value = 0;
+		std::string best;
+		bool isDone = false;
+	};
+
+	std::vector<ClusterWorker> g_clusterWorkers;
+	u32 g_searchesCount = 0;
+
+	void setClusterWorkers(std::string_view addresses) {
+		g_clusterWorkers.clear();
+		for (std::string_view address : str_utils::split(addresses, ",")) {
+			g_clusterWorkers.push_back(ClusterWorker { .address = std::string(address) });
+		}
+	}
+
+	// Reads everything the worker sent, relaying its entries to the other workers
+	void readWorker(ClusterWorker& worker, std::vector<ClusterWorker*>& active, const std::string& searchId) {
+		std::string line;
+		ReadResult result;
+		while ((result = worker.connection->readLine(line, 0)) == ReadResult::LINE) {
+			const std::vector<std::string_view> args = str_utils::split(line, " ");
+			if (args.empty()) {
+				continue;
+			}
+
+			if (args[0] == "tt") {
+				importEntries(args);
+				for (ClusterWorker* other : active) {
+					if (other != &worker) {
+						other->connection->writeLine(line);
+					}
+				}
+			} else if (args[0] == "info" && args.size() == 6 && args[1] == searchId) {
+				i32 depth = 0, value = 0;
+				std::from_chars(args[2].data(), args[2].data() + args[2].size(), depth);
+				std::from_chars(args[3].data(), args[3].data() + args[3].size(), value);
+
+				worker.depth = Depth(depth);
+				worker.value = Value(value);
+				worker.best = args[5];
+			} else if (args[0] == "bestmove" && args.size() == 4 && args[1] == searchId) {
+				worker.isDone = true;
+			}
+		}
+
+		if (result == ReadResult::CLOSED) {
+			worker.isDone = true;
+		}
+	}
+
+	// Returns the legal move with the given notation, or the null move
+	Move findLegalMove(Board& board, std::string_view str) {
+		MoveList moves;
+		board.generateMoves(moves);
+		for (Move m : moves) {
+			if (m.toString() == str && board.isLegal(m)) {
+				return m;
+			}
+		}
+
+		return Move();
+	}
+
+	SearchResult clusterRootSearch(Board& board) {
+		const std::string searchId = std::to_string(++g_searchesCount);
+		const std::string fen = board.toFEN();
+
+		std::vector<ClusterWorker*> active;
+		for (ClusterWorker& worker : g_clusterWorkers) {
+			if (!worker.connection || !worker.connection->isOpen()) {
+				const int s = openSocket(worker.address, false);
+				worker.connection = s < 0 ? nullptr : std::make_unique<Connection>(s);
+			}
+
+			worker.depth = 0;
+			worker.best.clear();
+			worker.isDone = false;
+
+			if (worker.connection && worker.connection->writeLine("position " + fen) && worker.connection->writeLine("go " + searchId)) {
+				active.push_back(&worker);
+			}
+		}
+
+		if (active.empty()) {
+			return rootSearch(board);
+		}
+
+		TranspositionTable::setExportDepth(CLUSTER_SHARED_ENTRY_DEPTH);
+
+		std::atomic_bool isStopping = false;
+		std::thread exchange([&active, &isStopping, &searchId]() {
+			std::vector<TableEntry> entries;
+			auto deadline = std::chrono::steady_clock::time_point::max();
+
+			while (true) {
+				for (ClusterWorker* worker : active) {
+					readWorker(*worker, active, searchId);
+				}
+
+				entries.clear();
+				TranspositionTable::takeExportedEntries(entries);
+				for (ClusterWorker* worker : active) {
+					sendEntries(*worker->connection, entries);
+				}
+
+				if (isStopping) {
+					if (deadline == std::chrono::steady_clock::time_point::max()) {
+						deadline = std::chrono::steady_clock::now() + STOP_TIMEOUT;
+					}
+
+					if (std::all_of(active.begin(), active.end(), [](const ClusterWorker* worker) { return worker->isDone; })
+						|| std::chrono::steady_clock::now() > deadline) {
+						break;
+					}
+				}
+
+				std::this_thread::sleep_for(EXCHANGE_INTERVAL);
+			}
+		});
+
+		SearchResult result = rootSearch(board);
+
+		for (ClusterWorker* worker : active) {
+			worker->connection->writeLine("stop");
+		}
+
+		isStopping = true;
+		exchange.join();
+		TranspositionTable::setExportDepth(0);
+
+		// The deepest iteration wins, the local search wins the ties
+		Depth bestDepth = getCompletedDepth();
+		for (const ClusterWorker* worker : active) {
+			if (worker->depth > bestDepth) {
+				if (const Move m = findLegalMove(board, worker->best); !m.isNullMove()) {
+					result = SearchResult { .best = m, .value = worker->value };
+					bestDepth = worker->depth;
+				}
+			}
+		}
+
+		return result;
+	}
+#else
+	void setClusterWorkers(std::string_view) {
+		std::cerr << "The cluster is not supported on this platform" << std::endl;
+	}
+
+	SearchResult clusterRootSearch(Board& board) {
+		return rootSearch(board);
+	}
+
+	bool runClusterWorker(const std::vector<std::string>&) {
+		std::cerr << "The cluster is not supported on this platform" << std::endl;
+		return false;
+	}
+#endif // _WIN32
+}
@@ -0,0 +1,64 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Search.h"
+
+/*
+*	Cluster(.h/.cpp) contains the search distributed over several processes or hosts (POSIX only).
+*
+*	The workers are started as
+*		ChessMaster2023 cluster-worker <address>
+*	and the coordinator is any interactive engine started with "--cluster <address>[,<address>...]".
+*	An address is either "unix:<path>" or "[<host>:]<port>" (a worker listens on all the interfaces without a host).
+*
+*	The search is Lazy SMP-like: every worker searches the same root position as the coordinator
+*	until the coordinator stops, and the deep transposition table entries are exchanged in batches meanwhile,
+*	so the searches cut off each other's subtrees and diverge. The coordinator relays the entries of
+*	every worker to the other ones. The best move of the deepest completed iteration wins.
+*
+*	The protocol is line-based, from the coordinator:
+*		position <fen>
+*		go <id>
+*		stop
+*		tt <hash> <data> [<hash> <data>...] (the entries in hex, the data as TableEntry::getData())
+*		shutdown (the worker exits)
+*	and from the worker:
+*		info <id> <depth> <value> <nodes> <best move>
+*		bestmove <id> <move> <value>
+*		tt ...
+*/
+
+namespace engine {
+	// The entries of at least this depth are exchanged
+	constexpr u8 CLUSTER_SHARED_ENTRY_DEPTH = 8;
+
+	// Sets the comma separated addresses of the workers, the connections are made at the first search
+	void setClusterWorkers(std::string_view addresses);
+
+	// The same as rootSearch, but the workers help if there are any
+	SearchResult clusterRootSearch(Board& board);
+
+	// Runs a worker with the command line arguments following "cluster-worker"
+	// Returns false on incorrect arguments or if the address cannot be listened on
+	bool runClusterWorker(const std::vector<std::string>& args);
+}
@@ -18,12 +18,23 @@
 
 #include "Engine.h"
 #include <chrono>
+#include <thread>
 
 #include "Utils/CommandHandlingUtils.h"
 #include "Utils/StringUtils.h"
+#include "Book.h"
+#include "EpdSuite.h"
 #include "Eval.h"
+#include "Learning.h"
+#include "MateSolver.h"
+#include "MCTS.h"
+#include "PerftSuite.h"
+#include "Cluster.h"
 #include "Search.h"
+#include "Syzygy.h"
+#include "Tablebases.h"
 #include "Test.h"
+#include "TranspositionTable.h"
 #include "Tuning.h"
 
 namespace engine {
@@ -50,7 +61,7 @@ namespace engine {
 	void consoleGo() {
 		g_limits.reset();
 
-		SearchResult result = rootSearch(g_board);
+		SearchResult result = g_mctsSettings.isEnabled ? mctsRootSearch(g_board) : clusterRootSearch(g_board);
 		if (result.best.isNullMove()) {
 			return;
 		}
@@ -77,6 +88,7 @@ namespace engine {
 			"\n\tdo [move] - to make a move"\
 			"\n\tundo - to unmake a move"\
 			"\n\trandom - toggles the random mode, where the engine makes more random moves"\
+			"\n\tmtdf - toggles the MTD(f) root search, which finds the value with the zero window searches instead of the aspiration windows"\
 			"\n\tforce - sets the force mode, where the engine doesn't make moves and only accepts input"\
 			"\n\tlevel [control: uint] [base time: minutes:seconds] [inc time: seconds] - sets time limits"\
 			"\n\tset_max_nodes [nodes: u64] - sets nodes limit"\
@@ -87,6 +99,20 @@ namespace engine {
 			"\n\teval - returns static evaluation of the current position"\
 			"\n\tsearch [depth: uint] - returns the position evaluation based on search for given depth"\
 			"\n\tperft [depth: uint] - starts the performance test for the given depth and prints the number of nodes"\
+			"\n\tdivide [depth: uint] - perft that prints the number of nodes for every move"\
+			"\n\tperftsuite [file: epd] [optional: max depth, 6 by default] - checks perft results for positions like <fen> ;D1 20 ;D2 400"\
+			"\n\tepdsuite [file: epd] [limit: <ms>, <ms>ms or <nodes>n] [optional: threads, 1 by default] - solves a test suite with bm/am and prints the time to solution"\
+			"\n\tsavehash [file] - saves the transposition table to the file"\
+			"\n\tloadhash [file] - loads the transposition table saved by savehash"\
+			"\n\tautosavehash [file] [minutes: uint] - saves the transposition table every given minutes in the background, 0 stops it"\
+			"\n\tlearning [file|off] - remembers the deep search results in the file and uses them in the next searches"\
+			"\n\tbook [file|off] [optional: best|random, random by default] - plays the moves from the opening book without searching"\
+			"\n\tmakebook [from: pgn file] [to: book file] [optional: max plies, 20 by default] [optional: min games, 2 by default] - builds an opening book from the games"\
+			"\n\tmate [moves: uint] - looks for a mate in at most the given number of moves (any for 0) with the proof-number search"\
+			"\n\ttablebases [directory|off] - probes the 3- and 4-man tablebases from the directory in the search"\
+			"\n\ttbgen [directory] [optional: threads] - generates the missing 3- and 4-man tablebases in the directory and probes them"\
+			"\n\tsyzygy [directories|off] [optional: probe limit, 7 by default] - probes the Syzygy tablebases from the directories in the search"\
+			"\n\tmcts [threads|off] - searches with the Monte-Carlo tree search on the given number of threads instead of alpha-beta"\
 			"\n\t? - stops the current search and prints the results or makes a move immediately"\
 			"\n\ttest - developer's command, runs all the tests"\
 			"\n\tcompute_eval_err/ceerr [optinal: filename, default: test_suit.fen] - conputes the error of static evaluation for the given positions"\
@@ -158,6 +184,7 @@ namespace engine {
 					io::g_out << io::Color::Red << "Cannot unmake move: " << g_errorMessage << std::endl;
 				} break;
 			CASE_CMD("random", 0, 0) options::g_randomMode = !options::g_randomMode; break;
+			CASE_CMD("mtdf", 0, 0) options::g_mtdfMode = !options::g_mtdfMode; break;
 			CASE_CMD("force", 0, 0) options::g_forceMode = true; break;
 			CASE_CMD("level", 3, 3) {
 				const u32 control = str_utils::fromString<u32>(args[0]);
@@ -205,6 +232,109 @@ namespace engine {
 					<< "Time: " << io::Color::Blue << perftTimeInSeconds << io::Color::White << " seconds" << std::endl
 					<< "Kn/S: " << io::Color::Blue << kiloNodesPerSecond << io::Color::White << " kilonodes per second" << std::endl;
 			} break;
+			CASE_CMD("divide", 1, 1) perftDivide(g_board, str_utils::fromString<u8>(args[0])); break;
+			CASE_CMD("perftsuite", 1, 2) 
+				runPerftSuite(args[0], args.size() > 1 ? str_utils::fromString<u8>(args[1]) : 6);
+				break;
+			CASE_CMD("epdsuite", 2, 3)
+				runEpdSuite(args[0], args[1], args.size() > 2 ? str_utils::fromString<u32>(args[2]) : 1);
+				break;
+			CASE_CMD("savehash", 1, 1)
+				if (TranspositionTable::save(args[0])) {
+					io::g_out << io::Color::Green << "The hash was saved to " << args[0] << std::endl;
+				} else {
+					io::g_out << io::Color::Red << "Cannot save the hash to " << args[0] << std::endl;
+				}
+				break;
+			CASE_CMD("loadhash", 1, 1)
+				if (TranspositionTable::load(args[0])) {
+					io::g_out << io::Color::Green << "The hash was loaded from " << args[0] << std::endl;
+				} else {
+					io::g_out << io::Color::Red << "Cannot load the hash from " << args[0] << ", it is missing or corrupted" << std::endl;
+				}
+				break;
+			CASE_CMD("autosavehash", 2, 2)
+				TranspositionTable::setAutosave(args[0], str_utils::fromString<u32>(args[1]));
+				break;
+			CASE_CMD("learning", 1, 1)
+				if (args[0] == "off") {
+					LearningStore::close();
+				} else if (LearningStore::open(args[0])) {
+					io::g_out << io::Color::Green << "Using the learning store " << args[0] << std::endl;
+				} else {
+					io::g_out << io::Color::Red << "Cannot open the learning store " << args[0] << std::endl;
+				}
+				break;
+			CASE_CMD("book", 1, 2)
+				Book::setBestMoveMode(args.size() > 1 && args[1] == "best");
+				if (args[0] == "off") {
+					Book::close();
+				} else if (Book::open(args[0])) {
+					io::g_out << io::Color::Green << "Using the book " << args[0] << std::endl;
+				} else {
+					io::g_out << io::Color::Red << "Cannot open the book " << args[0] << std::endl;
+				}
+				break;
+			CASE_CMD("makebook", 2, 4) {
+				const u32 maxPlies = args.size() > 2 ? str_utils::fromString<u32>(args[2]) : Book::DEFAULT_MAX_PLIES;
+				const u32 minGames = args.size() > 3 ? str_utils::fromString<u32>(args[3]) : Book::DEFAULT_MIN_GAMES;
+
+				Book::close(); // The book may be the one being rewritten
+				if (const i64 entries = Book::build(args[0], args[1], maxPlies, minGames); entries >= 0) {
+					io::g_out << io::Color::Green << "The book " << args[1] << " has " << entries << " moves" << std::endl;
+				} else {
+					io::g_out << io::Color::Red << "Cannot write the book to " << args[1] << std::endl;
+				}
+			} break;
+			CASE_CMD("mate", 1, 1) {
+				g_limits.reset();
+
+				MoveList pv;
+				const Depth moves = solveMate(g_board, str_utils::fromString<u32>(args[0]), pv);
+				if (moves) {
+					io::g_out << "Mate in " << io::Color::Blue << moves << io::Color::White << ": " << pv.toString() << std::endl;
+				} else {
+					io::g_out << io::Color::Red << "No mate found within the limits" << std::endl;
+				}
+			} break;
+			CASE_CMD("mcts", 1, 1)
+				g_mctsSettings.isEnabled = args[0] != "off";
+				if (g_mctsSettings.isEnabled) {
+					g_mctsSettings.threads = std::max(1u, str_utils::fromString<u32>(args[0]));
+				}
+
+				break;
+			CASE_CMD("tablebases", 1, 1)
+				if (args[0] == "off") {
+					Tablebases::close();
+				} else if (const u32 tables = Tablebases::open(args[0]); tables) {
+					io::g_out << io::Color::Green << "Using " << tables << " tablebases from " << args[0] << std::endl;
+				} else {
+					io::g_out << io::Color::Red << "No tablebases found in " << args[0] << std::endl;
+				}
+				break;
+			CASE_CMD("syzygy", 1, 2)
+				if (args[0] == "off") {
+					Syzygy::close();
+				} else if (const u32 tables = Syzygy::open(args[0]); tables) {
+					Syzygy::setProbeLimit(args.size() > 1 ? str_utils::fromString<u32>(args[1]) : Syzygy::MAX_PIECES);
+					io::g_out << io::Color::Green << "Using " << tables << " Syzygy tables from " << args[0] << std::endl;
+				} else {
+					io::g_out << io::Color::Red << "No Syzygy tables found in " << args[0] << std::endl;
+				}
+				break;
+			CASE_CMD("tbgen", 1, 2) {
+				using namespace std::chrono;
+
+				const u32 threads = args.size() > 1 ? std::max(1u, str_utils::fromString<u32>(args[1])) : std::max(1u, std::thread::hardware_concurrency());
+				const auto start = steady_clock::now();
+				if (Tablebases::generate(args[0], threads)) {
+					io::g_out << io::Color::Green << "The tablebases are ready in " << args[0] << io::Color::White << " ("
+						<< duration_cast<seconds>(steady_clock::now() - start).count() << " seconds)" << std::endl;
+				} else {
+					io::g_out << io::Color::Red << "Cannot write the tablebases to " << args[0] << std::endl;
+				}
+			} break;
 			IGNORE_CMD("?")
 			CASE_CMD("test", 0, 0) {
 				runTests();
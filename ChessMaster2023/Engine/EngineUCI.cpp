@@ -21,16 +21,119 @@
 
 #include "Utils/CommandHandlingUtils.h"
 #include "Utils/StringUtils.h"
+#include "Book.h"
+#include "Learning.h"
+#include "MateSolver.h"
+#include "MCTS.h"
+#include "Cluster.h"
 #include "Search.h"
+#include "Syzygy.h"
+#include "Tablebases.h"
+#include "TranspositionTable.h"
 
 namespace engine {
-	void uciGo() {
-		SearchResult result = rootSearch(g_board);
+	std::string g_hashFileName = "ChessMaster2023.hash"; // The file for the Save Hash/Load Hash/Hash Autosave options
+
+	constexpr Depth MATE_FALLBACK_DEPTH = 8; // The depth of the search that picks the move when no mate is found
 
-		io::g_out << "bestmove " << result.best << std::endl;
-		g_board.makeMove(result.best);
+	void playBestMoveUCI(const Move best) {
+		io::g_out << "bestmove " << best << std::endl;
+		g_board.makeMove(best);
 		g_limits.addMoves(1);
-		g_moveHistory.push_back(result.best);
+		g_moveHistory.push_back(best);
+	}
+
+	void uciGo() {
+		SearchResult result = g_mctsSettings.isEnabled ? mctsRootSearch(g_board) : clusterRootSearch(g_board);
+		playBestMoveUCI(result.best);
+	}
+
+	// go mate <moves>: the mate solver is used instead of the search
+	void uciGoMate(const Depth moves) {
+		MoveList pv;
+		if (solveMate(g_board, moves, pv)) {
+			playBestMoveUCI(pv[0]);
+			return;
+		}
+
+		io::g_out << "info string No mate in " << moves << " found" << std::endl;
+
+		// The best move must be given anyway
+		const Limits limits = g_limits;
+		g_limits.setDepthLimit(MATE_FALLBACK_DEPTH);
+		const SearchResult result = rootSearch(g_board);
+		g_limits = limits;
+
+		playBestMoveUCI(result.best);
+	}
+
+	// setoption name <name> [value <value>], both may consist of several words
+	void setOptionUCI(const std::vector<std::string>& args) {
+		const auto valueIt = std::find(args.begin(), args.end(), "value");
+
+		std::string name;
+		for (auto it = args.begin() + 1; it != valueIt; it++) {
+			name.append(name.empty() ? "" : " ").append(*it);
+		}
+
+		std::string value;
+		for (auto it = valueIt; it != args.end() && ++it != args.end(); ) {
+			value.append(value.empty() ? "" : " ").append(*it);
+		}
+
+		if (name == "Hash") {
+			TranspositionTable::init(std::max<size_t>(1, str_utils::fromString<u32>(value)) * 1024 * 1024);
+		} else if (name == "Hash File") {
+			g_hashFileName = value;
+		} else if (name == "Save Hash") {
+			if (!TranspositionTable::save(g_hashFileName)) {
+				io::g_out << "info string Cannot save the hash to " << g_hashFileName << std::endl;
+			}
+		} else if (name == "Load Hash") {
+			if (!TranspositionTable::load(g_hashFileName)) {
+				io::g_out << "info string Cannot load the hash from " << g_hashFileName << std::endl;
+			}
+		} else if (name == "Hash Autosave") {
+			TranspositionTable::setAutosave(g_hashFileName, str_utils::fromString<u32>(value));
+		} else if (name == "MTDf") {
+			options::g_mtdfMode = value == "true";
+		} else if (name == "Nodes Per Second") {
+			options::g_nodesPerSecond = str_utils::fromString<u64>(value);
+		} else if (name == "MCTS") {
+			g_mctsSettings.isEnabled = value == "true";
+		} else if (name == "MCTS Threads") {
+			g_mctsSettings.threads = std::max(1u, str_utils::fromString<u32>(value));
+		} else if (name == "MCTS Memory") {
+			g_mctsSettings.memoryMegabytes = std::max(1u, str_utils::fromString<u32>(value));
+		} else if (name == "Learning File") {
+			if (value.empty() || value == "<empty>") {
+				LearningStore::close();
+			} else if (!LearningStore::open(value)) {
+				io::g_out << "info string Cannot open the learning store " << value << std::endl;
+			}
+		} else if (name == "Book File") {
+			if (value.empty() || value == "<empty>") {
+				Book::close();
+			} else if (!Book::open(value)) {
+				io::g_out << "info string Cannot open the book " << value << std::endl;
+			}
+		} else if (name == "Book Best Move") {
+			Book::setBestMoveMode(value == "true");
+		} else if (name == "Tablebase Path") {
+			if (value.empty() || value == "<empty>") {
+				Tablebases::close();
+			} else if (!Tablebases::open(value)) {
+				io::g_out << "info string No tablebases found in " << value << std::endl;
+			}
+		} else if (name == "SyzygyPath") {
+			if (value.empty() || value == "<empty>") {
+				Syzygy::close();
+			} else if (!Syzygy::open(value)) {
+				io::g_out << "info string No Syzygy tables found in " << value << std::endl;
+			}
+		} else if (name == "SyzygyProbeLimit") {
+			Syzygy::setProbeLimit(str_utils::fromString<u32>(value));
+		}
 	}
 
 	void handleIncorrectCommandUCI(std::string_view cmd, const std::vector<std::string>& args, CommandError err) {
@@ -43,12 +146,12 @@ namespace engine {
 			CASE_CMD_WITH_VARIANT("quit", "q", 0, 0) return false;
 			CASE_CMD("debug", 1, 1) options::g_debugMode = (args[0] == "on"); break;
 			CASE_CMD("isready", 0, 0) io::g_out << "readyok" << std::endl; break;
-			CASE_CMD("setoption", 1, 2) {
-				// TODO: implement
+			CASE_CMD("setoption", 2, 9999) {
+				setOptionUCI(args);
 			} break;
 			IGNORE_CMD("register")
 			CASE_CMD("ucinewgame", 0, 0) {
-				// May do something to reset the search state
+				TranspositionTable::clear();
 			} break;
 			CASE_CMD("position", 1, 9999) {
 				g_moveHistory.clear();
@@ -70,6 +173,12 @@ namespace engine {
 				u32 movesTillControl = 0;
 				time_t incTime = 0;
 				time_t timeLeft = 0;
+				Depth mateMoves = 0;
+
+				// The mate search is not limited by the time control of the game, only by the limits given with it
+				if (std::find(args.begin(), args.end(), "mate") != args.end()) {
+					g_limits.makeInfinite();
+				}
 
 				for (auto it = args.begin(); it != args.end(); it++) {
 					if (*it == "infinite") {
@@ -90,7 +199,9 @@ namespace engine {
 					} else if ((*it == "wtime" && g_board.side() == Color::WHITE)
 							 || (*it == "btime" && g_board.side() == Color::BLACK)) {
 						timeLeft = str_utils::fromString<u32>(*(++it));
-					} // TODO: implement searchmoves, ponder, mate
+					} else if (*it == "mate") {
+						mateMoves = str_utils::fromString<u32>(*(++it));
+					} // TODO: implement searchmoves, ponder
 				}
 
 				if (movesTillControl || incTime) {
@@ -101,7 +212,11 @@ namespace engine {
 					g_limits.reset(timeLeft);
 				}
 
-				uciGo();
+				if (mateMoves) {
+					uciGoMate(mateMoves);
+				} else {
+					uciGo();
+				}
 			} break;
 			IGNORE_CMD("stop")
 			IGNORE_CMD("ponderhit")
@@ -20,12 +20,15 @@
 #include "Utils/CommandHandlingUtils.h"
 #include "Utils/StringUtils.h"
 #include "ChessMasterInfo.h"
+#include "Cluster.h"
 #include "Search.h"
+#include "TranspositionTable.h"
 #include "Eval.h"
 
 namespace engine {
 	time_t g_timeLeft = 0;
 	Value g_initialPositionValue = 0; // The evaluated value of the position the engine began the game from
+	bool g_isAnalysisRunning = false; // While it is, the board is somewhere inside the search tree
 
 	///  SOME OF XBOARD COMMANDS HANDLING  ///
 
@@ -62,7 +65,7 @@ namespace engine {
 	void xboardGo() {
 		g_limits.reset(g_timeLeft);
 
-		SearchResult result = rootSearch(g_board);
+		SearchResult result = clusterRootSearch(g_board);
 		if (result.best.isNullMove()) {
 			if (xboardCheckForGameOver()) {
 				return;
@@ -85,21 +88,63 @@ namespace engine {
 		g_moveHistory.push_back(result.best);
 	}
 
+	// The analysis is stopped only by the commands changing the position (the others are served while searching),
+	// and it is resumed warm after them, unless the position is a new one
 	void xboardAnalyze() {
 		g_limits = Limits();
 		options::g_postMode = true;
 
-		while (true) {
-			rootSearch(g_board);
+		bool isResumed = false;
+		while (options::g_analyzeMode) {
+			g_isAnalysisRunning = true;
+			rootSearch(g_board, isResumed);
+			g_isAnalysisRunning = false;
+			isResumed = true;
 
-			if (options::g_analyzeMode) {
-				if (io::hasCommandsInQueue()) {
-					std::vector<std::string> args;
-					std::string cmd = io::getCommand(args, true);
-					handleXboard(cmd, args);
-				}
-			} else {
-				break;
+			// The search that ended by itself (reached the maximal depth or found a mate) waits for a command
+			std::vector<std::string> args;
+			do {
+				std::string cmd = io::getCommand(args, true);
+				isResumed &= cmd != "new" && cmd != "setboard";
+				handleXboard(std::move(cmd), args);
+			} while (io::hasCommandsInQueue() && options::g_analyzeMode);
+		}
+	}
+
+	// stat01: <time> <nodes> <depth> <moves left> <moves total> <current move>
+	void xboardPrintStatus() {
+		const SearchStatus status = getSearchStatus();
+		io::g_out << "stat01: " << status.milliseconds / 10 << ' ' << status.nodes << ' ' << status.depth << ' '
+			<< status.rootMovesCount - std::min(status.rootMovesSearched, status.rootMovesCount) << ' ' << status.rootMovesCount;
+
+		if (!status.rootMove.isNullMove()) {
+			io::g_out << ' ' << status.rootMove;
+		}
+
+		io::g_out << std::endl;
+	}
+
+	// The best move of the running analysis, or else the one of the transposition table, found by the previous search
+	void xboardPrintHint() {
+		if (g_isAnalysisRunning) {
+			if (const Move best = getSearchStatus().bestMove; !best.isNullMove()) {
+				io::g_out << "Hint: " << best << std::endl;
+			}
+
+			return;
+		}
+
+		TableEntry entry;
+		if (!TranspositionTable::probe(g_board.computeHash(), entry) || !entry.move) {
+			return;
+		}
+
+		MoveList moves;
+		g_board.generateMoves(moves);
+		for (Move m : moves) {
+			if (m.getData() == entry.move && g_board.isLegal(m)) {
+				io::g_out << "Hint: " << m << std::endl;
+				return;
 			}
 		}
 	}
@@ -159,7 +204,7 @@ namespace engine {
 			} break;
 			CASE_CMD("st", 1, 1) g_limits.setTimeLimits(0, 0, str_utils::fromString<u32>(args[0])); break;
 			CASE_CMD("sd", 1, 1) g_limits.setDepthLimit(str_utils::fromString<u8>(args[0])); break;
-			CASE_CMD("nps", 1, 1) break; // TODO: implement
+			CASE_CMD("nps", 1, 1) options::g_nodesPerSecond = str_utils::fromString<u64>(args[0]); break;
 			CASE_CMD("time", 1, 1) g_timeLeft = str_utils::fromString<u32>(args[0]) * 10; break;
 			IGNORE_CMD("otim")
 			CASE_CMD("usermove", 1, 1) 
@@ -185,7 +230,11 @@ namespace engine {
 
 					g_initialPositionValue = eval(g_board);
 				} break;
-			CASE_CMD("hint", 0, 0) break; // TODO: implement hinting
+			CASE_CMD("hint", 0, 0) xboardPrintHint(); break;
+			CASE_CMD(".", 0, 0)
+				if (options::g_analyzeMode) {
+					xboardPrintStatus();
+				} break;
 			IGNORE_CMD("bk") // When the user chooses the "Book" option in the menu
 			CASE_CMD("undo", 0, 0)
 				if (!unmakeMove()) {
@@ -198,13 +247,13 @@ namespace engine {
 			IGNORE_CMD("hard") // Should turn pondering on
 			IGNORE_CMD("easy") // Should turn pondering off
 			CASE_CMD("post", 0, 0) options::g_postMode = true; break;
-			CASE_CMD("nopost", 0, 0) options::g_postMode = true; break;
+			CASE_CMD("nopost", 0, 0) options::g_postMode = false; break;
 			CASE_CMD("analyze", 0, 0)
 				if (!options::g_analyzeMode) {
 					options::g_analyzeMode = true;
 					xboardAnalyze();
 				} break;
-			IGNORE_CMD("exit")
+			CASE_CMD("exit", 0, 0) options::g_analyzeMode = false; break;
 			CASE_CMD("name", 1, 999) {
 				options::g_isPlayingAgainstSelf = (io::getAllArguments().find(ENGINE_NAME) != std::string_view::npos);
 			} break;
@@ -219,10 +268,20 @@ namespace engine {
 
 	void checkXboard(std::string cmd, const std::vector<std::string>& args) {
 		const static Hash s_acceptedCommands[] = { // Commands that are handled right away
-			HASH_OF("usermove"), HASH_OF("undo"), HASH_OF("new"), HASH_OF("setboard"), HASH_OF("exit"), 
-			HASH_OF("."), HASH_OF("?"), HASH_OF("q"), HASH_OF("quit")
+			HASH_OF("usermove"), HASH_OF("undo"), HASH_OF("remove"), HASH_OF("new"), HASH_OF("setboard"), HASH_OF("exit"), 
+			HASH_OF("?"), HASH_OF("q"), HASH_OF("quit")
+		};
+
+		const static Hash s_servedCommands[] = { // Commands that do not change the position are served without stopping the analysis
+			HASH_OF("."), HASH_OF("hint"), HASH_OF("ping"), HASH_OF("post"), HASH_OF("nopost"), HASH_OF("computer"), HASH_OF("name"),
+			HASH_OF("rating"), HASH_OF("ics"), HASH_OF("time"), HASH_OF("otim"), HASH_OF("easy"), HASH_OF("hard"), HASH_OF("accepted")
 		};
 
+		if (options::g_analyzeMode && isOneOf(cmd, s_servedCommands)) {
+			handleXboard(std::move(cmd), args);
+			return;
+		}
+
 		if (!isOneOf(cmd, s_acceptedCommands)) {
 			io::pushCommand(std::move(cmd), args);
 			return;
@@ -0,0 +1,340 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "EpdSuite.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Utils/IO.h"
+#include "Utils/StringUtils.h"
+#include "Chess/Board.h"
+#include "Search.h"
+
+namespace engine {
+	// A position of the suite with the moves expected from the engine
+	struct EpdPosition final {
+		u32 line;
+		std::string fen;
+		std::string id;
+		std::vector<Move> bestMoves;
+		std::vector<Move> avoidMoves;
+
+		CM_PURE bool isSolution(const Move m) const noexcept {
+			const auto isSame = [m](const Move other) { return other.getData() == m.getData(); };
+
+			return !m.isNullMove()
+				&& (bestMoves.empty() || std::any_of(bestMoves.begin(), bestMoves.end(), isSame))
+				&& std::none_of(avoidMoves.begin(), avoidMoves.end(), isSame);
+		}
+	};
+
+	// The result of the search of a single position
+	struct EpdResult final {
+		Move found = Move::makeNullMove();
+		bool isSolved = false;
+
+		// The moment since which the best move has been correct
+		time_t solvedAtMs = 0;
+		NodesCount solvedAtNodes = 0;
+		Depth solvedAtDepth = 0;
+		bool isSolutionFound = false;
+
+		time_t totalMs = 0;
+		NodesCount totalNodes = 0;
+	};
+
+	// Splits the operations of an EPD line into the opcode and its operands
+	// Quoted operands may contain spaces and semicolons
+	std::vector<std::vector<std::string>> parseEpdOperations(std::string_view str) {
+		std::vector<std::vector<std::string>> result;
+		std::vector<std::string> operation;
+		std::string token;
+		bool isQuoted = false;
+
+		const auto finishToken = [&]() {
+			if (!token.empty()) {
+				operation.push_back(std::move(token));
+				token.clear();
+			}
+		};
+
+		for (const char ch : str) {
+			if (ch == '"') {
+				isQuoted = !isQuoted;
+			} else if (isQuoted) {
+				token += ch;
+			} else if (ch == ';') {
+				finishToken();
+				if (!operation.empty()) {
+					result.push_back(std::move(operation));
+					operation.clear();
+				}
+			} else if (isspace(ch)) {
+				finishToken();
+			} else {
+				token += ch;
+			}
+		}
+
+		finishToken();
+		if (!operation.empty()) {
+			result.push_back(std::move(operation));
+		}
+
+		return result;
+	}
+
+	// Parses a line of an EPD suite: <4 FEN fields> <operations>
+	// Returns false if the line has no correct position or no move to check
+	bool parseEpdLine(std::string_view line, EpdPosition& position, std::string& error) {
+		std::vector<std::string_view> tokens = str_utils::split(line, " \t\r");
+		if (tokens.size() < 4) {
+			error = "not enough FEN fields";
+			return false;
+		}
+
+		// EPD contains only 4 fields of FEN, the rest are operations
+		// The move counters are completed, so that the position is set up fully
+		position.fen.clear();
+		for (size_t i = 0; i < 4; i++) {
+			position.fen.append(position.fen.empty() ? "" : " ").append(tokens[i]);
+		}
+
+		position.fen.append(" 0 1");
+
+		bool success;
+		Board board = Board::fromFEN(position.fen, success);
+		if (!success) {
+			error = "incorrect FEN";
+			return false;
+		}
+
+		const size_t operationsStart = tokens[3].data() + tokens[3].size() - line.data();
+		for (const auto& operation : parseEpdOperations(line.substr(operationsStart))) {
+			const std::string& opcode = operation[0];
+			if (opcode == "id" && operation.size() > 1) {
+				position.id = operation[1];
+			} else if (opcode == "bm" || opcode == "am") {
+				for (size_t i = 1; i < operation.size(); i++) {
+					Move m = board.makeMoveFromSAN(operation[i]);
+					if (m.isNullMove()) {
+						m = board.makeMoveFromString(operation[i]);
+					}
+
+					if (m.isNullMove()) {
+						error = "incorrect move " + operation[i];
+						return false;
+					}
+
+					(opcode == "bm" ? position.bestMoves : position.avoidMoves).push_back(m);
+				}
+			}
+		}
+
+		if (position.bestMoves.empty() && position.avoidMoves.empty()) {
+			error = "no bm or am";
+			return false;
+		}
+
+		return true;
+	}
+
+	// Searches the positions until there are none left, every thread has its own search state
+	void solveEpdPositions(
+		const std::vector<EpdPosition>& positions,
+		std::vector<EpdResult>& results,
+		std::atomic<u32>& nextPosition,
+		const u64 limit,
+		const bool isNodesLimit,
+		std::mutex& outputMutex
+	) {
+		EpdResult* current = nullptr;
+		const EpdPosition* position = nullptr;
+
+		g_reporting.checkInput = false;
+		g_reporting.isAnalysis = true;
+		g_reporting.onIteration = [&](const IterationInfo& info) {
+			if (info.pv.size() && position->isSolution(info.pv[0])) {
+				if (!current->isSolutionFound) {
+					current->isSolutionFound = true;
+					current->solvedAtMs = info.milliseconds;
+					current->solvedAtNodes = info.nodes;
+					current->solvedAtDepth = info.depth;
+				}
+			} else {
+				current->isSolutionFound = false;
+			}
+		};
+
+		initSearch();
+		for (u32 i; (i = nextPosition++) < positions.size(); ) {
+			position = &positions[i];
+			current = &results[i];
+
+			g_limits = Limits();
+			if (isNodesLimit) {
+				g_limits.makeInfinite();
+				g_limits.setNodesLimit(limit);
+			} else {
+				g_limits.setTimeLimitsInMs(0, 0, time_t(limit));
+				g_limits.reset(time_t(limit));
+			}
+
+			bool success;
+			Board board = Board::fromFEN(position->fen, success);
+			const SearchResult result = rootSearch(board);
+
+			current->found = result.best;
+			current->isSolved = current->isSolutionFound && position->isSolution(result.best);
+			current->totalMs = g_limits.elapsedMilliseconds();
+			current->totalNodes = getNodesCount();
+
+			std::lock_guard lock(outputMutex);
+			io::g_out << (current->isSolved ? io::Color::Green : io::Color::Red)
+				<< (current->isSolved ? "Solved " : "Failed ") << io::Color::White
+				<< position->id << " (line " << position->line << "): " << result.best << std::endl;
+		}
+
+		g_reporting = SearchReporting();
+	}
+
+	bool runEpdSuite(const std::string& fileName, std::string_view limit, const u32 threadsCount) {
+		u32 i = 0;
+		const u64 limitValue = str_utils::fromString<u64>(limit, i);
+		const std::string_view limitUnit = limit.substr(i);
+		if (!limitValue || (limitUnit != "" && limitUnit != "ms" && limitUnit != "n" && limitUnit != "nodes")) {
+			io::g_out << io::Color::Red << "Incorrect limit: " << limit << ", expected <ms>, <ms>ms or <nodes>n" << std::endl;
+			return false;
+		}
+
+		std::ifstream file(fileName);
+		if (!file.is_open()) {
+			io::g_out << io::Color::Red << "Cannot open the EPD suite: " << fileName << std::endl;
+			return false;
+		}
+
+		// Reading the suite
+		std::vector<EpdPosition> positions;
+		std::string line;
+		std::string error;
+
+		for (u32 lineNumber = 1; std::getline(file, line); lineNumber++) {
+			if (line.empty() || line[0] == '#' || line.find_first_not_of(" \t\r") == std::string::npos) {
+				continue;
+			}
+
+			EpdPosition position { .line = lineNumber };
+			if (!parseEpdLine(line, position, error)) {
+				io::g_out << io::Color::Red << "Line " << lineNumber << " skipped: " << error << std::endl;
+				continue;
+			}
+
+			if (position.id.empty()) {
+				position.id = "line " + std::to_string(lineNumber);
+			}
+
+			positions.push_back(std::move(position));
+		}
+
+		// Solving the positions in parallel
+		const u32 workersCount = std::clamp<u32>(threadsCount, 1, std::max<u32>(1, u32(positions.size())));
+		io::g_out << "Positions: " << io::Color::Blue << positions.size() << io::Color::White
+			<< ", threads: " << io::Color::Blue << workersCount << std::endl;
+
+		std::vector<EpdResult> results(positions.size());
+		std::atomic<u32> nextPosition = 0;
+		std::mutex outputMutex;
+		const bool isNodesLimit = limitUnit == "n" || limitUnit == "nodes";
+
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> workers;
+		for (u32 w = 0; w < workersCount; w++) {
+			workers.emplace_back([&, w]() {
+				bindSearchThread(w);
+				solveEpdPositions(positions, results, nextPosition, limitValue, isNodesLimit, outputMutex);
+			});
+		}
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+		const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+		// Per-position results
+		io::g_out << std::endl << "id,line,solved,found,expected,time_ms,nodes,depth,total_time_ms,total_nodes" << std::endl;
+
+		u32 solvedCount = 0;
+		time_t solvedTotalMs = 0;
+		NodesCount solvedTotalNodes = 0;
+		NodesCount totalNodes = 0;
+
+		for (size_t p = 0; p < positions.size(); p++) {
+			const EpdPosition& position = positions[p];
+			const EpdResult& result = results[p];
+
+			std::string expected;
+			for (Move m : position.bestMoves) {
+				expected.append(expected.empty() ? "" : " ").append(m.toString());
+			}
+
+			for (Move m : position.avoidMoves) {
+				expected.append(expected.empty() ? "!" : " !").append(m.toString());
+			}
+
+			io::g_out << '"' << position.id << "\"," << position.line << ',' << result.isSolved << ','
+				<< result.found.toString() << ',' << expected << ',';
+			if (result.isSolved) {
+				io::g_out << result.solvedAtMs << ',' << result.solvedAtNodes << ',' << result.solvedAtDepth << ',';
+			} else {
+				io::g_out << ",,,";
+			}
+
+			io::g_out << result.totalMs << ',' << result.totalNodes << std::endl;
+
+			totalNodes += result.totalNodes;
+			if (result.isSolved) {
+				++solvedCount;
+				solvedTotalMs += result.solvedAtMs;
+				solvedTotalNodes += result.solvedAtNodes;
+			}
+		}
+
+		// The summary
+		io::g_out << std::endl << "Solved: " << io::Color::Blue << solvedCount << io::Color::White
+			<< " of " << io::Color::Blue << positions.size() << std::endl;
+		if (solvedCount) {
+			io::g_out << "Mean time to solution: " << io::Color::Blue << std::fixed << std::setprecision(1)
+				<< double(solvedTotalMs) / solvedCount << io::Color::White << " ms" << std::endl
+				<< "Mean nodes to solution: " << io::Color::Blue << std::setprecision(0)
+				<< double(solvedTotalNodes) / solvedCount << std::endl;
+		}
+
+		io::g_out << "Nodes: " << io::Color::Blue << totalNodes << std::endl
+			<< "Time: " << io::Color::Blue << std::fixed << std::setprecision(3) << elapsed / 1000.0 << io::Color::White << " seconds" << std::endl;
+
+		io::g_out << std::defaultfloat << std::setprecision(6);
+		return true;
+	}
+}
@@ -0,0 +1,39 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <string>
+
+#include "Utils/Types.h"
+
+/*
+*	EpdSuite(.h/.cpp) contains the runner for the test suites like WAC, ECM or STS.
+*
+*	A suite is an EPD file with a position and its operations on each line:
+*		2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - bm Qg6; id "WAC.001";
+*	The operations used are bm (the best moves), am (the moves to avoid) and id (the name of the position).
+*/
+
+namespace engine {
+	// Searches every position of the file with the given limit: "<ms>" or "<ms>ms" for time, "<nodes>n" for nodes
+	// The positions are searched in parallel on <threadsCount> threads sharing the transposition table
+	// Prints the time and nodes at which the correct move appeared and stayed as the best one,
+	// as CSV for every position, then the solved count and the mean time to solution
+	// Returns false if the file cannot be read or the limit is incorrect
+	bool runEpdSuite(const std::string& fileName, std::string_view limit, const u32 threadsCount);
+}
@@ -17,9 +17,13 @@
 */
 
 #include "Eval.h"
+#include "Bitbase.h"
 #include "PawnHashTable.h"
 
 namespace engine {
+	constexpr Value KPK_WIN = SURE_WIN / 2; // Below KXK, so that the pawn is promoted
+	constexpr Value KPK_PAWN_RANK_BONUS = 20;
+
 	// Checks if the current position is drawish from the stonger side's POV
 	template<Color::Value StrongSide>
 	CM_PURE bool isDrawishEndgame(Board& board, const u8 strongMat, const u8 weakMat) {
@@ -117,6 +121,24 @@ namespace engine {
 		return (-1 + 2 * (board.side() == Color::WHITE)) * result;
 	}
 
+	// King and pawn versus king is either won or drawn, as the bitbase says
+	// Returns evaluation from the moving side POV
+	template<Color::Value StrongSide>
+	CM_PURE Value evalKPK(Board& board) {
+		constexpr Color::Value WeakSide = Color(StrongSide).getOpposite().value();
+
+		const Square pawn = Square::makeRelativeSquare(StrongSide, board.byPiece(Piece(StrongSide, PieceType::PAWN)).lsb());
+		const Square strongKing = Square::makeRelativeSquare(StrongSide, board.king(StrongSide));
+		const Square weakKing = Square::makeRelativeSquare(StrongSide, board.king(WeakSide));
+
+		if (!bitbase::probeKPK(board.side() == StrongSide, strongKing, pawn, weakKing)) {
+			return 0;
+		}
+
+		const Value result = KPK_WIN + KPK_PAWN_RANK_BONUS * pawn.getRank();
+		return board.side() == StrongSide ? result : -result;
+	}
+
 	// Evaluation by side for the endgame with pawns and kings only
 	template<Color::Value Side>
 	CM_PURE Value evalPawnEndgame(Board& board) {
@@ -208,6 +230,12 @@ namespace engine {
 		///  ENDGAMES  ///
 
 		if (!board.hasNonPawns(Color::WHITE) && !board.hasNonPawns(Color::BLACK)) { // Pawn endgame
+			const BitBoard whitePawns = board.byPiece(Piece::PAWN_WHITE);
+			const BitBoard blackPawns = board.byPiece(Piece::PAWN_BLACK);
+			if (whitePawns.b_or(blackPawns).popcnt() == 1) { // KPK
+				return whitePawns ? evalKPK<Color::WHITE>(board) : evalKPK<Color::BLACK>(board);
+			}
+
 			Value result = evalPawnEndgame<Color::WHITE>(board) - evalPawnEndgame<Color::BLACK>(board);
 			result *= (-1 + 2 * (board.side() == Color::WHITE));
 
@@ -38,6 +38,7 @@
 *		12) Pawn distortion
 * 
 *		13) Separate evaluation functions for: KXK, KPsKPS, KBNK, some drawish endgames
+*		14) KPK from the bitbase
 */
 
 namespace engine {
@@ -0,0 +1,349 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Learning.h"
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace engine {
+	// The records file is a header followed by the records in the order of learning
+	struct LearningFileHeader final {
+		char magic[8];
+		u32 version;
+		u32 reserved;
+	};
+
+	struct LearningRecord final {
+		Hash hash;		// 8b
+		Value value;	// 2b
+		u16 move;		// 2b | Only the move data without its score
+		u8 depth;		// 1b
+		u8 reserved[3]; // 3b
+	};
+
+	// The index file is a header followed by an open addressing hash table of the records
+	struct IndexHeader final {
+		char magic[8];
+		u32 version;
+		u32 reserved;
+		u64 recordsCount; // The number of records indexed, the index is outdated if the records file has another number
+		u64 slotsCount;
+	};
+
+	struct IndexSlot final {
+		Hash hash;
+		u32 record; // The number of the record plus one, 0 for an empty slot
+		u32 depth;  // The depth of the record, so that merging does not read the records
+	};
+
+	static_assert(sizeof(LearningFileHeader) == 16 && sizeof(LearningRecord) == 16);
+	static_assert(sizeof(IndexHeader) == 32 && sizeof(IndexSlot) == 16);
+
+	constexpr char LEARNING_FILE_MAGIC[8] = "CMLEARN";
+	constexpr char INDEX_FILE_MAGIC[8] = "CMLIDX";
+	constexpr u32 LEARNING_FILE_VERSION = 1;
+	constexpr u64 MIN_SLOTS_COUNT = 1024;
+
+	std::mutex g_learningMutex;
+	std::atomic_bool g_isLearningOpen = false;
+
+	std::fstream g_records;
+	u64 g_recordsCount = 0;
+
+	std::string g_indexFileName;
+	IndexHeader* g_index = nullptr; // Either mapped from the index file or allocated
+	size_t g_indexSize = 0;
+	int g_indexFile = -1;
+
+
+	///  INDEX  ///
+
+	inline IndexSlot* getSlots() noexcept {
+		return reinterpret_cast<IndexSlot*>(g_index + 1);
+	}
+
+	void releaseIndex() {
+		if (!g_index) {
+			return;
+		}
+
+#ifndef _WIN32
+		munmap(g_index, g_indexSize);
+		::close(g_indexFile);
+		g_indexFile = -1;
+#else
+		free(g_index);
+#endif // _WIN32
+
+		g_index = nullptr;
+		g_indexSize = 0;
+	}
+
+	// Maps (or allocates) the zero-filled index with the given number of slots
+	bool allocateIndex(const u64 slotsCount) {
+		releaseIndex();
+
+		const size_t size = sizeof(IndexHeader) + slotsCount * sizeof(IndexSlot);
+#ifndef _WIN32
+		g_indexFile = ::open(g_indexFileName.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+		if (g_indexFile < 0 || ftruncate(g_indexFile, off_t(size)) != 0) {
+			return false;
+		}
+
+		void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, g_indexFile, 0);
+		if (memory == MAP_FAILED) {
+			::close(g_indexFile);
+			g_indexFile = -1;
+			return false;
+		}
+
+		g_index = reinterpret_cast<IndexHeader*>(memory);
+#else
+		g_index = reinterpret_cast<IndexHeader*>(calloc(1, size));
+		if (!g_index) {
+			return false;
+		}
+#endif // _WIN32
+
+		g_indexSize = size;
+		memcpy(g_index->magic, INDEX_FILE_MAGIC, sizeof(g_index->magic));
+		g_index->version = LEARNING_FILE_VERSION;
+		g_index->slotsCount = slotsCount;
+		return true;
+	}
+
+	// Maps the index file if it is up to date with the records
+	bool mapExistingIndex() {
+#ifndef _WIN32
+		g_indexFile = ::open(g_indexFileName.c_str(), O_RDWR);
+		struct stat info;
+		if (g_indexFile < 0 || fstat(g_indexFile, &info) != 0 || size_t(info.st_size) < sizeof(IndexHeader)) {
+			if (g_indexFile >= 0) {
+				::close(g_indexFile);
+				g_indexFile = -1;
+			}
+
+			return false;
+		}
+
+		void* memory = mmap(nullptr, size_t(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, g_indexFile, 0);
+		if (memory == MAP_FAILED) {
+			::close(g_indexFile);
+			g_indexFile = -1;
+			return false;
+		}
+
+		g_index = reinterpret_cast<IndexHeader*>(memory);
+		g_indexSize = size_t(info.st_size);
+
+		if (memcmp(g_index->magic, INDEX_FILE_MAGIC, sizeof(g_index->magic)) != 0
+			|| g_index->version != LEARNING_FILE_VERSION
+			|| g_index->recordsCount != g_recordsCount
+			|| g_index->slotsCount < MIN_SLOTS_COUNT
+			|| g_indexSize != sizeof(IndexHeader) + g_index->slotsCount * sizeof(IndexSlot)) {
+			releaseIndex();
+			return false;
+		}
+
+		return true;
+#else
+		return false; // The index is always rebuilt in memory
+#endif // _WIN32
+	}
+
+	// Returns the slot of the hash, or the empty slot where it would be inserted
+	IndexSlot* findSlot(const Hash hash) noexcept {
+		IndexSlot* slots = getSlots();
+		for (u64 i = hash % g_index->slotsCount; ; i = (i + 1) % g_index->slotsCount) {
+			if (!slots[i].record || slots[i].hash == hash) {
+				return &slots[i];
+			}
+		}
+	}
+
+	// The later record replaces the earlier one, unless it is shallower
+	void indexRecord(const LearningRecord& record, const u64 number) noexcept {
+		IndexSlot* slot = findSlot(record.hash);
+		if (!slot->record || slot->depth <= record.depth) {
+			*slot = IndexSlot { .hash = record.hash, .record = u32(number + 1), .depth = record.depth };
+		}
+	}
+
+	// Builds the index from the records, with at most a half of the slots used
+	bool rebuildIndex() {
+		if (!allocateIndex(std::max(MIN_SLOTS_COUNT, std::bit_ceil(2 * g_recordsCount + 2)))) {
+			return false;
+		}
+
+		g_records.clear();
+		g_records.seekg(sizeof(LearningFileHeader));
+
+		LearningRecord record;
+		for (u64 i = 0; i < g_recordsCount; i++) {
+			if (!g_records.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+				return false;
+			}
+
+			indexRecord(record, i);
+		}
+
+		g_index->recordsCount = g_recordsCount;
+		return true;
+	}
+
+
+	///  STORE  ///
+
+	bool openRecords(const std::string& fileName) {
+		std::error_code error;
+		if (!std::filesystem::exists(fileName, error) || !std::filesystem::file_size(fileName, error)) {
+			std::ofstream out(fileName, std::ios::binary);
+			LearningFileHeader header { .magic = {}, .version = LEARNING_FILE_VERSION, .reserved = 0 };
+			memcpy(header.magic, LEARNING_FILE_MAGIC, sizeof(header.magic));
+
+			if (!out.write(reinterpret_cast<const char*>(&header), sizeof(header))) {
+				return false;
+			}
+		}
+
+		// Checking the header before touching anything
+		LearningFileHeader header;
+		if (!std::ifstream(fileName, std::ios::binary).read(reinterpret_cast<char*>(&header), sizeof(header))
+			|| memcmp(header.magic, LEARNING_FILE_MAGIC, sizeof(header.magic)) != 0
+			|| header.version != LEARNING_FILE_VERSION) {
+			return false;
+		}
+
+		// A record torn by a crash is dropped
+		const u64 size = std::filesystem::file_size(fileName, error);
+		if (error) {
+			return false;
+		}
+
+		g_recordsCount = (size - sizeof(LearningFileHeader)) / sizeof(LearningRecord);
+		if (size != sizeof(LearningFileHeader) + g_recordsCount * sizeof(LearningRecord)) {
+			std::filesystem::resize_file(fileName, sizeof(LearningFileHeader) + g_recordsCount * sizeof(LearningRecord), error);
+		}
+
+		g_records.open(fileName, std::ios::in | std::ios::out | std::ios::binary);
+		return g_records.is_open();
+	}
+
+	bool LearningStore::open(const std::string& fileName) {
+		close();
+
+		std::lock_guard lock(g_learningMutex);
+		g_indexFileName = fileName + ".idx";
+
+		if (!openRecords(fileName) || (!mapExistingIndex() && !rebuildIndex())) {
+			g_records.close();
+			releaseIndex();
+			return false;
+		}
+
+		g_isLearningOpen = true;
+		return true;
+	}
+
+	void LearningStore::close() {
+		std::lock_guard lock(g_learningMutex);
+
+		g_isLearningOpen = false;
+		g_records.close();
+		g_records.clear();
+		g_recordsCount = 0;
+		releaseIndex();
+	}
+
+	bool LearningStore::isOpen() noexcept {
+		return g_isLearningOpen;
+	}
+
+	bool LearningStore::probe(const Hash hash, LearningEntry& entry) {
+		if (!g_isLearningOpen) {
+			return false;
+		}
+
+		std::lock_guard lock(g_learningMutex);
+		if (!g_index) {
+			return false;
+		}
+
+		const IndexSlot* slot = findSlot(hash);
+		if (!slot->record) {
+			return false;
+		}
+
+		LearningRecord record;
+		g_records.clear();
+		g_records.seekg(sizeof(LearningFileHeader) + (slot->record - 1) * sizeof(LearningRecord));
+		if (!g_records.read(reinterpret_cast<char*>(&record), sizeof(record)) || record.hash != hash) {
+			return false;
+		}
+
+		entry = LearningEntry { .move = Move::fromData(record.move), .value = record.value, .depth = record.depth };
+		return true;
+	}
+
+	void LearningStore::record(const Hash hash, const Move move, const Value value, const Depth depth) {
+		if (!g_isLearningOpen || depth < MIN_DEPTH || move.isNullMove()) {
+			return;
+		}
+
+		std::lock_guard lock(g_learningMutex);
+		if (!g_index) {
+			return;
+		}
+
+		const IndexSlot* slot = findSlot(hash);
+		if (slot->record && i32(slot->depth) >= depth) {
+			return;
+		}
+
+		const LearningRecord record { .hash = hash, .value = value, .move = move.getData(), .depth = u8(depth), .reserved = {} };
+		g_records.clear();
+		g_records.seekp(0, std::ios::end);
+		if (!g_records.write(reinterpret_cast<const char*>(&record), sizeof(record)).flush()) {
+			return;
+		}
+
+		// The index is updated only after the record is written, so a crash leaves it outdated, but not wrong
+		const u64 number = g_recordsCount++;
+		if (2 * g_recordsCount + 2 > g_index->slotsCount) {
+			if (!rebuildIndex()) {
+				releaseIndex();
+			}
+
+			return;
+		}
+
+		indexRecord(record, number);
+		g_index->recordsCount = g_recordsCount;
+	}
+}
@@ -0,0 +1,63 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <string>
+
+#include "Chess/Move.h"
+#include "Scores.h"
+
+/*
+*	Learning(.h/.cpp) contains the persistent position learning store.
+*
+*	The results of the deep root searches (the hash, the depth, the value and the best move)
+*	are appended to a file that survives between the games and the sessions.
+*	A deeper result for a position replaces the older one, the shallower ones are not recorded.
+*	The records are found through a hash index kept in <file>.idx and memory-mapped (POSIX only,
+*	elsewhere it is kept in memory), which is rebuilt from the records whenever it is missing or outdated.
+*
+*	The root search consults the store and seeds its first iterations with the learned move and value.
+*	Only one process may use a store at a time.
+*/
+
+namespace engine {
+	struct LearningEntry final {
+		Move move;
+		Value value;
+		Depth depth;
+	};
+
+	class LearningStore final {
+	public:
+		// The searches shallower than this are not worth remembering
+		constexpr inline static Depth MIN_DEPTH = 10;
+
+		// Opens the store, creating it if there is none, and closes the previous one
+		// Returns false if the file cannot be opened or is not a learning store
+		static bool open(const std::string& fileName);
+		static void close();
+
+		static bool isOpen() noexcept;
+
+		// Returns false if the position was never learned
+		static bool probe(const Hash hash, LearningEntry& entry);
+
+		// Records the result unless the store has a result at least as deep for the position
+		static void record(const Hash hash, const Move move, const Value value, const Depth depth);
+	};
+}
@@ -0,0 +1,243 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Library.h"
+#include "LibraryC.h"
+#include <atomic>
+#include <mutex>
+
+#include "Utils/StringUtils.h"
+#include "Chess/BitBoard.h"
+#include "Scores.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+#include "PawnHashTable.h"
+#include "Bitbase.h"
+
+namespace engine {
+	std::once_flag g_libraryInitialized;
+	std::atomic<u32> g_searchesStarted = 0; // Spreads the searches of the handles over the cores
+
+	void initLibrary(const size_t hashMegabytes) {
+		std::call_once(g_libraryInitialized, [hashMegabytes]() {
+			BitBoard::init();
+			scores::initScores();
+			TranspositionTable::init(std::max<size_t>(1, hashMegabytes) * 1024 * 1024);
+			PawnHashTable::init();
+			bitbase::init();
+		});
+	}
+
+	void destroyLibrary() {
+		TranspositionTable::destroy();
+	}
+
+	SearchHandle::SearchHandle() {
+		setPosition("startpos");
+	}
+
+	SearchHandle::~SearchHandle() {
+		stop();
+		wait();
+	}
+
+	bool SearchHandle::setPosition(std::string_view fen, const std::vector<std::string>& moves) {
+		stop();
+		wait();
+
+		// The move counters are optional
+		std::string fullFEN = fen == "startpos" ? "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" : std::string(fen);
+		if (str_utils::split(fullFEN, " ").size() < 6) {
+			fullFEN += " 0 1";
+		}
+
+		bool success;
+		Board board = Board::fromFEN(fullFEN, success);
+		if (!success) {
+			return false;
+		}
+
+		for (const std::string& str : moves) {
+			const bool isCoordinateMove = str.size() >= 4 && str[0] >= 'a' && str[0] <= 'h' && str[1] >= '1' && str[1] <= '8'
+				&& str[2] >= 'a' && str[2] <= 'h' && str[3] >= '1' && str[3] <= '8';
+
+			const Move m = isCoordinateMove ? board.makeMoveFromString(str) : board.makeMoveFromSAN(str);
+			if (m.isNullMove() || !board.isLegal(m)) {
+				return false;
+			}
+
+			board.makeMove(m);
+		}
+
+		m_board = std::move(board);
+		return true;
+	}
+
+	void SearchHandle::go(const SearchLimits& limits, InfoCallback onInfo, BestMoveCallback onBestMove) {
+		// The previous search may be infinite
+		stop();
+		wait();
+
+		m_stopRequest = false;
+		m_thread = std::thread([this, limits, onInfo = std::move(onInfo), onBestMove = std::move(onBestMove)]() {
+			bindSearchThread(g_searchesStarted++);
+			g_reporting.checkInput = false;
+			g_reporting.stopRequest = &m_stopRequest;
+			g_reporting.onIteration = [&onInfo](const IterationInfo& info) {
+				if (!onInfo) {
+					return;
+				}
+
+				SearchInfo searchInfo { .depth = info.depth, .value = info.value, .nodes = info.nodes, .milliseconds = info.milliseconds };
+				for (Move m : info.pv) {
+					searchInfo.pv.push_back(m.toString());
+				}
+
+				onInfo(searchInfo);
+			};
+
+			initSearch();
+
+			g_limits.makeInfinite();
+			if (limits.moveTime) {
+				g_limits.setTimeLimitsInMs(0, 0, limits.moveTime);
+				g_limits.reset(limits.moveTime);
+			}
+
+			if (limits.depth) {
+				g_limits.setDepthLimit(limits.depth);
+			}
+
+			if (limits.nodes) {
+				g_limits.setNodesLimit(limits.nodes);
+			}
+
+			SearchResult result = rootSearch(m_board);
+
+			// Stopped before the first iteration was completed
+			if (result.best.isNullMove()) {
+				MoveList moves;
+				m_board.generateMoves(moves);
+				for (Move m : moves) {
+					if (m_board.isLegal(m)) {
+						result.best = m;
+						break;
+					}
+				}
+			}
+
+			if (onBestMove) {
+				onBestMove(result.best.isNullMove() ? "0000" : result.best.toString(), result.value);
+			}
+
+			g_reporting = SearchReporting();
+		});
+	}
+
+	void SearchHandle::stop() noexcept {
+		m_stopRequest = true;
+	}
+
+	void SearchHandle::wait() {
+		if (m_thread.joinable()) {
+			m_thread.join();
+		}
+	}
+}
+
+
+///  C INTERFACE  ///
+
+struct cm_handle {
+	engine::SearchHandle handle;
+};
+
+extern "C" {
+	void cm_init(uint32_t hash_megabytes) {
+		engine::initLibrary(hash_megabytes);
+	}
+
+	void cm_destroy(void) {
+		engine::destroyLibrary();
+	}
+
+	cm_handle* cm_create(void) {
+		return new cm_handle();
+	}
+
+	void cm_free(cm_handle* handle) {
+		delete handle;
+	}
+
+	int cm_set_position(cm_handle* handle, const char* fen, const char* moves) {
+		std::vector<std::string> moveStrings;
+		if (moves) {
+			for (std::string_view move : str_utils::split(moves, " ")) {
+				moveStrings.emplace_back(move);
+			}
+		}
+
+		return handle->handle.setPosition(fen ? fen : "startpos", moveStrings);
+	}
+
+	void cm_go(cm_handle* handle, int32_t depth, uint64_t nodes, int64_t movetime_ms,
+		cm_info_callback on_info, cm_bestmove_callback on_bestmove, void* user_data) {
+		engine::InfoCallback onInfo;
+		if (on_info) {
+			onInfo = [on_info, user_data](const engine::SearchInfo& info) {
+				std::string pv;
+				for (const std::string& move : info.pv) {
+					pv.append(pv.empty() ? "" : " ").append(move);
+				}
+
+				const bool isMate = engine::isMateValue(info.value);
+				const cm_info cInfo {
+					.depth = info.depth,
+					.score = isMate ? (info.value < 0 ? -i32(engine::gettingMatedIn(info.value)) : i32(engine::givingMateIn(info.value))) : info.value,
+					.is_mate = isMate,
+					.nodes = info.nodes,
+					.time_ms = info.milliseconds,
+					.pv = pv.c_str()
+				};
+
+				on_info(&cInfo, user_data);
+			};
+		}
+
+		engine::BestMoveCallback onBestMove;
+		if (on_bestmove) {
+			onBestMove = [on_bestmove, user_data](const std::string& bestMove, const Value) {
+				on_bestmove(bestMove.c_str(), user_data);
+			};
+		}
+
+		handle->handle.go(engine::SearchLimits {
+			.depth = Depth(std::clamp<int32_t>(depth, 0, engine::MAX_DEPTH)),
+			.nodes = nodes,
+			.moveTime = time_t(std::max<int64_t>(0, movetime_ms))
+		}, std::move(onInfo), std::move(onBestMove));
+	}
+
+	void cm_stop(cm_handle* handle) {
+		handle->handle.stop();
+	}
+
+	void cm_wait(cm_handle* handle) {
+		handle->handle.wait();
+	}
+}
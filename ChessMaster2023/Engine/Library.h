@@ -0,0 +1,103 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Chess/Board.h"
+
+/*
+*	Library(.h/.cpp) contains the C++ interface for embedding the engine into another program
+*	(the C interface is in LibraryC.h), built with "make lib" or "make shared".
+*
+*	Usage:
+*		engine::initLibrary(256);
+*		engine::SearchHandle handle;
+*		handle.setPosition("startpos", { "e2e4", "e7e5" });
+*		handle.go({ .depth = 12 }, onInfo, onBestMove);
+*		...
+*		handle.stop(); // From any thread
+*		handle.wait();
+*
+*	Every handle searches on its own thread, so several handles can search at once,
+*	sharing the transposition table. The callbacks are called on the search thread.
+*	A single handle is not supposed to be used from several threads at once, except for stop().
+*/
+
+namespace engine {
+	// Zero means no limit, and if there are no limits at all, the search goes until stop()
+	struct SearchLimits final {
+		Depth depth = 0;
+		NodesCount nodes = 0;
+		time_t moveTime = 0;
+	};
+
+	// The state of the search after a completed iteration
+	struct SearchInfo final {
+		Depth depth;
+		Value value; // From the point of view of the side to move
+		NodesCount nodes;
+		time_t milliseconds;
+		std::vector<std::string> pv;
+	};
+
+	using InfoCallback = std::function<void(const SearchInfo&)>;
+	using BestMoveCallback = std::function<void(const std::string& bestMove, const Value value)>;
+
+	// Initializes the tables of the engine, only the first call does anything
+	// Must be called before any handle is created
+	void initLibrary(const size_t hashMegabytes = 16);
+
+	// Frees the transposition table, no handle may search during this call
+	void destroyLibrary();
+
+	class SearchHandle final {
+	private:
+		Board m_board;
+		std::thread m_thread;
+		std::atomic_bool m_stopRequest = false;
+
+	public:
+		SearchHandle();
+		~SearchHandle();
+
+		SearchHandle(const SearchHandle&) = delete;
+		SearchHandle& operator=(const SearchHandle&) = delete;
+
+		// Sets the position from a FEN (or "startpos") and the moves in the coordinate notation made from it
+		// Stops the current search, if there is one
+		// Returns false if the FEN or any of the moves is incorrect, the position is not changed then
+		bool setPosition(std::string_view fen, const std::vector<std::string>& moves = {});
+
+		// Starts searching the current position in the background, stopping the previous search
+		// The best move is "0000" if there are no legal moves
+		void go(const SearchLimits& limits, InfoCallback onInfo, BestMoveCallback onBestMove);
+
+		// Asks the current search to stop, it still reports the best move
+		// Can be called from any thread, including the callbacks
+		void stop() noexcept;
+
+		// Waits for the current search to finish, must not be called from the callbacks
+		void wait();
+	};
+}
@@ -0,0 +1,67 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <stdint.h>
+
+/*
+*	LibraryC.h contains the C interface for embedding the engine, a thin wrapper
+*	over the C++ one from Library.h (implemented in Library.cpp). This header is plain C.
+*
+*	The functions returning int return 1 on success and 0 on failure.
+*	The strings passed to the callbacks are valid only during the call.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cm_handle cm_handle;
+
+typedef struct cm_info {
+	int32_t depth;
+	int32_t score; // Centipawns, or moves to mate if is_mate is set (negative if the side to move is getting mated)
+	int32_t is_mate;
+	uint64_t nodes;
+	int64_t time_ms;
+	const char* pv; // Space-separated moves in the coordinate notation
+} cm_info;
+
+typedef void (*cm_info_callback)(const cm_info* info, void* user_data);
+typedef void (*cm_bestmove_callback)(const char* best_move, void* user_data);
+
+// Must be called once before anything else
+void cm_init(uint32_t hash_megabytes);
+void cm_destroy(void);
+
+cm_handle* cm_create(void);
+void cm_free(cm_handle* handle);
+
+// fen may be "startpos", moves is a space-separated list in the coordinate notation or NULL
+int cm_set_position(cm_handle* handle, const char* fen, const char* moves);
+
+// Zero limits are ignored, the callbacks may be NULL
+void cm_go(cm_handle* handle, int32_t depth, uint64_t nodes, int64_t movetime_ms,
+	cm_info_callback on_info, cm_bestmove_callback on_bestmove, void* user_data);
+
+void cm_stop(cm_handle* handle);
+void cm_wait(cm_handle* handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -36,8 +36,16 @@ namespace engine {
 		m_movesMade = 0;
 		m_baseTime = INT32_MAX;
 		m_incTime = INT32_MAX;
-		m_depthLimit = 99;
+		m_depthLimit = NO_DEPTH_LIMIT;
 		m_nodesLimit = UINT64_MAX;
+		m_softNodes = UINT64_MAX;
+		m_hardNodes = UINT64_MAX;
+	}
+
+	// The number of nodes searched in the given time at the rate of the nps mode
+	NodesCount nodesForMilliseconds(const time_t ms) noexcept {
+		const NodesCount nps = options::g_nodesPerSecond;
+		return NodesCount(ms / 1000) * nps + NodesCount(ms % 1000) * nps / 1000;
 	}
 
 	void Limits::reset(const time_t msLeft) noexcept {
@@ -65,6 +73,16 @@ namespace engine {
 			m_softBreak = m_start + std::max(computedSoftLimit / 10, 100ull);
 			m_hardBreak = m_start + std::max(computedHardLimit / 10, 100ull);
 		}
+
+		// The time for the move becomes a node budget, and the clock is not looked at anymore
+		m_softNodes = UINT64_MAX;
+		m_hardNodes = UINT64_MAX;
+		if (options::g_nodesPerSecond && m_hardBreak != INT64_MAX) {
+			m_softNodes = nodesForMilliseconds(m_softBreak - m_start);
+			m_hardNodes = nodesForMilliseconds(m_hardBreak - m_start);
+			m_softBreak = INT64_MAX;
+			m_hardBreak = INT64_MAX;
+		}
 	}
 
 	void Limits::addMoves(const i32 cnt) noexcept {
@@ -129,12 +147,12 @@ namespace engine {
 		return timeNow() - m_start;
 	}
 
-	bool Limits::isSoftLimitBroken() const noexcept {
-		return timeNow() >= m_softBreak;
+	bool Limits::isSoftLimitBroken(const NodesCount nodes) const noexcept {
+		return nodes >= m_softNodes || timeNow() >= m_softBreak;
 	}
 
-	bool Limits::isHardLimitBroken() const noexcept {
-		return timeNow() >= m_hardBreak;
+	bool Limits::isHardLimitBroken(const NodesCount nodes) const noexcept {
+		return nodes >= m_hardNodes || timeNow() >= m_hardBreak;
 	}
 
 	bool Limits::isNodesLimitBroken(const NodesCount nodes) const noexcept {
@@ -144,4 +162,9 @@ namespace engine {
 	bool Limits::isDepthLimitBroken(const Depth depth) const noexcept {
 		return depth > m_depthLimit;
 	}
+
+	bool Limits::isInfinite() const noexcept {
+		return m_softBreak == INT64_MAX && m_hardBreak == INT64_MAX && m_softNodes == UINT64_MAX && m_hardNodes == UINT64_MAX
+			&& m_nodesLimit == UINT64_MAX && m_depthLimit == NO_DEPTH_LIMIT;
+	}
 }
\ No newline at end of file
@@ -24,12 +24,15 @@
 *	for limitins the search.
 * 
 *	There are three possible limitations: by time, by maximal root depth, and by nodes.
+*	In the nps mode (see options::g_nodesPerSecond) the time limits are converted into the soft and hard node limits.
 */
 
 namespace engine {
 	// Limits the search
 	class Limits final {
 	private:
+		constexpr static Depth NO_DEPTH_LIMIT = 99;
+
 		time_t m_softBreak = INT64_MAX;
 		time_t m_hardBreak = INT64_MAX;
 		time_t m_start = 0;
@@ -38,8 +41,10 @@ namespace engine {
 		i32 m_movesMade = 0;
 		time_t m_baseTime = 60000;
 		time_t m_incTime = 3000;
-		Depth m_depthLimit = 99;
+		Depth m_depthLimit = NO_DEPTH_LIMIT;
 		NodesCount m_nodesLimit = UINT64_MAX;
+		NodesCount m_softNodes = UINT64_MAX; // The soft and hard limits of the nps mode
+		NodesCount m_hardNodes = UINT64_MAX;
 
 	public:
 		// Resets all the limits and makes the search infinite
@@ -74,12 +79,15 @@ namespace engine {
 
 		// Soft limit is the optimal time to end the search
 		// The search is stopped if the soft limit is broken in a convenient time
-		bool isSoftLimitBroken() const noexcept;
+		bool isSoftLimitBroken(const NodesCount nodes) const noexcept;
 
 		// Hard limit is the time when the search is stopped no matter what
-		bool isHardLimitBroken() const noexcept;
+		bool isHardLimitBroken(const NodesCount nodes) const noexcept;
 
 		bool isNodesLimitBroken(const NodesCount nodes) const noexcept;
 		bool isDepthLimitBroken(const Depth depth) const noexcept;
+
+		// There is no limit by time, by depth or by nodes, the search goes on until it is stopped
+		bool isInfinite() const noexcept;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,361 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "MCTS.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "Utils/MemoryUtils.h"
+#include "MovePicker.h"
+#include "TranspositionTable.h"
+
+namespace engine {
+	MctsSettings g_mctsSettings;
+
+	// The win probabilities are kept in the fixed point
+	constexpr u32 PROBABILITY_ONE = 1 << 16;
+	constexpr u32 PROBABILITY_DRAW = PROBABILITY_ONE / 2;
+
+	constexpr u32 VIRTUAL_LOSS = 3;		   // The visits added on the way down
+	constexpr float EXPLORATION = 1.5f;	   // The weight of the priors against the values in PUCT
+	constexpr float FIRST_PLAY_URGENCY_REDUCTION = 0.1f; // The unvisited moves are expected to be a bit worse than their parent
+	constexpr float PRIOR_DECAY = 0.8f;	   // Every next move in the MovePicker order is this much less likely to be the best
+	constexpr u32 NODES_FLUSH_INTERVAL = 16; // The playouts between adding the nodes of a thread to the total and checking the limits
+	constexpr time_t REPORT_INTERVAL = 1000;
+
+	enum class NodeState : u8 {
+		UNEXPANDED = 0,
+		EXPANDING,
+		EXPANDED,
+		TERMINAL
+	};
+
+	// The arena memory is zero-filled, which makes an unvisited unexpanded node
+	struct MctsNode final {
+		std::atomic<u32> visits;	  // Including the virtual losses of the playouts in progress
+		std::atomic<u64> valueSum;	  // The sum of the win probabilities of the side that made the move leading here
+		std::atomic<u32> firstChild;
+		std::atomic<NodeState> state;
+		u8 terminalValue;			  // For a terminal node: 0 if the side to move is mated, 1 for a draw
+		u16 childrenCount;
+		u16 move;
+		float prior;
+	};
+
+	// Maps the quiescence value to the win probability of the side to move
+	inline u32 valueToProbability(const Value value) {
+		return u32(PROBABILITY_ONE / (1.0 + std::pow(10.0, -value / 400.0)));
+	}
+
+	inline Value probabilityToValue(const double probability) {
+		const double p = std::clamp(probability, 0.001, 0.999);
+		return Value(std::round(-400.0 * std::log10(1.0 / p - 1.0)));
+	}
+
+	class MonteCarloSearch final {
+	private:
+		MctsNode* m_nodes;
+		u32 m_capacity;
+		std::atomic<u32> m_used = 1; // The root is always there
+		std::atomic_bool m_isFull = false;
+
+		std::atomic_bool m_stopRequest = false;
+		std::atomic<NodesCount> m_totalNodes = 0;
+
+	public:
+		MonteCarloSearch(MctsNode* nodes, const u32 capacity) : m_nodes(nodes), m_capacity(capacity) { }
+
+		void run(Board& board) {
+			std::vector<std::thread> helpers;
+			for (u32 i = 1; i < std::max(1u, g_mctsSettings.threads); i++) {
+				helpers.emplace_back([this, i, helperBoard = board.clone()]() mutable {
+					bindSearchThread(i);
+
+					g_limits.makeInfinite();
+					g_reporting.checkInput = false;
+					g_reporting.stopRequest = &m_stopRequest;
+					resetSearchState();
+
+					searchUntilStopped(helperBoard, false);
+				});
+			}
+
+			resetSearchState();
+			searchUntilStopped(board, true);
+
+			for (std::thread& helper : helpers) {
+				helper.join();
+			}
+
+			report();
+		}
+
+		SearchResult getResult() const {
+			const MctsNode* best = getMostVisitedChild(m_nodes[0]);
+			if (!best) {
+				return SearchResult { .best = Move::makeNullMove(), .value = 0 };
+			}
+
+			return SearchResult { .best = Move::fromData(best->move), .value = probabilityToValue(getAverage(*best)) };
+		}
+
+	private:
+		void searchUntilStopped(Board& board, const bool isMain) {
+			time_t lastReport = g_limits.elapsedMilliseconds();
+			NodesCount flushedNodes = 0;
+
+			for (u32 playouts = 1; !m_stopRequest; playouts++) {
+				playout(board);
+
+				if (playouts % NODES_FLUSH_INTERVAL != 0) {
+					continue;
+				}
+
+				m_totalNodes += getNodesCount() - flushedNodes;
+				flushedNodes = getNodesCount();
+
+				if (!isMain) {
+					continue;
+				}
+
+				if (isSearchStopped()
+					|| g_limits.isSoftLimitBroken(m_totalNodes)
+					|| g_limits.isNodesLimitBroken(m_totalNodes)
+					|| g_limits.isDepthLimitBroken(Depth(getPrincipalVariationLength()))) {
+					m_stopRequest = true;
+				} else if (g_limits.elapsedMilliseconds() >= lastReport + REPORT_INTERVAL) {
+					lastReport = g_limits.elapsedMilliseconds();
+					report();
+				}
+			}
+
+			m_totalNodes += getNodesCount() - flushedNodes;
+		}
+
+		// Descends to a leaf, scores it and propagates the result back
+		void playout(Board& board) {
+			MctsNode* path[MAX_DEPTH + 1];
+			Move moves[MAX_DEPTH];
+			Depth ply = 0;
+
+			MctsNode* node = &m_nodes[0];
+			path[0] = node;
+			node->visits += VIRTUAL_LOSS;
+
+			u32 value; // The win probability of the side to move at the leaf
+			while (true) {
+				NodeState state = node->state.load(std::memory_order_acquire);
+				const bool isJustExpanded = state == NodeState::UNEXPANDED && ply < MAX_DEPTH - 1 && expand(*node, board, ply);
+				if (isJustExpanded) {
+					state = node->state.load(std::memory_order_relaxed);
+				}
+
+				if (state == NodeState::TERMINAL) {
+					value = node->terminalValue ? PROBABILITY_DRAW : 0;
+					break;
+				}
+
+				if (ply && board.isDraw(ply)) {
+					value = PROBABILITY_DRAW;
+					break;
+				}
+
+				// The leaf is either just expanded, or being expanded by another thread, or the tree is full
+				if (isJustExpanded || state != NodeState::EXPANDED || ply >= MAX_DEPTH - 1) {
+					value = valueToProbability(quiescence<NodeType::NON_PV>(board, -INF, INF, ply, 0));
+					break;
+				}
+
+				MctsNode& child = select(*node);
+				child.visits += VIRTUAL_LOSS;
+
+				moves[ply] = Move::fromData(child.move);
+				board.makeMove(moves[ply]);
+				path[++ply] = &child;
+				node = &child;
+			}
+
+			// The quiescence search was interrupted, so its value means nothing
+			const bool isAborted = isSearchStopped();
+
+			for (Depth i = ply; i >= 0; i--) {
+				// Every node keeps the value of the side that made the move leading to it
+				value = PROBABILITY_ONE - value;
+				if (isAborted) {
+					path[i]->visits -= VIRTUAL_LOSS;
+				} else {
+					path[i]->valueSum += value;
+					path[i]->visits -= VIRTUAL_LOSS - 1;
+				}
+
+				if (i) {
+					board.unmakeMove(moves[i - 1]);
+				}
+			}
+		}
+
+		// Creates the children of the node with the priors by the MovePicker order
+		// Returns false if another thread is expanding the node or the tree is full
+		bool expand(MctsNode& node, Board& board, const Depth ply) {
+			NodeState expected = NodeState::UNEXPANDED;
+			if (m_isFull || !node.state.compare_exchange_strong(expected, NodeState::EXPANDING)) {
+				return false;
+			}
+
+			MoveList moves;
+			board.generateMoves(moves);
+
+			TableEntry entry;
+			const Move tableMove = TranspositionTable::probe(board.computeHash(), entry) ? Move::fromData(entry.move) : Move::makeNullMove();
+
+			MoveList legalMoves;
+			MovePicker picker(board, moves, ply, tableMove);
+			while (picker.hasMore()) {
+				const Move m = picker.pick();
+				if (board.isLegal(m)) {
+					legalMoves.push(m);
+				}
+			}
+
+			if (!legalMoves.size()) {
+				node.terminalValue = !board.isInCheck();
+				node.state.store(NodeState::TERMINAL, std::memory_order_release);
+				return true;
+			}
+
+			const u32 first = m_used.fetch_add(legalMoves.size());
+			if (first + legalMoves.size() > m_capacity) {
+				m_isFull = true;
+				node.state.store(NodeState::UNEXPANDED, std::memory_order_release);
+				return false;
+			}
+
+			float priorsSum = 0;
+			float prior = 1;
+			for (u32 i = 0; i < legalMoves.size(); i++, prior *= PRIOR_DECAY) {
+				priorsSum += prior;
+			}
+
+			prior = 1;
+			for (u32 i = 0; i < legalMoves.size(); i++, prior *= PRIOR_DECAY) {
+				m_nodes[first + i].move = legalMoves[i].getData();
+				m_nodes[first + i].prior = prior / priorsSum;
+			}
+
+			node.childrenCount = u16(legalMoves.size());
+			node.firstChild.store(first, std::memory_order_relaxed);
+			node.state.store(NodeState::EXPANDED, std::memory_order_release);
+			return true;
+		}
+
+		// PUCT: the average value plus the prior weighted by how rarely the move was visited
+		MctsNode& select(MctsNode& node) {
+			const u32 first = node.firstChild.load(std::memory_order_relaxed);
+			const float visitsRoot = std::sqrt(float(node.visits));
+
+			// The value of the side to move is the opposite of the one kept in the node
+			const float firstPlayUrgency = std::max(0.0f, 1.0f - float(getAverage(node)) - FIRST_PLAY_URGENCY_REDUCTION);
+
+			MctsNode* best = &m_nodes[first];
+			float bestScore = -1;
+			for (u32 i = first; i < first + node.childrenCount; i++) {
+				MctsNode& child = m_nodes[i];
+				const u32 visits = child.visits;
+
+				const float average = visits ? float(getAverage(child)) : firstPlayUrgency;
+				const float score = average + EXPLORATION * child.prior * visitsRoot / float(1 + visits);
+				if (score > bestScore) {
+					bestScore = score;
+					best = &child;
+				}
+			}
+
+			return *best;
+		}
+
+		static double getAverage(const MctsNode& node) {
+			const u32 visits = node.visits;
+			return visits ? double(node.valueSum) / (double(visits) * PROBABILITY_ONE) : 0.5;
+		}
+
+		const MctsNode* getMostVisitedChild(const MctsNode& node) const {
+			if (node.state.load(std::memory_order_acquire) != NodeState::EXPANDED) {
+				return nullptr;
+			}
+
+			const u32 first = node.firstChild.load(std::memory_order_relaxed);
+			const MctsNode* best = nullptr;
+			for (u32 i = first; i < first + node.childrenCount; i++) {
+				if (m_nodes[i].visits && (!best || m_nodes[i].visits > best->visits)) {
+					best = &m_nodes[i];
+				}
+			}
+
+			return best;
+		}
+
+		u32 getPrincipalVariationLength() const {
+			u32 length = 0;
+			for (const MctsNode* node = getMostVisitedChild(m_nodes[0]); node && length < MAX_DEPTH; node = getMostVisitedChild(*node)) {
+				length++;
+			}
+
+			return length;
+		}
+
+		void report() const {
+			const MctsNode* best = getMostVisitedChild(m_nodes[0]);
+			if (!best) {
+				return;
+			}
+
+			MoveList pv;
+			for (const MctsNode* node = best; node && pv.size() < MAX_DEPTH; node = getMostVisitedChild(*node)) {
+				pv.push(Move::fromData(node->move));
+			}
+
+			reportIteration(IterationInfo {
+				.depth = Depth(pv.size()),
+				.value = probabilityToValue(getAverage(*best)),
+				.nodes = m_totalNodes,
+				.milliseconds = g_limits.elapsedMilliseconds(),
+				.pv = pv
+			});
+		}
+	};
+
+	SearchResult mctsRootSearch(Board& board) {
+		mem_utils::LargeMemory memory = mem_utils::allocateLarge(size_t(std::max(1u, g_mctsSettings.memoryMegabytes)) * 1024 * 1024);
+		if (!memory.data) {
+			return rootSearch(board);
+		}
+
+		MovePicker::resetHistoryTables();
+		TranspositionTable::setRootAge(board.moveCount());
+
+		MonteCarloSearch search(reinterpret_cast<MctsNode*>(memory.data), u32(std::min<size_t>(UINT32_MAX, memory.size / sizeof(MctsNode))));
+		search.run(board);
+
+		const SearchResult result = search.getResult();
+		mem_utils::freeLarge(memory);
+		return result;
+	}
+}
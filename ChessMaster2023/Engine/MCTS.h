@@ -0,0 +1,46 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "Search.h"
+
+/*
+*	MCTS(.h/.cpp) contains the Monte-Carlo tree search, an alternative to the alpha-beta root search.
+*
+*	The tree is grown best-first: every playout descends by PUCT from the root to a leaf,
+*	expands it and scores it with the quiescence search, mapped to the win probability of the side to move,
+*	and the result is propagated back to the root. The priors of the moves come from the MovePicker order.
+*	The nodes are taken from an arena allocated once per search, and when it is exhausted, the tree stops growing.
+*
+*	Several threads descend the same tree without locks: the visits are added on the way down,
+*	before the results are known (a virtual loss), so that the threads spread over different lines.
+*	The move with the most visits is played.
+*/
+
+namespace engine {
+	struct MctsSettings final {
+		bool isEnabled = false; // Replaces the alpha-beta search in the interactive modes
+		u32 threads = 1;
+		u32 memoryMegabytes = 256; // The size of the node arena
+	};
+
+	extern MctsSettings g_mctsSettings;
+
+	// Searches the position within g_limits, the depth limit applies to the length of the principal variation
+	SearchResult mctsRootSearch(Board& board);
+}
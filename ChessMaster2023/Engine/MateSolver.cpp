@@ -0,0 +1,311 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "MateSolver.h"
+#include <algorithm>
+#include <memory>
+
+#include "Utils/MemoryUtils.h"
+#include "Engine.h"
+
+namespace engine {
+	constexpr size_t MATE_TABLE_SIZE = 64 * 1024 * 1024;
+	constexpr u32 BUCKET_SIZE = 4;
+	constexpr u32 PN_INFINITY = 1 << 30; // The number of a disproven (or proven for the disproof number) node, the sums are capped by it
+	constexpr NodesCount LIMITS_CHECK_INTERVAL = 4096;
+	constexpr Hash DRAWN_KEY = 0; // Marks the children drawn by the repetition or the fifty moves rule, they are never stored
+
+	struct MateEntry final {
+		Hash key;
+		u32 proof;
+		u32 disproof;
+		u32 work;	  // The nodes searched under the entry, the entry with the least work in a bucket is replaced
+		u16 distance; // The plies to the mate of a proven node
+		u16 move;	  // For a proven node: the shortest mate of the attacker or the longest defence of the defender
+	};
+
+	class ProofNumberSearch final {
+	private:
+		MateEntry* m_table;
+		size_t m_bucketsCount;
+		Color m_attacker;
+
+		NodesCount m_nodes = 0;
+		bool m_isAborted = false;
+
+		MoveList m_generated;
+		MoveList m_moveLists[MAX_DEPTH + 1];
+		Hash m_childKeys[MAX_DEPTH + 1][MoveList::MAX_MOVES];
+
+	public:
+		ProofNumberSearch(MateEntry* table, const size_t entriesCount, const Color attacker)
+			: m_table(table), m_bucketsCount(entriesCount / BUCKET_SIZE), m_attacker(attacker) { }
+
+		// Returns true if the mate in the given number of plies is proven
+		bool prove(Board& board, const Depth plies) {
+			mid(board, PN_INFINITY, PN_INFINITY, plies, 0);
+			return !m_isAborted && probe(keyOf(board, plies)).proof == 0;
+		}
+
+		// Follows the moves of the proven entries, returns the plies to the mate
+		Depth extractPrincipalVariation(Board& board, const Depth plies, MoveList& pv) {
+			pv.clear();
+
+			const Depth distance = probe(keyOf(board, plies)).distance;
+			for (Depth pliesLeft = plies; Depth(pv.size()) < distance; pliesLeft--) {
+				const MateEntry entry = probe(keyOf(board, pliesLeft));
+				if (entry.proof != 0 || !entry.move) {
+					break; // Replaced in the table
+				}
+
+				pv.push(Move::fromData(entry.move));
+				board.makeMove(pv[pv.size() - 1]);
+			}
+
+			for (u32 i = pv.size(); i-- > 0; ) {
+				board.unmakeMove(pv[i]);
+			}
+
+			return distance;
+		}
+
+		NodesCount getNodesCount() const noexcept {
+			return m_nodes;
+		}
+
+	private:
+		// The same position with a different number of plies left is a different node
+		static Hash keyOf(const Board& board, const Depth pliesLeft) noexcept {
+			return board.computeHash() ^ ((u64(pliesLeft) + 1) * 0x9E3779B97F4A7C15ull);
+		}
+
+		MateEntry probe(const Hash key) const noexcept {
+			const MateEntry* bucket = m_table + (key % m_bucketsCount) * BUCKET_SIZE;
+			for (u32 i = 0; i < BUCKET_SIZE; i++) {
+				if (bucket[i].key == key) {
+					return bucket[i];
+				}
+			}
+
+			return MateEntry { .key = key, .proof = 1, .disproof = 1 };
+		}
+
+		void record(const MateEntry& entry) noexcept {
+			MateEntry* bucket = m_table + (entry.key % m_bucketsCount) * BUCKET_SIZE;
+			MateEntry* replaced = bucket;
+			for (u32 i = 0; i < BUCKET_SIZE; i++) {
+				if (bucket[i].key == entry.key) {
+					replaced = bucket + i;
+					break;
+				}
+
+				if (bucket[i].work < replaced->work) {
+					replaced = bucket + i;
+				}
+			}
+
+			*replaced = entry;
+		}
+
+		// The attacker only gives checks, and the defender is always in check
+		void generateMoves(Board& board, MoveList& moves, const bool isAttacker) {
+			if (board.isInCheck()) {
+				board.generateMoves<movegen::CHECK_EVASIONS>(m_generated);
+			} else {
+				board.generateMoves<movegen::CAPTURES>(m_generated);
+				board.generateMoves<movegen::QUIET_CHECKS>(m_generated);
+			}
+
+			moves.clear();
+			for (Move m : m_generated) {
+				const bool isDuplicate = std::any_of(moves.begin(), moves.end(), [m](const Move other) { return other.getData() == m.getData(); });
+				if (isDuplicate || !board.isLegal(m)) {
+					continue;
+				}
+
+				if (isAttacker) {
+					board.makeMove(m);
+					const bool isCheck = board.isInCheck();
+					board.unmakeMove(m);
+
+					if (!isCheck) {
+						continue;
+					}
+				}
+
+				moves.push(m);
+			}
+		}
+
+		void checkLimits() {
+			if (g_reporting.checkInput) {
+				checkInput();
+			}
+
+			m_isAborted = isSearchStopped() || g_limits.isHardLimitBroken(m_nodes) || g_limits.isNodesLimitBroken(m_nodes);
+		}
+
+		// Multiple iterative deepening: searches the node until its numbers reach the thresholds
+		void mid(Board& board, const u32 proofLimit, const u32 disproofLimit, const Depth pliesLeft, const Depth ply) {
+			const Hash key = keyOf(board, pliesLeft);
+			const NodesCount startNodes = m_nodes;
+			if (++m_nodes % LIMITS_CHECK_INTERVAL == 0) {
+				checkLimits();
+			}
+
+			const bool isAttacker = board.side() == m_attacker;
+			if (isAttacker && pliesLeft == 0) {
+				record(MateEntry { .key = key, .proof = PN_INFINITY, .disproof = 0, .work = 1 });
+				return;
+			}
+
+			MoveList& moves = m_moveLists[ply];
+			generateMoves(board, moves, isAttacker);
+
+			// The attacker has no checks, or the defender is mated (or stalemated, which cannot happen after a check)
+			if (moves.size() == 0) {
+				const bool isMate = !isAttacker && board.isInCheck();
+				record(MateEntry { .key = key, .proof = isMate ? 0 : PN_INFINITY, .disproof = isMate ? PN_INFINITY : 0, .work = 1 });
+				return;
+			}
+
+			// The defender has escaped the check
+			if (pliesLeft == 0) {
+				record(MateEntry { .key = key, .proof = PN_INFINITY, .disproof = 0, .work = 1 });
+				return;
+			}
+
+			Hash* childKeys = m_childKeys[ply];
+			for (u32 i = 0; i < moves.size(); i++) {
+				board.makeMove(moves[i]);
+				childKeys[i] = board.isDraw(ply + 1) ? DRAWN_KEY : keyOf(board, pliesLeft - 1);
+				board.unmakeMove(moves[i]);
+			}
+
+			while (true) {
+				// The attacker needs any child proven, and the defender needs any child disproven
+				u64 proof = isAttacker ? PN_INFINITY : 0;
+				u64 disproof = isAttacker ? 0 : PN_INFINITY;
+
+				u32 bestIndex = 0;
+				u32 bestNumber = UINT32_MAX; // The proof number for the attacker, the disproof one for the defender
+				u32 secondNumber = UINT32_MAX;
+				MateEntry best { };
+
+				u16 distance = isAttacker ? UINT16_MAX : 0;
+				u16 distanceMove = 0;
+
+				for (u32 i = 0; i < moves.size(); i++) {
+					const MateEntry child = childKeys[i] == DRAWN_KEY
+						? MateEntry { .key = DRAWN_KEY, .proof = PN_INFINITY, .disproof = 0 }
+						: probe(childKeys[i]);
+
+					if (isAttacker) {
+						proof = std::min<u64>(proof, child.proof);
+						disproof += child.disproof;
+					} else {
+						proof += child.proof;
+						disproof = std::min<u64>(disproof, child.disproof);
+					}
+
+					const u32 number = isAttacker ? child.proof : child.disproof;
+					if (number < bestNumber) {
+						secondNumber = bestNumber;
+						bestNumber = number;
+						bestIndex = i;
+						best = child;
+					} else {
+						secondNumber = std::min(secondNumber, number);
+					}
+
+					if (child.proof == 0 && (isAttacker ? child.distance < distance : child.distance >= distance)) {
+						distance = child.distance;
+						distanceMove = moves[i].getData();
+					}
+				}
+
+				proof = std::min<u64>(proof, PN_INFINITY);
+				disproof = std::min<u64>(disproof, PN_INFINITY);
+
+				if (proof == 0 || disproof == 0 || proof >= proofLimit || disproof >= disproofLimit || m_isAborted) {
+					record(MateEntry {
+						.key = key,
+						.proof = u32(proof),
+						.disproof = u32(disproof),
+						.work = u32(std::min<NodesCount>(m_nodes - startNodes, UINT32_MAX)),
+						.distance = u16(proof == 0 ? distance + 1 : 0),
+						.move = proof == 0 ? distanceMove : u16(0)
+					});
+
+					return;
+				}
+
+				// The child may use the slack of the parent until it stops being the best one
+				u64 childProofLimit;
+				u64 childDisproofLimit;
+				if (isAttacker) {
+					childProofLimit = std::min<u64>(proofLimit, u64(secondNumber) + 1);
+					childDisproofLimit = u64(disproofLimit) - disproof + best.disproof;
+				} else {
+					childProofLimit = u64(proofLimit) - proof + best.proof;
+					childDisproofLimit = std::min<u64>(disproofLimit, u64(secondNumber) + 1);
+				}
+
+				board.makeMove(moves[bestIndex]);
+				mid(board, u32(std::min<u64>(childProofLimit, PN_INFINITY)), u32(std::min<u64>(childDisproofLimit, PN_INFINITY)), pliesLeft - 1, ply + 1);
+				board.unmakeMove(moves[bestIndex]);
+			}
+		}
+	};
+
+	Depth solveMate(Board& board, const Depth maxMoves, MoveList& pv) {
+		pv.clear();
+
+		mem_utils::LargeMemory memory = mem_utils::allocateLarge(MATE_TABLE_SIZE);
+		if (!memory.data) {
+			return 0;
+		}
+
+		resetSearchState();
+		auto search = std::make_unique<ProofNumberSearch>(static_cast<MateEntry*>(memory.data), memory.size / sizeof(MateEntry), board.side());
+
+		// The attacker makes the last move, so the number of plies is odd
+		Depth plies = maxMoves > 0 ? std::min<Depth>(2 * maxMoves - 1, MAX_DEPTH - 1) : MAX_DEPTH - 1;
+		plies -= plies % 2 == 0;
+
+		Depth movesToMate = 0;
+		while (plies > 0 && search->prove(board, plies)) {
+			const Depth distance = search->extractPrincipalVariation(board, plies, pv);
+			movesToMate = (distance + 1) / 2;
+
+			reportIteration(IterationInfo {
+				.depth = distance,
+				.value = Value(MATE - distance),
+				.nodes = search->getNodesCount(),
+				.milliseconds = g_limits.elapsedMilliseconds(),
+				.pv = pv
+			});
+
+			// Looking for a shorter mate
+			plies = distance - 2;
+		}
+
+		mem_utils::freeLarge(memory);
+		return movesToMate;
+	}
+}
@@ -0,0 +1,39 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "Search.h"
+
+/*
+*	MateSolver(.h/.cpp) contains the mate solver based on the depth-first proof-number search (df-pn).
+*
+*	The attacker only gives checks (the checking captures and the quiet checks) and the defender
+*	only evades them, so the tree is much narrower than in the alpha-beta search.
+*	Every node has a proof number (how many leaves must be proven for the mate) and a disproof number,
+*	and the search always descends into the most proving node while it stays within the thresholds.
+*	The numbers are kept in a table of its own, which lives only during the solving.
+*
+*	Once a mate is found, the solver looks for a shorter one, until there is none or the limits are broken.
+*/
+
+namespace engine {
+	// Looks for a mate by the side to move in at most maxMoves moves (any length for 0) within g_limits
+	// Returns the number of moves to the shortest mate found (and its line in pv) or 0 if there is none
+	// The mates found are reported with reportIteration
+	Depth solveMate(Board& board, const Depth maxMoves, MoveList& pv);
+}
@@ -19,8 +19,8 @@
 #include "MovePicker.h"
 
 namespace engine {
-	uint32_t s_historyTries[Piece::VALUES_COUNT][Square::VALUES_COUNT];
-	uint32_t s_historySuccesses[Piece::VALUES_COUNT][Square::VALUES_COUNT];
+	thread_local uint32_t s_historyTries[Piece::VALUES_COUNT][Square::VALUES_COUNT];
+	thread_local uint32_t s_historySuccesses[Piece::VALUES_COUNT][Square::VALUES_COUNT];
 
 	SearchStack MovePicker::s_noSS { 
 		.firstKiller = Move::makeNullMove(), 
@@ -28,12 +28,12 @@
 */
 
 namespace engine {
-	// Used in history heuristic
+	// Used in history heuristic, each search thread has its own tables
 	// s_historyTries is the number of times the move was made during the search
-	extern uint32_t s_historyTries[Piece::VALUES_COUNT][Square::VALUES_COUNT];
+	extern thread_local uint32_t s_historyTries[Piece::VALUES_COUNT][Square::VALUES_COUNT];
 
 	// s_historySuccesses is the number of times the move triggered a successful cut
-	extern uint32_t s_historySuccesses[Piece::VALUES_COUNT][Square::VALUES_COUNT];
+	extern thread_local uint32_t s_historySuccesses[Piece::VALUES_COUNT][Square::VALUES_COUNT];
 
 	// Does not generate the moves, only sorts them and picks the best ones.
 	class MovePicker final {
@@ -24,6 +24,8 @@ namespace options {
 	bool g_analyzeMode = false;
 	bool g_postMode = true;
 	bool g_debugMode = false;
+	bool g_mtdfMode = false;
+	NodesCount g_nodesPerSecond = 0;
 
 	bool g_isThinking = false;
 	bool g_isIllegalPosition = false;
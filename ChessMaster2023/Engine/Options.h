@@ -43,6 +43,13 @@ namespace options {
 	// into the log file.
 	extern bool g_debugMode;
 
+	// MTD(f) mode makes the root search find the value with the zero window searches instead of the aspiration windows
+	extern bool g_mtdfMode;
+
+	// NPS mode measures the time by the nodes searched at the given rate instead of the clock, 0 turns it off.
+	// The limits are then the same on any machine and under any load.
+	extern NodesCount g_nodesPerSecond;
+
 
 	///  OWN ENGINE STATE VARIABLES  ///
 
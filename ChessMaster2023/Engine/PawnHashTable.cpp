@@ -19,10 +19,11 @@
 #include "PawnHashTable.h"
 #include <cstring>
 
+#include "Utils/NumaUtils.h"
 #include "Scores.h"
 
 namespace engine {
-    PawnHashEntry PawnHashTable::s_table[1 << PAWN_HASH_TABLE_SIZE_LOG2];
+    thread_local PawnHashEntry PawnHashTable::s_table[1 << PAWN_HASH_TABLE_SIZE_LOG2];
 
     void PawnHashTable::init() {
 		reset();
@@ -32,6 +33,10 @@ namespace engine {
 		memset(s_table, 0, sizeof(s_table));
 	}
 
+	void PawnHashTable::moveToLocalNode() {
+		numa_utils::moveToLocalNode(s_table, sizeof(s_table));
+	}
+
     PawnHashEntry& PawnHashTable::getOrScanPHE(Board& board) {
         const BitBoard wpawns = board.byPiece(Piece::PAWN_WHITE);
         const BitBoard bpawns = board.byPiece(Piece::PAWN_BLACK);
@@ -57,63 +62,107 @@ namespace engine {
 		return entry;
     }
 
+	// The squares of the set and all the squares from them in the direction (UP or DOWN)
+	template<Direction::Value Dir>
+	inline BitBoard fill(const BitBoard bb) noexcept {
+		u64 result = bb;
+		if constexpr (Dir == Direction::UP) {
+			result |= result << 8;
+			result |= result << 16;
+			result |= result << 32;
+		} else {
+			result |= result >> 8;
+			result |= result >> 16;
+			result |= result >> 32;
+		}
+
+		return BitBoard(result);
+	}
+
+	// All the pawns are analyzed at once with the set-wise operations, only the rank-dependent terms and the distortion are looped over.
+	// The passed and backward pawns look ahead on their own file and on the adjacent file to the left only,
+	// the evaluation weights were tuned with the file to the right left out
 	template<Color::Value Side>
 	void PawnHashTable::scanPawns(Board& board, PawnHashEntry& entry) {
 		constexpr Color::Value OppositeSide = Color(Side).getOpposite().value();
 		constexpr Direction::Value Up = Direction::makeRelativeDirection(Side, Direction::UP).value();
+		constexpr Direction::Value Down = Direction::makeRelativeDirection(Side, Direction::DOWN).value();
 
 		const BitBoard pawns = board.byPiece(Piece(Side, PieceType::PAWN));
 		const BitBoard enemyPawns = board.byPiece(Piece(OppositeSide, PieceType::PAWN));
 
 		const BitBoard ourPawnAttacks = pawns.pawnAttackedSquares<Side>();
+		const BitBoard enemyPawnAttacks = enemyPawns.pawnAttackedSquares<OppositeSide>();
+
+		const BitBoard behindOurPawns = fill<Down>(pawns.shift(Down));
+		const BitBoard behindEnemyPawns = fill<Down>(enemyPawns.shift(Down));
+		const BitBoard ourFiles = fill<Up>(fill<Down>(pawns));
+
+		// Passed pawns: no enemy pawns ahead on the same file or on the file to the left, and no pawns of ours ahead
+		const BitBoard passed = pawns.b_and(behindEnemyPawns.b_or(behindEnemyPawns.shift(Direction::RIGHT)).b_or(behindOurPawns).b_not());
+
+		// Isolated pawns: no pawns of ours on the adjacent files
+		const BitBoard isolated = pawns.b_and(ourFiles.shift(Direction::LEFT).b_or(ourFiles.shift(Direction::RIGHT)).b_not());
+
+		// Doubled pawns: a pawn of ours ahead
+		const BitBoard doubled = pawns.b_and(behindOurPawns);
+
+		// Backward pawns: no pawns of ours on the file to the left that are not ahead, and the stop square is attacked by an enemy pawn
+		const BitBoard backward = pawns.b_and(fill<Up>(pawns).shift(Direction::RIGHT).b_not()).b_and(enemyPawnAttacks.shift(Down));
+
+		entry.passed |= passed;
+		entry.isolated |= isolated;
+		entry.doubled |= doubled;
+		entry.backward |= backward;
 
-		BitBoard pieces = pawns;
-		BB_FOR_EACH(sq, pieces) {
-			// Most advanced ranks
-			entry.mostAdvanced[Side][sq.getFile() + 1] = std::max(entry.mostAdvanced[Side][sq.getFile() + 1], Rank::makeRelativeRank(Side, sq.getRank()));
-
-			// Counting islands
-			if (File f = sq.getFile(); f == File::H || BitBoard::fromFile(File::Value(f + 1)).b_and(pawns) == BitBoard::EMPTY) {
-				entry.islandsCount[Side]++;
-			} else if (BitBoard pawnsOnNextFile = BitBoard::fromFile(File::Value(f + 1)).b_and(pawns); pawnsOnNextFile != BitBoard::EMPTY) {
-				entry.distortion[Side] += std::max(0, std::abs(pawnsOnNextFile.lsb().getRank() - sq.getRank()) - 1);
-			}
-
-			// Defended pawns
-			if (ourPawnAttacks.test(sq)) {
-				entry.pawnEvaluation[Side] += scores::DEFENDED_PAWN[Rank::makeRelativeRank(Side, sq.getRank())];
-			}
-
-			if (BitBoard::threeFilesForward<Side>(sq).b_and(enemyPawns) == BitBoard::EMPTY
-				&& BitBoard::directionBits<Up>(sq).b_and(pawns) == BitBoard::EMPTY) { // Passed pawn
-				entry.pawnEvaluation[Side] += scores::PASSED_PAWN[Rank::makeRelativeRank(Side, sq.getRank())];
-				entry.passed.set(sq);
-			}
-
-			// Isolated pawn
-			if (BitBoard::adjacentFiles(sq.getFile()).b_and(pawns) == BitBoard::EMPTY) {
-				entry.pawnEvaluation[Side] += scores::ISOLATED_PAWN;
-				entry.isolated.set(sq);
-			}
-
-			// Double pawn
-			if (BitBoard::directionBits<Up>(sq).b_and(pawns) != BitBoard::EMPTY) {
-				entry.pawnEvaluation[Side] += scores::DOUBLE_PAWN;
-				entry.doubled.set(sq);
-			}
-
-			// Backward pawn
-			if (BitBoard::adjacentFilesForward<OppositeSide>(sq.shift(Up)).b_and(pawns) == BitBoard::EMPTY
-				&& BitBoard::pawnAttacks(Side, sq.shift(Up)).b_and(enemyPawns)) {
-				entry.pawnEvaluation[Side] += scores::BACKWARD_PAWN;
-				entry.backward.set(sq);
-			}
+		// Accumulated locally, as the stores into the entry's byte fields would make the compiler reload it
+		Score evaluation = scores::ISOLATED_PAWN * isolated.popcnt();
+		evaluation += scores::DOUBLE_PAWN * doubled.popcnt();
+		evaluation += scores::BACKWARD_PAWN * backward.popcnt();
+
+		// Defended and passed pawns are scored by their ranks
+		BitBoard defended = pawns.b_and(ourPawnAttacks);
+		BB_FOR_EACH(sq, defended) {
+			evaluation += scores::DEFENDED_PAWN[Rank::makeRelativeRank(Side, sq.getRank())];
+		}
+
+		BitBoard passers = passed;
+		BB_FOR_EACH(sq, passers) {
+			evaluation += scores::PASSED_PAWN[Rank::makeRelativeRank(Side, sq.getRank())];
+		}
+
+		// A bit for every file with pawns, an island ends on a file without pawns on the next one
+		const u8 occupiedFiles = u8(ourFiles);
+		const u8 islandEnds = occupiedFiles & ~(occupiedFiles >> 1);
+		const u8 islandsCount = BitBoard(islandEnds).popcnt();
+
+		// The frontmost pawn of every file is the most advanced one
+		BitBoard frontmost = pawns.b_and(doubled.b_not());
+		BB_FOR_EACH(sq, frontmost) {
+			entry.mostAdvanced[Side][sq.getFile() + 1] = Rank::makeRelativeRank(Side, sq.getRank());
+		}
+
+		// Distortion: the pawns are compared with the lowest pawn on the next file
+		Rank lowestRanks[File::VALUES_COUNT];
+		BitBoard lowest = pawns.b_and(fill<Direction::UP>(pawns.shift(Direction::UP)).b_not());
+		BB_FOR_EACH(sq, lowest) {
+			lowestRanks[sq.getFile()] = sq.getRank();
+		}
+
+		u8 distortion = 0;
+		BitBoard distorted = pawns.b_and(ourFiles.shift(Direction::LEFT));
+		BB_FOR_EACH(sq, distorted) {
+			distortion += std::max(0, std::abs(lowestRanks[sq.getFile() + 1] - sq.getRank()) - 1);
 		}
 
 		// Pawn islands
-		entry.pawnEvaluation[Side] += scores::PAWN_ISLANDS[entry.islandsCount[Side]];
+		evaluation += scores::PAWN_ISLANDS[islandsCount];
 
 		// Pawn distortion
-		entry.pawnEvaluation[Side] += scores::PAWN_DISTORTION * entry.distortion[Side];
+		evaluation += scores::PAWN_DISTORTION * distortion;
+
+		entry.islandsCount[Side] = islandsCount;
+		entry.distortion[Side] = distortion;
+		entry.pawnEvaluation[Side] = evaluation;
 	}
 }
\ No newline at end of file
@@ -46,12 +46,16 @@ namespace engine {
 		constexpr inline static uint32_t PAWN_HASH_TABLE_SIZE_LOG2 = 12; // Nodes number in the table = 2**PAWN_HASH_TABLE_SIZE_LOG2
 
 	private:
-		static PawnHashEntry s_table[1 << PAWN_HASH_TABLE_SIZE_LOG2];
+		// Each search thread has its own table
+		static thread_local PawnHashEntry s_table[1 << PAWN_HASH_TABLE_SIZE_LOG2];
 
 	public:
 		static void init();
 		static void reset();
 
+		// Moves the table of the calling thread to its NUMA node
+		static void moveToLocalNode();
+
 		// Returns an entry from the table if there is, or creates a new one
 		static PawnHashEntry& getOrScanPHE(Board& board);
 
@@ -0,0 +1,218 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "PerftSuite.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+#include "Utils/IO.h"
+#include "Utils/StringUtils.h"
+#include "Search.h"
+
+namespace engine {
+	// The expected result of perft for a single position and depth
+	struct PerftExpectation final {
+		Depth depth;
+		NodesCount nodes;
+	};
+
+	// A failed perft check, for the summary
+	struct PerftFailure final {
+		u32 line;
+		std::string fen;
+		Depth depth;
+		NodesCount expected;
+		NodesCount found;
+	};
+
+	u64 nanosecondsSince(const std::chrono::high_resolution_clock::time_point start) {
+		using namespace std::chrono;
+		return duration_cast<nanoseconds>(high_resolution_clock::now() - start).count();
+	}
+
+	double kiloNodesPerSecond(const NodesCount nodes, const u64 ns) {
+		return ns ? nodes * 1'000'000.0 / ns : 0.0;
+	}
+
+	// Parses a line of a perft suite: <fen> ;D1 <nodes> ;D2 <nodes> ...
+	// Returns false if the line has no position
+	bool parsePerftLine(std::string_view line, std::string& fen, std::vector<PerftExpectation>& expectations) {
+		expectations.clear();
+
+		std::vector<std::string_view> fields = str_utils::split(line, ";");
+		if (fields.empty()) {
+			return false;
+		}
+
+		std::vector<std::string_view> tokens = str_utils::split(fields[0], " \t\r");
+		if (tokens.empty()) {
+			return false;
+		}
+
+		fen.clear();
+		for (std::string_view token : tokens) {
+			fen.append(fen.empty() ? "" : " ").append(token);
+		}
+
+		for (size_t i = 1; i < fields.size(); i++) {
+			tokens = str_utils::split(fields[i], " \t\r", std::move(tokens));
+			if (tokens.size() != 2 || tokens[0].size() < 2 || (tokens[0][0] != 'D' && tokens[0][0] != 'd')) {
+				continue;
+			}
+
+			expectations.push_back(PerftExpectation {
+				.depth = Depth(str_utils::fromString<u32>(tokens[0].substr(1))),
+				.nodes = str_utils::fromString<NodesCount>(tokens[1])
+			});
+		}
+
+		return true;
+	}
+
+	NodesCount perftDivide(Board& board, const Depth depth) {
+		const auto start = std::chrono::high_resolution_clock::now();
+		NodesCount result = 0;
+		u32 movesCount = 0;
+
+		MoveList moves;
+		board.generateMoves(moves);
+		for (Move m : moves) {
+			if (!board.isLegal(m)) {
+				continue;
+			}
+
+			board.makeMove(m);
+			const NodesCount nodes = depth > 1 ? perft(board, depth - 1) : 1;
+			board.unmakeMove(m);
+
+			result += nodes;
+			++movesCount;
+			io::g_out << m << ": " << io::Color::Blue << nodes << std::endl;
+		}
+
+		const u64 ns = nanosecondsSince(start);
+		io::g_out << "Moves: " << io::Color::Blue << movesCount << std::endl
+			<< "Nodes found: " << io::Color::Blue << result << std::endl
+			<< "Time: " << io::Color::Blue << ns / 1'000'000'000.0 << io::Color::White << " seconds" << std::endl
+			<< "Kn/S: " << io::Color::Blue << kiloNodesPerSecond(result, ns) << io::Color::White << " kilonodes per second" << std::endl;
+
+		return result;
+	}
+
+	bool runPerftSuite(const std::string& fileName, const Depth maxDepth) {
+		std::ifstream file(fileName);
+		if (!file.is_open()) {
+			io::g_out << io::Color::Red << "Cannot open the perft suite: " << fileName << std::endl;
+			return false;
+		}
+
+		std::vector<PerftFailure> failures;
+		std::vector<PerftExpectation> expectations;
+		std::string line;
+		std::string fen;
+
+		NodesCount totalNodes = 0;
+		u64 totalNs = 0;
+		u32 positionsCount = 0;
+		u32 checksCount = 0;
+
+		for (u32 lineNumber = 1; std::getline(file, line); lineNumber++) {
+			if (line.empty() || line[0] == '#' || !parsePerftLine(line, fen, expectations)) {
+				continue;
+			}
+
+			bool success;
+			Board board = Board::fromFEN(fen, success);
+			if (!success) {
+				io::g_out << io::Color::Red << "Line " << lineNumber << ": incorrect FEN " << fen << std::endl;
+				failures.push_back(PerftFailure { .line = lineNumber, .fen = fen, .depth = 0, .expected = 0, .found = 0 });
+				continue;
+			}
+
+			++positionsCount;
+			io::g_out << "Position " << positionsCount << " (line " << lineNumber << "): " << io::Color::Blue << fen << std::endl;
+
+			NodesCount positionNodes = 0;
+			u64 positionNs = 0;
+			for (const PerftExpectation& expectation : expectations) {
+				if (expectation.depth < 1 || expectation.depth > maxDepth) {
+					continue;
+				}
+
+				const auto start = std::chrono::high_resolution_clock::now();
+				const NodesCount nodes = perft(board, expectation.depth);
+				const u64 ns = nanosecondsSince(start);
+
+				++checksCount;
+				positionNodes += nodes;
+				positionNs += ns;
+
+				io::g_out << "\tD" << expectation.depth << ": " << nodes;
+				if (nodes == expectation.nodes) {
+					io::g_out << io::Color::Green << " OK";
+				} else {
+					io::g_out << io::Color::Red << " FAILED, expected " << expectation.nodes;
+					failures.push_back(PerftFailure {
+						.line = lineNumber, 
+						.fen = fen, 
+						.depth = expectation.depth, 
+						.expected = expectation.nodes, 
+						.found = nodes 
+					});
+				}
+
+				io::g_out << io::Color::White << " (" << std::fixed << std::setprecision(3) << ns / 1'000'000'000.0 << " s, "
+					<< std::setprecision(0) << kiloNodesPerSecond(nodes, ns) << " kN/s)" << std::endl;
+			}
+
+			io::g_out << "\tTotal: " << positionNodes << " nodes, "
+				<< std::fixed << std::setprecision(0) << kiloNodesPerSecond(positionNodes, positionNs) << " kN/s" << std::endl;
+
+			totalNodes += positionNodes;
+			totalNs += positionNs;
+		}
+
+		// The summary
+		io::g_out << std::endl << "Positions: " << io::Color::Blue << positionsCount << std::endl
+			<< "Checks: " << io::Color::Blue << checksCount << std::endl
+			<< "Nodes: " << io::Color::Blue << totalNodes << std::endl
+			<< "Time: " << io::Color::Blue << std::fixed << std::setprecision(3) << totalNs / 1'000'000'000.0 << io::Color::White << " seconds" << std::endl
+			<< "Kn/S: " << io::Color::Blue << std::setprecision(0) << kiloNodesPerSecond(totalNodes, totalNs) << io::Color::White << " kilonodes per second" << std::endl;
+
+		if (failures.empty()) {
+			io::g_out << io::Color::Green << "All the checks passed" << std::endl;
+		} else {
+			io::g_out << io::Color::Red << failures.size() << " checks failed:" << std::endl;
+			for (const PerftFailure& failure : failures) {
+				io::g_out << io::Color::Red << "\tline " << failure.line << ", " << failure.fen;
+				if (failure.depth) {
+					io::g_out << ", D" << failure.depth << ": expected " << failure.expected << ", found " << failure.found;
+				} else {
+					io::g_out << ": incorrect FEN";
+				}
+
+				io::g_out << std::endl;
+			}
+		}
+
+		io::g_out << std::defaultfloat << std::setprecision(6);
+		return failures.empty();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <string>
+
+#include "Chess/Board.h"
+
+/*
+*	PerftSuite(.h/.cpp) contains the tools for move generation debugging:
+*	perft divide and a runner for perft suites.
+* 
+*	A perft suite is an EPD-like file with a position and the expected perft results on each line:
+*		rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ;D1 20 ;D2 400 ;D3 8902
+*/
+
+namespace engine {
+	// Prints the number of nodes for every root move and returns the total number of nodes
+	NodesCount perftDivide(Board& board, const Depth depth);
+
+	// Runs perft for every position in the file up to <maxDepth> and compares it with the expected results
+	// Prints the time and nodes per second for every position, in aggregate, and a summary of failures
+	// Returns false if the file cannot be read or any of the results is wrong
+	bool runPerftSuite(const std::string& fileName, const Depth maxDepth);
+}
\ No newline at end of file
@@ -22,9 +22,15 @@
 #include <algorithm>
 
 #include "Utils/IO.h"
+#include "Utils/NumaUtils.h"
 #include "Eval.h"
+#include "Book.h"
 #include "Engine.h"
+#include "Learning.h"
 #include "MovePicker.h"
+#include "PawnHashTable.h"
+#include "Syzygy.h"
+#include "Tablebases.h"
 #include "TranspositionTable.h"
 
 namespace engine {
@@ -34,6 +40,7 @@ namespace engine {
 
 	constexpr Depth MAX_QPLY_FOR_CHECKS = 2;
 	constexpr Depth MIN_NULLMOVE_DEPTH = 2;
+	constexpr Depth RESUMED_DEPTH_MARGIN = 1; // The resumed search starts this much below the depth completed before
 	constexpr Depth NULLMOVE_DEPTH_REDUCTION_BASE = 3;
 	constexpr Depth MIN_NULLMOVE_VERIFICATION_DEPTH = 5;
 	constexpr Depth MIN_LMR_DEPTH = 3;
@@ -46,17 +53,74 @@ namespace engine {
 	constexpr Depth LMR_HIGH_DEPTH_DENOMINATOR = 9;
 	constexpr u8 LMR_MANY_QUIETS_DENOMINATOR = 9;
 
+	constexpr i32 MTDF_FIRST_STEP = 16; // The first move of the MTD(f) guess while the value is bounded from one side only
 
-	// Global variables
-	std::atomic_bool g_mustStop = false; // Must the search stop?
 
-	NodesCount g_nodesCount = 0; // Nodes during the current search
-	Depth g_rootDepth = 0;
-	SearchStack g_searchStacks[2 * MAX_DEPTH + 2];
-	MoveList g_moveLists[2 * MAX_DEPTH];
-	MoveList g_PVs[2 * MAX_DEPTH];
+	// Global variables, each thread has its own
+	thread_local std::atomic_bool g_mustStop = false; // Must the search stop?
 
-	Limits g_limits;
+	thread_local NodesCount g_nodesCount = 0; // Nodes during the current search
+	thread_local Depth g_rootDepth = 0;
+	thread_local Depth g_completedDepth = 0; // The depth of the last completed iteration
+	thread_local u32 g_rootMovesSearched = 0;
+	thread_local u32 g_rootMovesCount = 0;
+	thread_local Move g_currentRootMove;
+	thread_local Move g_bestRootMove; // Of the last completed iteration
+	thread_local SearchStack g_searchStacks[2 * MAX_DEPTH + 2];
+	thread_local MoveList g_moveLists[2 * MAX_DEPTH];
+	thread_local MoveList g_PVs[2 * MAX_DEPTH];
+
+	thread_local Limits g_limits;
+	thread_local SearchReporting g_reporting;
+	thread_local std::vector<Move> g_excludedRootMoves;
+	thread_local std::vector<Move> g_tablebaseRootMoves; // The only root moves searched if not empty
+
+
+	///  AUXILIARY FUNCTIONS  ///
+
+	void reportIteration(const IterationInfo& info) {
+		if (g_reporting.onIteration) {
+			g_reporting.onIteration(info);
+			return;
+		}
+
+		if (!options::g_postMode) {
+			return;
+		}
+
+		if (io::getMode() == io::IOMode::UCI) {
+			io::g_out
+				<< "info depth " << info.depth
+				<< " nodes " << info.nodes
+				<< " time " << info.milliseconds
+				<< " score " << scoreToString(info.value)
+				<< " pv " << info.pv.toString() << std::endl;
+		} else { // Xboard/Console
+			io::g_out << info.depth << ' '
+				<< info.value << ' '
+				<< info.milliseconds / 10 << ' '
+				<< info.nodes << ' '
+				<< info.pv.toString() << std::endl;
+		}
+	}
+
+	// Prints the current search state or passes it to the callback
+	void reportIteration(const Value result) {
+		g_completedDepth = g_rootDepth;
+		reportIteration(IterationInfo {
+			.depth = g_rootDepth,
+			.value = result,
+			.nodes = g_nodesCount,
+			.milliseconds = g_limits.elapsedMilliseconds(),
+			.pv = g_PVs[0]
+		});
+	}
+
+
+	// Checks if another thread asked to stop the search
+	inline bool isStopRequested() noexcept {
+		return g_reporting.stopRequest && *g_reporting.stopRequest;
+	}
 
 
 	///  SEARCH FUNCTIONS  ///
@@ -66,25 +130,112 @@ namespace engine {
 		MoveList& moves = g_moveLists[depth];
 
 		board.generateMoves(moves);
+
+		// Bulk counting: the moves of the last ply are only checked for legality, but never made
+		if (depth <= 1) {
+			for (Move m : moves) {
+				result += board.isLegal(m);
+			}
+
+			return result;
+		}
+
 		for (Move m : moves) {
 			if (!board.isLegal(m)) {
 				continue;
 			}
 
 			board.makeMove(m);
-			if (depth <= 1) {
-				result++;
+			result += perft(board, depth - 1);
+			board.unmakeMove(m);
+		}
+
+		return result;
+	}
+
+	// Remembers the result of a deep enough search for the next sessions
+	SearchResult learnRootResult(const Hash rootHash, const SearchResult result, const Depth depth) {
+		if (g_excludedRootMoves.empty()) {
+			LearningStore::record(rootHash, result.best, result.value, depth);
+		}
+
+		return result;
+	}
+
+	// The zero window searches are mostly cut off by the TT, so their PV is completed with the moves of the TT
+	void completePrincipalVariation(Board& board, MoveList& pv) {
+		for (Move m : pv) {
+			board.makeMove(m);
+		}
+
+		TableEntry entry;
+		MoveList moves;
+		while (Depth(pv.size()) < g_rootDepth && !board.isDraw() && TranspositionTable::probe(board.computeHash(), entry) && entry.move) {
+			board.generateMoves(moves);
+
+			const Move m = Move::fromData(entry.move);
+			if (std::none_of(moves.begin(), moves.end(), [m](const Move other) { return other.getData() == m.getData(); }) || !board.isLegal(m)) {
+				break;
+			}
+
+			board.makeMove(m);
+			pv.push(m);
+		}
+
+		for (u32 i = pv.size(); i-- > 0; ) {
+			board.unmakeMove(pv[i]);
+		}
+	}
+
+	// MTD(f): the value of the root is found by the zero window searches only, the TT keeps their trees between the calls
+	// The search fails hard, so the guess is moved by the doubling steps until the value is bounded from both sides,
+	// and then the bounds are halved (as in the best node search)
+	// The PV is the one of the last search that failed high
+	Value mtdf(Board& board, const Value firstGuess, MoveList& pv) {
+		i32 lower = -INF; // The value is within [lower, upper]
+		i32 upper = INF;
+		i32 guess = firstGuess;
+		i32 step = MTDF_FIRST_STEP;
+
+		pv.clear();
+		while (lower < upper) {
+			const i32 beta = std::clamp(guess, lower + 1, upper);
+			const Value result = search<NodeType::NON_PV>(board, Value(beta - 1), Value(beta), g_rootDepth, 0);
+
+			if (g_mustStop) {
+				return result;
+			}
+
+			if (result >= beta) {
+				lower = result;
+				pv.clear();
+				pv.mergeWith(g_PVs[0], 0);
 			} else {
-				result += perft(board, depth - 1);
+				upper = result;
 			}
 
-			board.unmakeMove(m);
+			if (upper == INF) {
+				guess = lower + step;
+				step *= 2;
+			} else if (lower == -INF) {
+				guess = upper - step + 1;
+				step *= 2;
+			} else {
+				guess = (lower + upper + 1) / 2;
+			}
 		}
 
-		return result;
+		// Every search failed low, so only the first move is known
+		if (!pv.size()) {
+			pv.mergeWith(g_PVs[0], 0);
+		}
+
+		completePrincipalVariation(board, pv);
+
+		return Value(lower > -INF ? lower : upper);
 	}
 
-	SearchResult rootSearch(Board& board) {
+	SearchResult rootSearch(Board& board, const bool isResumed) {
 		//static MoveList moves;
 
 		Move lastBest;
@@ -93,82 +244,133 @@ namespace engine {
 		Value beta = INF;
 		Value result = 0;
 
+		// The iterations below the first one are served by the transposition table when resuming
+		const Depth firstDepth = isResumed ? std::max<Depth>(1, g_completedDepth - RESUMED_DEPTH_MARGIN) : 1;
+
 		// Initializing the search
 		g_mustStop = false;
 		g_nodesCount = 0;
-		g_rootDepth = 0;
+		g_rootDepth = firstDepth - 1;
+		g_completedDepth = 0;
+		g_bestRootMove = Move::makeNullMove();
 
-		MovePicker::resetHistoryTables();
+		MoveList rootMoves;
+		board.generateMoves(rootMoves);
+		g_rootMovesSearched = 0;
+		g_rootMovesCount = u32(std::count_if(rootMoves.begin(), rootMoves.end(), [&board](const Move m) { return board.isLegal(m); }));
+
+		if (!isResumed) {
+			MovePicker::resetHistoryTables();
+		}
 		TranspositionTable::setRootAge(board.moveCount());
 
 		memset(g_searchStacks, 0, sizeof(g_searchStacks));
 
-		// Looking for the best move
-		while (!g_limits.isDepthLimitBroken(++g_rootDepth)) {
-
+		// The book moves and the tablebase lines are played without searching, but never analyzed:
+		// neither by an analysis mode nor by an infinite search
+		const bool isAnalysis = g_reporting.isAnalysis || options::g_analyzeMode || g_limits.isInfinite();
+		if (g_excludedRootMoves.empty() && Book::isOpen() && !isAnalysis) {
+			if (const Move bookMove = Book::probe(board); !bookMove.isNullMove()) {
+				g_PVs[0].clear();
+				g_PVs[0].push(bookMove);
+				return SearchResult { .best = bookMove, .value = 0 };
+			}
+		}
 
-			///  ASPIRATION WINDOW  ///
+		// The positions in the tablebases are played perfectly without searching
+		Value tableValue;
+		if (g_excludedRootMoves.empty() && Tablebases::getMaxPieces() && !isAnalysis && Tablebases::probeRoot(board, g_PVs[0], tableValue)) {
+			g_rootDepth = Depth(g_PVs[0].size());
+			reportIteration(tableValue);
+			return SearchResult { .best = g_PVs[0][0], .value = tableValue };
+		}
 
-			const static i32 WINDOW_WIDTH[] = { 35, 110, 450, 2 * INF };
-			u8 failedLowCnt = g_rootDepth < 2 ? std::size(WINDOW_WIDTH) - 1 : 0;
-			u8 failedHighCnt = failedLowCnt;
+		// The Syzygy tables keep only the root moves that do not spoil the result (within the fifty moves rule),
+		// the search chooses among them
+		g_tablebaseRootMoves.clear();
+		if (g_excludedRootMoves.empty() && Syzygy::getProbeLimit() && !isAnalysis && Syzygy::rankRootMoves(board, g_tablebaseRootMoves)) {
+			g_rootMovesCount = u32(g_tablebaseRootMoves.size());
+		}
 
-			alpha = Value(std::max(i32(-INF), i32(result) - WINDOW_WIDTH[failedLowCnt]));
-			beta = Value(std::min(i32(INF), i32(result) + WINDOW_WIDTH[failedHighCnt]));
+		// Seeding the first iterations with the result learned in the previous sessions:
+		// the move is tried first, and the aspiration window is centered on the value
+		const Hash rootHash = board.computeHash();
+		LearningEntry learned;
+		if (g_excludedRootMoves.empty() && LearningStore::probe(rootHash, learned)) {
+			MoveList moves;
+			board.generateMoves(moves);
+			for (Move m : moves) {
+				if (m.getData() == learned.move.getData() && board.isLegal(m)) {
+					TranspositionTable::tryRecord(EntryType(EntryType::EXACT | EntryType::PV), rootHash, m.getData(), learned.value, board.moveCount(), u8(learned.depth), 0);
+					lastBest = m;
+					lastResult = learned.value;
+					result = learned.value;
+					break;
+				}
+			}
+		}
 
-			while (true) {
-				result = search<NodeType::PV>(board, alpha, beta, g_rootDepth, 0);
+		// Looking for the best move
+		while (!g_limits.isDepthLimitBroken(++g_rootDepth)) {
+			if (options::g_mtdfMode) {
+				MoveList pv;
+				result = mtdf(board, result, pv);
 
 				if (g_mustStop) {
-					return SearchResult { .best = lastBest, .value = lastResult };
+					return learnRootResult(rootHash, SearchResult { .best = lastBest, .value = lastResult }, g_rootDepth - 1);
 				}
 
-				if (result <= alpha && failedLowCnt < std::size(WINDOW_WIDTH) - 1) { // Failed low
-					alpha = Value(std::max(i32(-INF), i32(result) - WINDOW_WIDTH[++failedLowCnt]));
-					beta = Value(std::min(i32(INF), i32(result) + WINDOW_WIDTH[failedHighCnt]));
-				} else if (result >= beta && failedHighCnt < std::size(WINDOW_WIDTH) - 1) { // Failed low
-					alpha = Value(std::max(i32(-INF), i32(result) - WINDOW_WIDTH[failedLowCnt]));
-					beta = Value(std::min(i32(INF), i32(result) + WINDOW_WIDTH[++failedHighCnt]));
-				} else {
-					break;
-				}
-			}
+				g_PVs[0].clear();
+				g_PVs[0].mergeWith(pv, 0);
+			} else {
+				///  ASPIRATION WINDOW  ///
 
-			// Printing the current search state
-			if (options::g_postMode) {
-				if (io::getMode() == io::IOMode::UCI) {
-					io::g_out
-						<< "info depth " << g_rootDepth
-						<< " nodes " << g_nodesCount
-						<< " time " << g_limits.elapsedMilliseconds();
-
-					if (isMateValue(result)) {
-						io::g_out << " score mate " << (result < 0 ? -gettingMatedIn(result) : givingMateIn(result));
+				const static i32 WINDOW_WIDTH[] = { 35, 110, 450, 2 * INF };
+				u8 failedLowCnt = g_rootDepth < 2 || g_rootDepth == firstDepth ? std::size(WINDOW_WIDTH) - 1 : 0;
+				u8 failedHighCnt = failedLowCnt;
+
+				alpha = Value(std::max(i32(-INF), i32(result) - WINDOW_WIDTH[failedLowCnt]));
+				beta = Value(std::min(i32(INF), i32(result) + WINDOW_WIDTH[failedHighCnt]));
+
+				while (true) {
+					result = search<NodeType::PV>(board, alpha, beta, g_rootDepth, 0);
+
+					if (g_mustStop) {
+						return learnRootResult(rootHash, SearchResult { .best = lastBest, .value = lastResult }, g_rootDepth - 1);
+					}
+
+					if (result <= alpha && failedLowCnt < std::size(WINDOW_WIDTH) - 1) { // Failed low
+						alpha = Value(std::max(i32(-INF), i32(result) - WINDOW_WIDTH[++failedLowCnt]));
+						beta = Value(std::min(i32(INF), i32(result) + WINDOW_WIDTH[failedHighCnt]));
+					} else if (result >= beta && failedHighCnt < std::size(WINDOW_WIDTH) - 1) { // Failed low
+						alpha = Value(std::max(i32(-INF), i32(result) - WINDOW_WIDTH[failedLowCnt]));
+						beta = Value(std::min(i32(INF), i32(result) + WINDOW_WIDTH[++failedHighCnt]));
 					} else {
-						io::g_out << " score cp " << result;
+						break;
 					}
+				}
 
-					io::g_out << " pv " << g_PVs[0].toString() << std::endl;
-				} else { // Xboard/Console
-					io::g_out << g_rootDepth << ' '
-						<< result << ' '
-						<< g_limits.elapsedCentiseconds() << ' '
-						<< g_nodesCount << ' '
-						<< g_PVs[0].toString() << std::endl;
+				// The resumed search is cut off by the transposition table right at the root
+				if (isResumed) {
+					completePrincipalVariation(board, g_PVs[0]);
 				}
 			}
 
+			// Printing the current search state
+			reportIteration(result);
+
 			// Check if we reached the soft limit
 			// Here is the perfect place to stop search
-			if (g_limits.isSoftLimitBroken()) {
-				return SearchResult { .best = g_PVs[0][0], .value = result };
+			if (g_limits.isSoftLimitBroken(g_nodesCount)) {
+				return learnRootResult(rootHash, SearchResult { .best = g_PVs[0][0], .value = result }, g_rootDepth);
 			}
 
 			lastBest = g_PVs[0][0];
 			lastResult = result;
+			g_bestRootMove = lastBest;
 		}
 
-		return SearchResult { .best = lastBest, .value = lastResult };
+		return learnRootResult(rootHash, SearchResult { .best = lastBest, .value = lastResult }, g_rootDepth - 1);
 	}
 
 	// The general search function
@@ -185,13 +387,13 @@ namespace engine {
 
 		// Checking limits and input
 		if ((g_nodesCount & 0x1ff) == 0) {
-			if (g_limits.isHardLimitBroken() || g_limits.isNodesLimitBroken(g_nodesCount)) {
+			if (g_limits.isHardLimitBroken(g_nodesCount) || g_limits.isNodesLimitBroken(g_nodesCount) || isStopRequested()) {
 				g_mustStop = true;
 				return alpha;
 			}
 
 			// Cheching for possible input once in 8192 nodes
-			if ((g_nodesCount & 0x1fff) == 0) {
+			if ((g_nodesCount & 0x1fff) == 0 && g_reporting.checkInput) {
 				checkInput();
 			}
 		}
@@ -225,9 +427,10 @@ namespace engine {
 
 		///  TRANSPOSITION TABLE  ///
 
-		TableEntry* entry = TranspositionTable::probe(board.computeHash());
+		TableEntry tableEntry;
+		const TableEntry* entry = &tableEntry;
 		Move tableMove = Move::makeNullMove();
-		if (entry != nullptr) { // Current position was found
+		if (TranspositionTable::probe(board.computeHash(), tableEntry)) { // Current position was found
 			// Check if it is possible to just return the value from the table
 			if (entry->depth >= depth && ply && (entry->isPvNode() || NT != NodeType::PV)) {
 				Value value = entry->value;
@@ -257,10 +460,44 @@ namespace engine {
 		}
 
 
+		///  TABLEBASES  ///
+
+		// The values of the tablebases are exact, so they are kept in the TT as the deepest ones
+		Value tableValue;
+		if (ply && board.allPieces().popcnt() <= Tablebases::getMaxPieces() && Tablebases::probe(board, ply, tableValue)) {
+			TranspositionTable::tryRecord(EntryType(EntryType::EXACT | EntryType::PV), board.computeHash(), 0, tableValue, board.moveCount(), MAX_DEPTH, ply);
+			return tableValue;
+		}
+
+		// The WDL of the Syzygy tables is exact only right after a capture or a pawn move,
+		// so it is probed there and kept in the TT deeper than the search would reach
+		// A win is a lower bound and a loss is an upper bound (the mates are beyond them), so the search goes on
+		// within the bound when it does not cut off
+		WDL wdl;
+		bool isWinFromTables = false;
+		Value maxValueFromTables = INF;
+		if (ply && !board.fiftyRule() && board.allPieces().popcnt() <= Syzygy::getProbeLimit() && Syzygy::probeWDL(board, wdl)) {
+			const Value value = wdl == WDL::WIN ? Value(Syzygy::WIN_VALUE - ply) : wdl == WDL::LOSS ? Value(-Syzygy::WIN_VALUE + ply) : 0;
+			const EntryType bound = wdl == WDL::WIN ? EntryType::BETA : wdl == WDL::LOSS ? EntryType::ALPHA : EntryType::EXACT;
+			if (bound == EntryType::EXACT || (bound == EntryType::BETA ? value >= beta : value <= alpha)) {
+				TranspositionTable::tryRecord(bound, board.computeHash(), 0, value, board.moveCount(), u8(std::min<Depth>(MAX_DEPTH, depth + 6)), ply);
+				return value;
+			}
+
+			if (bound == EntryType::BETA && value > alpha) {
+				alpha = value;
+				isWinFromTables = true;
+			} else if (bound == EntryType::ALPHA) {
+				maxValueFromTables = value;
+			}
+		}
+
+
 		///  PRUNINGS AND REDUCTIONS  ///
 
+		// The root is never pruned, even when MTD(f) searches it with the zero windows
 		const bool isInCheck = board.isInCheck();
-		if (NT != NodeType::PV && !isInCheck) {
+		if (NT != NodeType::PV && !isInCheck && ply) {
 			const static Value FUTILITY_MARGIN[] = { 0, 50, 200, 400, 700 };
 
 			Value staticEval = eval(board);
@@ -349,10 +586,24 @@ namespace engine {
 				continue;
 			}
 
+			if (!ply && !g_excludedRootMoves.empty() && std::any_of(g_excludedRootMoves.begin(), g_excludedRootMoves.end(),
+				[m](const Move excluded) { return excluded.getData() == m.getData(); })) {
+				continue;
+			}
+
+			if (!ply && !g_tablebaseRootMoves.empty() && std::none_of(g_tablebaseRootMoves.begin(), g_tablebaseRootMoves.end(),
+				[m](const Move kept) { return kept.getData() == m.getData(); })) {
+				continue;
+			}
+
 			++legalMovesCount;
+			if (!ply) {
+				g_rootMovesSearched = legalMovesCount;
+				g_currentRootMove = m;
+			}
 
 			const bool isQuiet = board.isQuiet(m);
-			if (NT != NodeType::PV && depth <= MAX_LOW_DEPTH_SEE_PRUNING_DEPTH && !isInCheck && board.hasNonPawns(board.side())) {
+			if (NT != NodeType::PV && ply && depth <= MAX_LOW_DEPTH_SEE_PRUNING_DEPTH && !isInCheck && board.hasNonPawns(board.side())) {
 
 
 				///  LOW DEPTH SEE PRUNING  ///
@@ -474,16 +725,27 @@ namespace engine {
 				: 0; // Stalemate
 		}
 
+		// The bounds of the tables: no move reached beyond the win, or the result is not above the loss
+		if (isWinFromTables && entryType == EntryType::ALPHA) {
+			entryType = EntryType::BETA;
+		} else if (alpha > maxValueFromTables) {
+			alpha = maxValueFromTables;
+			entryType = EntryType::ALPHA;
+		}
+
 		// Saving the results in the transposition table
-		TranspositionTable::tryRecord(
-			EntryType(u8(entryType) | u8(NT)), 
-			board.computeHash(), 
-			bestMove.getData(), 
-			alpha, 
-			board.moveCount(), 
-			depth,
-			ply
-		);
+		// The root searched with some of its moves excluded (the later multi-PV lines) does not get its true value
+		if (ply || g_excludedRootMoves.empty()) {
+			TranspositionTable::tryRecord(
+				EntryType(u8(entryType) | u8(NT)), 
+				board.computeHash(), 
+				bestMove.getData(), 
+				alpha, 
+				board.moveCount(), 
+				depth,
+				ply
+			);
+		}
 
 		return alpha;
 	}
@@ -496,13 +758,13 @@ namespace engine {
 
 		// Checking limits and input
 		if ((g_nodesCount & 0x1ff) == 0) {
-			if (g_limits.isHardLimitBroken() || g_limits.isNodesLimitBroken(g_nodesCount)) {
+			if (g_limits.isHardLimitBroken(g_nodesCount) || g_limits.isNodesLimitBroken(g_nodesCount) || isStopRequested()) {
 				g_mustStop = true;
 				return alpha;
 			}
 
 			// Cheching for possible input once in 8192 nodes
-			if ((g_nodesCount & 0x1fff) == 0) {
+			if ((g_nodesCount & 0x1fff) == 0 && g_reporting.checkInput) {
 				checkInput();
 			}
 		}
@@ -622,6 +884,54 @@ namespace engine {
 		MovePicker::init();
 	}
 
+	void bindSearchThread(const u32 index) {
+		if (!numa_utils::bindThread(index)) {
+			return;
+		}
+
+		numa_utils::moveToLocalNode(g_searchStacks, sizeof(g_searchStacks));
+		numa_utils::moveToLocalNode(g_moveLists, sizeof(g_moveLists));
+		numa_utils::moveToLocalNode(g_PVs, sizeof(g_PVs));
+		numa_utils::moveToLocalNode(s_historyTries, sizeof(s_historyTries));
+		numa_utils::moveToLocalNode(s_historySuccesses, sizeof(s_historySuccesses));
+		PawnHashTable::moveToLocalNode();
+	}
+
+	std::string scoreToString(const Value value) {
+		return isMateValue(value)
+			? "mate " + std::to_string(value < 0 ? -gettingMatedIn(value) : givingMateIn(value))
+			: "cp " + std::to_string(value);
+	}
+
+	NodesCount getNodesCount() {
+		return g_nodesCount;
+	}
+
+	void resetSearchState() {
+		g_mustStop = false;
+		g_nodesCount = 0;
+	}
+
+	bool isSearchStopped() {
+		return g_mustStop || isStopRequested();
+	}
+
+	Depth getCompletedDepth() {
+		return g_completedDepth;
+	}
+
+	SearchStatus getSearchStatus() {
+		return SearchStatus {
+			.depth = g_rootDepth,
+			.nodes = g_nodesCount,
+			.milliseconds = g_limits.elapsedMilliseconds(),
+			.rootMovesSearched = g_rootMovesSearched,
+			.rootMovesCount = g_rootMovesCount,
+			.rootMove = g_currentRootMove,
+			.bestMove = g_bestRootMove
+		};
+	}
+
 	void stopSearching() {
 		g_mustStop = true;
 	}
@@ -17,6 +17,9 @@
 */
 
 #pragma once
+#include <atomic>
+#include <functional>
+
 #include "Chess/Board.h"
 #include "Limits.h"
 
@@ -44,6 +47,9 @@
 *		17) History Leaf Pruning
 *		18) Aspiration Window
 *		19) Internal Iterative Deepening
+* 
+*	All the search state is thread-local, so several independent searches can run in parallel,
+*	sharing only the transposition table.
 */
 
 namespace engine {
@@ -62,7 +68,47 @@ namespace engine {
 		Move secondKiller;
 	};
 
-	extern Limits g_limits;
+	// The state of the search after a completed iteration of the iterative deepening
+	struct IterationInfo final {
+		Depth depth;
+		Value value;
+		NodesCount nodes;
+		time_t milliseconds;
+		const MoveList& pv;
+	};
+
+	// The progress of the current iteration, requested by the GUI while analyzing
+	struct SearchStatus final {
+		Depth depth;
+		NodesCount nodes;
+		time_t milliseconds;
+		u32 rootMovesSearched; // Including the one being searched
+		u32 rootMovesCount;
+		Move rootMove;
+		Move bestMove; // Of the last completed iteration
+	};
+
+	// Defines how the search of the current thread communicates with the outer world
+	struct SearchReporting final {
+		// Only the thread that owns the input may check it while searching
+		bool checkInput = true;
+
+		// If set, it is called after every completed iteration instead of printing the search state
+		std::function<void(const IterationInfo&)> onIteration;
+
+		// If set, the search stops as soon as it becomes true, so that another thread can stop it
+		const std::atomic_bool* stopRequest = nullptr;
+
+		// The analysis must search the position itself, so neither the opening book nor the tablebases are played from
+		bool isAnalysis = false;
+	};
+
+	extern thread_local Limits g_limits;
+	extern thread_local SearchReporting g_reporting;
+
+	// The root moves skipped by the search of the current thread
+	// Multi-PV is searched by excluding the best moves of the previous lines
+	extern thread_local std::vector<Move> g_excludedRootMoves;
 
 
 	///  SEARCH FUNCTIONS  ///
@@ -71,7 +117,9 @@ namespace engine {
 	NodesCount perft(Board& board, const Depth depth);
 
 	// The main search function used to find the best move
-	SearchResult rootSearch(Board& board);
+	// The resumed search (after a move or an undo while analyzing) keeps the history tables and starts
+	// the iterative deepening near the depth completed by the previous search, as the transposition table is warm
+	SearchResult rootSearch(Board& board, const bool isResumed = false);
 
 	// The general search function
 	template<NodeType NT = NodeType::PV>
@@ -87,7 +135,32 @@ namespace engine {
 	// Initialization before a new game
 	void initSearch();
 
-	// When called - stops all searches
+	// Places the calling search thread according to the affinity settings, the threads are numbered from 0
+	// The thread-local search state is moved along to the node of the thread
+	void bindSearchThread(const u32 index);
+
+	// The value as in UCI: "cp <centipawns>" or "mate <moves>"
+	std::string scoreToString(const Value value);
+
+	// Prints the state of the search or passes it to g_reporting.onIteration
+	void reportIteration(const IterationInfo& info);
+
+	// Prepares the current thread for a search driven by something else than rootSearch
+	void resetSearchState();
+
+	// Returns true if the search of the current thread was stopped by the limits, the input or another thread
+	bool isSearchStopped();
+
+	// The number of nodes searched by the current thread since the start of the last search
+	NodesCount getNodesCount();
+
+	// The depth of the last iteration completed by the current thread
+	Depth getCompletedDepth();
+
+	// The progress of the search of the current thread
+	SearchStatus getSearchStatus();
+
+	// When called - stops the search of the current thread
 	// Expected to be used when a command was given to stop thinking
 	void stopSearching();
 }
\ No newline at end of file
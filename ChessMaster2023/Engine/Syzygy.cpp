@@ -0,0 +1,1572 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Syzygy.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <Windows.h>
+#endif // _WIN32
+
+namespace engine {
+	constexpr u8 WDL_MAGIC[] = { 0x71, 0xe8, 0x23, 0x5d };
+	constexpr u8 DTZ_MAGIC[] = { 0xd7, 0x66, 0x0c, 0xa5 };
+	constexpr const char* WDL_EXTENSION = ".rtbw";
+	constexpr const char* DTZ_EXTENSION = ".rtbz";
+
+	// The flags of the file
+	constexpr u8 SPLIT_FLAG = 1; // Both sides to move are kept
+	constexpr u8 PAWNS_FLAG = 2; // The table is split by the file of the leading pawn
+
+	// The flags of a part of the table
+	constexpr u8 STM_FLAG = 1; // DTZ: the side to move kept
+	constexpr u8 MAPPED_FLAG = 2; // DTZ: the values are mapped by the WDL
+	constexpr u8 WIN_PLIES_FLAG = 4; // DTZ: the wins are in plies, not in moves
+	constexpr u8 LOSS_PLIES_FLAG = 8; // DTZ: the losses are in plies, not in moves
+	constexpr u8 WIDE_FLAG = 16; // DTZ: the map has 16-bit values
+	constexpr u8 SINGLE_VALUE_FLAG = 128; // All the positions have the same value
+
+	constexpr u16 LEAF_SYMBOL = 0xfff; // The right half of a symbol that is not a pair
+	constexpr i32 MAX_DTZ = 1 << 18; // The rank of the sure wins at the root
+
+	u32 Syzygy::s_maxPieces = 0;
+	u32 Syzygy::s_probeLimit = Syzygy::MAX_PIECES;
+
+	template<typename T>
+	inline T readLittleEndian(const u8* bytes) noexcept {
+		T value = 0;
+		for (size_t i = 0; i < sizeof(T); i++) {
+			value = T(value | (T(bytes[i]) << (8 * i)));
+		}
+
+		return value;
+	}
+
+	template<typename T>
+	inline T readBigEndian(const u8* bytes) noexcept {
+		T value = 0;
+		for (size_t i = 0; i < sizeof(T); i++) {
+			value = T((value << 8) | bytes[i]);
+		}
+
+		return value;
+	}
+
+	template<typename T>
+	inline void writeLittleEndian(std::vector<u8>& bytes, const T value) {
+		for (size_t i = 0; i < sizeof(T); i++) {
+			bytes.push_back(u8(value >> (8 * i)));
+		}
+	}
+
+
+	///  INDEXING  ///
+
+	// The squares below the A1-H8 diagonal are negative, the ones above it are positive
+	CM_PURE constexpr i32 offDiagonal(const i32 sq) noexcept {
+		return (sq >> 3) - (sq & 7);
+	}
+
+	i32 g_mapB1H1H7[64]; // The squares below the A1-H8 diagonal, 0 ... 27
+	i32 g_mapA1D1D4[64]; // The squares of the A1-D1-D4 triangle, 0 ... 9 (the diagonal ones are the last)
+	i32 g_mapKK[10][64]; // The 462 positions of the two kings, the first one in the triangle
+	u64 g_binomial[6][64]; // [k][n], the ways to choose k elements of n
+	i32 g_mapPawns[64]; // The pawns nearer the edge and on the lower ranks are greater, 0 ... 47
+	u64 g_leadPawnIndex[6][64]; // [leading pawns][the first one], the index of the first leading pawn on its file
+	u64 g_leadPawnsSize[6][4]; // [leading pawns][file], the positions of the leading pawns on the file
+
+	void initIndexing() {
+		static bool isInitialized = false;
+		if (isInitialized) {
+			return;
+		}
+
+		isInitialized = true;
+
+		i32 code = 0;
+		for (i32 sq = 0; sq < 64; sq++) {
+			if (offDiagonal(sq) < 0) {
+				g_mapB1H1H7[sq] = code++;
+			}
+		}
+
+		code = 0;
+		std::vector<i32> diagonal;
+		for (i32 sq = 0; sq <= Square::D4; sq++) {
+			if (offDiagonal(sq) < 0 && (sq & 7) <= File::D) {
+				g_mapA1D1D4[sq] = code++;
+			} else if (!offDiagonal(sq) && (sq & 7) <= File::D) {
+				diagonal.push_back(sq);
+			}
+		}
+
+		for (const i32 sq : diagonal) {
+			g_mapA1D1D4[sq] = code++;
+		}
+
+		// The kings on the diagonal are the last, and the second one is never above it then
+		code = 0;
+		std::vector<std::pair<i32, i32>> bothOnDiagonal;
+		for (i32 index = 0; index < 10; index++) {
+			for (i32 first = 0; first <= Square::D4; first++) {
+				if (g_mapA1D1D4[first] != index || (!index && first != Square::B1) || (first & 7) > File::D || offDiagonal(first) > 0) {
+					continue;
+				}
+
+				for (i32 second = 0; second < 64; second++) {
+					if (Square::distance(Square(u8(first)), Square(u8(second))) <= 1) {
+						continue;
+					} else if (!offDiagonal(first) && offDiagonal(second) > 0) {
+						continue;
+					} else if (!offDiagonal(first) && !offDiagonal(second)) {
+						bothOnDiagonal.emplace_back(index, second);
+					} else {
+						g_mapKK[index][second] = code++;
+					}
+				}
+			}
+		}
+
+		for (const auto& [index, second] : bothOnDiagonal) {
+			g_mapKK[index][second] = code++;
+		}
+
+		g_binomial[0][0] = 1;
+		for (i32 n = 1; n < 64; n++) {
+			for (i32 k = 0; k < 6 && k <= n; k++) {
+				g_binomial[k][n] = (k > 0 ? g_binomial[k - 1][n - 1] : 0) + (k < n ? g_binomial[k][n - 1] : 0);
+			}
+		}
+
+		i32 availableSquares = 47;
+		for (u32 leadPawnsCount = 1; leadPawnsCount <= 5; leadPawnsCount++) {
+			for (i32 file = 0; file < 4; file++) {
+				u64 index = 0;
+				for (i32 rank = 1; rank <= 6; rank++) {
+					const i32 sq = 8 * rank + file;
+					if (leadPawnsCount == 1) {
+						g_mapPawns[sq] = availableSquares--;
+						g_mapPawns[sq ^ 7] = availableSquares--;
+					}
+
+					g_leadPawnIndex[leadPawnsCount][sq] = index;
+					index += g_binomial[leadPawnsCount - 1][g_mapPawns[sq]];
+				}
+
+				g_leadPawnsSize[leadPawnsCount][file] = index;
+			}
+		}
+	}
+
+	inline bool comparePawns(const i32 a, const i32 b) noexcept {
+		return g_mapPawns[a] < g_mapPawns[b];
+	}
+
+
+	///  TABLES  ///
+
+	struct MappedFile final {
+		const u8* data = nullptr;
+		size_t size = 0;
+#ifdef _WIN32
+		HANDLE mapping = nullptr;
+#endif // _WIN32
+	};
+
+	// A part of a table: the positions of one side to move with the leading pawn on one file
+	struct PairsData final {
+		u8 flags = 0;
+		u8 minSymbolLength = 0; // Or the value of all the positions
+		u8 maxSymbolLength = 0;
+		u64 blockSize = 0;
+		u64 span = 0; // The values between the entries of the sparse index
+		size_t sparseIndexSize = 0;
+		size_t blockLengthsSize = 0;
+		u32 blocksCount = 0;
+
+		const u8* lowestSymbols = nullptr; // 16 bits for every length of the codes, the first symbol of the length
+		const u8* symbolTree = nullptr; // 24 bits for every symbol, its halves (or its value if it is not a pair)
+		const u8* sparseIndex = nullptr; // 48 bits for every entry, the block and the offset in it
+		const u8* blockLengths = nullptr; // 16 bits for every block, its values less one
+		const u8* data = nullptr;
+
+		std::vector<u64> base; // The first code of every length, left-aligned
+		std::vector<u16> symbolLengths; // The values of every symbol less one
+
+		u8 pieces[Syzygy::MAX_PIECES] { }; // In the order of the index
+		u8 groupLengths[Syzygy::MAX_PIECES + 1] { }; // Zero-terminated
+		u64 groupFactors[Syzygy::MAX_PIECES + 1] { }; // The last one is the size of the part
+		u16 mapIndices[4] { }; // DTZ: where the map of every WDL starts
+
+		CM_PURE u16 getLeft(const u16 symbol) const noexcept {
+			const u8* lr = symbolTree + 3 * symbol;
+			return u16(((lr[1] & 0xf) << 8) | lr[0]);
+		}
+
+		CM_PURE u16 getRight(const u16 symbol) const noexcept {
+			const u8* lr = symbolTree + 3 * symbol;
+			return u16((lr[2] << 4) | (lr[1] >> 4));
+		}
+
+		CM_PURE u64 getSize() const noexcept {
+			return groupFactors[std::find(groupLengths, groupLengths + Syzygy::MAX_PIECES + 1, 0) - groupLengths];
+		}
+	};
+
+	struct SyzygyTable final {
+		std::string name;
+		u64 key = 0; // The material of the stronger side being White
+		u64 flippedKey = 0;
+		u32 piecesCount = 0;
+		u8 pawnsCount[2] { }; // Of the leading color, then of the other one
+		bool hasPawns = false;
+		bool hasUniquePieces = false; // Any piece but a king is alone of its kind
+		bool hasDTZ = false;
+
+		MappedFile wdlFile;
+		MappedFile dtzFile;
+		PairsData wdl[2][4]; // [side to move][file]
+		PairsData dtz[4];
+		const u8* dtzMap = nullptr;
+
+		CM_PURE bool isSymmetric() const noexcept {
+			return key == flippedKey;
+		}
+	};
+
+	std::vector<std::unique_ptr<SyzygyTable>> g_syzygyTables;
+	std::unordered_map<u64, const SyzygyTable*> g_syzygyByKey; // Both the keys of every table
+
+	// 4 bits for the count of every piece, the white ones first
+	u64 computeMaterialKey(const Board& board, const bool isFlipped) {
+		u64 key = 0;
+		for (Color color : Color::iter()) {
+			for (u8 pt = PieceType::PAWN; pt <= PieceType::KING; pt++) {
+				const u32 count = board.byPiece(Piece(color, PieceType::Value(pt))).popcnt();
+				const bool isWhite = (color == Color::WHITE) != isFlipped;
+				key |= u64(count) << (4 * (6 * isWhite + pt - 1));
+			}
+		}
+
+		return key;
+	}
+
+	// The code of the piece in the files: 1 ... 6 for the white pawn ... king, 9 ... 14 for the black ones
+	CM_PURE constexpr u8 getPieceCode(const Piece piece) noexcept {
+		return u8(piece.getType() | (piece.getColor() == Color::BLACK ? 8 : 0));
+	}
+
+	// Parses the configuration (like KRPvKN), the first side being White
+	bool parseName(const std::string& name, SyzygyTable& table, std::vector<u8>& codes) {
+		const size_t separator = name.find('v');
+		if (separator == std::string::npos || name.size() < 3 || name[0] != 'K' || name[separator + 1] != 'K') {
+			return false;
+		}
+
+		u32 counts[2][7] = { }; // [is black][type]
+		codes.clear();
+		for (size_t i = 0; i < name.size(); i++) {
+			const u32 isBlack = i > separator;
+			if (i == separator) {
+				continue;
+			}
+
+			const char* TYPES = "PNBRQK";
+			const char* type = strchr(TYPES, name[i]);
+			if (!name[i] || !type || (name[i] == 'K' && i != 0 && i != separator + 1)) {
+				return false;
+			}
+
+			counts[isBlack][type - TYPES + 1]++;
+			codes.push_back(u8((type - TYPES + 1) | (isBlack ? 8 : 0)));
+		}
+
+		table.name = name;
+		table.piecesCount = u32(codes.size());
+		if (table.piecesCount > Syzygy::MAX_PIECES) {
+			return false;
+		}
+
+		table.key = table.flippedKey = 0;
+		table.hasUniquePieces = false;
+		for (u32 isBlack = 0; isBlack < 2; isBlack++) {
+			for (u32 pt = 1; pt <= 6; pt++) {
+				table.key |= u64(counts[isBlack][pt]) << (4 * (6 * !isBlack + pt - 1));
+				table.flippedKey |= u64(counts[isBlack][pt]) << (4 * (6 * isBlack + pt - 1));
+				table.hasUniquePieces |= pt != 6 && counts[isBlack][pt] == 1;
+			}
+		}
+
+		// The leading pawns are the ones of the side with fewer pawns, White if they are equal
+		const bool isWhiteLeading = !counts[1][1] || (counts[0][1] && counts[1][1] >= counts[0][1]);
+		table.hasPawns = counts[0][1] || counts[1][1];
+		table.pawnsCount[0] = u8(counts[!isWhiteLeading][1]);
+		table.pawnsCount[1] = u8(counts[isWhiteLeading][1]);
+		return true;
+	}
+
+	bool mapFile(const std::filesystem::path& path, MappedFile& file) {
+#ifndef _WIN32
+		const int descriptor = ::open(path.string().c_str(), O_RDONLY);
+		struct stat info;
+		if (descriptor < 0 || fstat(descriptor, &info) != 0 || info.st_size < 16) {
+			if (descriptor >= 0) {
+				::close(descriptor);
+			}
+
+			return false;
+		}
+
+		file.size = size_t(info.st_size);
+		void* memory = mmap(nullptr, file.size, PROT_READ, MAP_SHARED, descriptor, 0);
+		::close(descriptor); // The mapping stays
+		if (memory == MAP_FAILED) {
+			return false;
+		}
+
+		file.data = static_cast<const u8*>(memory);
+#else
+		const HANDLE handle = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+		LARGE_INTEGER size;
+		if (handle == INVALID_HANDLE_VALUE || !GetFileSizeEx(handle, &size) || size.QuadPart < 16) {
+			if (handle != INVALID_HANDLE_VALUE) {
+				CloseHandle(handle);
+			}
+
+			return false;
+		}
+
+		file.size = size_t(size.QuadPart);
+		file.mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(handle); // The mapping stays
+		if (!file.mapping) {
+			return false;
+		}
+
+		file.data = static_cast<const u8*>(MapViewOfFile(file.mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!file.data) {
+			CloseHandle(file.mapping);
+			file.mapping = nullptr;
+			return false;
+		}
+#endif // _WIN32
+
+		return true;
+	}
+
+	void unmapFile(MappedFile& file) {
+		if (!file.data) {
+			return;
+		}
+
+#ifndef _WIN32
+		munmap(const_cast<u8*>(file.data), file.size);
+#else
+		UnmapViewOfFile(file.data);
+		CloseHandle(file.mapping);
+		file.mapping = nullptr;
+#endif // _WIN32
+
+		file.data = nullptr;
+		file.size = 0;
+	}
+
+
+	///  PARSING  ///
+
+	// The groups of the pieces and their factors in the index
+	void setGroups(const SyzygyTable& table, PairsData& d, const u8 order[2], const u32 file) {
+		u32 n = 0;
+		i32 firstLength = table.hasPawns ? 0 : table.hasUniquePieces ? 3 : 2;
+		d.groupLengths[n] = 1;
+
+		// The leading pieces (or pawns) are the first group, then every group is of the same pieces
+		for (u32 i = 1; i < table.piecesCount; i++) {
+			if (--firstLength > 0 || d.pieces[i] == d.pieces[i - 1]) {
+				d.groupLengths[n]++;
+			} else {
+				d.groupLengths[++n] = 1;
+			}
+		}
+
+		d.groupLengths[++n] = 0;
+
+		// The order of the groups in the index is given by the table: the leading group is at order[0],
+		// the remaining pawns at order[1], and the other groups follow in turn
+		const bool hasBothPawns = table.hasPawns && table.pawnsCount[1];
+		u32 next = hasBothPawns ? 2 : 1;
+		u32 freeSquares = 64 - d.groupLengths[0] - (hasBothPawns ? d.groupLengths[1] : 0);
+		u64 factor = 1;
+		for (u32 k = 0; next < n || k == order[0] || k == order[1]; k++) {
+			if (k == order[0]) {
+				d.groupFactors[0] = factor;
+				factor *= table.hasPawns ? g_leadPawnsSize[d.groupLengths[0]][file] : table.hasUniquePieces ? 31332 : 462;
+			} else if (k == order[1]) {
+				d.groupFactors[1] = factor;
+				factor *= g_binomial[d.groupLengths[1]][48 - d.groupLengths[0]];
+			} else {
+				d.groupFactors[next] = factor;
+				factor *= g_binomial[d.groupLengths[next]][freeSquares];
+				freeSquares -= d.groupLengths[next++];
+			}
+		}
+
+		d.groupFactors[n] = factor;
+	}
+
+	u16 computeSymbolLength(PairsData& d, const u16 symbol, std::vector<bool>& isVisited) {
+		isVisited[symbol] = true; // The tree has no cycles
+		const u16 right = d.getRight(symbol);
+		if (right == LEAF_SYMBOL) {
+			return 0;
+		}
+
+		const u16 left = d.getLeft(symbol);
+		if (!isVisited[left]) {
+			d.symbolLengths[left] = computeSymbolLength(d, left, isVisited);
+		}
+
+		if (!isVisited[right]) {
+			d.symbolLengths[right] = computeSymbolLength(d, right, isVisited);
+		}
+
+		return u16(d.symbolLengths[left] + d.symbolLengths[right] + 1);
+	}
+
+	// Reads the sizes of the part and its symbols
+	const u8* parseSizes(PairsData& d, const u8* data) {
+		d.flags = *data++;
+		if (d.flags & SINGLE_VALUE_FLAG) {
+			d.blocksCount = 0;
+			d.blockLengthsSize = 0;
+			d.span = 0;
+			d.sparseIndexSize = 0;
+			d.minSymbolLength = *data++;
+			return data;
+		}
+
+		d.blockSize = u64(1) << *data++;
+		d.span = u64(1) << *data++;
+		d.sparseIndexSize = size_t((d.getSize() + d.span - 1) / d.span);
+		const u8 padding = *data++;
+		d.blocksCount = readLittleEndian<u32>(data);
+		data += sizeof(u32);
+		d.blockLengthsSize = d.blocksCount + padding; // The sparse index may point to the padding
+		d.maxSymbolLength = *data++;
+		d.minSymbolLength = *data++;
+		d.lowestSymbols = data;
+
+		// The canonical Huffman codes: the longer codes are lower, and the codes of the same length are consecutive,
+		// so a left-aligned code of a length is between the first codes of its length and of the next shorter one
+		d.base.assign(d.maxSymbolLength - d.minSymbolLength + 1, 0);
+		for (i32 i = i32(d.base.size()) - 2; i >= 0; i--) {
+			d.base[i] = (d.base[i + 1] + readLittleEndian<u16>(d.lowestSymbols + 2 * i) - readLittleEndian<u16>(d.lowestSymbols + 2 * (i + 1))) / 2;
+		}
+
+		for (size_t i = 0; i < d.base.size(); i++) {
+			d.base[i] <<= 64 - i - d.minSymbolLength;
+		}
+
+		data += d.base.size() * sizeof(u16);
+		d.symbolLengths.assign(readLittleEndian<u16>(data), 0);
+		data += sizeof(u16);
+		d.symbolTree = data;
+
+		// The symbols are the values and the pairs of the symbols, replaced by the recursive pairing
+		std::vector<bool> isVisited(d.symbolLengths.size());
+		for (u16 symbol = 0; symbol < d.symbolLengths.size(); symbol++) {
+			if (!isVisited[symbol]) {
+				d.symbolLengths[symbol] = computeSymbolLength(d, symbol, isVisited);
+			}
+		}
+
+		return data + 3 * d.symbolLengths.size() + (d.symbolLengths.size() & 1);
+	}
+
+	// Parses the file of the table, returns false if it is not one
+	bool parseTable(SyzygyTable& table, const bool isDTZ) {
+		const MappedFile& file = isDTZ ? table.dtzFile : table.wdlFile;
+		const u8* begin = file.data;
+		const u8* data = begin;
+		if (memcmp(data, isDTZ ? DTZ_MAGIC : WDL_MAGIC, 4) != 0) {
+			return false;
+		}
+
+		data += 4;
+		const u8 flags = *data++;
+		if (bool(flags & PAWNS_FLAG) != table.hasPawns || bool(flags & SPLIT_FLAG) != !table.isSymmetric()) {
+			return false;
+		}
+
+		const u32 sides = !isDTZ && !table.isSymmetric() ? 2 : 1;
+		const u32 files = table.hasPawns ? 4 : 1;
+		const bool hasBothPawns = table.hasPawns && table.pawnsCount[1];
+		auto part = [&table, isDTZ](const u32 side, const u32 file) -> PairsData& {
+			return isDTZ ? table.dtz[file] : table.wdl[side][file];
+		};
+
+		for (u32 f = 0; f < files; f++) {
+			for (u32 side = 0; side < sides; side++) {
+				part(side, f) = PairsData();
+			}
+
+			const u8 order[2][2] = {
+				{ u8(data[0] & 0xf), u8(hasBothPawns ? data[1] & 0xf : 0xf) },
+				{ u8(data[0] >> 4), u8(hasBothPawns ? data[1] >> 4 : 0xf) }
+			};
+			data += 1 + hasBothPawns;
+
+			for (u32 k = 0; k < table.piecesCount; k++, data++) {
+				for (u32 side = 0; side < sides; side++) {
+					part(side, f).pieces[k] = side ? *data >> 4 : *data & 0xf;
+				}
+			}
+
+			for (u32 side = 0; side < sides; side++) {
+				setGroups(table, part(side, f), order[side], f);
+			}
+		}
+
+		data += (data - begin) & 1;
+
+		for (u32 f = 0; f < files; f++) {
+			for (u32 side = 0; side < sides; side++) {
+				data = parseSizes(part(side, f), data);
+			}
+		}
+
+		// The DTZ maps of the values, for every file the ones of the win, the loss, the cursed win and the blessed loss
+		if (isDTZ) {
+			table.dtzMap = data;
+			for (u32 f = 0; f < files; f++) {
+				PairsData& d = table.dtz[f];
+				if (!(d.flags & MAPPED_FLAG)) {
+					continue;
+				}
+
+				if (d.flags & WIDE_FLAG) {
+					data += (data - begin) & 1;
+					for (u32 i = 0; i < 4; i++) {
+						d.mapIndices[i] = u16((data - table.dtzMap) / 2 + 1);
+						data += 2 * readLittleEndian<u16>(data) + 2;
+					}
+				} else {
+					for (u32 i = 0; i < 4; i++) {
+						d.mapIndices[i] = u16(data - table.dtzMap + 1);
+						data += *data + 1;
+					}
+				}
+			}
+
+			data += (data - begin) & 1;
+		}
+
+		for (u32 f = 0; f < files; f++) {
+			for (u32 side = 0; side < sides; side++) {
+				part(side, f).sparseIndex = data;
+				data += 6 * part(side, f).sparseIndexSize;
+			}
+		}
+
+		for (u32 f = 0; f < files; f++) {
+			for (u32 side = 0; side < sides; side++) {
+				part(side, f).blockLengths = data;
+				data += sizeof(u16) * part(side, f).blockLengthsSize;
+			}
+		}
+
+		for (u32 f = 0; f < files; f++) {
+			for (u32 side = 0; side < sides; side++) {
+				data = begin + (((data - begin) + 0x3f) & ~0x3f);
+				part(side, f).data = data;
+				data += part(side, f).blocksCount * part(side, f).blockSize;
+			}
+		}
+
+		return data <= begin + file.size;
+	}
+
+	void closeTable(SyzygyTable& table) {
+		unmapFile(table.wdlFile);
+		unmapFile(table.dtzFile);
+	}
+
+
+	///  PROBING  ///
+
+	enum class ProbeState : i8 {
+		FAIL = 0,
+		OK,
+		CHANGE_STM, // The DTZ is kept for the other side to move
+		ZEROING_BEST_MOVE // The best move is a capture or a pawn move, so the DTZ is not in the table
+	};
+
+	CM_PURE constexpr i32 sign(const i32 value) noexcept {
+		return (value > 0) - (value < 0);
+	}
+
+	CM_PURE inline bool isZeroing(const Board& board, const Move m) noexcept {
+		return board[m.getTo()] != Piece::NONE || m.getMoveType() == MoveType::ENPASSANT || board[m.getFrom()].getType() == PieceType::PAWN;
+	}
+
+	CM_PURE inline bool isCapture(const Board& board, const Move m) noexcept {
+		return board[m.getTo()] != Piece::NONE || m.getMoveType() == MoveType::ENPASSANT;
+	}
+
+	bool hasLegalMoves(const Board& board) {
+		MoveList moves;
+		board.generateMoves(moves);
+		return std::any_of(moves.begin(), moves.end(), [&board](const Move m) { return board.isLegal(m); });
+	}
+
+	// The part of the table with the position, and the index of the position in it
+	// Returns the null part if the DTZ of the position is kept for the other side to move
+	const PairsData* findPosition(const SyzygyTable& table, const bool isDTZ, const Board& board, u64& index, u32& side, u32& file) {
+		i32 squares[Syzygy::MAX_PIECES] { };
+		u8 pieces[Syzygy::MAX_PIECES] { };
+		u32 size = 0;
+		u32 leadPawnsCount = 0;
+		BitBoard leadPawns = BitBoard::EMPTY;
+		file = 0;
+
+		// The tables are kept for the stronger side being White, and the symmetric ones for White to move
+		const bool isFlipped = (table.isSymmetric() && board.side() == Color::BLACK) || computeMaterialKey(board, false) != table.key;
+		const u8 flipColor = isFlipped ? 8 : 0;
+		const i32 flipSquares = isFlipped ? 56 : 0;
+		side = u32(isFlipped) ^ u32(board.side() == Color::BLACK);
+
+		// The table is split by the file of the leading pawn: the one nearest the edge, and then the lowest one
+		if (table.hasPawns) {
+			const u8 pawn = u8((isDTZ ? table.dtz[0] : table.wdl[0][0]).pieces[0] ^ flipColor);
+			leadPawns = board.byPiece(Piece(pawn & 8 ? Color::BLACK : Color::WHITE, PieceType::PAWN));
+
+			BitBoard pawns = leadPawns;
+			BB_FOR_EACH(sq, pawns) {
+				squares[size++] = i32(sq) ^ flipSquares;
+			}
+
+			leadPawnsCount = size;
+			std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCount, comparePawns));
+			file = std::min(squares[0] & 7, 7 - (squares[0] & 7));
+		}
+
+		const PairsData& d = isDTZ ? table.dtz[file] : table.wdl[table.isSymmetric() ? 0 : side][file];
+		if (isDTZ && (d.flags & STM_FLAG) != side && !(table.isSymmetric() && !table.hasPawns)) {
+			return nullptr;
+		}
+
+		BitBoard others = board.allPieces().b_xor(leadPawns);
+		BB_FOR_EACH(sq, others) {
+			squares[size] = i32(sq) ^ flipSquares;
+			pieces[size++] = u8(getPieceCode(board[sq]) ^ flipColor);
+		}
+
+		// The pieces are put in the order of the table
+		for (u32 i = leadPawnsCount; i + 1 < size; i++) {
+			for (u32 j = i + 1; j < size; j++) {
+				if (d.pieces[i] == pieces[j]) {
+					std::swap(pieces[i], pieces[j]);
+					std::swap(squares[i], squares[j]);
+					break;
+				}
+			}
+		}
+
+		// The leading piece is moved to the files A-D
+		if ((squares[0] & 7) > File::D) {
+			for (u32 i = 0; i < size; i++) {
+				squares[i] ^= 7;
+			}
+		}
+
+		if (table.hasPawns) {
+			index = g_leadPawnIndex[leadPawnsCount][squares[0]];
+			std::stable_sort(squares + 1, squares + leadPawnsCount, comparePawns);
+			for (u32 i = 1; i < leadPawnsCount; i++) {
+				index += g_binomial[i][g_mapPawns[squares[i]]];
+			}
+		} else {
+			// Then to the ranks 1-4, and then below the A1-H8 diagonal, unless it is on the diagonal,
+			// then the first piece of the leading group that is not on it is moved below it
+			if ((squares[0] >> 3) > Rank::R4) {
+				for (u32 i = 0; i < size; i++) {
+					squares[i] ^= 56;
+				}
+			}
+
+			for (u32 i = 0; i < d.groupLengths[0]; i++) {
+				if (!offDiagonal(squares[i])) {
+					continue;
+				}
+
+				if (offDiagonal(squares[i]) > 0) {
+					for (u32 j = i; j < size; j++) {
+						squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+					}
+				}
+
+				break;
+			}
+
+			if (table.hasUniquePieces) {
+				const i32 adjust1 = squares[1] > squares[0];
+				const i32 adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+				if (offDiagonal(squares[0])) {
+					index = (g_mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+				} else if (offDiagonal(squares[1])) {
+					index = (6 * 63 + (squares[0] >> 3) * 28 + g_mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+				} else if (offDiagonal(squares[2])) {
+					index = 6 * 63 * 62 + 4 * 28 * 62 + (squares[0] >> 3) * 7 * 28 + ((squares[1] >> 3) - adjust1) * 28 + g_mapB1H1H7[squares[2]];
+				} else {
+					index = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + (squares[0] >> 3) * 7 * 6 + ((squares[1] >> 3) - adjust1) * 6 + ((squares[2] >> 3) - adjust2);
+				}
+			} else {
+				index = g_mapKK[g_mapA1D1D4[squares[0]]][squares[1]];
+			}
+		}
+
+		// The other groups are the combinations of their squares, the squares of the previous groups left out
+		index *= d.groupFactors[0];
+		i32* groupSquares = squares + d.groupLengths[0];
+		bool hasRemainingPawns = table.hasPawns && table.pawnsCount[1];
+		for (u32 next = 1; d.groupLengths[next]; next++) {
+			std::stable_sort(groupSquares, groupSquares + d.groupLengths[next]);
+
+			u64 combination = 0;
+			for (u32 i = 0; i < d.groupLengths[next]; i++) {
+				const auto adjust = std::count_if(squares, groupSquares, [sq = groupSquares[i]](const i32 other) { return sq > other; });
+				combination += g_binomial[i + 1][groupSquares[i] - adjust - 8 * hasRemainingPawns];
+			}
+
+			hasRemainingPawns = false;
+			index += combination * d.groupFactors[next];
+			groupSquares += d.groupLengths[next];
+		}
+
+		return &d;
+	}
+
+	i32 decompressPairs(const PairsData& d, const u64 index) {
+		if (d.flags & SINGLE_VALUE_FLAG) {
+			return d.minSymbolLength;
+		}
+
+		// The sparse index entry k is the block and the offset of the value k * span + span / 2
+		const u64 k = index / d.span;
+		u32 block = readLittleEndian<u32>(d.sparseIndex + 6 * k);
+		i64 offset = readLittleEndian<u16>(d.sparseIndex + 6 * k + 4);
+		offset += i64(index % d.span) - i64(d.span / 2);
+
+		// Every block has its length plus one values
+		while (offset < 0) {
+			offset += readLittleEndian<u16>(d.blockLengths + 2 * --block) + 1;
+		}
+
+		while (offset > readLittleEndian<u16>(d.blockLengths + 2 * block)) {
+			offset -= readLittleEndian<u16>(d.blockLengths + 2 * block++) + 1;
+		}
+
+		// Going through the codes of the block up to the symbol with the value
+		const u8* ptr = d.data + block * d.blockSize;
+		u64 buffer = readBigEndian<u64>(ptr);
+		ptr += 8;
+		i32 bufferSize = 64;
+		u16 symbol;
+		while (true) {
+			u32 length = 0;
+			while (buffer < d.base[length]) {
+				length++;
+			}
+
+			symbol = u16((buffer - d.base[length]) >> (64 - length - d.minSymbolLength));
+			symbol = u16(symbol + readLittleEndian<u16>(d.lowestSymbols + 2 * length));
+			if (offset < d.symbolLengths[symbol] + 1) {
+				break;
+			}
+
+			offset -= d.symbolLengths[symbol] + 1;
+			length += d.minSymbolLength;
+			buffer <<= length;
+			bufferSize -= length;
+
+			if (bufferSize <= 32) {
+				bufferSize += 32;
+				buffer |= u64(readBigEndian<u32>(ptr)) << (64 - bufferSize);
+				ptr += 4;
+			}
+		}
+
+		// The pairs are expanded down to the value
+		while (d.symbolLengths[symbol]) {
+			const u16 left = d.getLeft(symbol);
+			if (offset < d.symbolLengths[left] + 1) {
+				symbol = left;
+			} else {
+				offset -= d.symbolLengths[left] + 1;
+				symbol = d.getRight(symbol);
+			}
+		}
+
+		return d.getLeft(symbol);
+	}
+
+	// The DTZ in plies, from its value in the table
+	i32 mapDTZ(const SyzygyTable& table, const u32 file, i32 value, const WDL wdl) {
+		constexpr u32 WDL_MAP[] = { 1, 3, 0, 2, 0 }; // The loss, the blessed loss, -, the cursed win, the win
+		const PairsData& d = table.dtz[file];
+		if (d.flags & MAPPED_FLAG) {
+			const u32 i = d.mapIndices[WDL_MAP[i32(wdl) + 2]] + value;
+			value = d.flags & WIDE_FLAG ? readLittleEndian<u16>(table.dtzMap + 2 * i) : table.dtzMap[i];
+		}
+
+		if ((wdl == WDL::WIN && !(d.flags & WIN_PLIES_FLAG)) || (wdl == WDL::LOSS && !(d.flags & LOSS_PLIES_FLAG))
+			|| wdl == WDL::CURSED_WIN || wdl == WDL::BLESSED_LOSS) {
+			value *= 2;
+		}
+
+		return value + 1;
+	}
+
+	ProbeState probeTable(const Board& board, const bool isDTZ, const WDL wdl, i32& value) {
+		if (board.allPieces().popcnt() == 2) { // The lone kings
+			value = 0;
+			return ProbeState::OK;
+		}
+
+		const auto it = g_syzygyByKey.find(computeMaterialKey(board, false));
+		if (it == g_syzygyByKey.end() || (isDTZ && !it->second->hasDTZ)) {
+			return ProbeState::FAIL;
+		}
+
+		u64 index;
+		u32 side, file;
+		const PairsData* d = findPosition(*it->second, isDTZ, board, index, side, file);
+		if (!d) {
+			return ProbeState::CHANGE_STM;
+		}
+
+		const i32 stored = decompressPairs(*d, index);
+		value = isDTZ ? mapDTZ(*it->second, file, stored, wdl) : stored - 2;
+		return ProbeState::OK;
+	}
+
+	// The WDL of the position with its captures (and its pawn moves for the DTZ) searched:
+	// the positions where en passant is possible are not in the tables, and the DTZ is not kept when a capture is the best
+	template<bool IsZeroingChecked>
+	WDL searchZeroing(Board& board, ProbeState& state) {
+		WDL best = WDL::LOSS;
+		u32 legalCount = 0;
+		u32 searchedCount = 0;
+
+		MoveList moves;
+		board.generateMoves(moves);
+		for (Move m : moves) {
+			if (!board.isLegal(m)) {
+				continue;
+			}
+
+			legalCount++;
+			if (IsZeroingChecked ? !isZeroing(board, m) : !isCapture(board, m)) {
+				continue;
+			}
+
+			searchedCount++;
+			board.makeMove(m);
+			const WDL value = WDL(-i32(searchZeroing<false>(board, state)));
+			board.unmakeMove(m);
+
+			if (state == ProbeState::FAIL) {
+				return WDL::DRAW;
+			}
+
+			if (value > best) {
+				best = value;
+				if (value >= WDL::WIN) {
+					state = ProbeState::ZEROING_BEST_MOVE;
+					return value;
+				}
+			}
+		}
+
+		// The table is not probed if all the moves were searched, the values of the positions with en passant are not kept
+		const bool isAllSearched = searchedCount && searchedCount == legalCount;
+		WDL value = best;
+		if (!isAllSearched) {
+			i32 stored;
+			state = probeTable(board, false, WDL::DRAW, stored);
+			if (state == ProbeState::FAIL) {
+				return WDL::DRAW;
+			}
+
+			value = WDL(stored);
+		}
+
+		if (best >= value) {
+			state = best > WDL::DRAW || isAllSearched ? ProbeState::ZEROING_BEST_MOVE : ProbeState::OK;
+			return best;
+		}
+
+		state = ProbeState::OK;
+		return value;
+	}
+
+	// The DTZ of the position before the zeroing move of the given result
+	CM_PURE constexpr i32 getDTZBeforeZeroing(const WDL wdl) noexcept {
+		switch (wdl) {
+			case WDL::WIN: return 1;
+			case WDL::CURSED_WIN: return 101;
+			case WDL::BLESSED_LOSS: return -101;
+			case WDL::LOSS: return -1;
+		default: return 0;
+		}
+	}
+
+	i32 probeDTZ(Board& board, ProbeState& state) {
+		state = ProbeState::OK;
+		const WDL wdl = searchZeroing<true>(board, state);
+		if (state == ProbeState::FAIL || wdl == WDL::DRAW) { // The draws are not kept
+			return 0;
+		} else if (state == ProbeState::ZEROING_BEST_MOVE) {
+			return getDTZBeforeZeroing(wdl);
+		}
+
+		i32 dtz;
+		state = probeTable(board, true, wdl, dtz);
+		if (state == ProbeState::FAIL) {
+			return 0;
+		} else if (state != ProbeState::CHANGE_STM) {
+			return (dtz + 100 * (wdl == WDL::BLESSED_LOSS || wdl == WDL::CURSED_WIN)) * sign(i32(wdl));
+		}
+
+		// The DTZ is kept for the other side, so it is the best of the moves
+		i32 minDTZ = 0xffff;
+		MoveList moves;
+		board.generateMoves(moves);
+		for (Move m : moves) {
+			if (!board.isLegal(m)) {
+				continue;
+			}
+
+			const bool isMoveZeroing = isZeroing(board, m);
+			board.makeMove(m);
+
+			// The zeroing moves are counted by the result after them, the other moves by the DTZ after them
+			i32 moveDTZ = isMoveZeroing ? -getDTZBeforeZeroing(searchZeroing<false>(board, state)) : -probeDTZ(board, state);
+			if (moveDTZ == 1 && board.isInCheck() && !hasLegalMoves(board)) { // Mate
+				minDTZ = 1;
+			}
+
+			if (!isMoveZeroing) {
+				moveDTZ += sign(moveDTZ);
+			}
+
+			if (moveDTZ < minDTZ && sign(moveDTZ) == sign(i32(wdl))) {
+				minDTZ = moveDTZ;
+			}
+
+			board.unmakeMove(m);
+			if (state == ProbeState::FAIL) {
+				return 0;
+			}
+		}
+
+		return minDTZ == 0xffff ? -1 : minDTZ; // Mated
+	}
+
+	CM_PURE inline bool isProbed(const Board& board) noexcept {
+		return !Castle::hasAnyCastleRight(board.castleRight()) && board.allPieces().popcnt() <= Syzygy::getProbeLimit();
+	}
+
+
+	///  OPENING  ///
+
+	u32 Syzygy::open(const std::string& paths) {
+		close();
+		initIndexing();
+
+#ifdef _WIN32
+		constexpr char SEPARATOR = ';';
+#else
+		constexpr char SEPARATOR = ':';
+#endif // _WIN32
+
+		for (size_t begin = 0; begin <= paths.size(); ) {
+			size_t end = paths.find(SEPARATOR, begin);
+			end = end == std::string::npos ? paths.size() : end;
+			const std::filesystem::path directory(paths.substr(begin, end - begin));
+			begin = end + 1;
+
+			std::error_code error;
+			for (const auto& fileEntry : std::filesystem::directory_iterator(directory, error)) {
+				if (fileEntry.path().extension() != WDL_EXTENSION) {
+					continue;
+				}
+
+				auto table = std::make_unique<SyzygyTable>();
+				std::vector<u8> codes;
+				if (!parseName(fileEntry.path().stem().string(), *table, codes) || g_syzygyByKey.count(table->key)) {
+					continue;
+				}
+
+				if (!mapFile(fileEntry.path(), table->wdlFile) || !parseTable(*table, false)) {
+					closeTable(*table);
+					continue;
+				}
+
+				// The DTZ is optional, only the root needs it
+				std::filesystem::path dtzPath = fileEntry.path();
+				dtzPath.replace_extension(DTZ_EXTENSION);
+				table->hasDTZ = mapFile(dtzPath, table->dtzFile) && parseTable(*table, true);
+				if (!table->hasDTZ) {
+					unmapFile(table->dtzFile);
+				}
+
+				g_syzygyByKey[table->key] = table.get();
+				g_syzygyByKey[table->flippedKey] = table.get();
+				s_maxPieces = std::max(s_maxPieces, table->piecesCount);
+				g_syzygyTables.push_back(std::move(table));
+			}
+		}
+
+		return u32(g_syzygyTables.size());
+	}
+
+	void Syzygy::close() {
+		for (auto& table : g_syzygyTables) {
+			closeTable(*table);
+		}
+
+		g_syzygyTables.clear();
+		g_syzygyByKey.clear();
+		s_maxPieces = 0;
+	}
+
+	void Syzygy::setProbeLimit(const u32 limit) noexcept {
+		s_probeLimit = std::min(limit, MAX_PIECES);
+	}
+
+	bool Syzygy::probeWDL(Board& board, WDL& wdl) {
+		if (!isProbed(board)) {
+			return false;
+		}
+
+		ProbeState state = ProbeState::OK;
+		wdl = searchZeroing<false>(board, state);
+		return state != ProbeState::FAIL;
+	}
+
+	bool Syzygy::probeDTZ(Board& board, i32& dtz) {
+		if (!isProbed(board)) {
+			return false;
+		}
+
+		ProbeState state;
+		dtz = engine::probeDTZ(board, state);
+		return state != ProbeState::FAIL;
+	}
+
+	bool Syzygy::rankRootMoves(Board& board, std::vector<Move>& moves) {
+		if (!isProbed(board)) {
+			return false;
+		}
+
+		const i32 fiftyRule = board.fiftyRule();
+		const bool isRepeated = board.repetitionDraw(1); // The root occurred before
+
+		std::vector<std::pair<Move, i32>> ranked;
+		MoveList legalMoves;
+		board.generateMoves(legalMoves);
+		for (Move m : legalMoves) {
+			if (!board.isLegal(m)) {
+				continue;
+			}
+
+			// The DTZ counted from the root
+			ProbeState state = ProbeState::OK;
+			i32 dtz;
+			board.makeMove(m);
+			if (board.fiftyRule() == 0) {
+				dtz = getDTZBeforeZeroing(WDL(-i32(searchZeroing<false>(board, state))));
+			} else if (board.fiftyRuleDraw() || board.repetitionDraw(1)) {
+				dtz = 0;
+			} else {
+				dtz = -engine::probeDTZ(board, state);
+				dtz += sign(dtz);
+			}
+
+			if (dtz == 2 && board.isInCheck() && !hasLegalMoves(board)) { // Mate
+				dtz = 1;
+			}
+
+			board.unmakeMove(m);
+			if (state == ProbeState::FAIL) {
+				return false;
+			}
+
+			// The wins within the fifty moves rule are equal, the losses beyond it are equal, the rest are by the DTZ
+			const i32 rank = dtz > 0 ? (dtz + fiftyRule <= 99 && !isRepeated ? MAX_DTZ : MAX_DTZ - (dtz + fiftyRule))
+				: dtz < 0 ? (-dtz * 2 + fiftyRule < 100 ? -MAX_DTZ : -MAX_DTZ + (-dtz + fiftyRule))
+				: 0;
+			ranked.emplace_back(m, rank);
+		}
+
+		if (ranked.empty()) {
+			return false;
+		}
+
+		const i32 bestRank = std::max_element(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) { return a.second < b.second; })->second;
+		moves.clear();
+		for (const auto& [m, rank] : ranked) {
+			if (rank == bestRank) {
+				moves.push_back(m);
+			}
+		}
+
+		return true;
+	}
+
+
+	///  WRITING  ///
+
+	// The recursive pairing and the canonical Huffman codes of the values of a part
+	void compressPart(std::vector<u16>& values, const u8 flags, std::vector<u8>& sizes, std::vector<u8>& sparseIndex,
+			std::vector<u8>& blockLengths, std::vector<u8>& blocks) {
+		constexpr u32 BLOCK_SIZE_LOG = 6;
+		constexpr u32 SPAN_LOG = 10;
+		constexpr u32 MAX_BLOCK_VALUES = 1 << 15;
+		constexpr u32 PAIRING_PASSES = 8;
+
+		if (std::all_of(values.begin(), values.end(), [&values](const u16 value) { return value == values[0]; })) {
+			sizes.push_back(u8(flags | SINGLE_VALUE_FLAG));
+			sizes.push_back(u8(values[0]));
+			return;
+		}
+
+		// The leaves are the values, then the most frequent pair of the symbols is replaced by a new symbol in every pass
+		std::vector<std::pair<u16, u16>> symbols; // The halves, or the value and LEAF_SYMBOL
+		std::vector<u32> expansions; // The values of every symbol
+		std::unordered_map<u16, u16> leaves;
+		std::vector<u16> sequence;
+		sequence.reserve(values.size());
+		for (const u16 value : values) {
+			const auto [it, isInserted] = leaves.emplace(value, u16(symbols.size()));
+			if (isInserted) {
+				symbols.emplace_back(value, LEAF_SYMBOL);
+				expansions.push_back(1);
+			}
+
+			sequence.push_back(it->second);
+		}
+
+		for (u32 pass = 0; pass < PAIRING_PASSES; pass++) {
+			std::unordered_map<u32, u32> pairCounts;
+			for (size_t i = 0; i + 1 < sequence.size(); i++) {
+				pairCounts[(u32(sequence[i]) << 12) | sequence[i + 1]]++;
+			}
+
+			const auto best = std::max_element(pairCounts.begin(), pairCounts.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+			if (best == pairCounts.end() || best->second < 16) {
+				break;
+			}
+
+			const u16 left = u16(best->first >> 12);
+			const u16 right = u16(best->first & 0xfff);
+			const u16 pair = u16(symbols.size());
+			symbols.emplace_back(left, right);
+			expansions.push_back(expansions[left] + expansions[right]);
+
+			size_t j = 0;
+			for (size_t i = 0; i < sequence.size(); i++) {
+				if (i + 1 < sequence.size() && sequence[i] == left && sequence[i + 1] == right) {
+					sequence[j++] = pair;
+					i++;
+				} else {
+					sequence[j++] = sequence[i];
+				}
+			}
+
+			sequence.resize(j);
+		}
+
+		// The Huffman code lengths of the symbols used
+		std::vector<u64> frequencies(symbols.size());
+		for (const u16 symbol : sequence) {
+			frequencies[symbol]++;
+		}
+
+		std::vector<u32> lengths(symbols.size());
+		{
+			using Node = std::pair<u64, std::vector<u16>>; // The frequency and the symbols below
+			auto greater = [](const Node& a, const Node& b) { return a.first > b.first; };
+			std::priority_queue<Node, std::vector<Node>, decltype(greater)> queue(greater);
+			for (u16 symbol = 0; symbol < symbols.size(); symbol++) {
+				if (frequencies[symbol]) {
+					queue.push(Node { frequencies[symbol], { symbol } });
+				}
+			}
+
+			if (queue.size() == 1) {
+				lengths[queue.top().second[0]] = 1;
+			}
+
+			while (queue.size() > 1) {
+				Node a = queue.top();
+				queue.pop();
+				Node b = queue.top();
+				queue.pop();
+
+				for (const u16 symbol : a.second) {
+					lengths[symbol]++;
+				}
+
+				for (const u16 symbol : b.second) {
+					lengths[symbol]++;
+				}
+
+				a.second.insert(a.second.end(), b.second.begin(), b.second.end());
+				queue.push(Node { a.first + b.first, std::move(a.second) });
+			}
+		}
+
+		// The longer codes get the lower symbols, the unused symbols are the last
+		std::vector<u16> order(symbols.size());
+		for (u16 symbol = 0; symbol < symbols.size(); symbol++) {
+			order[symbol] = symbol;
+		}
+
+		std::stable_sort(order.begin(), order.end(), [&lengths](const u16 a, const u16 b) {
+			return lengths[a] > lengths[b];
+		});
+
+		std::vector<u16> renamed(symbols.size());
+		for (u16 i = 0; i < order.size(); i++) {
+			renamed[order[i]] = i;
+		}
+
+		u32 minLength = UINT32_MAX, maxLength = 0;
+		for (const u32 length : lengths) {
+			if (length) {
+				minLength = std::min(minLength, length);
+				maxLength = std::max(maxLength, length);
+			}
+		}
+
+		// The codes of every length are consecutive, starting at half of the first code after the longer ones
+		std::vector<u32> lengthCounts(maxLength + 2);
+		for (const u32 length : lengths) {
+			lengthCounts[length]++;
+		}
+
+		std::vector<u64> firstCodes(maxLength + 2);
+		std::vector<u16> lowestSymbols(maxLength + 2);
+		for (u32 length = maxLength - 1; length >= minLength; length--) {
+			firstCodes[length] = (firstCodes[length + 1] + lengthCounts[length + 1]) / 2;
+			lowestSymbols[length] = u16(lowestSymbols[length + 1] + lengthCounts[length + 1]);
+		}
+
+		std::vector<u64> codes(symbols.size());
+		for (u16 symbol = 0; symbol < symbols.size(); symbol++) {
+			if (lengths[symbol]) {
+				codes[symbol] = firstCodes[lengths[symbol]] + renamed[symbol] - lowestSymbols[lengths[symbol]];
+			}
+		}
+
+		// The blocks are filled with the whole symbols, the first bit is the highest one
+		std::vector<u32> blockValues;
+		std::vector<u8> block;
+		u64 bitsCount = 0;
+		u32 valuesCount = 0;
+		auto closeBlock = [&]() {
+			block.resize(size_t(1) << BLOCK_SIZE_LOG);
+			blocks.insert(blocks.end(), block.begin(), block.end());
+			blockValues.push_back(valuesCount);
+			block.clear();
+			bitsCount = 0;
+			valuesCount = 0;
+		};
+
+		for (const u16 symbol : sequence) {
+			const u32 length = lengths[symbol];
+			if (bitsCount + length > (u64(8) << BLOCK_SIZE_LOG) || valuesCount + expansions[symbol] > MAX_BLOCK_VALUES) {
+				closeBlock();
+			}
+
+			for (u32 bit = 0; bit < length; bit++, bitsCount++) {
+				if (bitsCount % 8 == 0) {
+					block.push_back(0);
+				}
+
+				if ((codes[symbol] >> (length - 1 - bit)) & 1) {
+					block.back() |= u8(0x80 >> (bitsCount % 8));
+				}
+			}
+
+			valuesCount += expansions[symbol];
+		}
+
+		closeBlock();
+
+		// The sparse index points to the middle of every span
+		std::vector<u64> blockStarts;
+		u64 start = 0;
+		for (const u32 count : blockValues) {
+			blockStarts.push_back(start);
+			start += count;
+		}
+
+		const u64 span = u64(1) << SPAN_LOG;
+		for (u64 k = 0; k * span < values.size(); k++) {
+			const u64 middle = k * span + span / 2;
+			const u32 block = u32(std::upper_bound(blockStarts.begin(), blockStarts.end(), middle) - blockStarts.begin() - 1);
+			writeLittleEndian<u32>(sparseIndex, block);
+			writeLittleEndian<u16>(sparseIndex, u16(middle - blockStarts[block]));
+		}
+
+		for (const u32 count : blockValues) {
+			writeLittleEndian<u16>(blockLengths, u16(count - 1));
+		}
+
+		sizes.push_back(flags);
+		sizes.push_back(u8(BLOCK_SIZE_LOG));
+		sizes.push_back(u8(SPAN_LOG));
+		sizes.push_back(0); // No padding of the block lengths
+		writeLittleEndian<u32>(sizes, u32(blockValues.size()));
+		sizes.push_back(u8(maxLength));
+		sizes.push_back(u8(minLength));
+		for (u32 length = minLength; length <= maxLength; length++) {
+			writeLittleEndian<u16>(sizes, lowestSymbols[length]);
+		}
+
+		writeLittleEndian<u16>(sizes, u16(symbols.size()));
+		for (const u16 symbol : order) {
+			const auto [left, right] = symbols[symbol];
+			const u16 l = right == LEAF_SYMBOL ? left : renamed[left];
+			const u16 r = right == LEAF_SYMBOL ? LEAF_SYMBOL : renamed[right];
+			sizes.push_back(u8(l & 0xff));
+			sizes.push_back(u8((l >> 8) | ((r & 0xf) << 4)));
+			sizes.push_back(u8(r >> 4));
+		}
+
+		if (symbols.size() & 1) {
+			sizes.push_back(0);
+		}
+	}
+
+	bool Syzygy::write(const std::string& directory, const std::string& name,
+			const std::function<void(const Board& board, WDL& wdl, i32& dtz)>& value) {
+		initIndexing();
+
+		SyzygyTable table;
+		std::vector<u8> codes;
+		if (!parseName(name, table, codes)) {
+			return false;
+		}
+
+		// The order of the pieces: the leading pawns, the other pawns, or the kings and a unique piece,
+		// and then the same pieces together
+		const u8 leadPawn = table.pawnsCount[0] == std::count(codes.begin(), codes.end(), u8(1)) ? 1 : 9;
+		std::stable_sort(codes.begin(), codes.end(), [leadPawn, &table](const u8 a, const u8 b) {
+			auto priority = [leadPawn, &table](const u8 code) {
+				if (table.hasPawns) {
+					return code == leadPawn ? 0 : (code & 7) == 1 ? 1 : 2;
+				}
+
+				return (code & 7) == 6 ? 0 : 2;
+			};
+
+			return priority(a) != priority(b) ? priority(a) < priority(b) : a < b;
+		});
+
+		if (!table.hasPawns && table.hasUniquePieces) {
+			const auto unique = std::find_if(codes.begin() + 2, codes.end(), [&codes](const u8 code) {
+				return std::count(codes.begin(), codes.end(), code) == 1;
+			});
+
+			std::rotate(codes.begin() + 2, unique, unique + 1);
+		}
+
+		const bool hasBothPawns = table.hasPawns && table.pawnsCount[1];
+		const u32 files = table.hasPawns ? 4 : 1;
+		const u8 order[2] = { 0, u8(hasBothPawns ? 1 : 0xf) };
+		for (u32 f = 0; f < files; f++) {
+			for (u32 side = 0; side < 2; side++) {
+				std::copy(codes.begin(), codes.end(), table.wdl[side][f].pieces);
+				setGroups(table, table.wdl[side][f], order, f);
+			}
+
+			std::copy(codes.begin(), codes.end(), table.dtz[f].pieces); // White to move
+			setGroups(table, table.dtz[f], order, f);
+		}
+
+		// Every legal position is put to its index, the others are left with the value of the previous index
+		constexpr u16 NO_VALUE = 0xffff;
+		std::vector<u16> wdlValues[2][4];
+		std::vector<u16> dtzValues[4];
+		for (u32 f = 0; f < files; f++) {
+			for (u32 side = 0; side < 2; side++) {
+				wdlValues[side][f].assign(table.wdl[side][f].getSize(), NO_VALUE);
+			}
+
+			dtzValues[f].assign(table.dtz[f].getSize(), NO_VALUE);
+		}
+
+		// Without pawns, the first piece is enough in the A1-D1-D4 triangle
+		std::vector<i32> squares(table.piecesCount, 0);
+		char placement[64];
+		for (const Color side : { Color::WHITE, Color::BLACK }) {
+			if (table.isSymmetric() && side == Color::BLACK) {
+				continue;
+			}
+
+			while (true) {
+				bool isValid = table.hasPawns || g_mapA1D1D4[squares[0]] < 10 && (squares[0] & 7) <= File::D && offDiagonal(squares[0]) <= 0 && squares[0] <= Square::D4;
+				memset(placement, 0, sizeof(placement));
+				for (u32 i = 0; i < table.piecesCount && isValid; i++) {
+					const bool isPawn = (codes[i] & 7) == 1;
+					isValid = !placement[squares[i]] && (!isPawn || (squares[i] >= 8 && squares[i] < 56));
+					placement[squares[i]] = "?PNBRQK??pnbrqk"[codes[i]];
+				}
+
+				if (isValid) {
+					std::string fen;
+					for (i32 rank = 7; rank >= 0; rank--) {
+						u32 empty = 0;
+						for (i32 file = 0; file < 8; file++) {
+							if (const char piece = placement[8 * rank + file]; piece) {
+								fen += (empty ? std::to_string(empty) : "") + piece;
+								empty = 0;
+							} else {
+								empty++;
+							}
+						}
+
+						fen += (empty ? std::to_string(empty) : "") + (rank ? "/" : "");
+					}
+
+					bool success;
+					const Board board = Board::fromFEN(fen + (side == Color::WHITE ? " w - - 0 1" : " b - - 0 1"), success);
+					if (success && Square::distance(board.king(Color::WHITE), board.king(Color::BLACK)) > 1
+						&& board.computeAttackersOf(board.side(), board.king(board.side().getOpposite())) == BitBoard::EMPTY) {
+						WDL wdl = WDL::DRAW;
+						i32 dtz = 0;
+						value(board, wdl, dtz);
+
+						u64 index;
+						u32 tableSide, file;
+						findPosition(table, false, board, index, tableSide, file);
+						wdlValues[tableSide][file][index] = u16(i32(wdl) + 2);
+
+						if (const PairsData* d = findPosition(table, true, board, index, tableSide, file); d && wdl != WDL::DRAW) {
+							const bool isFiftyMovesDraw = wdl == WDL::CURSED_WIN || wdl == WDL::BLESSED_LOSS;
+							dtzValues[file][index] = u16(isFiftyMovesDraw ? (std::abs(dtz) - 100 - 1) / 2 : std::abs(dtz) - 1);
+						}
+					}
+				}
+
+				u32 i = 0;
+				for (; i < table.piecesCount && ++squares[i] == 64; i++) {
+					squares[i] = 0;
+				}
+
+				if (i == table.piecesCount) {
+					break;
+				}
+			}
+		}
+
+		// The file: the pieces of every file, the sizes of every part, the sparse indices, the block lengths and the blocks
+		const u32 sides[2] = { table.isSymmetric() ? 1u : 2u, 1u };
+		for (u32 isDTZ = 0; isDTZ < 2; isDTZ++) {
+			std::vector<u8> file(isDTZ ? std::begin(DTZ_MAGIC) : std::begin(WDL_MAGIC), isDTZ ? std::end(DTZ_MAGIC) : std::end(WDL_MAGIC));
+			file.push_back(u8((table.isSymmetric() ? 0 : SPLIT_FLAG) | (table.hasPawns ? PAWNS_FLAG : 0)));
+
+			std::vector<u8> sparseIndices[2][4], blockLengths[2][4], blocks[2][4];
+			for (u32 f = 0; f < files; f++) {
+				file.push_back(u8(order[0] | (order[0] << 4)));
+				if (hasBothPawns) {
+					file.push_back(u8(order[1] | (order[1] << 4)));
+				}
+
+				for (const u8 code : codes) {
+					file.push_back(u8(code | (code << 4)));
+				}
+			}
+
+			if (file.size() & 1) {
+				file.push_back(0);
+			}
+
+			for (u32 f = 0; f < files; f++) {
+				for (u32 side = 0; side < sides[isDTZ]; side++) {
+					std::vector<u16>& values = isDTZ ? dtzValues[f] : wdlValues[side][f];
+					const auto first = std::find_if(values.begin(), values.end(), [](const u16 v) { return v != NO_VALUE; });
+					u16 previous = first != values.end() ? *first : 0;
+					for (u16& v : values) {
+						v = v == NO_VALUE ? previous : v;
+						previous = v;
+					}
+
+					const u8 flags = isDTZ ? u8(WIN_PLIES_FLAG | LOSS_PLIES_FLAG) : 0;
+					std::vector<u8> partSizes;
+					compressPart(values, flags, partSizes, sparseIndices[side][f], blockLengths[side][f], blocks[side][f]);
+					file.insert(file.end(), partSizes.begin(), partSizes.end());
+				}
+			}
+
+			if (file.size() & 1) {
+				file.push_back(0);
+			}
+
+			for (auto* section : { &sparseIndices, &blockLengths }) {
+				for (u32 f = 0; f < files; f++) {
+					for (u32 side = 0; side < sides[isDTZ]; side++) {
+						file.insert(file.end(), (*section)[side][f].begin(), (*section)[side][f].end());
+					}
+				}
+			}
+
+			for (u32 f = 0; f < files; f++) {
+				for (u32 side = 0; side < sides[isDTZ]; side++) {
+					file.resize((file.size() + 0x3f) & ~size_t(0x3f));
+					file.insert(file.end(), blocks[side][f].begin(), blocks[side][f].end());
+				}
+			}
+
+			file.resize(file.size() + 8); // The last codes are read by 64 bits
+
+			std::ofstream out(std::filesystem::path(directory) / (name + (isDTZ ? DTZ_EXTENSION : WDL_EXTENSION)), std::ios::binary);
+			if (!out.write(reinterpret_cast<const char*>(file.data()), std::streamsize(file.size()))) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
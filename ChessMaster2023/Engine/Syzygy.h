@@ -0,0 +1,99 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Chess/Board.h"
+#include "Scores.h"
+
+/*
+*	Syzygy(.h/.cpp) contains the probing of the Syzygy endgame tablebases (up to 7 men).
+*
+*	Every configuration has two files: <configuration>.rtbw with the WDL of every position (a loss, a loss saved
+*	by the fifty moves rule, a draw, a win spoiled by the fifty moves rule, a win) for both sides to move,
+*	and <configuration>.rtbz with the DTZ (the plies to the next capture or pawn move of the best play) for one side only.
+*	The positions are indexed by their pieces split into groups (the leading pieces or pawns and then the pieces
+*	of the same kind together), and the values are compressed by the recursive pairing and the canonical Huffman codes
+*	in small blocks, found by a sparse index. The layout is the one of the original generator, so the published
+*	tables are read.
+*
+*	The files are memory-mapped (POSIX and Windows) when the directories are opened. The values are exact only
+*	when the fifty moves counter is reset, so the search probes the WDL right after the captures and the pawn moves,
+*	and the root keeps only the moves of the best DTZ rank. Castling is not in the tables, so the positions
+*	with the castling rights are never probed.
+*/
+
+namespace engine {
+	// The result for the side to move
+	enum class WDL : i8 {
+		LOSS = -2,
+		BLESSED_LOSS = -1, // A loss drawn by the fifty moves rule
+		DRAW = 0,
+		CURSED_WIN = 1, // A win drawn by the fifty moves rule
+		WIN = 2
+	};
+
+	class Syzygy final {
+	private:
+		static u32 s_maxPieces;
+		static u32 s_probeLimit;
+
+	public:
+		constexpr inline static u32 MAX_PIECES = 7;
+
+		// Below the mates and above any evaluation, so the search takes the shortest way to a sure win
+		constexpr inline static Value WIN_VALUE = MATE - 2 * MAX_DEPTH - 1;
+
+		// Maps the tables found in the directories (separated by ';' on Windows and ':' elsewhere),
+		// closing the previous ones, and returns the number of the configurations
+		static u32 open(const std::string& paths);
+		static void close();
+
+		// The positions with more pieces are not probed
+		static void setProbeLimit(const u32 limit) noexcept;
+
+		// The number of pieces probed: the largest table open within the limit, 0 if there are none
+		INLINE static u32 getProbeLimit() noexcept {
+			return std::min(s_maxPieces, s_probeLimit);
+		}
+
+		// Returns false if the position is not in the tables (or has the castling rights)
+		static bool probeWDL(Board& board, WDL& wdl);
+
+		// The plies to the next zeroing move, positive for a win and negative for a loss (0 for a draw),
+		// the ones drawn by the fifty moves rule are counted beyond 100
+		// Returns false if the position is not in the tables (or has the castling rights)
+		static bool probeDTZ(Board& board, i32& dtz);
+
+		// Keeps the legal moves of the best rank: all the wins that are won before the fifty moves rule are ranked equally
+		// (unless the position already repeated, then the faster ones are better), and the other moves by their DTZ
+		// Returns false if the position or any position after the moves is not in the tables
+		static bool rankRootMoves(Board& board, std::vector<Move>& moves);
+
+		// Writes the files of the configuration (like KRvK) with the given values of the positions:
+		// the WDL for both sides to move, and the DTZ for the stronger side to move
+		// The writer is a plain one (a few passes of pairing, no search for the best order of the pieces),
+		// so its files are larger than the published ones. Returns false if the files cannot be written
+		static bool write(const std::string& directory, const std::string& name,
+			const std::function<void(const Board& board, WDL& wdl, i32& dtz)>& value);
+	};
+}
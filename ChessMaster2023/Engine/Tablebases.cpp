@@ -0,0 +1,1128 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Tablebases.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace engine {
+	// The table file is a header followed by the entry of every index
+	struct TableFileHeader final {
+		char magic[8];
+		u32 version;
+		u32 reserved;
+		char material[16]; // For example, KQvKR
+		u64 entriesCount;
+	};
+
+	static_assert(sizeof(TableFileHeader) == 40);
+
+	constexpr char TABLE_FILE_MAGIC[8] = "CMTBASE";
+	constexpr char TABLE_FILE_EXTENSION[] = ".cmtb";
+	constexpr u32 TABLE_FILE_VERSION = 1;
+
+	constexpr u32 NO_PIECE = UINT32_MAX;
+	constexpr u32 MAX_NEIGHBOURS = 128;	// The moves or the unmoves of a position, 62 at most
+	constexpr u32 MAX_DISTANCE = 253;	// The plies to the mate that fit in an entry
+
+	constexpr u32 KING_TRIANGLE_SQUARES_COUNT = 10;
+	constexpr u32 KING_HALF_SQUARES_COUNT = 32;
+	constexpr u8 KING_TRIANGLE_SQUARES[KING_TRIANGLE_SQUARES_COUNT] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 }; // A1-D1-D4
+
+	// The index of the square in the triangle, or -1 if it is not there
+	constexpr auto KING_TRIANGLE_INDEX = [] {
+		std::array<i8, 64> result { };
+		result.fill(-1);
+		for (u32 i = 0; i < KING_TRIANGLE_SQUARES_COUNT; i++) {
+			result[KING_TRIANGLE_SQUARES[i]] = i8(i);
+		}
+
+		return result;
+	}();
+
+
+	///  ENTRIES  ///
+
+	constexpr u8 DRAW_ENTRY = 0;
+
+	CM_PURE constexpr u8 makeWinEntry(const u32 plies) noexcept {
+		return u8(plies);
+	}
+
+	CM_PURE constexpr u8 makeLossEntry(const u32 plies) noexcept {
+		return u8(plies + 2);
+	}
+
+	CM_PURE constexpr bool isWinEntry(const u8 entry) noexcept {
+		return entry & 1;
+	}
+
+	CM_PURE constexpr bool isLossEntry(const u8 entry) noexcept {
+		return entry != DRAW_ENTRY && !(entry & 1);
+	}
+
+	CM_PURE constexpr u32 getEntryPlies(const u8 entry) noexcept {
+		return isWinEntry(entry) ? entry : entry - 2;
+	}
+
+	// The value from the side to move, the mates are counted from the ply
+	CM_PURE constexpr Value entryToValue(const u8 entry, const Depth ply) noexcept {
+		if (isWinEntry(entry)) {
+			return Value(MATE - i32(getEntryPlies(entry)) - ply);
+		} else if (isLossEntry(entry)) {
+			return Value(-MATE + i32(getEntryPlies(entry)) + ply);
+		}
+
+		return 0;
+	}
+
+
+	///  MATERIAL AND INDEXING  ///
+
+	// The pieces of a table: the kings, then the white pieces and the black ones, the stronger ones first
+	struct Material final {
+		u32 count = 2;
+		Piece pieces[Tablebases::MAX_PIECES] = { Piece::KING_WHITE, Piece::KING_BLACK };
+		bool hasPawns = false;
+
+		u64 getEntriesCount() const noexcept {
+			return u64(hasPawns ? KING_HALF_SQUARES_COUNT : KING_TRIANGLE_SQUARES_COUNT) << (6 * (count - 1) + 1);
+		}
+
+		std::string toString() const {
+			std::string result = "K";
+			for (const Color color : { Color::WHITE, Color::BLACK }) {
+				for (u32 i = 2; i < count; i++) {
+					if (pieces[i].getColor() == color) {
+						result += char(toupper(pieces[i].getType().toChar()));
+					}
+				}
+
+				result += color == Color::WHITE ? "vK" : "";
+			}
+
+			return result;
+		}
+	};
+
+	// The kings first, then the white pieces and the black ones, the stronger ones first
+	inline u32 getPieceOrder(const Piece piece) noexcept {
+		if (piece.getType() == PieceType::KING) {
+			return piece.getColor() == Color::WHITE ? 0 : 1;
+		}
+
+		return (piece.getColor() == Color::WHITE ? 2 : 8) + (PieceType::KING - piece.getType());
+	}
+
+	inline Piece flipPiece(const Piece piece) noexcept {
+		return Piece(piece.getColor().getOpposite(), piece.getType());
+	}
+
+	// Counts the pieces other than the kings, two bits for every piece type of every color
+	u32 computeMaterialKey(const Piece* pieces, const u32 count, const bool isFlipped) noexcept {
+		u32 key = 0;
+		for (u32 i = 0; i < count; i++) {
+			const Piece piece = isFlipped ? flipPiece(pieces[i]) : pieces[i];
+			if (piece.getType() != PieceType::KING) {
+				key += 1 << (2 * (piece.getType() - PieceType::PAWN) + (piece.getColor() == Color::WHITE ? 0 : 10));
+			}
+		}
+
+		return key;
+	}
+
+	Material makeMaterial(const std::vector<Piece>& pieces) {
+		Material material;
+		for (Piece piece : pieces) {
+			material.pieces[material.count++] = piece;
+			material.hasPawns |= piece.getType() == PieceType::PAWN;
+		}
+
+		std::sort(material.pieces, material.pieces + material.count, [](const Piece a, const Piece b) { return getPieceOrder(a) < getPieceOrder(b); });
+		return material;
+	}
+
+	// Parses the name like KQvKR, returns false if it is not a table
+	bool parseMaterial(const std::string& name, Material& material) {
+		const size_t separator = name.find("vK");
+		if (name.size() < 3 || name[0] != 'K' || separator == std::string::npos || name.size() - 2 > Tablebases::MAX_PIECES) {
+			return false;
+		}
+
+		std::vector<Piece> pieces;
+		for (size_t i = 1; i < name.size(); i++) {
+			if (i == separator || i == separator + 1) {
+				continue;
+			}
+
+			if (!strchr("QRBNP", name[i])) {
+				return false;
+			}
+
+			pieces.push_back(Piece::fromFENChar(i < separator ? name[i] : char(tolower(name[i]))));
+		}
+
+		material = makeMaterial(pieces);
+		return true;
+	}
+
+	// The squares in the order of the material pieces
+	struct TablePosition final {
+		Square squares[Tablebases::MAX_PIECES];
+		Color side;
+	};
+
+	inline u64 computeIndex(const Material& material, const TablePosition& pos) noexcept {
+		const Square king = pos.squares[0];
+		u64 index = material.hasPawns ? u64(king.getRank()) * 4 + king.getFile() : u64(KING_TRIANGLE_INDEX[king]);
+		for (u32 i = 1; i < material.count; i++) {
+			index = index * 64 + pos.squares[i];
+		}
+
+		return index * 2 + (pos.side == Color::BLACK);
+	}
+
+	TablePosition decodeIndex(const Material& material, u64 index) noexcept {
+		TablePosition pos;
+		pos.side = index & 1 ? Color::BLACK : Color::WHITE;
+		index >>= 1;
+
+		for (u32 i = material.count - 1; i > 0; i--) {
+			pos.squares[i] = Square(u8(index & 63));
+			index >>= 6;
+		}
+
+		pos.squares[0] = material.hasPawns
+			? Square(File::Value(index % 4), Rank::Value(index / 4))
+			: Square(KING_TRIANGLE_SQUARES[index]);
+		return pos;
+	}
+
+	// The same pieces are next to each other in the material, and the one on the lower square goes first
+	inline void sortSamePieces(const Material& material, TablePosition& pos) noexcept {
+		for (u32 i = 2; i + 1 < material.count; i++) {
+			if (material.pieces[i] == material.pieces[i + 1] && pos.squares[i] > pos.squares[i + 1]) {
+				std::swap(pos.squares[i], pos.squares[i + 1]);
+			}
+		}
+	}
+
+	inline Square transposeSquare(const Square sq) noexcept {
+		return Square(u8(((sq & 7) << 3) | (sq >> 3)));
+	}
+
+	// Applies the symmetries moving the white king to its part of the board and returns the index
+	u64 computeCanonicalIndex(const Material& material, TablePosition pos) noexcept {
+		u8 flip = 0;
+		if (pos.squares[0].getFile() > File::D) {
+			flip ^= 0x07;
+		}
+
+		if (!material.hasPawns && pos.squares[0].getRank() > Rank::R4) {
+			flip ^= 0x38;
+		}
+
+		for (u32 i = 0; i < material.count; i++) {
+			pos.squares[i] = Square(u8(pos.squares[i] ^ flip));
+		}
+
+		const u8 kingRank = u8(pos.squares[0].getRank());
+		const u8 kingFile = u8(pos.squares[0].getFile());
+		if (!material.hasPawns && kingRank >= kingFile) {
+			TablePosition transposed = pos;
+			for (u32 i = 0; i < material.count; i++) {
+				transposed.squares[i] = transposeSquare(pos.squares[i]);
+			}
+
+			sortSamePieces(material, transposed);
+			if (kingRank > kingFile) {
+				return computeIndex(material, transposed);
+			}
+
+			// The king is on the diagonal, where both of the positions are in the triangle
+			sortSamePieces(material, pos);
+			return std::min(computeIndex(material, pos), computeIndex(material, transposed));
+		}
+
+		sortSamePieces(material, pos);
+		return computeIndex(material, pos);
+	}
+
+
+	///  MOVES  ///
+
+	// Is the square attacked by the pieces of the color? The skipped piece is the one just captured
+	bool isAttacked(const Material& material, const TablePosition& pos, const Square target, const Color by, const BitBoard occ, const u32 skipped = NO_PIECE) noexcept {
+		for (u32 i = 0; i < material.count; i++) {
+			const Piece piece = material.pieces[i];
+			if (i == skipped || piece.getColor() != by) {
+				continue;
+			}
+
+			const BitBoard attacks = piece.getType() == PieceType::PAWN
+				? BitBoard::pawnAttacks(by, pos.squares[i])
+				: BitBoard::attacksOf(piece.getType(), pos.squares[i], occ);
+
+			if (attacks.test(target)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	inline Square getKing(const TablePosition& pos, const Color color) noexcept {
+		return pos.squares[color == Color::WHITE ? 0 : 1];
+	}
+
+	BitBoard computeOccupancy(const Material& material, const TablePosition& pos) noexcept {
+		BitBoard occ;
+		for (u32 i = 0; i < material.count; i++) {
+			occ.set(pos.squares[i]);
+		}
+
+		return occ;
+	}
+
+	// The pieces are on different squares, the pawns are not on the last ranks, and the side not to move is not in check
+	bool isValid(const Material& material, const TablePosition& pos) noexcept {
+		BitBoard occ;
+		for (u32 i = 0; i < material.count; i++) {
+			const Square sq = pos.squares[i];
+			if (occ.test(sq) || (material.pieces[i].getType() == PieceType::PAWN && (sq.getRank() == Rank::R1 || sq.getRank() == Rank::R8))) {
+				return false;
+			}
+
+			occ.set(sq);
+		}
+
+		return !isAttacked(material, pos, getKing(pos, pos.side.getOpposite()), pos.side, occ);
+	}
+
+	// Calls function(next, moved, captured, promotion) for every legal move, the captured is NO_PIECE for the non-captures
+	template<typename Function>
+	void forEachMove(const Material& material, const TablePosition& pos, Function&& function) {
+		const BitBoard occ = computeOccupancy(material, pos);
+		const Color opposite = pos.side.getOpposite();
+
+		for (u32 i = 0; i < material.count; i++) {
+			const Piece piece = material.pieces[i];
+			if (piece.getColor() != pos.side) {
+				continue;
+			}
+
+			BitBoard own;
+			for (u32 j = 0; j < material.count; j++) {
+				if (material.pieces[j].getColor() == pos.side) {
+					own.set(pos.squares[j]);
+				}
+			}
+
+			const Square from = pos.squares[i];
+			const bool isPawn = piece.getType() == PieceType::PAWN;
+
+			BitBoard targets;
+			if (isPawn) {
+				const Direction up = Direction::makeRelativeDirection(pos.side, Direction::UP);
+				const Square push = from.shift(up);
+
+				targets = BitBoard::pawnAttacks(pos.side, from).b_and(occ.b_xor(own));
+				if (!occ.test(push)) {
+					targets.set(push);
+					if (Rank::makeRelativeRank(pos.side, from.getRank()) == Rank::R2 && !occ.test(push.shift(up))) {
+						targets.set(push.shift(up));
+					}
+				}
+			} else {
+				targets = BitBoard::attacksOf(piece.getType(), from, occ).b_and(own.b_not());
+			}
+
+			BB_FOR_EACH(to, targets) {
+				u32 captured = NO_PIECE;
+				for (u32 j = 0; j < material.count; j++) {
+					if (j != i && pos.squares[j] == to) {
+						captured = j;
+					}
+				}
+
+				TablePosition next = pos;
+				next.squares[i] = to;
+				next.side = opposite;
+
+				BitBoard nextOcc = occ;
+				nextOcc.clear(from);
+				nextOcc.set(to);
+				if (isAttacked(material, next, getKing(next, pos.side), opposite, nextOcc, captured)) {
+					continue;
+				}
+
+				if (isPawn && Rank::makeRelativeRank(pos.side, to.getRank()) == Rank::R8) {
+					for (const PieceType promotion : { PieceType::QUEEN, PieceType::ROOK, PieceType::BISHOP, PieceType::KNIGHT }) {
+						function(next, i, captured, promotion);
+					}
+				} else {
+					function(next, i, captured, PieceType(PieceType::NONE));
+				}
+			}
+		}
+	}
+
+	// Calls function(next, capturer) for every legal en passant capture of the pawn that has just made a double push
+	template<typename Function>
+	void forEachEnPassant(const Material& material, const TablePosition& pos, const u32 pawn, Function&& function) {
+		const Color mover = pos.side.getOpposite();
+		const Square pawnSquare = pos.squares[pawn];
+		const Square target = pawnSquare.shift(Direction::makeRelativeDirection(mover, Direction::DOWN));
+
+		for (u32 i = 0; i < material.count; i++) {
+			if (material.pieces[i] != Piece(pos.side, PieceType::PAWN) || !BitBoard::pawnAttacks(pos.side, pos.squares[i]).test(target)) {
+				continue;
+			}
+
+			TablePosition next = pos;
+			next.squares[i] = target;
+			next.side = mover;
+
+			BitBoard nextOcc = computeOccupancy(material, pos);
+			nextOcc.clear(pawnSquare);
+			nextOcc.clear(pos.squares[i]);
+			nextOcc.set(target);
+			if (!isAttacked(material, next, getKing(next, pos.side), mover, nextOcc, pawn)) {
+				function(next, i);
+			}
+		}
+	}
+
+	// Is the move a double push that can be captured en passant?
+	bool isEnPassantPossible(const Material& material, const TablePosition& previous, const TablePosition& next, const u32 moved) {
+		if (material.pieces[moved].getType() != PieceType::PAWN || std::abs(next.squares[moved].getRank() - previous.squares[moved].getRank()) != 2) {
+			return false;
+		}
+
+		bool isPossible = false;
+		forEachEnPassant(material, next, moved, [&isPossible](const TablePosition&, const u32) {
+			isPossible = true;
+		});
+
+		return isPossible;
+	}
+
+	// Calls function(previous, moved) for every legal unmove of the side not to move, the captures and the promotions are not unmade
+	template<typename Function>
+	void forEachUnmove(const Material& material, const TablePosition& pos, Function&& function) {
+		const BitBoard occ = computeOccupancy(material, pos);
+		const Color mover = pos.side.getOpposite();
+		const Square defenderKing = getKing(pos, pos.side);
+
+		for (u32 i = 0; i < material.count; i++) {
+			const Piece piece = material.pieces[i];
+			if (piece.getColor() != mover) {
+				continue;
+			}
+
+			const Square to = pos.squares[i];
+
+			BitBoard origins;
+			if (piece.getType() == PieceType::PAWN) {
+				const Direction down = Direction::makeRelativeDirection(mover, Direction::DOWN);
+				const Rank rank = Rank::makeRelativeRank(mover, to.getRank());
+				const Square back = to.shift(down);
+
+				if (rank >= Rank::R3 && !occ.test(back)) {
+					origins.set(back);
+					if (rank == Rank::R4 && !occ.test(back.shift(down))) {
+						origins.set(back.shift(down));
+					}
+				}
+			} else {
+				origins = BitBoard::attacksOf(piece.getType(), to, occ).b_and(occ.b_not());
+			}
+
+			BB_FOR_EACH(from, origins) {
+				TablePosition previous = pos;
+				previous.squares[i] = from;
+				previous.side = mover;
+
+				// The side not to move cannot be in check
+				BitBoard previousOcc = occ;
+				previousOcc.clear(to);
+				previousOcc.set(from);
+				if (!isAttacked(material, previous, defenderKing, mover, previousOcc)) {
+					function(previous, i);
+				}
+			}
+		}
+	}
+
+
+	///  MAPPED TABLES  ///
+
+	struct MappedTable final {
+		Material material;
+		const u8* entries = nullptr;
+		void* memory = nullptr;
+		size_t size = 0;
+	};
+
+	u32 Tablebases::s_maxPieces = 0;
+
+	std::unordered_map<u32, MappedTable> g_tables; // By the material key
+
+	void unmapTable(MappedTable& table) {
+#ifndef _WIN32
+		munmap(table.memory, table.size);
+#else
+		free(table.memory);
+#endif // _WIN32
+
+		table.memory = nullptr;
+	}
+
+	// Maps the table file and checks that it is complete
+	bool mapTable(const std::filesystem::path& path) {
+		MappedTable table;
+#ifndef _WIN32
+		const int file = ::open(path.string().c_str(), O_RDONLY);
+		struct stat info;
+		if (file < 0 || fstat(file, &info) != 0 || size_t(info.st_size) < sizeof(TableFileHeader)) {
+			if (file >= 0) {
+				::close(file);
+			}
+
+			return false;
+		}
+
+		table.size = size_t(info.st_size);
+		table.memory = mmap(nullptr, table.size, PROT_READ, MAP_SHARED, file, 0);
+		::close(file); // The mapping stays
+		if (table.memory == MAP_FAILED) {
+			return false;
+		}
+#else
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file || size_t(file.tellg()) < sizeof(TableFileHeader)) {
+			return false;
+		}
+
+		table.size = size_t(file.tellg());
+		table.memory = malloc(table.size);
+		file.seekg(0);
+		if (!table.memory || !file.read(static_cast<char*>(table.memory), std::streamsize(table.size))) {
+			free(table.memory);
+			return false;
+		}
+#endif // _WIN32
+
+		const TableFileHeader* header = static_cast<const TableFileHeader*>(table.memory);
+		const std::string name(header->material, strnlen(header->material, sizeof(header->material)));
+		if (memcmp(header->magic, TABLE_FILE_MAGIC, sizeof(header->magic)) != 0
+			|| header->version != TABLE_FILE_VERSION
+			|| !parseMaterial(name, table.material)
+			|| header->entriesCount != table.material.getEntriesCount()
+			|| table.size != sizeof(TableFileHeader) + header->entriesCount) {
+			unmapTable(table);
+			return false;
+		}
+
+		table.entries = reinterpret_cast<const u8*>(header + 1);
+
+		const u32 key = computeMaterialKey(table.material.pieces, table.material.count, false);
+		if (const auto it = g_tables.find(key); it != g_tables.end()) {
+			unmapTable(it->second);
+		}
+
+		g_tables[key] = table;
+		return true;
+	}
+
+	u32 computeMaxPieces() noexcept {
+		u32 result = 0;
+		for (const auto& [key, table] : g_tables) {
+			result = std::max(result, table.material.count);
+		}
+
+		return result;
+	}
+
+	std::filesystem::path getTablePath(const std::string& directory, const Material& material) {
+		return std::filesystem::path(directory) / (material.toString() + TABLE_FILE_EXTENSION);
+	}
+
+	// Returns false if there is no table for the material, the lone kings are a draw
+	bool probeEntry(const Piece* pieces, const Square* squares, const u32 count, const Color side, u8& entry) {
+		if (count == 2) {
+			entry = DRAW_ENTRY;
+			return true;
+		}
+
+		// The tables are kept for the stronger side being White only
+		bool isFlipped = false;
+		auto it = g_tables.find(computeMaterialKey(pieces, count, false));
+		if (it == g_tables.end()) {
+			isFlipped = true;
+			it = g_tables.find(computeMaterialKey(pieces, count, true));
+			if (it == g_tables.end()) {
+				return false;
+			}
+		}
+
+		u32 order[Tablebases::MAX_PIECES];
+		for (u32 i = 0; i < count; i++) {
+			order[i] = i;
+		}
+
+		std::sort(order, order + count, [pieces, isFlipped](const u32 a, const u32 b) {
+			return getPieceOrder(isFlipped ? flipPiece(pieces[a]) : pieces[a]) < getPieceOrder(isFlipped ? flipPiece(pieces[b]) : pieces[b]);
+		});
+
+		TablePosition pos;
+		pos.side = isFlipped ? side.getOpposite() : side;
+		for (u32 i = 0; i < count; i++) {
+			pos.squares[i] = isFlipped ? squares[order[i]].getOpposite() : squares[order[i]];
+		}
+
+		entry = it->second.entries[computeCanonicalIndex(it->second.material, pos)];
+		return true;
+	}
+
+	// The position after a capture or a promotion is in another table
+	bool probeConversion(const Material& material, const TablePosition& next, const u32 moved, const u32 captured, const PieceType promotion, u8& entry) {
+		Piece pieces[Tablebases::MAX_PIECES];
+		Square squares[Tablebases::MAX_PIECES];
+		u32 count = 0;
+
+		for (u32 i = 0; i < material.count; i++) {
+			if (i != captured) {
+				pieces[count] = i == moved && promotion != PieceType::NONE ? Piece(material.pieces[i].getColor(), promotion) : material.pieces[i];
+				squares[count++] = next.squares[i];
+			}
+		}
+
+		return probeEntry(pieces, squares, count, next.side, entry);
+	}
+
+	bool probeBoard(const Board& board, u8& entry) {
+		if (board.castleRight()) {
+			return false;
+		}
+
+		// En passant is considered only if it is possible
+		if (board.ep() != Square::NO_POS && BitBoard::pawnAttacks(board.side().getOpposite(), board.ep()).b_and(board.pawns(board.side())) != BitBoard::EMPTY) {
+			return false;
+		}
+
+		Piece pieces[Tablebases::MAX_PIECES];
+		Square squares[Tablebases::MAX_PIECES];
+		u32 count = 0;
+
+		BitBoard occ = board.allPieces();
+		BB_FOR_EACH(sq, occ) {
+			pieces[count] = board[sq];
+			squares[count++] = sq;
+		}
+
+		return probeEntry(pieces, squares, count, board.side(), entry);
+	}
+
+
+	///  GENERATION  ///
+
+	constexpr u8 FLAG_INVALID = 1;		// Not a legal position, or not the canonical index of its position
+	constexpr u8 FLAG_RESOLVED = 2;		// The entry is final
+	constexpr u8 FLAG_PROPAGATED = 4;	// The predecessors know about the entry
+	constexpr u8 FLAG_CANNOT_LOSE = 8;	// A capture or a promotion draws or wins
+
+	class TableGenerator final {
+	private:
+		// The position right after a double push that can be captured en passant is not the one in the table:
+		// it is a node after the entries, with the moves of the position and the captures en passant.
+		// Its only predecessor is the position the double push was made from
+		struct EnPassantNode final {
+			TablePosition pos;
+			u32 pawn;	// The pawn that has made the double push
+			u64 parent;
+		};
+
+		const Material& m_material;
+
+		std::vector<u8> m_entries;
+		std::vector<u8> m_flags;
+		std::vector<u8> m_counters;		 // The successors in the table that are not known to be won
+		std::vector<u8> m_longestLosses; // The longest loss by a capture or a promotion, in plies
+		std::vector<u32> m_levels[MAX_DISTANCE + 1]; // The indices to propagate by the plies to the mate
+
+		u64 m_entriesCount = 0;
+		std::vector<EnPassantNode> m_enPassantNodes;
+		std::unordered_multimap<u64, u64> m_enPassantByIndex; // The nodes by the index of their position
+
+	public:
+		explicit TableGenerator(const Material& material) : m_material(material) { }
+
+		const std::vector<u8>& generate() {
+			const u64 entriesCount = m_material.getEntriesCount();
+			m_entriesCount = entriesCount;
+			m_entries.assign(entriesCount, DRAW_ENTRY);
+			m_flags.assign(entriesCount, 0);
+			m_counters.assign(entriesCount, 0);
+			m_longestLosses.assign(entriesCount, 0);
+
+			for (u64 index = 0; index < entriesCount; index++) {
+				classify(index);
+			}
+
+			// Any entry goes to a later level, so the levels are complete when they are reached
+			for (u32 level = 0; level <= MAX_DISTANCE; level++) {
+				for (size_t i = 0; i < m_levels[level].size(); i++) {
+					propagate(m_levels[level][i], level);
+				}
+
+				m_levels[level] = std::vector<u32>();
+			}
+
+			// The positions left are draws
+			for (u64 index = 0; index < entriesCount; index++) {
+				if (!(m_flags[index] & FLAG_RESOLVED)) {
+					m_entries[index] = DRAW_ENTRY;
+				}
+			}
+
+			m_entries.resize(entriesCount);
+			return m_entries;
+		}
+
+	private:
+		void schedule(const u64 index, const u8 entry) {
+			const u32 plies = getEntryPlies(entry);
+			assert(plies <= MAX_DISTANCE);
+
+			m_entries[index] = entry;
+			m_levels[std::min(plies, MAX_DISTANCE)].push_back(u32(index));
+		}
+
+		// Counts the moves within the table and resolves the mates, the stalemates and the captures or the promotions
+		void classify(const u64 index) {
+			const TablePosition pos = decodeIndex(m_material, index);
+			if (computeCanonicalIndex(m_material, pos) != index || !isValid(m_material, pos)) {
+				m_flags[index] = FLAG_INVALID;
+				return;
+			}
+
+			classifyMoves(index, pos, NO_PIECE);
+		}
+
+		// The node after a double push is given the pawn that can be captured en passant
+		void classifyMoves(const u64 index, const TablePosition& pos, const u32 enPassantPawn) {
+			u64 successors[MAX_NEIGHBOURS];
+			u32 successorsCount = 0;
+			u32 movesCount = 0;
+			u32 fastestWin = UINT32_MAX;
+			u32 longestLoss = 0;
+			bool isDrawAvailable = false;
+
+			const auto addConversion = [&](const u8 entry) {
+				if (isLossEntry(entry)) {
+					fastestWin = std::min(fastestWin, getEntryPlies(entry) + 1);
+				} else if (isWinEntry(entry)) {
+					longestLoss = std::max(longestLoss, getEntryPlies(entry) + 1);
+				} else {
+					isDrawAvailable = true;
+				}
+			};
+
+			forEachMove(m_material, pos, [&](const TablePosition& next, const u32 moved, const u32 captured, const PieceType promotion) {
+				movesCount++;
+				if (captured == NO_PIECE && promotion == PieceType::NONE) {
+					successors[successorsCount++] = isEnPassantPossible(m_material, pos, next, moved)
+						? addEnPassantNode(index, next, moved)
+						: computeCanonicalIndex(m_material, next);
+					return;
+				}
+
+				u8 entry = DRAW_ENTRY;
+				probeConversion(m_material, next, moved, captured, promotion, entry);
+				addConversion(entry);
+			});
+
+			if (enPassantPawn != NO_PIECE) {
+				forEachEnPassant(m_material, pos, enPassantPawn, [&](const TablePosition& next, const u32 capturer) {
+					movesCount++;
+
+					u8 entry = DRAW_ENTRY;
+					probeConversion(m_material, next, capturer, enPassantPawn, PieceType(PieceType::NONE), entry);
+					addConversion(entry);
+				});
+			}
+
+			if (movesCount == 0) {
+				m_flags[index] = FLAG_RESOLVED;
+				if (isAttacked(m_material, pos, getKing(pos, pos.side), pos.side.getOpposite(), computeOccupancy(m_material, pos))) {
+					schedule(index, makeLossEntry(0)); // Mate, otherwise it is a stalemate
+				}
+
+				return;
+			}
+
+			// A position reached by several moves is counted once, just like its predecessor is found once
+			std::sort(successors, successors + successorsCount);
+			successorsCount = u32(std::unique(successors, successors + successorsCount) - successors);
+
+			m_counters[index] = u8(successorsCount);
+			m_longestLosses[index] = u8(longestLoss);
+
+			if (fastestWin != UINT32_MAX) {
+				m_flags[index] = FLAG_CANNOT_LOSE; // A faster win may be found within the table
+				schedule(index, makeWinEntry(fastestWin));
+			} else if (isDrawAvailable) {
+				m_flags[index] = FLAG_CANNOT_LOSE;
+			} else if (successorsCount == 0) {
+				m_flags[index] = FLAG_RESOLVED;
+				schedule(index, makeLossEntry(longestLoss));
+			}
+		}
+
+		// Adds the node after the double push and classifies it, returns its index
+		u64 addEnPassantNode(const u64 parent, const TablePosition& pos, const u32 pawn) {
+			const u64 index = m_entries.size();
+			m_enPassantNodes.push_back(EnPassantNode { .pos = pos, .pawn = pawn, .parent = parent });
+			m_enPassantByIndex.emplace(computeCanonicalIndex(m_material, pos), index);
+
+			m_entries.push_back(DRAW_ENTRY);
+			m_flags.push_back(0);
+			m_counters.push_back(0);
+			m_longestLosses.push_back(0);
+
+			classifyMoves(index, pos, pawn);
+			return index;
+		}
+
+		// Resolves the predecessors of the position from its entry
+		void propagate(const u64 index, const u32 level) {
+			if (m_flags[index] & FLAG_PROPAGATED) {
+				return; // A faster win was already propagated
+			}
+
+			m_flags[index] |= FLAG_RESOLVED | FLAG_PROPAGATED;
+			const u8 entry = m_entries[index];
+
+			if (index >= m_entriesCount) {
+				resolvePredecessor(m_enPassantNodes[index - m_entriesCount].parent, entry, level);
+				return;
+			}
+
+			// The double push that can be captured en passant leads to the node after it instead
+			const TablePosition pos = decodeIndex(m_material, index);
+			u64 predecessors[MAX_NEIGHBOURS];
+			u32 predecessorsCount = 0;
+			forEachUnmove(m_material, pos, [&](const TablePosition& previous, const u32 moved) {
+				if (!isEnPassantPossible(m_material, previous, pos, moved)) {
+					predecessors[predecessorsCount++] = computeCanonicalIndex(m_material, previous);
+				}
+			});
+
+			std::sort(predecessors, predecessors + predecessorsCount);
+			predecessorsCount = u32(std::unique(predecessors, predecessors + predecessorsCount) - predecessors);
+
+			for (u32 i = 0; i < predecessorsCount; i++) {
+				resolvePredecessor(predecessors[i], entry, level);
+
+				// The nodes after the double pushes to the predecessor have the same moves
+				if (!m_enPassantNodes.empty()) {
+					for (auto [it, end] = m_enPassantByIndex.equal_range(predecessors[i]); it != end; it++) {
+						resolvePredecessor(it->second, entry, level);
+					}
+				}
+			}
+		}
+
+		void resolvePredecessor(const u64 previous, const u8 entry, const u32 level) {
+			u8& flags = m_flags[previous];
+			if (flags & (FLAG_INVALID | FLAG_RESOLVED)) {
+				return;
+			}
+
+			if (isLossEntry(entry)) {
+				flags |= FLAG_RESOLVED;
+				schedule(previous, makeWinEntry(level + 1));
+			} else if (--m_counters[previous] == 0 && !(flags & FLAG_CANNOT_LOSE)) {
+				flags |= FLAG_RESOLVED;
+				schedule(previous, makeLossEntry(std::max(level + 1, u32(m_longestLosses[previous]))));
+			}
+		}
+	};
+
+	bool writeTable(const std::filesystem::path& path, const Material& material, const std::vector<u8>& entries) {
+		TableFileHeader header { };
+		memcpy(header.magic, TABLE_FILE_MAGIC, sizeof(header.magic));
+		header.version = TABLE_FILE_VERSION;
+		strncpy(header.material, material.toString().c_str(), sizeof(header.material) - 1);
+		header.entriesCount = entries.size();
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(entries.data()), std::streamsize(entries.size()));
+		return bool(file);
+	}
+
+	// All the 3- and 4-man configurations with the stronger side being White
+	std::vector<Material> listMaterials() {
+		constexpr PieceType TYPES[] = { PieceType::QUEEN, PieceType::ROOK, PieceType::BISHOP, PieceType::KNIGHT, PieceType::PAWN };
+
+		std::vector<Material> materials;
+		for (u32 a = 0; a < std::size(TYPES); a++) {
+			materials.push_back(makeMaterial({ Piece(Color::WHITE, TYPES[a]) }));
+			for (u32 b = a; b < std::size(TYPES); b++) {
+				materials.push_back(makeMaterial({ Piece(Color::WHITE, TYPES[a]), Piece(Color::WHITE, TYPES[b]) }));
+				materials.push_back(makeMaterial({ Piece(Color::WHITE, TYPES[a]), Piece(Color::BLACK, TYPES[b]) }));
+			}
+		}
+
+		return materials;
+	}
+
+	// Adds the keys of the material and of all the materials it is converted into by the captures and the promotions
+	void addConversionKeys(const Material& material, std::vector<u32>& keys) {
+		const u32 key = computeMaterialKey(material.pieces, material.count, false);
+		if (material.count == 2 || std::find(keys.begin(), keys.end(), key) != keys.end()) {
+			return;
+		}
+
+		keys.push_back(key);
+		keys.push_back(computeMaterialKey(material.pieces, material.count, true));
+
+		for (u32 i = 2; i < material.count; i++) {
+			std::vector<Piece> pieces(material.pieces + 2, material.pieces + material.count);
+			pieces.erase(pieces.begin() + (i - 2));
+			addConversionKeys(makeMaterial(pieces), keys);
+
+			if (material.pieces[i].getType() == PieceType::PAWN) {
+				for (const PieceType promotion : { PieceType::QUEEN, PieceType::ROOK, PieceType::BISHOP, PieceType::KNIGHT }) {
+					pieces.insert(pieces.begin() + (i - 2), Piece(material.pieces[i].getColor(), promotion));
+					addConversionKeys(makeMaterial(pieces), keys);
+					pieces.erase(pieces.begin() + (i - 2));
+				}
+			}
+		}
+	}
+
+	// The captures lead to the tables with fewer pieces and the promotions to the ones with fewer pawns
+	inline u32 getGenerationTier(const Material& material) noexcept {
+		u32 pawns = 0;
+		for (u32 i = 0; i < material.count; i++) {
+			pawns += material.pieces[i].getType() == PieceType::PAWN;
+		}
+
+		return material.count * Tablebases::MAX_PIECES + pawns;
+	}
+
+
+	///  TABLEBASES  ///
+
+	bool Tablebases::generate(const std::string& directory, const u32 threadsCount, const std::vector<std::string>& names) {
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+		open(directory);
+
+		std::vector<Material> materials = listMaterials();
+		if (!names.empty()) {
+			std::vector<u32> keys;
+			for (const std::string& name : names) {
+				Material material;
+				if (!parseMaterial(name, material)) {
+					return false;
+				}
+
+				addConversionKeys(material, keys);
+			}
+
+			std::erase_if(materials, [&keys](const Material& material) {
+				return std::find(keys.begin(), keys.end(), computeMaterialKey(material.pieces, material.count, false)) == keys.end();
+			});
+		}
+		std::stable_sort(materials.begin(), materials.end(), [](const Material& a, const Material& b) {
+			return getGenerationTier(a) < getGenerationTier(b);
+		});
+
+		for (auto tierBegin = materials.begin(); tierBegin != materials.end(); ) {
+			const auto tierEnd = std::find_if(tierBegin, materials.end(), [tierBegin](const Material& material) {
+				return getGenerationTier(material) != getGenerationTier(*tierBegin);
+			});
+
+			std::vector<const Material*> missing;
+			for (auto it = tierBegin; it != tierEnd; it++) {
+				if (!g_tables.contains(computeMaterialKey(it->pieces, it->count, false))) {
+					missing.push_back(&*it);
+				}
+			}
+
+			// The tables of a tier only probe the previous tiers, which are not changed meanwhile
+			std::atomic<u32> next = 0;
+			std::atomic_bool isFailed = false;
+			const auto work = [&]() {
+				for (u32 i; (i = next++) < missing.size(); ) {
+					auto generator = std::make_unique<TableGenerator>(*missing[i]);
+					if (!writeTable(getTablePath(directory, *missing[i]), *missing[i], generator->generate())) {
+						isFailed = true;
+					}
+				}
+			};
+
+			std::vector<std::thread> threads;
+			for (u32 i = 1; i < std::min<u32>(threadsCount, u32(missing.size())); i++) {
+				threads.emplace_back(work);
+			}
+
+			work();
+			for (std::thread& thread : threads) {
+				thread.join();
+			}
+
+			for (const Material* material : missing) {
+				if (isFailed || !mapTable(getTablePath(directory, *material))) {
+					return false;
+				}
+			}
+
+			tierBegin = tierEnd;
+			s_maxPieces = computeMaxPieces();
+		}
+
+		return true;
+	}
+
+	u32 Tablebases::open(const std::string& directory) {
+		close();
+
+		std::error_code error;
+		for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+			if (file.path().extension() == TABLE_FILE_EXTENSION) {
+				mapTable(file.path());
+			}
+		}
+
+		s_maxPieces = computeMaxPieces();
+		return u32(g_tables.size());
+	}
+
+	void Tablebases::close() {
+		for (auto& [key, table] : g_tables) {
+			unmapTable(table);
+		}
+
+		g_tables.clear();
+		s_maxPieces = 0;
+	}
+
+	bool Tablebases::probe(const Board& board, const Depth ply, Value& value) {
+		u8 entry;
+		if (!probeBoard(board, entry)) {
+			return false;
+		}
+
+		value = entryToValue(entry, ply);
+		return true;
+	}
+
+	bool Tablebases::probeRoot(Board& board, MoveList& pv, Value& value) {
+		pv.clear();
+		if (!probe(board, 0, value)) {
+			return false;
+		}
+
+		// Following the shortest win, or the longest loss, or the draw, which is shown by its first move only
+		for (Depth ply = 0; ply < MAX_DEPTH; ply++) {
+			MoveList moves;
+			board.generateMoves(moves);
+
+			Move best;
+			i32 bestValue = INT32_MIN;
+			for (Move m : moves) {
+				if (!board.isLegal(m)) {
+					continue;
+				}
+
+				board.makeMove(m);
+				u8 entry;
+				const bool isFound = probeBoard(board, entry);
+				board.unmakeMove(m);
+
+				if (!isFound) {
+					bestValue = INT32_MIN;
+					break;
+				}
+
+				if (-entryToValue(entry, 1) > bestValue) {
+					bestValue = -entryToValue(entry, 1);
+					best = m;
+				}
+			}
+
+			if (bestValue == INT32_MIN) {
+				break; // The end of the game, or a position out of the tables
+			}
+
+			pv.push(best);
+			board.makeMove(best);
+			if (bestValue == 0) {
+				break;
+			}
+		}
+
+		for (u32 i = pv.size(); i-- > 0; ) {
+			board.unmakeMove(pv[i]);
+		}
+
+		return pv.size() > 0;
+	}
+
+	u32 Tablebases::getLongestMate(const std::string& name) {
+		Material material;
+		if (!parseMaterial(name, material)) {
+			return 0;
+		}
+
+		const auto it = g_tables.find(computeMaterialKey(material.pieces, material.count, false));
+		if (it == g_tables.end()) {
+			return 0;
+		}
+
+		u32 result = 0;
+		for (u64 index = 0; index < it->second.material.getEntriesCount(); index++) {
+			if (isWinEntry(it->second.entries[index])) {
+				result = std::max(result, getEntryPlies(it->second.entries[index]));
+			}
+		}
+
+		return result;
+	}
+}
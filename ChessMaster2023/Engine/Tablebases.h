@@ -0,0 +1,80 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <string>
+
+#include "Chess/Board.h"
+#include "Scores.h"
+
+/*
+*	Tablebases(.h/.cpp) contains the endgame tablebases of all the 3- and 4-man material configurations:
+*	their generator and their probing.
+*
+*	Every configuration (KQvKR, KPvKP, ...) has a table of its own, kept in the file <configuration>.cmtb:
+*	a header followed by a byte for every position, the distance to mate (DTM) from the side to move.
+*	0 is a draw, an odd byte is a win in that many plies, and an even one is a loss in two plies less (2 is mated).
+*	The positions are indexed by the squares of the pieces and the side to move. The stronger side is always White
+*	(the positions of the other one are flipped), and the white king is moved to the A1-D1-D4 triangle by the symmetries
+*	of the board (to the files A-D with pawns), so a 4-man table takes 5 MB without pawns and 16 MB with them.
+*
+*	The tables are generated by the retrograde analysis: the mates are found first, and then the positions are resolved
+*	level by level, going back from the resolved ones by the unmoves. A position is won if any move leads to a lost one,
+*	and lost if all its moves lead to won ones. The captures and the promotions lead to the smaller tables,
+*	so the tables are generated from the smallest ones, and the tables of the same size are generated in parallel.
+*	The positions that are never resolved are draws. Neither castling nor the fifty moves rule is considered.
+*	A double push that can be captured en passant leads to a node out of the table, which has the capture among its moves,
+*	so the table has the value of the position without the en passant right.
+*
+*	The files are memory-mapped (POSIX only, elsewhere they are read into memory). The search takes their values
+*	as exact ones (the positions where en passant is possible are not probed), and the root plays the shortest win
+*	(or the longest loss) at once.
+*/
+
+namespace engine {
+	class Tablebases final {
+	private:
+		static u32 s_maxPieces;
+
+	public:
+		constexpr inline static u32 MAX_PIECES = 4;
+
+		// Generates the tables missing in the directory on the given number of threads and opens all the tables
+		// If the configurations (like KQvKR) are given, only they and the ones they are converted into are generated
+		// Returns false if a table cannot be written or a configuration is not known
+		static bool generate(const std::string& directory, const u32 threadsCount, const std::vector<std::string>& names = { });
+
+		// Maps the tables found in the directory, closing the previous ones, and returns the number of the tables
+		static u32 open(const std::string& directory);
+		static void close();
+
+		// The number of pieces in the largest table open, 0 if there are none
+		INLINE static u32 getMaxPieces() noexcept {
+			return s_maxPieces;
+		}
+
+		// Returns false if the position is not in the tables, otherwise the value is exact (with the mates counted from the ply)
+		static bool probe(const Board& board, const Depth ply, Value& value);
+
+		// The plies of the longest mate in the table of the configuration (like KQvKR), 0 if it is not open
+		static u32 getLongestMate(const std::string& name);
+
+		// Finds the line of the perfect play and its value, returns false if the position is not in the tables
+		static bool probeRoot(Board& board, MoveList& pv, Value& value);
+	};
+}
@@ -19,12 +19,19 @@
 #include "Test.h"
 
 #include <chrono>
+#include <filesystem>
+#include <thread>
 #include <tuple>
 
 #include "Utils/IO.h"
 #include "Chess/BitBoard.h"
+#include "Engine/Bitbase.h"
+#include "Engine/Book.h"
+#include "Engine/PawnHashTable.h"
 #include "Engine/Scores.h"
 #include "Engine/Search.h"
+#include "Engine/Syzygy.h"
+#include "Engine/Tablebases.h"
 
 
 ///  UTILS FOR TESTS  ///
@@ -169,18 +176,6 @@ template<> bool test<5>() {
 
 ///  BOARD TESTS  ///
 
-
-const std::string TEST_FENS[] = {
-	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
-	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
-	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
-	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
-	"r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
-	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
-	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
-};
-
-
 template<> bool test<6>() {
 	constexpr auto testName = "BoardTest(creationFromTest)";
 
@@ -261,6 +256,460 @@ template<> bool test<8>() {
 	return true;
 }
 
+template<> bool test<9>() {
+	constexpr auto testName = "BoardTest(incrementalHashTest)";
+
+	// The hash updated by a move must be the same as the hash of the position set from FEN
+	for (const auto& fen : TEST_FENS) {
+		bool success;
+		Board board = Board::fromFEN(fen, success);
+
+		MoveList moves;
+		board.generateMoves(moves);
+
+		for (Move m : moves) {
+			if (!board.isLegal(m)) {
+				continue;
+			}
+
+			board.makeMove(m);
+			const Hash incremental = board.hash();
+			const Board fromFEN = Board::fromFEN(board.toFEN(), success);
+			EXPECT_EQ(incremental, fromFEN.hash());
+
+			board.unmakeMove(m);
+		}
+	}
+
+	return true;
+}
+
+
+///  ENDGAME TESTS  ///
+
+template<> bool test<10>() {
+	constexpr auto testName = "EndgameTest(KPKBitbase)";
+
+	// The side with the pawn to move, its king, its pawn, the other king, and whether it wins
+	const std::tuple<bool, Square, Square, Square, bool> KPK_TESTS[] = {
+		{ true, Square::D6, Square::D5, Square::D8, true }, // The king on the 6th rank in front of its pawn
+		{ false, Square::D6, Square::D5, Square::D8, true },
+		{ true, Square::F6, Square::F5, Square::F8, true }, // The same on the mirrored files
+		{ false, Square::F6, Square::F5, Square::F8, true },
+		{ true, Square::E5, Square::E4, Square::E7, false }, // The opposition
+		{ false, Square::E5, Square::E4, Square::E7, true },
+		{ true, Square::G3, Square::H4, Square::H8, false }, // The rook pawn with the king in the corner
+		{ false, Square::G3, Square::H4, Square::H8, false },
+		{ true, Square::H1, Square::B6, Square::H8, true }, // The king is outside of the square of the pawn
+		{ false, Square::H1, Square::B6, Square::H8, true },
+		{ false, Square::E6, Square::E7, Square::E8, false } // Stalemate
+	};
+
+	for (const auto& [isStrongSideToMove, strongKing, strongPawn, weakKing, isWin] : KPK_TESTS) {
+		EXPECT_EQ(engine::bitbase::probeKPK(isStrongSideToMove, strongKing, strongPawn, weakKing), isWin);
+	}
+
+	return true;
+}
+
+
+// Places the pieces, given by their FEN characters, on an empty board
+std::string makePiecesFen(const std::initializer_list<std::pair<Square, char>> pieces, const Color side) {
+	char squares[64];
+	memset(squares, 0, sizeof(squares));
+	for (const auto& [sq, piece] : pieces) {
+		squares[sq] = piece;
+	}
+
+	std::string fen;
+	for (i32 rank = Rank::R8; rank >= Rank::R1; rank--) {
+		u32 empty = 0;
+		for (File file : File::iter()) {
+			if (const char c = squares[Square(file, Rank::Value(rank))]; c) {
+				fen += empty ? std::to_string(empty) + c : std::string(1, c);
+				empty = 0;
+			} else {
+				empty++;
+			}
+		}
+
+		fen += (empty ? std::to_string(empty) : "") + (rank != Rank::R1 ? "/" : "");
+	}
+
+	return fen + (side == Color::WHITE ? " w - - 0 1" : " b - - 0 1");
+}
+
+// The value from the tables, or from the moves where an en passant capture is possible, as the tables are not probed there
+bool searchTablebases(Board& board, const Depth ply, Value& value) {
+	if (engine::Tablebases::probe(board, ply, value)) {
+		return true;
+	} else if (board.ep() == Square::NO_POS) {
+		return false;
+	}
+
+	MoveList moves;
+	board.generateMoves(moves);
+
+	bool hasMoves = false;
+	value = -engine::INF;
+	for (Move m : moves) {
+		if (!board.isLegal(m)) {
+			continue;
+		}
+
+		board.makeMove(m);
+		Value childValue;
+		const bool isFound = searchTablebases(board, ply + 1, childValue);
+		board.unmakeMove(m);
+
+		if (!isFound) {
+			return false;
+		}
+
+		hasMoves = true;
+		value = std::max(value, Value(-childValue));
+	}
+
+	if (!hasMoves) {
+		value = board.isInCheck() ? Value(-engine::MATE + ply) : Value(0);
+	}
+
+	return true;
+}
+
+template<> bool test<11>() {
+	constexpr auto testName = "EndgameTest(tablebasesGeneration)";
+
+	const std::string directory = (std::filesystem::temp_directory_path() / "ChessMaster2023Tablebases").string();
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+
+	const bool isGenerated = engine::Tablebases::generate(directory, std::max(1u, std::thread::hardware_concurrency()),
+		{ "KBNvK", "KQvKR", "KRvKN", "KRvKB", "KPvK", "KPvKP" });
+
+	// The known longest mates, in plies
+	const std::pair<std::string, u32> LONGEST_MATES[] = {
+		{ "KQvK", 19 }, { "KRvK", 31 }, { "KBNvK", 65 }, { "KQvKR", 69 }, { "KRvKN", 79 }, { "KRvKB", 57 }
+	};
+
+	std::vector<std::pair<std::string, u32>> longestMates;
+	for (const auto& [name, plies] : LONGEST_MATES) {
+		longestMates.emplace_back(name, engine::Tablebases::getLongestMate(name));
+	}
+
+	const std::tuple<std::string, Value> TABLEBASES_TESTS[] = {
+		{ "k7/8/1K6/8/8/8/8/7R w - - 0 1", engine::MATE - 1 },
+		{ "k7/1Q6/1K6/8/8/8/8/8 b - - 0 1", -engine::MATE },
+		{ "k7/8/1Q6/8/8/8/8/7K b - - 0 1", 0 }, // Stalemate
+		{ "8/8/8/4k3/8/8/8/4K1N1 w - - 0 1", 0 }
+	};
+
+	std::vector<std::pair<std::string, Value>> values;
+	for (const auto& [fen, expected] : TABLEBASES_TESTS) {
+		bool success;
+		Board board = Board::fromFEN(fen, success);
+
+		Value value = -engine::INF;
+		engine::Tablebases::probe(board, 0, value);
+		values.emplace_back(fen, value);
+	}
+
+	// The KPvK table must agree with the bitbase in every position
+	u32 kpkMismatches = 0;
+	for (Square whiteKing : Square::iter()) {
+		for (Square blackKing : Square::iter()) {
+			for (Square whitePawn = Square::A2; whitePawn <= Square::H7; whitePawn = Square(u8(whitePawn + 1))) {
+				for (Color side : Color::iter()) {
+					if (whiteKing == blackKing || whiteKing == whitePawn || blackKing == whitePawn
+						|| BitBoard::pseudoAttacks<PieceType::KING>(whiteKing).test(blackKing)
+						|| (side == Color::WHITE && BitBoard::pawnAttacks(Color::WHITE, whitePawn).test(blackKing))) {
+						continue;
+					}
+
+					bool success;
+					Board board = Board::fromFEN(makePiecesFen({ { whiteKing, 'K' }, { whitePawn, 'P' }, { blackKing, 'k' } }, side), success);
+
+					Value value = 0;
+					if (!engine::Tablebases::probe(board, 0, value)
+						|| (side == Color::WHITE ? value > 0 : value < 0) != engine::bitbase::probeKPK(side == Color::WHITE, whiteKing, whitePawn, blackKing)) {
+						kpkMismatches++;
+					}
+				}
+			}
+		}
+	}
+
+	// A double push that can be captured en passant must be valued with the capture:
+	// the value of every position with such a move must be the best of its moves
+	u32 enPassantMismatches = 0;
+	for (Square whiteKing : Square::iter()) {
+		for (Square blackKing : Square::iter()) {
+			for (Square pushed = Square::A2; pushed <= Square::H2; pushed = Square(u8(pushed + 1))) {
+				for (const Color side : Color::iter()) {
+					for (const i32 fileShift : { -1, 1 }) {
+						if (pushed.getFile() + fileShift < File::A || pushed.getFile() + fileShift > File::H) {
+							continue;
+						}
+
+						// The pawn of the side to move is on its second rank, the enemy one is next to the square of the double push
+						const Square ourPawn = side == Color::WHITE ? pushed : pushed.getOpposite();
+						const Square theirPawn = Square(u8(ourPawn + fileShift + (side == Color::WHITE ? 16 : -16)));
+						const Square theirKing = side == Color::WHITE ? blackKing : whiteKing;
+						if (whiteKing == blackKing || BitBoard::pseudoAttacks<PieceType::KING>(whiteKing).test(blackKing)
+							|| whiteKing == ourPawn || whiteKing == theirPawn || blackKing == ourPawn || blackKing == theirPawn
+							|| BitBoard::pawnAttacks(side, ourPawn).test(theirKing)) {
+							continue;
+						}
+
+						const char ourPawnChar = side == Color::WHITE ? 'P' : 'p';
+						const char theirPawnChar = side == Color::WHITE ? 'p' : 'P';
+						bool success;
+						Board board = Board::fromFEN(makePiecesFen({ { whiteKing, 'K' }, { blackKing, 'k' },
+							{ ourPawn, ourPawnChar }, { theirPawn, theirPawnChar } }, side), success);
+
+						MoveList moves;
+						board.generateMoves(moves);
+
+						bool hasMoves = false;
+						bool isFound = true;
+						Value best = -engine::INF;
+						for (Move m : moves) {
+							if (!board.isLegal(m)) {
+								continue;
+							}
+
+							board.makeMove(m);
+							Value childValue;
+							isFound &= searchTablebases(board, 1, childValue);
+							board.unmakeMove(m);
+
+							hasMoves = true;
+							best = std::max(best, Value(-childValue));
+						}
+
+						Value value;
+						if (hasMoves && isFound && engine::Tablebases::probe(board, 0, value) && value != best) {
+							enPassantMismatches++;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	engine::Tablebases::close();
+	std::filesystem::remove_all(directory, error);
+
+	EXPECT_TRUE(isGenerated);
+	for (u32 i = 0; i < longestMates.size(); i++) {
+		EXPECT_EQ(longestMates[i].second, LONGEST_MATES[i].second);
+	}
+
+	for (u32 i = 0; i < values.size(); i++) {
+		EXPECT_EQ(values[i].second, std::get<1>(TABLEBASES_TESTS[i]));
+	}
+
+	EXPECT_EQ(kpkMismatches, u32(0));
+	EXPECT_EQ(enPassantMismatches, u32(0));
+	return true;
+}
+
+///  EVALUATION TESTS  ///
+
+template<> bool test<12>() {
+	constexpr auto testName = "EvaluationTest(pawnIslands)";
+
+	// Every island is counted once, however many pawns and doubled pawns it has
+	const std::tuple<std::string, u8, u8> ISLANDS_TESTS[] = {
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 1, 1 },
+		{ "4k3/8/8/8/8/P7/P7/4K3 w - - 0 1", 1, 0 },
+		{ "4k3/pp3ppp/8/8/8/8/P1P1P1P1/4K3 w - - 0 1", 4, 2 },
+		{ "4k3/p1p1p1pp/8/8/8/P7/PP3P1P/4K3 w - - 0 1", 3, 4 },
+		{ "4k3/8/8/2p5/2p5/2p5/8/4K3 w - - 0 1", 0, 1 }
+	};
+
+	for (const auto& [fen, white, black] : ISLANDS_TESTS) {
+		bool success;
+		Board board = Board::fromFEN(fen, success);
+
+		const engine::PawnHashEntry& entry = engine::PawnHashTable::getOrScanPHE(board);
+		EXPECT_EQ(u32(entry.islandsCount[Color::WHITE]), u32(white));
+		EXPECT_EQ(u32(entry.islandsCount[Color::BLACK]), u32(black));
+	}
+
+	return true;
+}
+
+
+///  BOOK TESTS  ///
+
+template<> bool test<13>() {
+	constexpr auto testName = "BookTest(polyglotKey)";
+
+	// The positions and the keys of the Polyglot format description,
+	// the en passant file is keyed only after 1.e4 d5 2.e5 f5 and 1.a4 b5 2.h4 b4 3.c4
+	const std::pair<std::string, Hash> KEY_TESTS[] = {
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463b96181691fc9cu },
+		{ "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823c9b50fd114196u },
+		{ "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756b94461c50fb0u },
+		{ "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662fafb965db29d4u },
+		{ "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22a48b5a8e47ff78u },
+		{ "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652a607ca3f242c1u },
+		{ "rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00fdd303c946bdd9u },
+		{ "rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3c8123ea7b067637u },
+		{ "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5c3f9b829b279560u }
+	};
+
+	for (const auto& [fen, key] : KEY_TESTS) {
+		bool success;
+		Board board = Board::fromFEN(fen, success);
+
+		EXPECT_TRUE(success);
+		EXPECT_EQ(engine::Book::computeKey(board), key);
+	}
+
+	// The same keys are reached by playing the moves
+	bool success;
+	Board board = Board::fromFEN(KEY_TESTS[0].first, success);
+	const char* MOVES[] = { "e2e4", "d7d5", "e4e5", "f7f5", "e1e2", "e8f7" };
+	for (u32 i = 0; i < std::size(MOVES); i++) {
+		const Move m = board.makeMoveFromString(MOVES[i]);
+		EXPECT_TRUE(!m.isNullMove());
+		board.makeMove(m);
+		EXPECT_EQ(engine::Book::computeKey(board), KEY_TESTS[i + 1].second);
+	}
+
+	return true;
+}
+
+
+///  SYZYGY TESTS  ///
+
+// The WDL and the DTZ of the position from the distance to mate of the tables, the ones without the zeroing moves
+void valueFromTablebases(const Board& board, engine::WDL& wdl, i32& dtz) {
+	Value value = 0;
+	engine::Tablebases::probe(board, 0, value);
+
+	wdl = value > 0 ? engine::WDL::WIN : value < 0 ? engine::WDL::LOSS : engine::WDL::DRAW;
+	dtz = value > 0 ? i32(engine::MATE - value) : value < 0 ? -std::max(1, i32(engine::MATE + value)) : 0;
+}
+
+template<> bool test<14>() {
+	constexpr auto testName = "EndgameTest(syzygy)";
+
+	// The Syzygy tables are written from the generated ones: in KRvK and KNNvK the only zeroing move is the mate,
+	// so their DTZ is the distance to mate, and KPvK keeps only the WDL
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "ChessMaster2023Tablebases";
+	const std::filesystem::path syzygyDirectory = directory / "syzygy";
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+
+	const bool isGenerated = engine::Tablebases::generate(directory.string(), std::max(1u, std::thread::hardware_concurrency()),
+		{ "KRvK", "KNNvK", "KPvK" });
+	std::filesystem::create_directories(syzygyDirectory, error);
+
+	bool isWritten = true;
+	for (const std::string name : { "KRvK", "KNvK", "KNNvK", "KPvK" }) {
+		isWritten &= engine::Syzygy::write(syzygyDirectory.string(), name, valueFromTablebases);
+	}
+
+	std::filesystem::remove(syzygyDirectory / "KPvK.rtbz", error);
+	const u32 tablesCount = engine::Syzygy::open(syzygyDirectory.string());
+	const u32 probeLimit = engine::Syzygy::getProbeLimit();
+
+	// Every legal position (of every 9th and 7th square of the knights in KNNvK) must agree with the generated tables
+	u32 positionsCount = 0;
+	u32 wdlMismatches = 0;
+	u32 dtzMismatches = 0;
+	auto check = [&](const std::initializer_list<std::pair<Square, char>> pieces, const Color side, const bool isDTZChecked) {
+		bool success;
+		Board board = Board::fromFEN(makePiecesFen(pieces, side), success);
+		if (!success || Square::distance(board.king(Color::WHITE), board.king(Color::BLACK)) <= 1
+			|| board.computeAttackersOf(side, board.king(side.getOpposite())) != BitBoard::EMPTY) {
+			return;
+		}
+
+		engine::WDL expectedWDL, wdl;
+		i32 expectedDTZ, dtz;
+		valueFromTablebases(board, expectedWDL, expectedDTZ);
+		positionsCount++;
+		if (!engine::Syzygy::probeWDL(board, wdl) || wdl != expectedWDL) {
+			wdlMismatches++;
+		}
+
+		if (isDTZChecked && (!engine::Syzygy::probeDTZ(board, dtz) || dtz != expectedDTZ)) {
+			dtzMismatches++;
+		}
+	};
+
+	for (Square whiteKing : Square::iter()) {
+		for (Square blackKing : Square::iter()) {
+			if (whiteKing == blackKing) {
+				continue;
+			}
+
+			for (Color side : Color::iter()) {
+				for (Square piece : Square::iter()) {
+					if (piece == whiteKing || piece == blackKing) {
+						continue;
+					}
+
+					check({ { whiteKing, 'K' }, { piece, 'R' }, { blackKing, 'k' } }, side, true);
+					if (piece.getRank() != Rank::R1 && piece.getRank() != Rank::R8) {
+						check({ { whiteKing, 'K' }, { piece, 'P' }, { blackKing, 'k' } }, side, false);
+					}
+				}
+
+				for (u8 knight1 = 0; knight1 < 64; knight1 += 9) {
+					for (u8 knight2 = u8(knight1 + 1); knight2 < 64; knight2 += 7) {
+						if (knight1 != whiteKing && knight1 != blackKing && knight2 != whiteKing && knight2 != blackKing) {
+							check({ { whiteKing, 'K' }, { Square(knight1), 'N' }, { Square(knight2), 'N' }, { blackKing, 'k' } }, side, true);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// The root keeps only the moves that win within the fifty moves rule, or the ones that save the game
+	const std::pair<std::string, std::vector<std::string>> ROOT_TESTS[] = {
+		{ "k7/8/1K6/8/8/8/8/7R w - - 98 1", { "h1h8" } },
+		{ "7K/8/8/8/8/8/1Rk5/8 b - - 0 1", { "c2b2" } }
+	};
+
+	std::vector<std::vector<std::string>> rootMoves;
+	for (const auto& rootTest : ROOT_TESTS) {
+		bool success;
+		Board board = Board::fromFEN(rootTest.first, success);
+
+		std::vector<Move> moves;
+		engine::Syzygy::rankRootMoves(board, moves);
+		std::vector<std::string> result;
+		for (Move m : moves) {
+			result.push_back(m.toString());
+		}
+
+		rootMoves.push_back(result);
+	}
+
+	engine::Syzygy::close();
+	engine::Tablebases::close();
+	std::filesystem::remove_all(directory, error);
+
+	EXPECT_TRUE(isGenerated);
+	EXPECT_TRUE(isWritten);
+	EXPECT_EQ(tablesCount, u32(4));
+	EXPECT_EQ(probeLimit, u32(4));
+	EXPECT_TRUE(positionsCount > 0);
+	EXPECT_EQ(wdlMismatches, u32(0));
+	EXPECT_EQ(dtzMismatches, u32(0));
+	for (u32 i = 0; i < rootMoves.size(); i++) {
+		EXPECT_TRUE(rootMoves[i] == ROOT_TESTS[i].second);
+	}
+
+	return true;
+}
+
 
 template<u32 Id>
 void runTestsSequence() {
@@ -282,5 +731,5 @@ void runTestsSequence() {
 }
 
 void runTests() {
-	runTestsSequence<8>();
+	runTestsSequence<14>();
 }
\ No newline at end of file
@@ -17,26 +17,326 @@
 */
 
 #include "TranspositionTable.h"
+#include <condition_variable>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#include "Utils/NumaUtils.h"
 
 namespace engine {
 	TableEntryCluster* TranspositionTable::s_table = nullptr;
 	uint32_t TranspositionTable::s_tableSize = 0;
-	u16 TranspositionTable::s_rootAge = 0;
+	thread_local u16 TranspositionTable::s_rootAge = 0;
+	std::string TranspositionTable::s_sharedMemoryName;
+	bool TranspositionTable::s_isShared = false;
+	mem_utils::LargeMemory TranspositionTable::s_memory;
+	u8 TranspositionTable::s_exportDepth = 0;
+
+	// Guards the table memory from being replaced while it is saved or loaded
+	std::mutex g_tableMutex;
+
+	// The autosave thread sleeps until the period passes or it is stopped
+	// It is stopped and joined on its destruction, even if the program just exits
+	std::mutex g_autosaveMutex;
+	std::condition_variable_any g_autosaveStopped;
+	std::jthread g_autosaveThread;
+
+	// The header of a saved table, the clusters follow it
+	struct TableFileHeader final {
+		char magic[8];
+		u32 version;
+		u32 clusterSize;
+		u64 clustersCount;
+		u64 checksum;
+	};
+
+	static_assert(sizeof(TableFileHeader) == sizeof(TableEntryCluster)); // So that the clusters stay aligned in a mapped file
+
+	constexpr char TABLE_FILE_MAGIC[8] = "CMHASH";
+	constexpr u32 TABLE_FILE_VERSION = 1;
+	constexpr size_t FILE_CHUNK_CLUSTERS = 1 << 16; // The table is read and written by 2 MB
+
+	u64 updateChecksum(u64 checksum, const TableEntryCluster* clusters, const size_t count) noexcept {
+		const u64* words = reinterpret_cast<const u64*>(clusters);
+		for (size_t i = 0; i < count * sizeof(TableEntryCluster) / sizeof(u64); i++) {
+			checksum = (checksum ^ words[i]) * 0x100000001b3ull;
+		}
+
+		return checksum;
+	}
 
-	void TranspositionTable::init() {
-		s_table = reinterpret_cast<TableEntryCluster*>(malloc(DEFAULT_TABLE_SIZE));
+	void TranspositionTable::init(const size_t sizeInBytes) {
+		std::lock_guard lock(g_tableMutex);
+		release();
+
+		if (!s_sharedMemoryName.empty()) {
+			if (initSharedMemory(sizeInBytes)) {
+				return;
+			}
+
+			std::cerr << "Cannot use the shared memory " << s_sharedMemoryName << ", the table is private" << std::endl;
+		}
+
+		// The memory is zeroed by the system on the first touch, so there is no need to wait for it here
+		s_memory = mem_utils::allocateLarge(sizeInBytes);
+		s_table = reinterpret_cast<TableEntryCluster*>(s_memory.data);
 		assert(s_table != nullptr);
 
-		memset(s_table, 0, DEFAULT_TABLE_SIZE);
-		s_tableSize = DEFAULT_TABLE_SIZE / sizeof(TableEntryCluster);
+		s_tableSize = uint32_t(sizeInBytes / sizeof(TableEntryCluster));
+	}
+
+	void TranspositionTable::destroy() {
+		setAutosave("", 0);
+
+		std::lock_guard lock(g_tableMutex);
+		release();
 	}
 
-	void TranspositionTable::destroy() { 
+	void TranspositionTable::release() {
 		if (s_table) {
-			free(s_table);
+#ifndef _WIN32
+			if (s_isShared) {
+				munmap(s_table, s_tableSize * sizeof(TableEntryCluster));
+			} else {
+				mem_utils::freeLarge(s_memory);
+			}
+#else
+			mem_utils::freeLarge(s_memory);
+#endif // _WIN32
+
 			s_table = nullptr;
 			s_tableSize = 0;
+			s_isShared = false;
+		}
+	}
+
+	constexpr size_t MAX_EXPORTED_ENTRIES = 16384; // The entries beyond this are dropped until the collected ones are taken
+
+	std::mutex g_exportMutex;
+	std::vector<TableEntry> g_exportedEntries;
+
+	void TranspositionTable::setExportDepth(const u8 depth) {
+		std::lock_guard lock(g_exportMutex);
+		s_exportDepth = depth;
+		g_exportedEntries.clear();
+	}
+
+	void TranspositionTable::takeExportedEntries(std::vector<TableEntry>& entries) {
+		std::lock_guard lock(g_exportMutex);
+		entries.insert(entries.end(), g_exportedEntries.begin(), g_exportedEntries.end());
+		g_exportedEntries.clear();
+	}
+
+	void TranspositionTable::exportEntry(const TableEntry& entry) {
+		std::lock_guard lock(g_exportMutex);
+		if (g_exportedEntries.size() < MAX_EXPORTED_ENTRIES) {
+			g_exportedEntries.push_back(entry);
+		}
+	}
+
+	void TranspositionTable::importEntry(const TableEntry& entry) noexcept {
+		TableEntry& mainEntry = s_table[entry.hash % s_tableSize].mainEntry;
+		if (mainEntry.type == 0 || mainEntry.age <= s_rootAge || entry.depth > mainEntry.depth) {
+			store(mainEntry, entry);
+		}
+	}
+
+	void TranspositionTable::clear() {
+		std::lock_guard lock(g_tableMutex);
+		if (s_table && !s_isShared) {
+			mem_utils::clearLarge(s_memory);
+		}
+	}
+
+	std::string TranspositionTable::describeMemory() {
+		return std::to_string(size_t(s_tableSize) * sizeof(TableEntryCluster) / (1024 * 1024)) + " MB, "
+			+ (s_isShared ? "shared memory " + s_sharedMemoryName : std::string(mem_utils::pageModeToString(s_memory.mode)))
+			+ (numa_utils::getNodesCount() > 1 && numa_utils::getAffinityMode() != numa_utils::AffinityMode::OFF
+				? ", interleaved over " + std::to_string(numa_utils::getNodesCount()) + " NUMA nodes" : "");
+	}
+
+	void TranspositionTable::setSharedMemoryName(std::string_view name) {
+		// POSIX requires the names to start with a slash
+		s_sharedMemoryName = name.empty() || name[0] == '/' ? std::string(name) : '/' + std::string(name);
+	}
+
+	bool TranspositionTable::initSharedMemory(const size_t sizeInBytes) {
+#ifndef _WIN32
+		const int fd = shm_open(s_sharedMemoryName.c_str(), O_CREAT | O_RDWR, 0600);
+		if (fd < 0) {
+			return false;
+		}
+
+		// The first process sets the size, a new segment is zero-filled
+		struct stat info;
+		size_t size = fstat(fd, &info) == 0 ? size_t(info.st_size) : 0;
+		if (size < sizeof(TableEntryCluster)) {
+			size = sizeInBytes;
+			if (ftruncate(fd, off_t(size)) != 0) {
+				close(fd);
+				return false;
+			}
+		}
+
+		void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+
+		if (memory == MAP_FAILED) {
+			return false;
+		}
+
+		numa_utils::interleave(memory, size);
+
+		s_table = reinterpret_cast<TableEntryCluster*>(memory);
+		s_tableSize = uint32_t(size / sizeof(TableEntryCluster));
+		s_isShared = true;
+		return true;
+#else
+		return false; // Not supported
+#endif // _WIN32
+	}
+
+	bool TranspositionTable::save(const std::string& fileName) {
+		std::lock_guard lock(g_tableMutex);
+		if (!s_table) {
+			return false;
+		}
+
+		// Writing to a temporary file first, so that a failure never spoils a good file
+		const std::string tempFileName = fileName + ".tmp";
+		std::ofstream out(tempFileName, std::ios::binary);
+		if (!out.is_open()) {
+			return false;
+		}
+
+		TableFileHeader header { .magic = {}, .version = TABLE_FILE_VERSION, .clusterSize = sizeof(TableEntryCluster), .clustersCount = s_tableSize, .checksum = 0 };
+		memcpy(header.magic, TABLE_FILE_MAGIC, sizeof(header.magic));
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		// The table may be written by the search meanwhile, so the checksum is computed on a copy
+		std::vector<TableEntryCluster> buffer(FILE_CHUNK_CLUSTERS);
+		u64 checksum = 0xcbf29ce484222325ull;
+		for (size_t from = 0; from < s_tableSize && out; from += FILE_CHUNK_CLUSTERS) {
+			const size_t count = std::min<size_t>(FILE_CHUNK_CLUSTERS, s_tableSize - from);
+			memcpy(buffer.data(), &s_table[from], count * sizeof(TableEntryCluster));
+
+			checksum = updateChecksum(checksum, buffer.data(), count);
+			out.write(reinterpret_cast<const char*>(buffer.data()), count * sizeof(TableEntryCluster));
+		}
+
+		header.checksum = checksum;
+		out.seekp(0);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.close();
+
+		std::error_code error;
+		if (!out || (std::filesystem::rename(tempFileName, fileName, error), error)) {
+			std::filesystem::remove(tempFileName, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool TranspositionTable::load(const std::string& fileName) {
+		std::lock_guard lock(g_tableMutex);
+		if (!s_table) {
+			return false;
+		}
+
+		std::ifstream in(fileName, std::ios::binary);
+		TableFileHeader header;
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+			|| memcmp(header.magic, TABLE_FILE_MAGIC, sizeof(header.magic)) != 0
+			|| header.version != TABLE_FILE_VERSION
+			|| header.clusterSize != sizeof(TableEntryCluster)) {
+			return false;
+		}
+
+		// The first pass only verifies the file
+		std::vector<TableEntryCluster> buffer(FILE_CHUNK_CLUSTERS);
+		u64 checksum = 0xcbf29ce484222325ull;
+		for (u64 from = 0; from < header.clustersCount; from += FILE_CHUNK_CLUSTERS) {
+			const size_t count = size_t(std::min<u64>(FILE_CHUNK_CLUSTERS, header.clustersCount - from));
+			if (!in.read(reinterpret_cast<char*>(buffer.data()), count * sizeof(TableEntryCluster))) {
+				return false;
+			}
+
+			checksum = updateChecksum(checksum, buffer.data(), count);
 		}
+
+		if (checksum != header.checksum) {
+			return false;
+		}
+
+		// The second pass fills the table
+		in.seekg(sizeof(header));
+		if (header.clustersCount != s_tableSize) {
+			if (s_isShared) {
+				mem_utils::zeroInParallel(s_table, size_t(s_tableSize) * sizeof(TableEntryCluster));
+			} else {
+				mem_utils::clearLarge(s_memory);
+			}
+		}
+
+		for (u64 from = 0; from < header.clustersCount; from += FILE_CHUNK_CLUSTERS) {
+			const size_t count = size_t(std::min<u64>(FILE_CHUNK_CLUSTERS, header.clustersCount - from));
+			if (header.clustersCount == s_tableSize) {
+				in.read(reinterpret_cast<char*>(&s_table[from]), count * sizeof(TableEntryCluster));
+				continue;
+			}
+
+			// Another size: every entry goes to the cluster of its hash, the deeper ones are kept as main
+			in.read(reinterpret_cast<char*>(buffer.data()), count * sizeof(TableEntryCluster));
+			for (size_t i = 0; i < count; i++) {
+				for (const TableEntry& entry : { buffer[i].mainEntry, buffer[i].auxEntry }) {
+					if (entry.type == 0) {
+						continue;
+					}
+
+					TableEntryCluster& cluster = s_table[entry.getHash() % s_tableSize];
+					if (cluster.mainEntry.type == 0 || entry.depth > cluster.mainEntry.depth) {
+						cluster.auxEntry = cluster.mainEntry;
+						cluster.mainEntry = entry;
+					} else {
+						cluster.auxEntry = entry;
+					}
+				}
+			}
+		}
+
+		return bool(in);
+	}
+
+	void TranspositionTable::setAutosave(const std::string& fileName, const u32 minutes) {
+		if (g_autosaveThread.joinable()) {
+			g_autosaveThread.request_stop();
+			g_autosaveThread.join();
+		}
+
+		if (!minutes || fileName.empty()) {
+			return;
+		}
+
+		g_autosaveThread = std::jthread([fileName, minutes](std::stop_token stopToken) {
+			std::unique_lock lock(g_autosaveMutex);
+			while (!g_autosaveStopped.wait_for(lock, stopToken, std::chrono::minutes(minutes), [&stopToken]() { return stopToken.stop_requested(); })) {
+				if (!save(fileName)) {
+					std::cerr << "Cannot autosave the hash to " << fileName << std::endl;
+				}
+			}
+		});
 	}
 }
@@ -17,6 +17,11 @@
 */
 
 #pragma once
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Utils/MemoryUtils.h"
 #include "Chess/Defs.h"
 #include "Scores.h"
 
@@ -25,6 +30,19 @@
 * 
 *	A transposition table is a hash table used to store search hash:
 *		the score, the best move, some data to correctly use those two.
+*
+*	The table is written without locks by all the search threads, and optionally
+*	by several processes through a named shared memory segment (POSIX only).
+*	Every entry keeps its hash XORed with its data, so an entry torn by concurrent writers
+*	does not match any position and is just ignored.
+*
+*	The table can be saved to a file and loaded back to resume a long analysis.
+*	The file is a header followed by the clusters exactly as they are in memory,
+*	protected by a checksum of the whole contents. When the table sizes differ, the entries are
+*	placed by their full hashes. A background autosave can save the table periodically.
+*
+*	For the distributed search, the deep entries can be collected as they are recorded
+*	to be sent to the other processes, which import them into their tables.
 */
 
 namespace engine {
@@ -39,7 +57,7 @@ namespace engine {
 
 	// A single record in the transposition table
 	struct TableEntry final {
-		Hash hash;	 //	8b | Used to ensure that the found position in the table is what we looked for
+		Hash hash;	 //	8b | The hash XORed with the data, used to ensure that the found position in the table is what we looked for
 		u16 move;	 //	2b | The best move (only the move data without its score)
 		Value value; // 2b | The found position value
 		u16 age;	 // 2b | The age of the entry is used to replace the old nodes that cannot be used anymore. Actually, it is the move count of the position
@@ -53,6 +71,17 @@ namespace engine {
 		CM_PURE constexpr EntryType getBoundType() const noexcept {
 			return EntryType(type & 0b110);
 		}
+
+		// All the fields but the hash as a single word
+		CM_PURE u64 getData() const noexcept {
+			u64 data;
+			memcpy(&data, &move, sizeof(data));
+			return data;
+		}
+
+		CM_PURE Hash getHash() const noexcept {
+			return hash ^ getData();
+		}
 	};
 
 	static_assert(sizeof(TableEntry) == 16);
@@ -77,27 +106,71 @@ namespace engine {
 	private:
 		static TableEntryCluster* s_table;
 		static uint32_t s_tableSize;
-		static u16 s_rootAge;
+		static thread_local u16 s_rootAge; // The table is shared between the search threads, the searched positions are not
+
+		static std::string s_sharedMemoryName; // If not empty, the table is placed in the shared memory segment with this name
+		static bool s_isShared;
+		static mem_utils::LargeMemory s_memory; // The private table memory
+
+		static u8 s_exportDepth; // The recorded entries of at least this depth are collected, 0 if none are
 
 	public:
-		static void init();
+		// Allocates the table of the given size, replacing the previous one if there was any
+		// If the shared memory segment already exists, its size is used instead of the given one
+		static void init(const size_t sizeInBytes = DEFAULT_TABLE_SIZE);
 		static void destroy();
 
+		// Forgets all the entries, a shared table is left as it is, since other processes use it
+		static void clear();
+
+		// Makes the following init() calls place the table in the named shared memory segment,
+		// so that all the processes using the same name share it. An empty name turns it off.
+		// The segment outlives the processes, so the results are kept for the next runs
+		// (on Linux, it can be removed from /dev/shm)
+		static void setSharedMemoryName(std::string_view name);
+
+		// The size and the kind of memory of the table, like "64 MB, transparent huge pages"
+		static std::string describeMemory();
+
+		// Returns false if the file cannot be written
+		static bool save(const std::string& fileName);
+
+		// Returns false if the file cannot be read or is not a correct table file, the table is not changed then
+		static bool load(const std::string& fileName);
+
+		// Saves the table in the background every given number of minutes, 0 stops it
+		// The file is replaced only after it is completely written
+		static void setAutosave(const std::string& fileName, const u32 minutes);
+
+		// Starts collecting the recorded entries of at least the given depth, 0 stops it
+		static void setExportDepth(const u8 depth);
+
+		// Moves the collected entries (with their plain hashes) to the end of the vector
+		static void takeExportedEntries(std::vector<TableEntry>& entries);
+
+		// Records an entry (with its plain hash) found by another process, unless the table has a deeper one
+		// The imported entries are not collected again
+		static void importEntry(const TableEntry& entry) noexcept;
+
 		INLINE static void setRootAge(const u16 age) {
 			s_rootAge = age;
 		}
 
-		// Looks for the record in the table
-		// Returns an entry if it was found and nullptr otherwise
-		CM_PURE static TableEntry* probe(const Hash hash) noexcept {
+		// Looks for the record in the table and copies it into the result
+		// Returns false if it was not found
+		CM_PURE static bool probe(const Hash hash, TableEntry& result) noexcept {
 			assert(s_tableSize != 0);
 
-			TableEntryCluster* entry = &s_table[hash % s_tableSize];
-			return entry->mainEntry.hash == hash
-					? &entry->mainEntry
-				: entry->auxEntry.hash == hash
-					? &entry->auxEntry
-					: nullptr;
+			const TableEntryCluster* entry = &s_table[hash % s_tableSize];
+
+			// The entries are copied before checking, since they may be rewritten meanwhile
+			result = entry->mainEntry;
+			if (result.getHash() == hash) {
+				return true;
+			}
+
+			result = entry->auxEntry;
+			return result.getHash() == hash;
 		}
 
 		// Naive Always-Replace strategy
@@ -132,10 +205,24 @@ namespace engine {
 					}
 				}
 
-				new(&mainEntry) TableEntry { .hash = hash, .move = move, .value = value, .age = age, .depth = depth, .type = type };
-			} else if (mainEntry.hash != hash) { // Otherwise, check if the auxiliary entry must be replaced
-				new(&entry->auxEntry) TableEntry { .hash = hash, .move = move, .value = value, .age = age, .depth = depth, .type = type };
+				store(mainEntry, TableEntry { .hash = hash, .move = move, .value = value, .age = age, .depth = depth, .type = type });
+
+				if (s_exportDepth && depth >= s_exportDepth) {
+					exportEntry(TableEntry { .hash = hash, .move = move, .value = value, .age = age, .depth = depth, .type = type });
+				}
+			} else if (mainEntry.getHash() != hash) { // Otherwise, check if the auxiliary entry must be replaced
+				store(entry->auxEntry, TableEntry { .hash = hash, .move = move, .value = value, .age = age, .depth = depth, .type = type });
 			}
 		}
+
+	private:
+		static bool initSharedMemory(const size_t sizeInBytes);
+		static void release();
+		static void exportEntry(const TableEntry& entry);
+
+		INLINE static void store(TableEntry& to, TableEntry entry) noexcept {
+			entry.hash ^= entry.getData();
+			to = entry;
+		}
 	};
 }
\ No newline at end of file
@@ -28,10 +28,9 @@
 #include "PawnHashTable.h"
 
 namespace engine {
-    void extractHeader(std::ifstream& pgn, std::string& initialFen, float &result) {
-        std::string line;
-
-        initialFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -"; // FEN by default
+    // Leaves the first line after the header in <line>
+    void extractHeader(std::ifstream& pgn, std::string& line, std::string& initialFen, float &result) {
+        initialFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"; // FEN by default
         while (std::getline(pgn, line) && (line[0] == '[' || line.size() < 2)) {
             if (line.starts_with("[Result")) {
                 if (line == "[Result \"1/2-1/2\"]") {
@@ -49,60 +48,46 @@ namespace engine {
     }
 
     void skipTillMoves(std::ifstream& pgn, std::string& line) {
-        while (std::getline(pgn, line) && line[0] != '1');
+        while (line[0] != '1' && std::getline(pgn, line));
     }
 
-    void extractMoves(
-        std::ifstream& pgn, 
-        std::string& line,
-        u32& movesCount,
-        const std::string& initialFen,
-        std::vector<std::string>& fens,
-        std::vector<u32>& fenMoveCounter
-    ) {
+    // Plays the moves of the game, calling the function with the board and the number of the move before every move
+    // Stops at the first comment or illegal move, returns the number of moves played
+    template<typename Function>
+    u32 playMoves(std::ifstream& pgn, std::string& line, const std::string& initialFen, const Function& function) {
         std::vector<std::string_view> moves;
         bool success;
         Board board = Board::fromFEN(initialFen, success);
 
-        fens.clear();
-        fenMoveCounter.clear();
-        movesCount = 0;
+        u32 movesCount = 0;
         if (!success) {
-            return;
+            return movesCount;
         }
 
-        bool wasQuiet = true; // Was the previous move quiet?
         do {
             moves = str_utils::split(line, ". \n\t", std::move(moves));
 
             for (auto& moveStr : moves) {
                 if (moveStr == "{") {
                     std::getline(pgn, line);
-                    return;
+                    return movesCount;
                 }
 
                 if (std::isalpha(moveStr[0])) {
                     Move m = board.makeMoveFromString(moveStr);
                     if (m.isNullMove() || !board.isLegal(m)) {
-                        return;
+                        return movesCount;
                     }
 
-                    if (!board.givesCheck(m) && board.isQuiet(m)) {
-                        if (!board.isInCheck() && wasQuiet) {
-                            fens.push_back(board.toFEN());
-                            fenMoveCounter.push_back(movesCount);
-                        }
-
-                        wasQuiet = true;
-                    } else {
-                        wasQuiet = false;
-                    }
+                    function(board, m, movesCount);
 
                     ++movesCount;
                     board.makeMove(m);
                 }
             }
         } while (std::getline(pgn, line) && line.size() > 1);
+
+        return movesCount;
     }
 
     void Tuning::extractPositions(const std::string& pgnFileName, const std::string& positionsFileName) {
@@ -116,16 +101,30 @@ namespace engine {
         std::ofstream out(positionsFileName);
         std::vector<std::string> fens;
         std::vector<u32> fenMoveCounters;
-        i32 indices[FENS_PER_GAME]; // indices of the positions chosen in the game
         std::string initialFen;
         std::string line;
         float result;
-        u32 movesCount;
 
         while (!pgn.eof() && pgn.is_open() && pgn.good()) {
-            extractHeader(pgn, initialFen, result);
+            extractHeader(pgn, line, initialFen, result);
             skipTillMoves(pgn, line);
-            extractMoves(pgn, line, movesCount, initialFen, fens, fenMoveCounters);
+
+            fens.clear();
+            fenMoveCounters.clear();
+
+            bool wasQuiet = true; // Was the previous move quiet?
+            const u32 movesCount = playMoves(pgn, line, initialFen, [&](const Board& board, const Move m, const u32 moveNumber) {
+                if (!board.givesCheck(m) && board.isQuiet(m)) {
+                    if (!board.isInCheck() && wasQuiet) {
+                        fens.push_back(board.toFEN());
+                        fenMoveCounters.push_back(moveNumber);
+                    }
+
+                    wasQuiet = true;
+                } else {
+                    wasQuiet = false;
+                }
+            });
 
             u32 step = (fens.size() <= FENS_PER_GAME) ? 1 : (fens.size() / FENS_PER_GAME);
              
@@ -136,6 +135,21 @@ namespace engine {
         }
     }
 
+    void Tuning::forEachMove(const std::string& pgnFileName, const std::function<void(const Board&, const Move, const u32, const float)>& function) {
+        std::ifstream pgn(pgnFileName);
+        std::string initialFen;
+        std::string line;
+        float result = 0.5f; // For the games without the result
+
+        while (!pgn.eof() && pgn.is_open() && pgn.good()) {
+            extractHeader(pgn, line, initialFen, result);
+            skipTillMoves(pgn, line);
+            playMoves(pgn, line, initialFen, [&function, result](const Board& board, const Move m, const u32 moveNumber) {
+                function(board, m, moveNumber, result);
+            });
+        }
+    }
+
     void Tuning::loadPositions(const std::string& fileName) {
         std::ifstream file(fileName);
         std::string line;
@@ -17,6 +17,8 @@
 */
 
 #pragma once
+#include <functional>
+
 #include "Chess/Board.h"
 
 /*
@@ -43,6 +45,10 @@ namespace engine {
 		// It works not with a true pgn, but rather with a pgn where moves were translated into long algebraic form
 		static void extractPositions(const std::string& pgnFileName, const std::string& positionsFileName = "test_suit.fen");
 
+		// Plays the games of the pgn file (in the same long algebraic form), calling the function before every move
+		// with the board, the move, the number of the move in the game, and the result of the game (1.0 is the white win)
+		static void forEachMove(const std::string& pgnFileName, const std::function<void(const Board&, const Move, const u32, const float)>& function);
+
 		// Loads an epd file with: fen, res (result)
 		void loadPositions(const std::string& fileName);
 
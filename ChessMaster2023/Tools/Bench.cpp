@@ -0,0 +1,725 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Utils/StringUtils.h"
+#include "Chess/BitBoard.h"
+#include "Chess/Board.h"
+#include "Engine/Scores.h"
+#include "Engine/Eval.h"
+#include "Engine/Options.h"
+#include "Engine/Search.h"
+#include "Engine/TranspositionTable.h"
+#include "Engine/PawnHashTable.h"
+#include "Engine/Bitbase.h"
+
+/*
+*	Bench.cpp contains the microbenchmarks of the core primitives.
+*	It is built as a separate executable with "make bench".
+*
+*	Every benchmark runs over a fixed corpus of positions. A sample is a number of
+*	passes over the corpus, calibrated so that it lasts at least MIN_SAMPLE_TIME_NS.
+*	After a warm-up sample, several samples are measured and the median, mean,
+*	standard deviation and 95% confidence interval of the time per operation are
+*	printed as CSV (or JSON lines), so that the results of two builds can be compared.
+*
+*	With --search-depth, the root search drivers (the aspiration windows and MTD(f)) are also compared:
+*	every position of the corpus is searched to the depth from an empty transposition table,
+*	and the nodes and the time to the depth are printed for every position and in total.
+*
+*	Usage: ChessMaster2023Bench.exe [--samples N] [--json] [--filter substring] [--search-depth N]
+*/
+
+using namespace engine;
+
+namespace {
+	constexpr u64 MIN_SAMPLE_TIME_NS = 20'000'000;
+	constexpr u32 TT_KEYS_COUNT = 1 << 16;
+	constexpr u32 PAWN_STRUCTURE_GAMES_COUNT = 128;
+	constexpr u32 PAWN_STRUCTURE_GAME_LENGTH = 80;
+
+	// The corpus: the test positions and some positions from real games
+	const char* const CORPUS[] = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		"r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+		"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		"r3k2r/2pb1ppp/2pp1q2/p7/1nP1B3/1P2P3/P2N1PPP/R2QK2R w KQkq a6 0 14",
+		"4rrk1/2p1b1p1/p1p3q1/4p3/2P2n1p/1P1NR2P/PB3PP1/3R1QK1 b - - 2 24",
+		"r3qbrk/6p1/2b2pPp/p3pP1Q/PpPpP2P/3P1B2/2PB3K/R5R1 w - - 16 42",
+		"6k1/1R3p2/6p1/2Bp3p/3P2q1/P7/1P2rQ1K/5R2 b - - 4 44",
+		"8/8/1p2k1p1/3p3p/1p1P1P1P/1P2PK2/8/8 w - - 3 54",
+		"7r/2p3k1/1p1p1qp1/1P1Bp3/p1P2r1P/P7/4R3/Q4RK1 w - - 0 36",
+		"r1bq1rk1/pp2b1pp/n1pp1n2/3P1p2/2P1p3/2N1P2N/PP2BPPP/R1BQ1RK1 b - - 2 10",
+		"3r3k/2r4p/1p1b3q/p4P2/P2Pp3/1B2P3/3BQ1RP/6K1 w - - 3 87",
+		"2r4r/1p4k1/1Pnp4/3Qb1pq/8/4BpPp/5P2/2RR1BK1 w - - 0 42",
+		"4q1bk/6b1/7p/p1p4p/PNPpP2P/KN4P1/3Q4/4R3 b - - 0 37",
+		"2q3r1/1r2pk2/pp3pp1/2pP3p/P1Pb1BbP/1P4Q1/R3NPP1/4R1K1 w - - 2 34",
+		"1r2r2k/1b4q1/pp5p/2pPp1p1/P3Pn2/1P1B1Q1P/2R3P1/4BR1K b - - 1 37",
+		"8/6pk/2b1Rp2/3r4/1R1B2PP/P5K1/8/2r5 b - - 16 42",
+		"1r4k1/4ppb1/2n1b1qp/pB4p1/1n1BP1P1/7P/2PNQPK1/3RN3 w - - 8 29",
+		"8/p2B4/PkP5/4p1pK/4Pb1p/5P2/8/8 w - - 29 68",
+		"3r4/ppq1ppkp/4bnp1/2pN4/2P1P3/1P4P1/PQ3PBP/R4K2 b - - 2 20",
+		"5rr1/4n2k/4q2P/P1P2n2/3B1p2/4pP2/2N1P3/1RR1K2Q w - - 1 49",
+		"1r5k/2pq2p1/3p3p/p1pP4/4QP2/PP1R3P/6PK/8 w - - 1 51",
+		"q5k1/5ppp/1r3bn1/1B6/P1N2P2/BQ2P1P1/5K1P/8 b - - 2 34"
+	};
+
+	// A position of the corpus with the precomputed move lists
+	struct BenchPosition final {
+		Board board;
+		std::vector<Move> pseudoLegal;
+		std::vector<Move> legal;
+		std::vector<Move> captures; // Legal captures and promotions
+	};
+
+	struct Statistics final {
+		double min;
+		double median;
+		double mean;
+		double stddev;
+		double ci95; // Half-width of the 95% confidence interval of the mean
+	};
+
+	volatile u64 g_sink = 0; // Prevents the benchmarked code from being optimized away
+
+	u32 g_samplesCount = 25;
+	bool g_jsonOutput = false;
+	std::string g_filter;
+	Depth g_searchDepth = 0; // The search drivers are not compared by default
+
+	std::vector<BenchPosition> g_positions;
+	std::vector<BenchPosition> g_inCheckPositions; // For CHECK_EVASIONS
+	std::vector<Hash> g_ttKeys;
+	std::vector<Board> g_pawnStructures; // Positions of random games, each pawn scan of them is forced
+
+
+	///  UTILS  ///
+
+	u64 nowNs() {
+		using namespace std::chrono;
+		return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	// SplitMix64, so that the keys are the same between the runs
+	u64 nextRandom(u64& state) {
+		u64 z = (state += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	Statistics computeStatistics(std::vector<double> samples) {
+		std::sort(samples.begin(), samples.end());
+
+		const size_t n = samples.size();
+		Statistics result { };
+		result.min = samples.front();
+		result.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+
+		for (double s : samples) {
+			result.mean += s;
+		}
+
+		result.mean /= n;
+		for (double s : samples) {
+			result.stddev += (s - result.mean) * (s - result.mean);
+		}
+
+		result.stddev = n > 1 ? std::sqrt(result.stddev / (n - 1)) : 0.0;
+		result.ci95 = 1.96 * result.stddev / std::sqrt(double(n));
+		return result;
+	}
+
+	void printHeader() {
+		if (!g_jsonOutput) {
+			std::cout << "benchmark,variant,samples,ops_per_sample,min_ns,median_ns,mean_ns,stddev_ns,ci95_ns" << std::endl;
+		}
+	}
+
+	void printResult(std::string_view name, std::string_view variant, u64 opsPerSample, const Statistics& stats) {
+		std::cout << std::fixed << std::setprecision(3);
+
+		if (g_jsonOutput) {
+			std::cout << "{\"benchmark\":\"" << name << "\",\"variant\":\"" << variant
+				<< "\",\"samples\":" << g_samplesCount
+				<< ",\"ops_per_sample\":" << opsPerSample
+				<< ",\"min_ns\":" << stats.min
+				<< ",\"median_ns\":" << stats.median
+				<< ",\"mean_ns\":" << stats.mean
+				<< ",\"stddev_ns\":" << stats.stddev
+				<< ",\"ci95_ns\":" << stats.ci95 << "}" << std::endl;
+		} else {
+			std::cout << name << ',' << variant << ','
+				<< g_samplesCount << ','
+				<< opsPerSample << ','
+				<< stats.min << ','
+				<< stats.median << ','
+				<< stats.mean << ','
+				<< stats.stddev << ','
+				<< stats.ci95 << std::endl;
+		}
+	}
+
+	// Measures <pass>, which does <opsPerPass> operations, and prints the time per operation
+	void runBenchmark(std::string_view name, std::string_view variant, u64 opsPerPass, const std::function<void()>& pass) {
+		if (!g_filter.empty() && (std::string(name) + "/" + std::string(variant)).find(g_filter) == std::string::npos) {
+			return;
+		}
+
+		if (opsPerPass == 0) {
+			return;
+		}
+
+		// Warming up and calibrating the number of passes per sample
+		u64 passesCount = 1;
+		u64 start;
+		while (true) {
+			start = nowNs();
+			for (u64 j = 0; j < passesCount; j++) {
+				pass();
+			}
+
+			if (nowNs() - start >= MIN_SAMPLE_TIME_NS) {
+				break;
+			}
+
+			passesCount *= 2;
+		}
+
+		std::vector<double> samples;
+		samples.reserve(g_samplesCount);
+		for (u32 i = 0; i < g_samplesCount; i++) {
+			start = nowNs();
+			for (u64 j = 0; j < passesCount; j++) {
+				pass();
+			}
+
+			samples.push_back(double(nowNs() - start) / double(passesCount * opsPerPass));
+		}
+
+		printResult(name, variant, passesCount * opsPerPass, computeStatistics(std::move(samples)));
+	}
+
+
+	///  CORPUS  ///
+
+	BenchPosition makeBenchPosition(Board board) {
+		BenchPosition result { .board = std::move(board) };
+		MoveList moves;
+
+		result.board.generateMoves(moves);
+		for (Move m : moves) {
+			result.pseudoLegal.push_back(m);
+			if (result.board.isLegal(m)) {
+				result.legal.push_back(m);
+
+				if (!result.board.isQuiet(m)) {
+					result.captures.push_back(m);
+				}
+			}
+		}
+
+		return result;
+	}
+
+	void loadCorpus() {
+		for (const char* fen : CORPUS) {
+			bool success;
+			Board board = Board::fromFEN(fen, success);
+			if (!success) {
+				std::cerr << "Skipping an incorrect FEN: " << fen << std::endl;
+				continue;
+			}
+
+			g_positions.push_back(makeBenchPosition(std::move(board)));
+		}
+
+		// Positions in check are made of the checking moves in the corpus
+		for (BenchPosition& pos : g_positions) {
+			for (Move m : pos.legal) {
+				if (pos.board.givesCheck(m)) {
+					pos.board.makeMove(m);
+
+					bool success;
+					g_inCheckPositions.push_back(makeBenchPosition(Board::fromFEN(pos.board.toFEN(), success)));
+
+					pos.board.unmakeMove(m);
+				}
+			}
+		}
+
+		u64 state = 0x2023;
+		for (u32 i = 0; i < TT_KEYS_COUNT; i++) {
+			g_ttKeys.push_back(nextRandom(state));
+		}
+
+		// The corpus has few distinct pawn structures, so the pawn scan is measured on the positions of random games
+		bool success;
+		for (u32 i = 0; i < PAWN_STRUCTURE_GAMES_COUNT; i++) {
+			Board board = Board::fromFEN(CORPUS[0], success);
+
+			for (u32 ply = 0; ply < PAWN_STRUCTURE_GAME_LENGTH; ply++) {
+				MoveList moves;
+				board.generateMoves(moves);
+
+				std::vector<Move> legal;
+				for (Move m : moves) {
+					if (board.isLegal(m)) {
+						legal.push_back(m);
+					}
+				}
+
+				if (legal.empty()) {
+					break;
+				}
+
+				board.makeMove(legal[nextRandom(state) % legal.size()]);
+				if (ply % 2) {
+					g_pawnStructures.push_back(Board::fromFEN(board.toFEN(), success));
+				}
+			}
+		}
+	}
+
+	u64 countMoves(const std::vector<BenchPosition>& positions, std::vector<Move> BenchPosition::*list) {
+		u64 result = 0;
+		for (const BenchPosition& pos : positions) {
+			result += (pos.*list).size();
+		}
+
+		return result;
+	}
+
+
+	///  PER-PAWN SCAN  ///
+
+	// The pawn-wise analysis that PawnHashTable::scanPawns replaced, kept as the baseline of its benchmark.
+	// The files ahead are the own file and the file to the left, as in the evaluation
+	u64 g_filesForward[Color::VALUES_COUNT][Square::VALUES_COUNT];
+
+	void initFilesForward() {
+		for (Square sq : Square::iter()) {
+			g_filesForward[Color::WHITE][sq] = BitBoard::directionBits<Direction::UP>(sq);
+			g_filesForward[Color::BLACK][sq] = BitBoard::directionBits<Direction::DOWN>(sq);
+
+			if (sq.getFile() != File::A) {
+				g_filesForward[Color::WHITE][sq] |= BitBoard::directionBits<Direction::UP>(sq.shift(Direction::LEFT));
+				g_filesForward[Color::BLACK][sq] |= BitBoard::directionBits<Direction::DOWN>(sq.shift(Direction::LEFT));
+			}
+		}
+	}
+
+	template<Color::Value Side>
+	void scanPawnsPerPawn(const Board& board, PawnHashEntry& entry) {
+		constexpr Color::Value OppositeSide = Color(Side).getOpposite().value();
+		constexpr Direction::Value Up = Direction::makeRelativeDirection(Side, Direction::UP).value();
+
+		const BitBoard pawns = board.byPiece(Piece(Side, PieceType::PAWN));
+		const BitBoard enemyPawns = board.byPiece(Piece(OppositeSide, PieceType::PAWN));
+
+		const BitBoard ourPawnAttacks = pawns.pawnAttackedSquares<Side>();
+
+		BitBoard pieces = pawns;
+		BB_FOR_EACH(sq, pieces) {
+			entry.mostAdvanced[Side][sq.getFile() + 1] = std::max(entry.mostAdvanced[Side][sq.getFile() + 1], Rank::makeRelativeRank(Side, sq.getRank()));
+
+			if (File f = sq.getFile(); f == File::H || BitBoard::fromFile(File::Value(f + 1)).b_and(pawns) == BitBoard::EMPTY) {
+				// Every island is counted once, by the lowest pawn on its last file
+				if (BitBoard::fromFile(f).b_and(pawns).lsb() == sq) {
+					entry.islandsCount[Side]++;
+				}
+			} else {
+				const BitBoard pawnsOnNextFile = BitBoard::fromFile(File::Value(f + 1)).b_and(pawns);
+				entry.distortion[Side] += std::max(0, std::abs(pawnsOnNextFile.lsb().getRank() - sq.getRank()) - 1);
+			}
+
+			if (ourPawnAttacks.test(sq)) {
+				entry.pawnEvaluation[Side] += scores::DEFENDED_PAWN[Rank::makeRelativeRank(Side, sq.getRank())];
+			}
+
+			if (BitBoard(g_filesForward[Side][sq]).b_and(enemyPawns) == BitBoard::EMPTY
+				&& BitBoard::directionBits<Up>(sq).b_and(pawns) == BitBoard::EMPTY) {
+				entry.pawnEvaluation[Side] += scores::PASSED_PAWN[Rank::makeRelativeRank(Side, sq.getRank())];
+				entry.passed.set(sq);
+			}
+
+			if (BitBoard::adjacentFiles(sq.getFile()).b_and(pawns) == BitBoard::EMPTY) {
+				entry.pawnEvaluation[Side] += scores::ISOLATED_PAWN;
+				entry.isolated.set(sq);
+			}
+
+			if (BitBoard::directionBits<Up>(sq).b_and(pawns) != BitBoard::EMPTY) {
+				entry.pawnEvaluation[Side] += scores::DOUBLE_PAWN;
+				entry.doubled.set(sq);
+			}
+
+			const Square stop = sq.shift(Up);
+			if (BitBoard(g_filesForward[OppositeSide][stop]).b_and(BitBoard::adjacentFiles(sq.getFile())).b_and(pawns) == BitBoard::EMPTY
+				&& BitBoard::pawnAttacks(Side, stop).b_and(enemyPawns)) {
+				entry.pawnEvaluation[Side] += scores::BACKWARD_PAWN;
+				entry.backward.set(sq);
+			}
+		}
+
+		entry.pawnEvaluation[Side] += scores::PAWN_ISLANDS[entry.islandsCount[Side]];
+		entry.pawnEvaluation[Side] += scores::PAWN_DISTORTION * entry.distortion[Side];
+	}
+
+	// A table of the same size and indexing as PawnHashTable's, so that the two scans pay the same for the memory
+	PawnHashEntry g_perPawnTable[1 << PawnHashTable::PAWN_HASH_TABLE_SIZE_LOG2];
+
+	PawnHashEntry& getOrScanPerPawn(const Board& board) {
+		const BitBoard wpawns = board.byPiece(Piece::PAWN_WHITE);
+		const BitBoard bpawns = board.byPiece(Piece::PAWN_BLACK);
+
+		Hash hash = (wpawns ^ bpawns) >> 8;
+		hash = (hash ^ (hash >> PawnHashTable::PAWN_HASH_TABLE_SIZE_LOG2) ^ (hash >> (PawnHashTable::PAWN_HASH_TABLE_SIZE_LOG2 * 2))
+			^ (hash >> (PawnHashTable::PAWN_HASH_TABLE_SIZE_LOG2 * 3)));
+		hash &= (1 << PawnHashTable::PAWN_HASH_TABLE_SIZE_LOG2) - 1;
+
+		PawnHashEntry& entry = g_perPawnTable[hash];
+		if (entry.pawns[Color::WHITE] == wpawns && entry.pawns[Color::BLACK] == bpawns) {
+			return entry;
+		}
+
+		memset(&entry, 0, sizeof(PawnHashEntry));
+
+		entry.pawns[Color::WHITE] = wpawns;
+		entry.pawns[Color::BLACK] = bpawns;
+
+		scanPawnsPerPawn<Color::WHITE>(board, entry);
+		scanPawnsPerPawn<Color::BLACK>(board, entry);
+
+		return entry;
+	}
+
+	///  BENCHMARKS  ///
+
+	void benchAttacks() {
+		const std::pair<PieceType::Value, const char*> PIECE_TYPES[] = {
+			{ PieceType::KNIGHT, "knight" },
+			{ PieceType::BISHOP, "bishop" },
+			{ PieceType::ROOK, "rook" },
+			{ PieceType::QUEEN, "queen" },
+			{ PieceType::KING, "king" }
+		};
+
+		for (auto [pt, ptName] : PIECE_TYPES) {
+			runBenchmark("attacksOf", ptName, g_positions.size() * Square::VALUES_COUNT, [pt]() {
+				BitBoard acc = BitBoard::EMPTY;
+				for (const BenchPosition& pos : g_positions) {
+					const BitBoard occ = pos.board.allPieces();
+					for (Square sq : Square::iter()) {
+						acc = acc.b_xor(BitBoard::attacksOf(pt, sq, occ));
+					}
+				}
+
+				g_sink = g_sink + u64(acc);
+			});
+		}
+	}
+
+	template<movegen::GenerationMode Mode>
+	void benchGeneration(const char* variant, const std::vector<BenchPosition>& positions) {
+		runBenchmark("generateMoves", variant, positions.size(), [&positions]() {
+			MoveList moves;
+			u64 acc = 0;
+			for (const BenchPosition& pos : positions) {
+				if constexpr (Mode == movegen::QUIET_CHECKS) {
+					moves.clear();
+				}
+
+				pos.board.generateMoves<Mode>(moves);
+				acc += moves.size();
+			}
+
+			g_sink = g_sink + acc;
+		});
+	}
+
+	void benchMoveGeneration() {
+		std::vector<BenchPosition> notInCheck;
+		for (const BenchPosition& pos : g_positions) {
+			if (!pos.board.isInCheck()) {
+				bool success;
+				notInCheck.push_back(makeBenchPosition(Board::fromFEN(pos.board.toFEN(), success)));
+			}
+		}
+
+		benchGeneration<movegen::ALL_MOVES>("all_moves", g_positions);
+		benchGeneration<movegen::CAPTURES>("captures", notInCheck);
+		benchGeneration<movegen::CHECK_EVASIONS>("check_evasions", g_inCheckPositions);
+		benchGeneration<movegen::QUIET_CHECKS>("quiet_checks", notInCheck);
+	}
+
+	void benchMoves() {
+		runBenchmark("makeMove+unmakeMove", "legal", countMoves(g_positions, &BenchPosition::legal), []() {
+			u64 acc = 0;
+			for (BenchPosition& pos : g_positions) {
+				for (Move m : pos.legal) {
+					pos.board.makeMove(m);
+					acc += pos.board.hash();
+					pos.board.unmakeMove(m);
+				}
+			}
+
+			g_sink = g_sink + acc;
+		});
+
+		runBenchmark("isLegal", "pseudo_legal", countMoves(g_positions, &BenchPosition::pseudoLegal), []() {
+			u64 acc = 0;
+			for (const BenchPosition& pos : g_positions) {
+				for (Move m : pos.pseudoLegal) {
+					acc += pos.board.isLegal(m);
+				}
+			}
+
+			g_sink = g_sink + acc;
+		});
+
+		runBenchmark("givesCheck", "legal", countMoves(g_positions, &BenchPosition::legal), []() {
+			u64 acc = 0;
+			for (const BenchPosition& pos : g_positions) {
+				for (Move m : pos.legal) {
+					acc += pos.board.givesCheck(m);
+				}
+			}
+
+			g_sink = g_sink + acc;
+		});
+
+		runBenchmark("SEE", "captures", countMoves(g_positions, &BenchPosition::captures), []() {
+			u64 acc = 0;
+			for (const BenchPosition& pos : g_positions) {
+				for (Move m : pos.captures) {
+					acc += pos.board.SEE(m);
+				}
+			}
+
+			g_sink = g_sink + acc;
+		});
+	}
+
+	void benchEval() {
+		runBenchmark("eval", "corpus", g_positions.size(), []() {
+			u64 acc = 0;
+			for (BenchPosition& pos : g_positions) {
+				acc += eval(pos.board);
+			}
+
+			g_sink = g_sink + acc;
+		});
+
+		runBenchmark("getOrScanPHE", "hit", g_positions.size(), []() {
+			u64 acc = 0;
+			for (BenchPosition& pos : g_positions) {
+				acc += PawnHashTable::getOrScanPHE(pos.board).islandsCount[Color::WHITE];
+			}
+
+			g_sink = g_sink + acc;
+		});
+
+		runBenchmark("getOrScanPHE", "miss", g_positions.size(), []() {
+			u64 acc = 0;
+			for (BenchPosition& pos : g_positions) {
+				PawnHashEntry& entry = PawnHashTable::getOrScanPHE(pos.board);
+				acc += entry.islandsCount[Color::WHITE];
+				entry.pawns[Color::WHITE] = BitBoard(~0ull); // Invalidating, so that the next call would miss
+			}
+
+			g_sink = g_sink + acc;
+		});
+	}
+
+	void benchPawnScan() {
+		// Both scans must give the same entries, otherwise the comparison is meaningless
+		for (Board& board : g_pawnStructures) {
+			PawnHashEntry& expected = getOrScanPerPawn(board);
+			PawnHashEntry& entry = PawnHashTable::getOrScanPHE(board);
+			if (memcmp(&entry, &expected, sizeof(PawnHashEntry))) {
+				std::cerr << "The pawn scans differ on " << board.toFEN() << std::endl;
+			}
+
+			entry.pawns[Color::WHITE] = BitBoard(~0ull);
+			expected.pawns[Color::WHITE] = BitBoard(~0ull);
+		}
+
+		runBenchmark("scanPawns", "set_wise", g_pawnStructures.size(), []() {
+			u64 acc = 0;
+			for (Board& board : g_pawnStructures) {
+				PawnHashEntry& entry = PawnHashTable::getOrScanPHE(board);
+				acc += entry.pawnEvaluation[Color::WHITE].middlegame();
+				entry.pawns[Color::WHITE] = BitBoard(~0ull); // Forcing the scan on the next call
+			}
+
+			g_sink = g_sink + acc;
+		});
+
+		runBenchmark("scanPawns", "per_pawn", g_pawnStructures.size(), []() {
+			u64 acc = 0;
+			for (const Board& board : g_pawnStructures) {
+				PawnHashEntry& entry = getOrScanPerPawn(board);
+				acc += entry.pawnEvaluation[Color::WHITE].middlegame();
+				entry.pawns[Color::WHITE] = BitBoard(~0ull);
+			}
+
+			g_sink = g_sink + acc;
+		});
+	}
+
+	void benchTranspositionTable() {
+		runBenchmark("TranspositionTable", "tryRecord", g_ttKeys.size(), []() {
+			u16 i = 0;
+			for (Hash key : g_ttKeys) {
+				TranspositionTable::tryRecord(EntryType(EntryType::EXACT | EntryType::PV), key, i, Value(i & 0xff), 1, u8(i & 0x1f), 0);
+				++i;
+			}
+		});
+
+		runBenchmark("TranspositionTable", "probe_hit", g_ttKeys.size(), []() {
+			u64 acc = 0;
+			TableEntry entry;
+			for (Hash key : g_ttKeys) {
+				acc += TranspositionTable::probe(key, entry);
+			}
+
+			g_sink = g_sink + acc;
+		});
+
+		runBenchmark("TranspositionTable", "probe_miss", g_ttKeys.size(), []() {
+			u64 acc = 0;
+			TableEntry entry;
+			for (Hash key : g_ttKeys) {
+				acc += TranspositionTable::probe(~key, entry);
+			}
+
+			g_sink = g_sink + acc;
+		});
+	}
+
+	void printSearchResult(std::string_view variant, std::string_view position, NodesCount nodes, u64 timeNs) {
+		const double milliseconds = timeNs / 1'000'000.0;
+
+		if (g_jsonOutput) {
+			std::cout << "{\"benchmark\":\"search\",\"variant\":\"" << variant
+				<< "\",\"depth\":" << g_searchDepth
+				<< ",\"position\":\"" << position
+				<< "\",\"nodes\":" << nodes
+				<< ",\"time_ms\":" << milliseconds << "}" << std::endl;
+		} else {
+			std::cout << "search," << variant << ',' << g_searchDepth << ',' << position << ',' << nodes << ',' << milliseconds << std::endl;
+		}
+	}
+
+	// The root search drivers, every search starts from an empty transposition table
+	void benchSearch() {
+		if (!g_searchDepth) {
+			return;
+		}
+
+		if (!g_jsonOutput) {
+			std::cout << "benchmark,variant,depth,position,nodes,time_ms" << std::endl;
+		}
+
+		g_reporting.checkInput = false;
+		g_reporting.onIteration = [](const IterationInfo&) { };
+
+		for (const bool isMtdf : { false, true }) {
+			const std::string_view variant = isMtdf ? "mtdf" : "aspiration";
+			if (!g_filter.empty() && ("search/" + std::string(variant)).find(g_filter) == std::string::npos) {
+				continue;
+			}
+
+			options::g_mtdfMode = isMtdf;
+
+			NodesCount totalNodes = 0;
+			u64 totalTime = 0;
+			for (size_t i = 0; i < g_positions.size(); i++) {
+				TranspositionTable::clear();
+				g_limits.makeInfinite();
+				g_limits.setDepthLimit(g_searchDepth);
+
+				const u64 start = nowNs();
+				rootSearch(g_positions[i].board);
+				const u64 time = nowNs() - start;
+
+				printSearchResult(variant, std::to_string(i), getNodesCount(), time);
+				totalNodes += getNodesCount();
+				totalTime += time;
+			}
+
+			printSearchResult(variant, "total", totalNodes, totalTime);
+		}
+
+		options::g_mtdfMode = false;
+	}
+}
+
+int main(int argc, char** argv) {
+	for (int i = 1; i < argc; i++) {
+		const std::string_view arg = argv[i];
+
+		if (arg == "--samples" && i + 1 < argc) {
+			g_samplesCount = std::max(str_utils::fromString<u32>(argv[++i]), 2u);
+		} else if (arg == "--json") {
+			g_jsonOutput = true;
+		} else if (arg == "--filter" && i + 1 < argc) {
+			g_filter = argv[++i];
+		} else if (arg == "--search-depth" && i + 1 < argc) {
+			g_searchDepth = Depth(std::min(str_utils::fromString<u32>(argv[++i]), u32(MAX_DEPTH)));
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--samples N] [--json] [--filter substring] [--search-depth N]" << std::endl;
+			return 1;
+		}
+	}
+
+	BitBoard::init();
+	scores::initScores();
+	TranspositionTable::init();
+	PawnHashTable::init();
+	bitbase::init();
+	initSearch();
+
+	loadCorpus();
+	initFilesForward();
+	printHeader();
+
+	benchAttacks();
+	benchMoveGeneration();
+	benchMoves();
+	benchEval();
+	benchPawnScan();
+	benchTranspositionTable();
+	benchSearch();
+
+	TranspositionTable::destroy();
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,1186 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Utils/StringUtils.h"
+#include "Chess/BitBoard.h"
+#include "Chess/Board.h"
+#include "Chess/Zobrist.h"
+#include "Engine/Scores.h"
+#include "Engine/Test.h"
+#include "Engine/TranspositionTable.h"
+#include "Engine/PawnHashTable.h"
+#include "Engine/Bitbase.h"
+
+/*
+*	Fuzz.cpp contains the differential fuzzer of the board.
+*	It is built as a separate executable with "make fuzz".
+*
+*	Random legal games are played from the test positions and from random positions.
+*	Every position of a game is compared against a deliberately naive reference
+*	implementation of the rules (a mailbox board with ray walks), which checks:
+*		1) The board, the bitboards, the side to move, the en passant square and the castling rights.
+*		2) The incremental hash, score and material against the ones computed from scratch.
+*		3) The check givers, the check blockers and the pinners.
+*		4) The legal moves produced by the move generator + isLegal against the reference move generator,
+*		   isLegal against making the move and testing the king, the captures and quiet checks modes, givesCheck.
+*		5) Making and unmaking of every legal move.
+*		6) SEE against a brute-force exchange on the target square.
+*
+*	When a check fails, the failure is reproduced from the position alone (or, if it depends on the
+*	history, from the shortest sequence of the last moves), the position is minimized by removing the
+*	pieces while the same check keeps failing and the minimal reproducing FEN is printed.
+*
+*	Usage: ChessMaster2023Fuzz.exe [--seed N] [--games N] [--plies N]
+*/
+
+namespace {
+	// The reference position
+	struct RefPosition final {
+		Piece board[Square::VALUES_COUNT];
+		Color side = Color::WHITE;
+		i32 ep = -1; // The en passant square, -1 if none
+		bool castling[Color::VALUES_COUNT][2] = { }; // [color][0 - king side, 1 - queen side]
+	};
+
+	struct Delta final {
+		i32 file;
+		i32 rank;
+	};
+
+	constexpr Delta KNIGHT_DELTAS[] = { { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 } };
+	constexpr Delta KING_DELTAS[] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+	constexpr Delta ROOK_DELTAS[] = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+	constexpr Delta BISHOP_DELTAS[] = { { 1, 1 }, { -1, 1 }, { -1, -1 }, { 1, -1 } };
+
+	constexpr PieceType PROMOTIONS[] = { PieceType::QUEEN, PieceType::ROOK, PieceType::BISHOP, PieceType::KNIGHT };
+
+	u64 g_positionsChecked = 0;
+	u64 g_movesChecked = 0;
+
+
+	///  REFERENCE IMPLEMENTATION  ///
+
+	i32 fileOf(const i32 sq) {
+		return sq & 7;
+	}
+
+	i32 rankOf(const i32 sq) {
+		return sq >> 3;
+	}
+
+	// Returns -1 if the square is out of the board
+	i32 shiftSquare(const i32 sq, const Delta d) {
+		const i32 file = fileOf(sq) + d.file;
+		const i32 rank = rankOf(sq) + d.rank;
+
+		return file < 0 || file > 7 || rank < 0 || rank > 7 ? -1 : rank * 8 + file;
+	}
+
+	i32 forwardOf(const Color color) {
+		return color == Color::WHITE ? 1 : -1;
+	}
+
+	bool isSliderOf(const Piece piece, const Color color, const bool diagonal) {
+		if (piece == Piece::NONE || piece.getColor() != color) {
+			return false;
+		}
+
+		return piece.getType() == PieceType::QUEEN
+			|| piece.getType() == (diagonal ? PieceType::BISHOP : PieceType::ROOK);
+	}
+
+	i32 kingOf(const RefPosition& pos, const Color color) {
+		for (i32 sq = 0; sq < 64; ++sq) {
+			if (pos.board[sq] == Piece(color, PieceType::KING)) {
+				return sq;
+			}
+		}
+
+		return -1;
+	}
+
+	// All the pieces of the given color attacking the square
+	u64 attackersOf(const RefPosition& pos, const i32 sq, const Color by) {
+		u64 result = 0;
+
+		for (const Delta d : KNIGHT_DELTAS) {
+			if (i32 s = shiftSquare(sq, d); s != -1 && pos.board[s] == Piece(by, PieceType::KNIGHT)) {
+				result |= 1ull << s;
+			}
+		}
+
+		for (const Delta d : KING_DELTAS) {
+			if (i32 s = shiftSquare(sq, d); s != -1 && pos.board[s] == Piece(by, PieceType::KING)) {
+				result |= 1ull << s;
+			}
+		}
+
+		for (const i32 df : { -1, 1 }) {
+			if (i32 s = shiftSquare(sq, { df, -forwardOf(by) }); s != -1 && pos.board[s] == Piece(by, PieceType::PAWN)) {
+				result |= 1ull << s;
+			}
+		}
+
+		for (const bool diagonal : { false, true }) {
+			for (const Delta d : diagonal ? BISHOP_DELTAS : ROOK_DELTAS) {
+				for (i32 s = shiftSquare(sq, d); s != -1; s = shiftSquare(s, d)) {
+					if (pos.board[s] != Piece::NONE) {
+						if (isSliderOf(pos.board[s], by, diagonal)) {
+							result |= 1ull << s;
+						}
+
+						break;
+					}
+				}
+			}
+		}
+
+		return result;
+	}
+
+	bool isAttacked(const RefPosition& pos, const i32 sq, const Color by) {
+		return attackersOf(pos, sq, by) != 0;
+	}
+
+	bool isInCheck(const RefPosition& pos) {
+		return isAttacked(pos, kingOf(pos, pos.side), pos.side.getOpposite());
+	}
+
+	bool isCapture(const RefPosition& pos, const Move m) {
+		return m.getMoveType() == MoveType::ENPASSANT
+			|| (m.getMoveType() != MoveType::CASTLE && pos.board[m.getTo()] != Piece::NONE);
+	}
+
+	RefPosition applyMove(const RefPosition& pos, const Move m) {
+		RefPosition result = pos;
+		const i32 from = m.getFrom();
+		const i32 to = m.getTo();
+		const Piece piece = pos.board[from];
+
+		result.board[from] = Piece::NONE;
+		result.board[to] = piece;
+		result.ep = -1;
+
+		switch (m.getMoveType()) {
+			case MoveType::PROMOTION: result.board[to] = Piece(pos.side, m.getPromotedPiece()); break;
+			case MoveType::ENPASSANT: result.board[rankOf(from) * 8 + fileOf(to)] = Piece::NONE; break;
+			case MoveType::CASTLE: {
+				const i32 rookFrom = fileOf(to) == 6 ? from + 3 : from - 4;
+				const i32 rookTo = fileOf(to) == 6 ? from + 1 : from - 1;
+
+				result.board[rookTo] = result.board[rookFrom];
+				result.board[rookFrom] = Piece::NONE;
+			} break;
+			default: break;
+		}
+
+		if (piece.getType() == PieceType::PAWN && std::abs(rankOf(to) - rankOf(from)) == 2) {
+			result.ep = (from + to) / 2;
+		}
+
+		// Castling rights are lost when the king or a rook leaves its initial square or a rook is captured there
+		for (const i32 sq : { from, to }) {
+			for (const Color color : { Color::WHITE, Color::BLACK }) {
+				const i32 base = color == Color::WHITE ? 0 : 56;
+
+				if (sq == base + 4) {
+					result.castling[color][0] = result.castling[color][1] = false;
+				} else if (sq == base + 7) {
+					result.castling[color][0] = false;
+				} else if (sq == base) {
+					result.castling[color][1] = false;
+				}
+			}
+		}
+
+		result.side = pos.side.getOpposite();
+		return result;
+	}
+
+	void addPawnMove(std::vector<Move>& moves, const i32 from, const i32 to) {
+		if (rankOf(to) == 0 || rankOf(to) == 7) {
+			for (PieceType pt : PROMOTIONS) {
+				moves.emplace_back(Square(from), Square(to), MoveType::PROMOTION, pt);
+			}
+		} else {
+			moves.emplace_back(Square(from), Square(to));
+		}
+	}
+
+	// Pseudo-legal moves, but castlings are generated only when fully legal
+	std::vector<Move> pseudoLegalMoves(const RefPosition& pos) {
+		std::vector<Move> result;
+		const Color us = pos.side;
+		const Color them = us.getOpposite();
+
+		for (i32 from = 0; from < 64; ++from) {
+			const Piece piece = pos.board[from];
+			if (piece == Piece::NONE || piece.getColor() != us) {
+				continue;
+			}
+
+			const auto addIfTarget = [&](const i32 to) {
+				if (to != -1 && (pos.board[to] == Piece::NONE || pos.board[to].getColor() == them)) {
+					result.emplace_back(Square(from), Square(to));
+				}
+			};
+
+			switch (piece.getType()) {
+				case PieceType::PAWN: {
+					const i32 one = shiftSquare(from, { 0, forwardOf(us) });
+					if (one != -1 && pos.board[one] == Piece::NONE) {
+						addPawnMove(result, from, one);
+
+						const i32 two = shiftSquare(one, { 0, forwardOf(us) });
+						if (rankOf(from) == (us == Color::WHITE ? 1 : 6) && pos.board[two] == Piece::NONE) {
+							result.emplace_back(Square(from), Square(two));
+						}
+					}
+
+					for (const i32 df : { -1, 1 }) {
+						const i32 to = shiftSquare(from, { df, forwardOf(us) });
+						if (to == -1) {
+							continue;
+						}
+
+						if (pos.board[to] != Piece::NONE && pos.board[to].getColor() == them) {
+							addPawnMove(result, from, to);
+						} else if (to == pos.ep) {
+							result.emplace_back(Square(from), Square(to), MoveType::ENPASSANT);
+						}
+					}
+				} break;
+				case PieceType::KNIGHT: {
+					for (const Delta d : KNIGHT_DELTAS) {
+						addIfTarget(shiftSquare(from, d));
+					}
+				} break;
+				case PieceType::KING: {
+					for (const Delta d : KING_DELTAS) {
+						addIfTarget(shiftSquare(from, d));
+					}
+				} break;
+				default: {
+					const bool rookLike = piece.getType() != PieceType::BISHOP;
+					const bool bishopLike = piece.getType() != PieceType::ROOK;
+
+					for (const Delta d : ROOK_DELTAS) {
+						for (i32 to = shiftSquare(from, d); rookLike && to != -1; to = shiftSquare(to, d)) {
+							addIfTarget(to);
+							if (pos.board[to] != Piece::NONE) {
+								break;
+							}
+						}
+					}
+
+					for (const Delta d : BISHOP_DELTAS) {
+						for (i32 to = shiftSquare(from, d); bishopLike && to != -1; to = shiftSquare(to, d)) {
+							addIfTarget(to);
+							if (pos.board[to] != Piece::NONE) {
+								break;
+							}
+						}
+					}
+				} break;
+			}
+		}
+
+		// Castlings
+		const i32 base = us == Color::WHITE ? 0 : 56;
+		const i32 kingSq = base + 4;
+		if (pos.board[kingSq] == Piece(us, PieceType::KING) && !isAttacked(pos, kingSq, them)) {
+			if (pos.castling[us][0] && pos.board[base + 7] == Piece(us, PieceType::ROOK)
+				&& pos.board[base + 5] == Piece::NONE && pos.board[base + 6] == Piece::NONE
+				&& !isAttacked(pos, base + 5, them) && !isAttacked(pos, base + 6, them)) {
+				result.emplace_back(Square(kingSq), Square(base + 6), MoveType::CASTLE);
+			}
+
+			if (pos.castling[us][1] && pos.board[base] == Piece(us, PieceType::ROOK)
+				&& pos.board[base + 1] == Piece::NONE && pos.board[base + 2] == Piece::NONE && pos.board[base + 3] == Piece::NONE
+				&& !isAttacked(pos, base + 3, them) && !isAttacked(pos, base + 2, them)) {
+				result.emplace_back(Square(kingSq), Square(base + 2), MoveType::CASTLE);
+			}
+		}
+
+		return result;
+	}
+
+	// Makes the move and tests whether the own king is attacked
+	bool isLegalByMaking(const RefPosition& pos, const Move m) {
+		const RefPosition next = applyMove(pos, m);
+		return !isAttacked(next, kingOf(next, pos.side), next.side);
+	}
+
+	std::vector<Move> legalMoves(const RefPosition& pos) {
+		std::vector<Move> result;
+		for (Move m : pseudoLegalMoves(pos)) {
+			if (isLegalByMaking(pos, m)) {
+				result.push_back(m);
+			}
+		}
+
+		return result;
+	}
+
+	bool parseFEN(const std::string& fen, RefPosition& pos) {
+		std::istringstream in(fen);
+		std::string placement, side, castling, ep;
+		if (!(in >> placement >> side >> castling >> ep)) {
+			return false;
+		}
+
+		pos = RefPosition();
+		for (Piece& piece : pos.board) {
+			piece = Piece::NONE;
+		}
+
+		i32 file = 0, rank = 7;
+		for (const char ch : placement) {
+			if (ch == '/') {
+				file = 0;
+				--rank;
+			} else if (ch >= '1' && ch <= '8') {
+				file += ch - '0';
+			} else if (file < 8 && rank >= 0) {
+				pos.board[rank * 8 + file++] = Piece::fromFENChar(ch);
+			}
+		}
+
+		pos.side = side == "b" ? Color::BLACK : Color::WHITE;
+		pos.castling[Color::WHITE][0] = castling.find('K') != std::string::npos;
+		pos.castling[Color::WHITE][1] = castling.find('Q') != std::string::npos;
+		pos.castling[Color::BLACK][0] = castling.find('k') != std::string::npos;
+		pos.castling[Color::BLACK][1] = castling.find('q') != std::string::npos;
+		pos.ep = ep.size() == 2 ? (ep[1] - '1') * 8 + (ep[0] - 'a') : -1;
+		return kingOf(pos, Color::WHITE) != -1 && kingOf(pos, Color::BLACK) != -1;
+	}
+
+	std::string toFEN(const RefPosition& pos) {
+		std::string result;
+
+		for (i32 rank = 7; rank >= 0; --rank) {
+			i32 empty = 0;
+			for (i32 file = 0; file < 8; ++file) {
+				const Piece piece = pos.board[rank * 8 + file];
+				if (piece == Piece::NONE) {
+					++empty;
+					continue;
+				}
+
+				if (empty) {
+					result += char('0' + empty);
+					empty = 0;
+				}
+
+				result += piece.toChar();
+			}
+
+			if (empty) {
+				result += char('0' + empty);
+			}
+
+			if (rank) {
+				result += '/';
+			}
+		}
+
+		result += pos.side == Color::WHITE ? " w " : " b ";
+
+		const std::string castling = std::string(pos.castling[Color::WHITE][0] ? "K" : "")
+			+ (pos.castling[Color::WHITE][1] ? "Q" : "")
+			+ (pos.castling[Color::BLACK][0] ? "k" : "")
+			+ (pos.castling[Color::BLACK][1] ? "q" : "");
+		result += castling.empty() ? "-" : castling;
+		result += ' ';
+		result += pos.ep == -1 ? std::string("-") : Square(pos.ep).toString();
+		return result + " 0 1";
+	}
+
+	// Drops the castling rights and the en passant square that do not fit the pieces
+	void normalize(RefPosition& pos) {
+		for (const Color color : { Color::WHITE, Color::BLACK }) {
+			const i32 base = color == Color::WHITE ? 0 : 56;
+
+			if (pos.board[base + 4] != Piece(color, PieceType::KING)) {
+				pos.castling[color][0] = pos.castling[color][1] = false;
+			}
+
+			if (pos.board[base + 7] != Piece(color, PieceType::ROOK)) {
+				pos.castling[color][0] = false;
+			}
+
+			if (pos.board[base] != Piece(color, PieceType::ROOK)) {
+				pos.castling[color][1] = false;
+			}
+		}
+
+		if (pos.ep != -1) {
+			const Color them = pos.side.getOpposite();
+			const i32 pawnSq = shiftSquare(pos.ep, { 0, forwardOf(them) });
+			const i32 fromSq = shiftSquare(pos.ep, { 0, -forwardOf(them) });
+
+			if (pos.board[pawnSq] != Piece(them, PieceType::PAWN) || pos.board[pos.ep] != Piece::NONE
+				|| pos.board[fromSq] != Piece::NONE) {
+				pos.ep = -1;
+			}
+		}
+	}
+
+	// A position is accepted if the side that has just moved is not in check
+	bool isValid(const RefPosition& pos) {
+		const i32 whiteKing = kingOf(pos, Color::WHITE);
+		const i32 blackKing = kingOf(pos, Color::BLACK);
+
+		return whiteKing != -1 && blackKing != -1
+			&& !isAttacked(pos, kingOf(pos, pos.side.getOpposite()), pos.side);
+	}
+
+	std::string randomFEN(std::mt19937_64& rng) {
+		const PieceType TYPES[] = { PieceType::PAWN, PieceType::PAWN, PieceType::PAWN,
+			PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN };
+
+		while (true) {
+			RefPosition pos;
+			for (Piece& piece : pos.board) {
+				piece = Piece::NONE;
+			}
+
+			const i32 whiteKing = rng() % 64;
+			const i32 blackKing = rng() % 64;
+			if (std::max(std::abs(fileOf(whiteKing) - fileOf(blackKing)), std::abs(rankOf(whiteKing) - rankOf(blackKing))) < 2) {
+				continue;
+			}
+
+			pos.board[whiteKing] = Piece::KING_WHITE;
+			pos.board[blackKing] = Piece::KING_BLACK;
+
+			const u32 piecesCount = rng() % 24;
+			for (u32 i = 0; i < piecesCount; ++i) {
+				const i32 sq = rng() % 64;
+				const PieceType pt = TYPES[rng() % std::size(TYPES)];
+
+				if (pos.board[sq] == Piece::NONE && (pt != PieceType::PAWN || (rankOf(sq) != 0 && rankOf(sq) != 7))) {
+					pos.board[sq] = Piece(rng() % 2 ? Color::WHITE : Color::BLACK, pt);
+				}
+			}
+
+			pos.side = rng() % 2 ? Color::WHITE : Color::BLACK;
+			pos.castling[Color::WHITE][0] = pos.castling[Color::WHITE][1] = rng() % 2;
+			pos.castling[Color::BLACK][0] = pos.castling[Color::BLACK][1] = rng() % 2;
+
+			// Some pawn of the opponent might have just made a double push
+			const Color them = pos.side.getOpposite();
+			pos.ep = (rng() % 8) + (them == Color::WHITE ? 16 : 40);
+
+			normalize(pos);
+			if (isValid(pos)) {
+				return toFEN(pos);
+			}
+		}
+	}
+
+
+	// Blockers and pinners by walking the rays from the king. As in the engine,
+	// the sliders of the opponent are transparent to each other on the ray
+	void computeBlockers(const RefPosition& pos, const Color side, u64& blockers, u64& pinners) {
+		const i32 kingSq = kingOf(pos, side);
+		const Color them = side.getOpposite();
+
+		blockers = pinners = 0;
+		for (const bool diagonal : { false, true }) {
+			for (const Delta d : diagonal ? BISHOP_DELTAS : ROOK_DELTAS) {
+				u64 between = 0;
+
+				for (i32 s = shiftSquare(kingSq, d); s != -1; s = shiftSquare(s, d)) {
+					if (pos.board[s] == Piece::NONE) {
+						continue;
+					}
+
+					if (!isSliderOf(pos.board[s], them, diagonal)) {
+						if (between) {
+							break; // The second piece that is not a sniper
+						}
+
+						between = 1ull << s;
+						continue;
+					}
+
+					if (between) {
+						blockers |= between;
+
+						if (pos.board[std::countr_zero(between)].getColor() == side) {
+							pinners |= 1ull << s;
+						}
+					}
+				}
+			}
+		}
+	}
+
+
+	///  REFERENCE SEE  ///
+
+	/*
+	*	SEE is a model of the exchange rather than the exact one, so it is checked against a brute-force
+	*	exchange under the same rules:
+	*		1) Each side either stops or captures with its least valuable attacker, the king being the last one.
+	*		   Any of the attackers of the same type may be chosen, so the result is a set of the possible values.
+	*		2) The legality is ignored, except that the king cannot capture a defended piece.
+	*		3) Recaptures do not promote.
+	*		4) The pieces pinned in the initial position do not take part in the exchange
+	*		   while any of the opponent's pinners from the initial position remains.
+	*	The brute-force exchange under the actual rules is computed as well, and the number of
+	*	moves where the model differs from it is reported as a statistic.
+	*/
+
+	struct ExchangeRules final {
+		u64 pinned[Color::VALUES_COUNT]; // Pieces pinned to their king in the initial position
+		u64 pinners[Color::VALUES_COUNT]; // Pieces of the color that pin the opponent's pieces
+	};
+
+	u64 g_seeChecked = 0;
+	u64 g_seeDiffersFromLegal = 0;
+
+	Value pieceValue(const Piece piece) {
+		return scores::SIMPLIFIED_PIECE_VALUES[piece];
+	}
+
+	// The material the move wins immediately
+	Value captureGain(const RefPosition& pos, const Move m) {
+		Value result = m.getMoveType() == MoveType::ENPASSANT
+			? pieceValue(Piece::PAWN_WHITE)
+			: pieceValue(pos.board[m.getTo()]);
+
+		if (m.getMoveType() == MoveType::PROMOTION) {
+			result += pieceValue(Piece(Color::WHITE, m.getPromotedPiece())) - pieceValue(Piece::PAWN_WHITE);
+		}
+
+		return result;
+	}
+
+	// The possible best gains of the side to move capturing on the square under the SEE rules
+	// <gone> contains the squares left by the pieces of the initial position
+	std::vector<Value> modelExchangeGains(const RefPosition& pos, const i32 sq, const ExchangeRules& rules, const u64 gone) {
+		const Color us = pos.side;
+		const Color them = us.getOpposite();
+
+		u64 attackers = attackersOf(pos, sq, us);
+		if (rules.pinners[them] & ~gone) {
+			attackers &= ~rules.pinned[us];
+		}
+
+		// Least valuable attackers
+		u64 captures = 0;
+		PieceType leastValuable = PieceType::NONE;
+		for (u64 b = attackers; b; b &= b - 1) {
+			const i32 from = std::countr_zero(b);
+			const PieceType pt = pos.board[from].getType();
+
+			if (!captures || pt < leastValuable) {
+				captures = 0;
+				leastValuable = pt;
+			}
+
+			if (pt == leastValuable) {
+				captures |= 1ull << from;
+			}
+		}
+
+		if (leastValuable == PieceType::KING && isAttacked(pos, sq, them)) {
+			captures = 0;
+		}
+
+		if (!captures) {
+			return { 0 };
+		}
+
+		std::vector<Value> result;
+		for (u64 b = captures; b; b &= b - 1) {
+			const i32 from = std::countr_zero(b);
+
+			RefPosition next = pos;
+			next.board[sq] = pos.board[from];
+			next.board[from] = Piece::NONE;
+			next.side = them;
+
+			for (const Value gain : modelExchangeGains(next, sq, rules, gone | (1ull << from))) {
+				result.push_back(std::max<Value>(0, pieceValue(pos.board[sq]) - gain));
+			}
+		}
+
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		return result;
+	}
+
+	std::vector<Value> modelSEE(const RefPosition& pos, const Move m) {
+		ExchangeRules rules;
+		for (const Color color : { Color::WHITE, Color::BLACK }) {
+			u64 blockers, pinners;
+			computeBlockers(pos, color, blockers, pinners);
+
+			rules.pinners[color.getOpposite()] = pinners;
+			rules.pinned[color] = 0;
+			for (u64 b = blockers; b; b &= b - 1) {
+				if (pos.board[std::countr_zero(b)].getColor() == color) {
+					rules.pinned[color] |= b & -b;
+				}
+			}
+		}
+
+		u64 gone = (1ull << m.getFrom()) | (1ull << m.getTo());
+		if (m.getMoveType() == MoveType::ENPASSANT) {
+			gone |= 1ull << (rankOf(m.getFrom()) * 8 + fileOf(m.getTo()));
+		}
+
+		std::vector<Value> result = modelExchangeGains(applyMove(pos, m), m.getTo(), rules, gone);
+		for (Value& value : result) {
+			value = captureGain(pos, m) - value;
+		}
+
+		return result;
+	}
+
+	// The same as above, but under the actual rules: only the legal captures, promoting to a queen
+	Value legalExchangeGain(const RefPosition& pos, const i32 sq) {
+		std::vector<Move> captures;
+		PieceType leastValuable = PieceType::NONE;
+
+		for (Move m : legalMoves(pos)) {
+			if (m.getTo() != sq || m.getMoveType() == MoveType::CASTLE || m.getMoveType() == MoveType::ENPASSANT
+				|| (m.getMoveType() == MoveType::PROMOTION && m.getPromotedPiece() != PieceType::QUEEN)) {
+				continue;
+			}
+
+			const PieceType pt = pos.board[m.getFrom()].getType();
+			if (captures.empty() || pt < leastValuable) {
+				captures.clear();
+				leastValuable = pt;
+			}
+
+			if (pt == leastValuable) {
+				captures.push_back(m);
+			}
+		}
+
+		Value result = 0;
+		for (Move m : captures) { // The best of the equal attackers
+			result = std::max<Value>(result, captureGain(pos, m) - legalExchangeGain(applyMove(pos, m), sq));
+		}
+
+		return result;
+	}
+
+	Value legalSEE(const RefPosition& pos, const Move m) {
+		return captureGain(pos, m) - legalExchangeGain(applyMove(pos, m), m.getTo());
+	}
+
+
+	///  CHECKS  ///
+
+	// Failures are reported as "<check>: <details>", the check name is used to group them
+	std::string checkName(const std::string& failure) {
+		return failure.substr(0, failure.find(':'));
+	}
+
+	std::string movesToString(std::vector<Move> moves) {
+		std::sort(moves.begin(), moves.end(), [](const Move a, const Move b) { return a.getData() < b.getData(); });
+
+		std::string result;
+		for (Move m : moves) {
+			result += (result.empty() ? "" : " ") + m.toString();
+		}
+
+		return result.empty() ? "(none)" : result;
+	}
+
+	// Moves are compared without their scores
+	bool contains(const std::vector<Move>& moves, const Move m) {
+		return std::any_of(moves.begin(), moves.end(), [m](const Move other) { return other.getData() == m.getData(); });
+	}
+
+	// Returns the moves of <a> that are not in <b>
+	std::vector<Move> difference(const std::vector<Move>& a, const std::vector<Move>& b) {
+		std::vector<Move> result;
+		for (Move m : a) {
+			if (!contains(b, m)) {
+				result.push_back(m);
+			}
+		}
+
+		return result;
+	}
+
+	std::string compareMoveSets(const std::string& name, const std::vector<Move>& engine, const std::vector<Move>& reference) {
+		const std::vector<Move> extra = difference(engine, reference);
+		const std::vector<Move> missing = difference(reference, engine);
+
+		if (extra.empty() && missing.empty()) {
+			return "";
+		}
+
+		return name + ": extra " + movesToString(extra) + ", missing " + movesToString(missing);
+	}
+
+	template<class T, class U>
+	std::string describeMismatch(const std::string& name, const T& engine, const U& reference) {
+		std::ostringstream out;
+		out << name << ": engine " << engine << ", reference " << reference;
+		return out.str();
+	}
+
+	std::string checkState(const Board& board, const RefPosition& ref) {
+		++g_positionsChecked;
+
+		// Pieces
+		for (i32 sq = 0; sq < 64; ++sq) {
+			if (board[Square(sq)] != ref.board[sq]) {
+				return describeMismatch("board", std::string(1, board[Square(sq)].toChar()) + " on " + Square(sq).toString(),
+								std::string(1, ref.board[sq].toChar()));
+			}
+		}
+
+		for (const Piece piece : Piece::iter()) {
+			if (piece.getType() == PieceType::NONE) {
+				continue;
+			}
+
+			u64 expected = 0;
+			for (i32 sq = 0; sq < 64; ++sq) {
+				expected |= u64(ref.board[sq] == piece) << sq;
+			}
+
+			if (u64(board.byPiece(piece)) != expected) {
+				return describeMismatch(std::string("bitboard of ") + piece.toChar(), u64(board.byPiece(piece)), expected);
+			}
+		}
+
+		for (const Color color : { Color::WHITE, Color::BLACK }) {
+			u64 expected = 0;
+			for (i32 sq = 0; sq < 64; ++sq) {
+				expected |= u64(ref.board[sq] != Piece::NONE && ref.board[sq].getColor() == color) << sq;
+			}
+
+			if (u64(board.byColor(color)) != expected) {
+				return describeMismatch("bitboard by color", u64(board.byColor(color)), expected);
+			}
+		}
+
+		// General state
+		const auto& st = board.state();
+		if (board.side() != ref.side) {
+			return describeMismatch("side", board.side().toString(), ref.side.toString());
+		}
+
+		if (i32(st.ep == Square::NO_POS ? -1 : i32(st.ep)) != ref.ep) {
+			return describeMismatch("en passant", i32(st.ep == Square::NO_POS ? -1 : i32(st.ep)), ref.ep);
+		}
+
+		for (const Color color : { Color::WHITE, Color::BLACK }) {
+			if (Castle::hasCastleRight(st.castleRight, Castle::KING_CASTLE, color) != ref.castling[color][0]
+				|| Castle::hasCastleRight(st.castleRight, Castle::QUEEN_CASTLE, color) != ref.castling[color][1]) {
+				return describeMismatch("castling rights", u32(st.castleRight), toFEN(ref));
+			}
+		}
+
+		const std::string fen = board.toFEN();
+		const std::string refFEN = toFEN(ref);
+		if (fen.substr(0, fen.rfind(' ', fen.rfind(' ') - 1)) != refFEN.substr(0, refFEN.rfind(' ', refFEN.rfind(' ') - 1))) {
+			return describeMismatch("toFEN", fen, refFEN);
+		}
+
+		// Incremental values
+		Hash hash = zobrist::SIDE[ref.side];
+		Score score[Color::VALUES_COUNT] = { Score(0, 0), Score(0, 0) };
+		i32 material[Color::VALUES_COUNT] = { 0, 0 };
+
+		for (i32 sq = 0; sq < 64; ++sq) {
+			if (const Piece piece = ref.board[sq]; piece != Piece::NONE) {
+				hash ^= zobrist::PIECE[piece][sq];
+				score[piece.getColor()] += scores::PST[piece][sq];
+				material[piece.getColor()] += Material::materialOf(piece.getType());
+			}
+		}
+
+		if (board.hash() != hash) {
+			return describeMismatch("hash", board.hash(), hash);
+		}
+
+		const Hash fullHash = hash
+			^ (ref.ep != -1 ? zobrist::EP[fileOf(ref.ep)] : 0ull)
+			^ zobrist::CASTLING[st.castleRight];
+		if (board.computeHash() != fullHash) {
+			return describeMismatch("computeHash", board.computeHash(), fullHash);
+		}
+
+		for (const Color color : { Color::WHITE, Color::BLACK }) {
+			if (!(board.scoreByColor(color) == score[color])) {
+				return describeMismatch("score", board.scoreByColor(color).middlegame(), score[color].middlegame());
+			}
+
+			if (board.materialByColor(color) != material[color]) {
+				return describeMismatch("material", board.materialByColor(color), material[color]);
+			}
+		}
+
+		// Internal state
+		const u64 checkGivers = attackersOf(ref, kingOf(ref, ref.side), ref.side.getOpposite());
+		if (u64(board.checkGivers()) != checkGivers) {
+			return describeMismatch("checkGivers", u64(board.checkGivers()), checkGivers);
+		}
+
+		for (const Color color : { Color::WHITE, Color::BLACK }) {
+			u64 blockers, pinners;
+			computeBlockers(ref, color, blockers, pinners);
+
+			if (u64(board.checkBlockers(color)) != blockers) {
+				return describeMismatch("checkBlockers", u64(board.checkBlockers(color)), blockers);
+			}
+
+			if (u64(st.pinners[color.getOpposite()]) != pinners) {
+				return describeMismatch("pinners", u64(st.pinners[color.getOpposite()]), pinners);
+			}
+		}
+
+		return "";
+	}
+
+	template<movegen::GenerationMode Mode>
+	std::vector<Move> engineMoves(const Board& board, const bool legalOnly) {
+		MoveList moves;
+		moves.clear();
+		board.generateMoves<Mode>(moves);
+
+		std::vector<Move> result;
+		for (Move m : moves) {
+			if (!legalOnly || board.isLegal(m)) {
+				result.push_back(m);
+			}
+		}
+
+		return result;
+	}
+
+	std::string checkMoves(Board& board, const RefPosition& ref) {
+		const std::vector<Move> refLegal = legalMoves(ref);
+		const std::vector<Move> pseudoLegal = engineMoves<movegen::ALL_MOVES>(board, false);
+
+		for (u32 i = 0; i < pseudoLegal.size(); ++i) {
+			for (u32 j = 0; j < i; ++j) {
+				if (pseudoLegal[i].getData() == pseudoLegal[j].getData()) {
+					return "duplicate move: " + pseudoLegal[i].toString();
+				}
+			}
+		}
+
+		// isLegal against making the move
+		std::vector<Move> legal;
+		for (Move m : pseudoLegal) {
+			const bool byMaking = m.getMoveType() == MoveType::CASTLE
+				? contains(refLegal, m) // The reference generates only the legal castlings
+				: isLegalByMaking(ref, m);
+
+			if (board.isLegal(m) != byMaking) {
+				return describeMismatch("isLegal " + m.toString(), board.isLegal(m), byMaking);
+			}
+
+			if (byMaking) {
+				legal.push_back(m);
+			}
+		}
+
+		if (std::string failure = compareMoveSets("legal moves", legal, refLegal); !failure.empty()) {
+			return failure;
+		}
+
+		if (!isInCheck(ref)) {
+			// Captures and queen promotions
+			std::vector<Move> refCaptures;
+			std::vector<Move> refQuietChecks;
+
+			for (Move m : refLegal) {
+				const bool isPromotion = m.getMoveType() == MoveType::PROMOTION;
+
+				if (isPromotion ? m.getPromotedPiece() == PieceType::QUEEN : isCapture(ref, m)) {
+					refCaptures.push_back(m);
+				}
+
+				if (!isPromotion && !isCapture(ref, m) && m.getMoveType() != MoveType::CASTLE) {
+					const RefPosition next = applyMove(ref, m);
+					if (isInCheck(next)) {
+						refQuietChecks.push_back(m);
+					}
+				}
+			}
+
+			if (std::string failure = compareMoveSets("captures", engineMoves<movegen::CAPTURES>(board, true), refCaptures);
+				!failure.empty()) {
+				return failure;
+			}
+
+			if (std::string failure = compareMoveSets("quiet checks", engineMoves<movegen::QUIET_CHECKS>(board, true), refQuietChecks);
+				!failure.empty()) {
+				return failure;
+			}
+		}
+
+		for (Move m : refLegal) {
+			++g_movesChecked;
+
+			// givesCheck
+			const RefPosition next = applyMove(ref, m);
+			if (board.givesCheck(m) != isInCheck(next)) {
+				return describeMismatch("givesCheck " + m.toString(), board.givesCheck(m), isInCheck(next));
+			}
+
+			// SEE
+			if (m.getMoveType() != MoveType::CASTLE) {
+				const Value see = board.SEE(m);
+				if (const std::vector<Value> expected = modelSEE(ref, m); std::find(expected.begin(), expected.end(), see) == expected.end()) {
+					std::string values;
+					for (const Value value : expected) {
+						values += (values.empty() ? "" : " or ") + std::to_string(value);
+					}
+
+					return describeMismatch("SEE " + m.toString(), see, values);
+				}
+
+				++g_seeChecked;
+				g_seeDiffersFromLegal += see != legalSEE(ref, m);
+			}
+
+			// Making and unmaking
+			const std::string fenBefore = board.toFEN();
+			const Hash hashBefore = board.computeHash();
+			const Score scoreBefore = board.score();
+
+			board.makeMove(m);
+			if (std::string failure = checkState(board, next); !failure.empty()) {
+				board.unmakeMove(m);
+				return "makeMove " + m.toString() + " -> " + failure;
+			}
+
+			board.unmakeMove(m);
+			if (board.toFEN() != fenBefore || board.computeHash() != hashBefore || !(board.score() == scoreBefore)) {
+				return describeMismatch("unmakeMove " + m.toString(), board.toFEN(), fenBefore);
+			}
+		}
+
+		return "";
+	}
+
+	std::string checkPosition(Board& board, const RefPosition& ref) {
+		if (std::string failure = checkState(board, ref); !failure.empty()) {
+			return failure;
+		}
+
+		return checkMoves(board, ref);
+	}
+
+	// Plays the moves from the position and checks the final position
+	std::string checkLine(const std::string& fen, const std::vector<Move>& moves) {
+		RefPosition ref;
+		if (!parseFEN(fen, ref)) {
+			return "parse: " + fen;
+		}
+
+		bool success;
+		Board board = Board::fromFEN(fen, success);
+		if (!success) {
+			return "fromFEN: " + fen;
+		}
+
+		for (Move m : moves) {
+			board.makeMove(m);
+			ref = applyMove(ref, m);
+		}
+
+		return checkPosition(board, ref);
+	}
+
+
+	///  FAILURE MINIMIZATION  ///
+
+	// Removes the pieces, the castling rights and the en passant square while the same check keeps failing
+	std::string minimize(const std::string& fen, const std::string& name) {
+		RefPosition pos;
+		parseFEN(fen, pos);
+
+		const auto stillFails = [&name](const RefPosition& candidate) {
+			if (!isValid(candidate)) {
+				return false;
+			}
+
+			const std::string failure = checkLine(toFEN(candidate), { });
+			return !failure.empty() && checkName(failure) == name;
+		};
+
+		bool changed = true;
+		while (changed) {
+			changed = false;
+
+			for (i32 sq = 0; sq < 64; ++sq) {
+				if (pos.board[sq] == Piece::NONE || pos.board[sq].getType() == PieceType::KING) {
+					continue;
+				}
+
+				RefPosition candidate = pos;
+				candidate.board[sq] = Piece::NONE;
+				normalize(candidate);
+
+				if (stillFails(candidate)) {
+					pos = candidate;
+					changed = true;
+				}
+			}
+
+			for (const Color color : { Color::WHITE, Color::BLACK }) {
+				for (i32 castle = 0; castle < 2; ++castle) {
+					RefPosition candidate = pos;
+					candidate.castling[color][castle] = false;
+
+					if (pos.castling[color][castle] && stillFails(candidate)) {
+						pos = candidate;
+						changed = true;
+					}
+				}
+			}
+
+			RefPosition candidate = pos;
+			candidate.ep = -1;
+			if (pos.ep != -1 && stillFails(candidate)) {
+				pos = candidate;
+				changed = true;
+			}
+		}
+
+		return toFEN(pos);
+	}
+
+	void reportFailure(const std::vector<std::string>& fens, const std::vector<Move>& moves, const std::string& failure) {
+		const std::string& fen = fens.back();
+		std::cout << "FAILURE " << failure << "\n\tposition: " << fen << "\n";
+
+		const std::string name = checkName(failure);
+		if (const std::string single = checkLine(fen, { }); !single.empty()) {
+			std::cout << "\tminimal: " << minimize(fen, checkName(single)) << "\n";
+			return;
+		}
+
+		// The failure depends on the history of the game: looking for the shortest reproducing line
+		for (size_t count = 1; count < fens.size(); ++count) {
+			const std::vector<Move> line(moves.end() - count, moves.end());
+
+			if (const std::string result = checkLine(fens[fens.size() - 1 - count], line); checkName(result) == name) {
+				std::cout << "\tminimal: " << fens[fens.size() - 1 - count] << " moves " << movesToString(line) << "\n";
+				return;
+			}
+		}
+
+		std::cout << "\tnot reproducible from the game" << std::endl;
+	}
+
+	// Plays a random game, returns false on a failure
+	bool fuzzGame(const std::string& startFEN, const u32 maxPlies, std::mt19937_64& rng) {
+		RefPosition ref;
+		parseFEN(startFEN, ref);
+
+		bool success;
+		Board board = Board::fromFEN(startFEN, success);
+
+		std::vector<std::string> fens = { startFEN };
+		std::vector<Move> moves;
+
+		for (u32 ply = 0; ; ++ply) {
+			if (std::string failure = checkPosition(board, ref); !failure.empty()) {
+				reportFailure(fens, moves, failure);
+				return false;
+			}
+
+			const std::vector<Move> legal = legalMoves(ref);
+			if (legal.empty() || ply >= maxPlies || board.fiftyRuleDraw()) {
+				return true;
+			}
+
+			const Move m = legal[rng() % legal.size()];
+			board.makeMove(m);
+			ref = applyMove(ref, m);
+
+			fens.push_back(board.toFEN());
+			moves.push_back(m);
+		}
+	}
+}
+
+
+int main(int argc, char** argv) {
+	u64 seed = 1;
+	u32 gamesCount = 200;
+	u32 maxPlies = 200;
+
+	for (int i = 1; i < argc; i++) {
+		const std::string_view arg = argv[i];
+
+		if (arg == "--seed" && i + 1 < argc) {
+			seed = str_utils::fromString<u64>(argv[++i]);
+		} else if (arg == "--games" && i + 1 < argc) {
+			gamesCount = str_utils::fromString<u32>(argv[++i]);
+		} else if (arg == "--plies" && i + 1 < argc) {
+			maxPlies = str_utils::fromString<u32>(argv[++i]);
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--seed N] [--games N] [--plies N]" << std::endl;
+			return 1;
+		}
+	}
+
+	BitBoard::init();
+	scores::initScores();
+	engine::TranspositionTable::init();
+	engine::PawnHashTable::init();
+	engine::bitbase::init();
+
+	std::mt19937_64 rng(seed);
+	u32 failuresCount = 0;
+
+	for (u32 game = 0; game < gamesCount; ++game) {
+		// Every other game starts from a random position
+		const std::string fen = game % 2
+			? randomFEN(rng)
+			: TEST_FENS[rng() % std::size(TEST_FENS)];
+
+		if (!fuzzGame(fen, maxPlies, rng)) {
+			++failuresCount;
+		}
+	}
+
+	std::cout << "Seed " << seed << ": " << gamesCount << " games, " << g_positionsChecked << " positions, "
+		<< g_movesChecked << " moves checked, " << failuresCount << " failures" << std::endl;
+	std::cout << "SEE differs from the exchange under the actual rules in " << g_seeDiffersFromLegal
+		<< " of " << g_seeChecked << " moves" << std::endl;
+
+	engine::TranspositionTable::destroy();
+	return failuresCount ? 1 : 0;
+}
\ No newline at end of file
@@ -32,6 +32,7 @@
 
 #include "ChessMasterInfo.h"
 #include "StringUtils.h"
+#include "Engine/TranspositionTable.h"
 
 ///  GLOBAL VARIABLES  ///
 
@@ -65,6 +66,7 @@ void initForConsole() {
 		"\nThis engine supports UCI and Xboard/Winboard, so you can run it in GUI."\
 		"\nIn the current console mode, there is a specific console interface."\
 		"\nTo get the commands available now, type help or h"
+		<< "\nTransposition table: " << io::Color::Blue << engine::TranspositionTable::describeMemory()
 		<< io::Color::White << std::endl;
 }
 
@@ -82,13 +84,31 @@ void initForXboard() {
 	io::g_out << "feature ping=1, setboard=1, playother=0, san=0, usermove=1, time=1, draw=1, reuse=1, analyze=1, myname=\""
 		<< ENGINE_NAME << " " << ENGINE_VERSION << " by " << AUTHOR_NAME << "\"" << std::endl
 		<< "feature variants=\"normal\"" << std::endl
-		<< "feature ics=1, name=1, pause=1, colors=0, nps=1, done=1" << std::endl;
+		<< "feature ics=1, name=1, pause=1, colors=0, nps=1, done=1" << std::endl
+		<< "# Transposition table: " << engine::TranspositionTable::describeMemory() << std::endl;
 }
 
 void initForUCI() {
 	io::g_out << "id name " << ENGINE_NAME << " " << ENGINE_VERSION << std::endl
 		<< "id author " << AUTHOR_NAME << std::endl;
-	io::g_out << "uciok" << std::endl;
+	io::g_out << "option name Hash type spin default " << engine::TranspositionTable::DEFAULT_TABLE_SIZE / (1024 * 1024) << " min 1 max 65536" << std::endl
+		<< "option name Hash File type string default ChessMaster2023.hash" << std::endl
+		<< "option name Save Hash type button" << std::endl
+		<< "option name Load Hash type button" << std::endl
+		<< "option name Hash Autosave type spin default 0 min 0 max 1440" << std::endl
+		<< "option name Learning File type string default <empty>" << std::endl
+		<< "option name Book File type string default <empty>" << std::endl
+		<< "option name Book Best Move type check default false" << std::endl
+		<< "option name Tablebase Path type string default <empty>" << std::endl
+		<< "option name SyzygyPath type string default <empty>" << std::endl
+		<< "option name SyzygyProbeLimit type spin default 7 min 0 max 7" << std::endl
+		<< "option name MTDf type check default false" << std::endl
+		<< "option name Nodes Per Second type spin default 0 min 0 max 1000000000" << std::endl
+		<< "option name MCTS type check default false" << std::endl
+		<< "option name MCTS Threads type spin default 1 min 1 max 1024" << std::endl
+		<< "option name MCTS Memory type spin default 256 min 16 max 65536" << std::endl;
+	io::g_out << "uciok" << std::endl
+		<< "info string Transposition table: " << engine::TranspositionTable::describeMemory() << std::endl;
 }
 
 io::IOMode requestIOMode() {
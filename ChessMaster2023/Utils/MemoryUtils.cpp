@@ -0,0 +1,138 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "MemoryUtils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <fstream>
+#include <string>
+#include <sys/mman.h>
+
+#include "NumaUtils.h"
+#endif // __linux__
+
+namespace mem_utils {
+#ifdef __linux__
+	bool areTransparentHugePagesEnabled() {
+		// Like "always [madvise] never", where the current mode is in brackets
+		std::ifstream in("/sys/kernel/mm/transparent_hugepage/enabled");
+		std::string modes;
+		return std::getline(in, modes) && modes.find("[never]") == std::string::npos;
+	}
+
+	void* mapAnonymous(const size_t size, const int flags = 0) noexcept {
+		void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+		return data == MAP_FAILED ? nullptr : data;
+	}
+
+	LargeMemory allocateLarge(const size_t size) noexcept {
+		if (size >= HUGE_PAGE_SIZE) {
+			const size_t roundedSize = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+			if (areTransparentHugePagesEnabled()) {
+				// Mapping a bit more to cut an aligned region out of it
+				if (u8* mapped = reinterpret_cast<u8*>(mapAnonymous(roundedSize + HUGE_PAGE_SIZE))) {
+					u8* aligned = reinterpret_cast<u8*>((uintptr_t(mapped) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+
+					if (aligned != mapped) {
+						munmap(mapped, aligned - mapped);
+					}
+
+					munmap(aligned + roundedSize, mapped + HUGE_PAGE_SIZE - aligned);
+
+					madvise(aligned, roundedSize, MADV_HUGEPAGE);
+					numa_utils::interleave(aligned, roundedSize);
+					return LargeMemory { .data = aligned, .size = roundedSize, .mode = PageMode::TRANSPARENT_HUGE_PAGES };
+				}
+			}
+
+#ifdef MAP_HUGETLB
+			if (void* data = mapAnonymous(roundedSize, MAP_HUGETLB)) {
+				numa_utils::interleave(data, roundedSize);
+				return LargeMemory { .data = data, .size = roundedSize, .mode = PageMode::EXPLICIT_HUGE_PAGES };
+			}
+#endif // MAP_HUGETLB
+		}
+
+		void* data = mapAnonymous(size);
+		numa_utils::interleave(data, size);
+		return LargeMemory { .data = data, .size = data ? size : 0, .mode = PageMode::NORMAL };
+	}
+
+	void freeLarge(LargeMemory& memory) noexcept {
+		if (memory.data) {
+			munmap(memory.data, memory.size);
+		}
+
+		memory = LargeMemory();
+	}
+
+	void clearLarge(LargeMemory& memory) {
+		// The private anonymous pages are replaced with the zero ones on the next touch
+		if (memory.data && madvise(memory.data, memory.size, MADV_DONTNEED) != 0) {
+			zeroInParallel(memory.data, memory.size);
+		}
+	}
+#else
+	LargeMemory allocateLarge(const size_t size) noexcept {
+		void* data = calloc(1, size);
+		return LargeMemory { .data = data, .size = data ? size : 0, .mode = PageMode::NORMAL };
+	}
+
+	void freeLarge(LargeMemory& memory) noexcept {
+		free(memory.data);
+		memory = LargeMemory();
+	}
+
+	void clearLarge(LargeMemory& memory) {
+		zeroInParallel(memory.data, memory.size);
+	}
+#endif // __linux__
+
+	void zeroInParallel(void* data, const size_t size) {
+		constexpr size_t MIN_PART_SIZE = 16 * 1024 * 1024; // Smaller parts are not worth a thread
+
+		const size_t threadsCount = std::clamp<size_t>(size / MIN_PART_SIZE, 1, std::max(1u, std::thread::hardware_concurrency()));
+		const size_t partSize = (size / threadsCount + 4095) / 4096 * 4096;
+
+		std::vector<std::thread> threads;
+		for (size_t from = partSize; from < size; from += partSize) {
+			threads.emplace_back([=]() {
+				memset(reinterpret_cast<u8*>(data) + from, 0, std::min(partSize, size - from));
+			});
+		}
+
+		memset(data, 0, std::min(partSize, size));
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+
+	std::string_view pageModeToString(const PageMode mode) noexcept {
+		switch (mode) {
+			case PageMode::TRANSPARENT_HUGE_PAGES: return "transparent huge pages";
+			case PageMode::EXPLICIT_HUGE_PAGES: return "explicit huge pages";
+			default: return "normal pages";
+		}
+	}
+}
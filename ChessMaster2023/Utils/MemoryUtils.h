@@ -0,0 +1,65 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+#include "Types.h"
+
+/*
+*	MemoryUtils(.h/.cpp) contains the allocation of the big tables.
+*
+*	On Linux, the tables are backed by 2 MB pages to reduce the TLB misses of the random accesses:
+*	transparent huge pages on a 2 MB aligned mapping if they are enabled,
+*	otherwise the explicitly reserved huge pages (MAP_HUGETLB), otherwise the usual pages.
+*	Elsewhere, the usual allocation is used.
+*	On the machines with several NUMA nodes, the pages are interleaved over the nodes.
+*
+*	The memory is zeroed lazily by the system on the first touch, so even a huge table is allocated instantly.
+*	Clearing returns the pages to the system where possible, otherwise they are zeroed by several threads.
+*/
+
+namespace mem_utils {
+	constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+	enum class PageMode : u8 {
+		NORMAL = 0,
+		TRANSPARENT_HUGE_PAGES,
+		EXPLICIT_HUGE_PAGES
+	};
+
+	struct LargeMemory final {
+		void* data = nullptr;
+		size_t size = 0; // The size actually allocated, rounded up to the page size
+		PageMode mode = PageMode::NORMAL;
+	};
+
+	// Allocates zero-filled memory, using the huge pages for the sizes of at least HUGE_PAGE_SIZE
+	// The data is nullptr if the allocation failed
+	LargeMemory allocateLarge(const size_t size) noexcept;
+	void freeLarge(LargeMemory& memory) noexcept;
+
+	// Makes the whole memory zero-filled again
+	void clearLarge(LargeMemory& memory);
+
+	// Zeroes the memory with a thread per core
+	void zeroInParallel(void* data, const size_t size);
+
+	std::string_view pageModeToString(const PageMode mode) noexcept;
+}
@@ -0,0 +1,217 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "NumaUtils.h"
+#include <atomic>
+
+#ifdef __linux__
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "StringUtils.h"
+#endif // __linux__
+
+namespace numa_utils {
+	std::atomic<AffinityMode> g_affinityMode = AffinityMode::AUTO;
+
+	bool setAffinityMode(std::string_view mode) {
+		if (mode == "auto") {
+			g_affinityMode = AffinityMode::AUTO;
+		} else if (mode == "cores") {
+			g_affinityMode = AffinityMode::CORES;
+		} else if (mode == "physical") {
+			g_affinityMode = AffinityMode::PHYSICAL_CORES;
+		} else if (mode == "off") {
+			g_affinityMode = AffinityMode::OFF;
+		} else {
+			return false;
+		}
+
+		return true;
+	}
+
+	AffinityMode getAffinityMode() noexcept {
+		return g_affinityMode;
+	}
+
+#ifdef __linux__
+	// The memory policies and flags of mbind, as in <linux/mempolicy.h>
+	constexpr int MPOL_INTERLEAVE_MODE = 3;
+	constexpr int MPOL_LOCAL_MODE = 4;
+	constexpr unsigned MPOL_MF_MOVE_FLAG = 1 << 1;
+
+	struct NumaNode final {
+		u32 id;
+		std::vector<u32> cpus;			// In the natural order
+		std::vector<u32> physicalFirst; // The first SMT sibling of every core goes before the others
+	};
+
+	// Parses the lists like "0-3,8,10-11"
+	std::vector<u32> parseCpuList(const std::string& list) {
+		std::vector<u32> cpus;
+		for (std::string_view range : str_utils::split(list, ",")) {
+			const std::vector<std::string_view> bounds = str_utils::split(range, "-");
+			if (bounds.empty()) {
+				continue;
+			}
+
+			const u32 from = str_utils::fromString<u32>(bounds[0]);
+			const u32 to = bounds.size() > 1 ? str_utils::fromString<u32>(bounds[1]) : from;
+			for (u32 cpu = from; cpu <= to; cpu++) {
+				cpus.push_back(cpu);
+			}
+		}
+
+		return cpus;
+	}
+
+	std::string readLine(const std::string& fileName) {
+		std::ifstream in(fileName);
+		std::string line;
+		std::getline(in, line);
+		return line;
+	}
+
+	std::vector<NumaNode> readTopology() {
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+			return { };
+		}
+
+		std::vector<NumaNode> nodes;
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error)) {
+			const std::string name = entry.path().filename().string();
+			if (name.size() > 4 && name.starts_with("node") && std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+				nodes.push_back(NumaNode { .id = str_utils::fromString<u32>(name.substr(4)), .cpus = parseCpuList(readLine(entry.path().string() + "/cpulist")) });
+			}
+		}
+
+		// A kernel without NUMA support has no nodes directory
+		if (nodes.empty()) {
+			nodes.push_back(NumaNode { .id = 0 });
+			for (u32 cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+				nodes[0].cpus.push_back(cpu);
+			}
+		}
+
+		for (NumaNode& node : nodes) {
+			std::erase_if(node.cpus, [&allowed](const u32 cpu) { return cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed); });
+
+			std::vector<u32> siblings;
+			for (const u32 cpu : node.cpus) {
+				const std::vector<u32> cpuSiblings = parseCpuList(readLine("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list"));
+				if (cpuSiblings.empty() || cpu == *std::min_element(cpuSiblings.begin(), cpuSiblings.end())) {
+					node.physicalFirst.push_back(cpu);
+				} else {
+					siblings.push_back(cpu);
+				}
+			}
+
+			node.physicalFirst.insert(node.physicalFirst.end(), siblings.begin(), siblings.end());
+		}
+
+		// The memory-only nodes cannot run the threads
+		std::erase_if(nodes, [](const NumaNode& node) { return node.cpus.empty(); });
+		std::sort(nodes.begin(), nodes.end(), [](const NumaNode& left, const NumaNode& right) { return left.id < right.id; });
+		return nodes;
+	}
+
+	const std::vector<NumaNode>& getTopology() {
+		static const std::vector<NumaNode> nodes = readTopology();
+		return nodes;
+	}
+
+	u32 getNodesCount() {
+		return std::max<u32>(1, u32(getTopology().size()));
+	}
+
+	bool bindThread(const u32 index) {
+		const std::vector<NumaNode>& nodes = getTopology();
+		const AffinityMode mode = g_affinityMode;
+		if (nodes.empty() || mode == AffinityMode::OFF || (mode == AffinityMode::AUTO && nodes.size() == 1)) {
+			return false;
+		}
+
+		const NumaNode& node = nodes[index % nodes.size()];
+		const u32 indexInNode = u32(index / nodes.size());
+
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		if (mode == AffinityMode::AUTO) {
+			for (const u32 cpu : node.cpus) {
+				CPU_SET(cpu, &cpus);
+			}
+		} else {
+			const std::vector<u32>& order = mode == AffinityMode::CORES ? node.cpus : node.physicalFirst;
+			CPU_SET(order[indexInNode % order.size()], &cpus);
+		}
+
+		return sched_setaffinity(0, sizeof(cpus), &cpus) == 0 && nodes.size() > 1;
+	}
+
+	void interleave(void* data, const size_t size) {
+		const std::vector<NumaNode>& nodes = getTopology();
+		if (nodes.size() < 2 || g_affinityMode == AffinityMode::OFF || !data) {
+			return;
+		}
+
+		constexpr size_t BITS_PER_WORD = sizeof(unsigned long) * 8;
+		std::vector<unsigned long> mask(nodes.back().id / BITS_PER_WORD + 1);
+		for (const NumaNode& node : nodes) {
+			mask[node.id / BITS_PER_WORD] |= 1ul << (node.id % BITS_PER_WORD);
+		}
+
+		// The policy applies to the pages touched later, failing is harmless
+		syscall(SYS_mbind, data, size, MPOL_INTERLEAVE_MODE, mask.data(), mask.size() * BITS_PER_WORD + 1, 0u);
+	}
+
+	void moveToLocalNode(void* data, const size_t size) {
+		if (getTopology().size() < 2 || !data) {
+			return;
+		}
+
+		// mbind works with the whole pages
+		const uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+		const uintptr_t from = uintptr_t(data) / pageSize * pageSize;
+		const uintptr_t to = (uintptr_t(data) + size + pageSize - 1) / pageSize * pageSize;
+
+		syscall(SYS_mbind, from, to - from, MPOL_LOCAL_MODE, nullptr, 0ul, MPOL_MF_MOVE_FLAG);
+	}
+#else
+	u32 getNodesCount() {
+		return 1;
+	}
+
+	bool bindThread(const u32) {
+		return false;
+	}
+
+	void interleave(void*, const size_t) { }
+
+	void moveToLocalNode(void*, const size_t) { }
+#endif // __linux__
+}
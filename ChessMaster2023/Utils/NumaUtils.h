@@ -0,0 +1,63 @@
+/*
+*	ChessMaster, a free UCI / Xboard chess engine
+*	Copyright (C) 2023 Ilyin Yegor
+*
+*	ChessMaster is free software : you can redistribute it and /or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	ChessMaster is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with ChessMaster. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+#include "Types.h"
+
+/*
+*	NumaUtils(.h/.cpp) contains the placement of the search threads and the big tables on the NUMA nodes.
+*
+*	The topology is read from /sys on Linux, restricted to the CPUs the process may run on.
+*	The affinity modes are:
+*		auto     - on a machine with several nodes, the threads are spread over the nodes round-robin
+*		           and may float within their node; on a single node, nothing is done
+*		cores    - every thread is pinned to a logical CPU, the nodes are used round-robin
+*		physical - the same, but the SMT siblings are used only after all the physical cores are taken
+*		off      - nothing is done
+*	The shared tables are interleaved over the nodes, so that no node serves all the accesses.
+*	Everything is a no-op on a single node machine and elsewhere than on Linux.
+*/
+
+namespace numa_utils {
+	enum class AffinityMode : u8 {
+		AUTO = 0,
+		CORES,
+		PHYSICAL_CORES,
+		OFF
+	};
+
+	// Returns false if there is no such mode
+	bool setAffinityMode(std::string_view mode);
+	AffinityMode getAffinityMode() noexcept;
+
+	// The number of the nodes with the CPUs available to the process, at least 1
+	u32 getNodesCount();
+
+	// Binds the calling thread according to the affinity mode, the threads are numbered from 0
+	// Returns true if the thread was bound to a node of several
+	bool bindThread(const u32 index);
+
+	// Spreads the pages of the memory that was not touched yet over the nodes
+	void interleave(void* data, const size_t size);
+
+	// Moves the already touched pages to the node of the calling thread
+	void moveToLocalNode(void* data, const size_t size);
+}
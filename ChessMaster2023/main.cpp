@@ -17,17 +17,33 @@
 */
 
 #include "Utils/IO.h"
+#include "Utils/NumaUtils.h"
 #include "Chess/BitBoard.h"
 #include "Engine/Scores.h"
 #include "Engine/Engine.h"
+#include "Engine/AnalysisServer.h"
+#include "Engine/Annotation.h"
+#include "Engine/BatchAnalysis.h"
+#include "Engine/Cluster.h"
+#include "Engine/Learning.h"
+#include "Engine/Search.h"
 #include "Engine/TranspositionTable.h"
 #include "Engine/PawnHashTable.h"
+#include "Engine/Bitbase.h"
 
 /*
 *	main.cpp contains the main function.
 * 
 *	It does some general initialization, requests the work mode
 *	and starts the engine.
+*	With the "analyze" argument, it runs the non-interactive batch analysis instead,
+*	with the "serve" argument - the resident analysis server,
+*	with the "annotate" argument - the annotation of PGN games,
+*	and with the "cluster-worker" argument - a worker of the distributed search.
+*	Any of the modes can be preceded with "--shared-hash <name>" to share the transposition table
+*	with the other processes using the same name, with "--learning <file>" to use the persistent learning store,
+*	with "--affinity <auto|cores|physical|off>" to choose the placement of the search threads,
+*	and with "--cluster <addresses>" to distribute the search of the interactive modes over the cluster workers.
 * 
 *	Bizzare ideas (just some notes):
 *		1) Dynamic square's "importance" (center, king zone, piece concentration, etc)
@@ -67,17 +83,58 @@
 *	Bugs: -
 */
 
-int main() {
+int main(int argc, char** argv) {
+	std::vector<std::string> args(argv + 1, argv + argc);
+
+	// The options common for all the modes go first
+	while (args.size() >= 2 && (args[0] == "--shared-hash" || args[0] == "--learning" || args[0] == "--affinity" || args[0] == "--cluster")) {
+		if (args[0] == "--shared-hash") {
+			engine::TranspositionTable::setSharedMemoryName(args[1]);
+		} else if (args[0] == "--cluster") {
+			engine::setClusterWorkers(args[1]);
+		} else if (args[0] == "--affinity") {
+			if (!numa_utils::setAffinityMode(args[1])) {
+				std::cerr << "Unknown affinity mode " << args[1] << ", expected auto, cores, physical or off" << std::endl;
+			}
+		} else if (!engine::LearningStore::open(args[1])) {
+			std::cerr << "Cannot open the learning store " << args[1] << std::endl;
+		}
+
+		args.erase(args.begin(), args.begin() + 2);
+	}
+
 	BitBoard::init();
 	scores::initScores();
 	engine::TranspositionTable::init();
 	engine::PawnHashTable::init();
+	engine::bitbase::init();
+
+	const std::string command = args.empty() ? "" : args[0];
+	if (command == "analyze" || command == "serve" || command == "annotate" || command == "cluster-worker") {
+		args.erase(args.begin());
+		const bool success = command == "analyze"
+			? engine::runBatchAnalysis(args)
+			: command == "serve"
+			? engine::runAnalysisServer(args)
+			: command == "annotate"
+			? engine::runAnnotation(args)
+			: engine::runClusterWorker(args);
+
+		engine::LearningStore::close();
+		engine::TranspositionTable::destroy();
+		return success ? 0 : 1;
+	}
+
 	io::Output::init();
 	io::init();
 
+	// The interactive modes search on the main thread
+	engine::bindSearchThread(0);
+
 	engine::run(io::getMode());
 	
 	io::Output::destroy();
+	engine::LearningStore::close();
 	engine::TranspositionTable::destroy();
 	return 0;
 }
\ No newline at end of file